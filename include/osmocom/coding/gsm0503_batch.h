@@ -0,0 +1,76 @@
+/*! \file gsm0503_batch.h
+ *  GSM TS 05.03 decoding of many blocks at once
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <osmocom/core/bits.h>
+
+/*! \addtogroup coding
+ *  @{
+ * \file gsm0503_batch.h */
+
+/*! Channel types of a gsm0503_decode_job, each selecting a decoding function */
+enum gsm0503_decode_chan {
+	GSM0503_DECODE_XCCH,		/*!< gsm0503_xcch_decode() */
+	GSM0503_DECODE_PDTCH,		/*!< gsm0503_pdtch_decode() */
+	GSM0503_DECODE_PDTCH_EGPRS,	/*!< gsm0503_pdtch_egprs_decode() */
+	GSM0503_DECODE_TCH_FR,		/*!< gsm0503_tch_fr_decode() */
+	GSM0503_DECODE_TCH_HR,		/*!< gsm0503_tch_hr_decode() */
+	GSM0503_DECODE_TCH_AFS,		/*!< gsm0503_tch_afs_decode_dtx() */
+	GSM0503_DECODE_TCH_AHS,		/*!< gsm0503_tch_ahs_decode_dtx() */
+};
+
+/*! One block to decode with gsm0503_decode_batch(). The arguments and
+ *  results are those of the decoding function selected by chan. */
+struct gsm0503_decode_job {
+	/*! channel type of the block */
+	enum gsm0503_decode_chan chan;
+	/*! burst input data as soft unpacked bits */
+	const sbit_t *bursts;
+	/*! caller-allocated output data buffer */
+	uint8_t *data;
+	/*! channel type specific arguments */
+	union {
+		struct {
+			uint16_t nbits;
+		} pdtch_egprs;
+		struct {
+			int net_order;
+			int efr;
+		} tch_fr;
+		struct {
+			int odd;
+		} tch_hr;
+		/*! TCH/AFS and TCH/AHS; odd is only used by TCH/AHS */
+		struct {
+			int odd;
+			int codec_mode_req;
+			uint8_t *codec;
+			int codecs;
+			uint8_t *ft;
+			uint8_t *cmr;
+			uint8_t *dtx;
+		} amr;
+	} u;
+
+	/*! return value of the decoding function */
+	int rc;
+	/*! uplink state flag (PDTCH only) */
+	uint8_t usf;
+	/*! number of detected bit errors */
+	int n_errors;
+	/*! total number of coded bits */
+	int n_bits_total;
+};
+
+struct gsm0503_decode_pool;
+
+struct gsm0503_decode_pool *gsm0503_decode_pool_alloc(void *ctx, unsigned int num_threads);
+void gsm0503_decode_pool_free(struct gsm0503_decode_pool *pool);
+int gsm0503_decode_batch(struct gsm0503_decode_pool *pool,
+	struct gsm0503_decode_job *jobs, unsigned int num);
+
+/*! @} */
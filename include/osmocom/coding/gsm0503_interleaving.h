@@ -12,9 +12,11 @@
 
 void gsm0503_xcch_deinterleave(sbit_t *cB, const sbit_t *iB);
 void gsm0503_xcch_interleave(const ubit_t *cB, ubit_t *iB);
+void gsm0503_xcch_burst_unmap_deinterleave(sbit_t *cB, const sbit_t *bursts);
 
 void gsm0503_tch_fr_deinterleave(sbit_t *cB, const sbit_t *iB);
 void gsm0503_tch_fr_interleave(const ubit_t *cB, ubit_t *iB);
+void gsm0503_tch_fr_burst_unmap_deinterleave(sbit_t *cB, const sbit_t *bursts);
 
 void gsm0503_tch_hr_deinterleave(sbit_t *cB, const sbit_t *iB);
 void gsm0503_tch_hr_interleave(const ubit_t *cB, ubit_t *iB);
@@ -80,6 +80,27 @@ unsigned int bitvec_add_array(struct bitvec *bv, const uint32_t *array,
 			      unsigned int array_len, bool dry_run,
 			      unsigned int num_bits);
 
+/*! Cursor reading and writing fields of up to 64 bits of a bit vector,
+ *  see bitvec_cursor_init() */
+struct bitvec_cursor {
+	uint8_t *data;		/*!< data of the bit vector */
+	unsigned int data_len;	/*!< length of data in bytes */
+	unsigned int pos;	/*!< number of the next bit to read or write */
+	int err;		/*!< 0, or the negative error of the first failed access */
+};
+
+void bitvec_cursor_init(struct bitvec_cursor *c, struct bitvec *bv, unsigned int bitnr);
+uint64_t bitvec_cursor_read(struct bitvec_cursor *c, unsigned int num_bits);
+int bitvec_cursor_write(struct bitvec_cursor *c, uint64_t val, unsigned int num_bits);
+int bitvec_cursor_write_lh(struct bitvec_cursor *c, uint64_t val, unsigned int num_bits);
+int bitvec_cursor_fill(struct bitvec_cursor *c, unsigned int num_bits, enum bit_value fill);
+
+/*! Return the number of bits remaining after the cursor position */
+static inline unsigned int bitvec_cursor_tailroom(const struct bitvec_cursor *c)
+{
+	return c->pos < c->data_len * 8 ? c->data_len * 8 - c->pos : 0;
+}
+
 /*! Return the number of bytes used within the bit vector */
 static inline unsigned int bitvec_used_bytes(const struct bitvec *bv)
 {
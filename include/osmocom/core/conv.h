@@ -25,6 +25,7 @@
 #include <stdint.h>
 
 #include <osmocom/core/bits.h>
+#include <osmocom/core/utils.h>
 
 /*! possibe termination types
  *
@@ -132,5 +133,29 @@ int osmo_conv_decode_get_output(struct osmo_conv_decoder *decoder,
 int osmo_conv_decode(const struct osmo_conv_code *code,
                      const sbit_t *input, ubit_t *output);
 
+	/* Batch decoding */
+
+/*! Trellis kernels for osmo_conv_decode_batch(), see osmo_conv_batch_kernel_set() */
+enum osmo_conv_batch_kernel {
+	/*! the fastest kernel supported by the CPU (default) */
+	OSMO_CONV_BATCH_KERNEL_AUTO,
+	/*! portable C, 16 codewords at a time */
+	OSMO_CONV_BATCH_KERNEL_GENERIC,
+	/*! x86 AVX2, 16 codewords at a time */
+	OSMO_CONV_BATCH_KERNEL_AVX2,
+	/*! x86 AVX-512BW, 32 codewords at a time */
+	OSMO_CONV_BATCH_KERNEL_AVX512,
+};
+
+extern const struct value_string osmo_conv_batch_kernel_names[];
+
+int osmo_conv_batch_kernel_set(enum osmo_conv_batch_kernel kernel);
+enum osmo_conv_batch_kernel osmo_conv_batch_kernel_get(void);
+unsigned int osmo_conv_batch_lanes(void);
+
+int osmo_conv_decode_batch(const struct osmo_conv_code *code,
+			   const sbit_t * const *input, ubit_t * const *output,
+			   unsigned int num);
+
 
 /*! @} */
@@ -41,6 +41,30 @@ int osmo_crcXXgen_check_bits(const struct osmo_crcXXgen_code *code,
 void osmo_crcXXgen_set_bits(const struct osmo_crcXXgen_code *code,
                             const ubit_t *in, int len, ubit_t *crc_bits);
 
+/*! lookup tables for the table-driven computation of a CRC code of max XX bits
+ *
+ * The tables are filled by osmo_crcXXgen_table_init() and can then be shared
+ * by any number of threads. The CRC state is kept left-aligned in the XX bit
+ * register, so that a CRC code of any width up to XX bits is processed four
+ * bytes at a time. */
+struct osmo_crcXXgen_table {
+	const struct osmo_crcXXgen_code *code; /*!< CRC code the tables were computed for */
+	uintXX_t t[4][256];                    /*!< slicing-by-4 tables */
+};
+
+void osmo_crcXXgen_table_init(struct osmo_crcXXgen_table *tbl,
+                              const struct osmo_crcXXgen_code *code);
+uintXX_t osmo_crcXXgen_compute_pbits(const struct osmo_crcXXgen_table *tbl,
+                                     const pbit_t *in, int len);
+uintXX_t osmo_crcXXgen_compute_bits_tbl(const struct osmo_crcXXgen_table *tbl,
+                                        const ubit_t *in, int len);
+int osmo_crcXXgen_check_bits_tbl(const struct osmo_crcXXgen_table *tbl,
+                                 const ubit_t *in, int len, const ubit_t *crc_bits);
+void osmo_crcXXgen_set_bits_tbl(const struct osmo_crcXXgen_table *tbl,
+                                const ubit_t *in, int len, ubit_t *crc_bits);
+int osmo_crcXXgen_check_sbits_tbl(const struct osmo_crcXXgen_table *tbl,
+                                  const sbit_t *in, int len, const sbit_t *crc_sbits);
+
 
 /*! @} */
 
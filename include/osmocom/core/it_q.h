@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdint.h>
 #include <osmocom/core/linuxlist.h>
 #include <osmocom/core/select.h>
 #include <pthread.h>
@@ -34,6 +35,11 @@ struct osmo_it_q {
 	void (*read_cb)(struct osmo_it_q *q, struct llist_head *item);
 	/* opaque data pointer passed through to call-back function */
 	void *data;
+
+	/* lock-free ring used instead of list + mutex, see osmo_it_q_alloc_ring(); NULL otherwise */
+	struct osmo_it_q_ring *ring;
+	/* number of items rejected by enqueue as the queue was full */
+	uint64_t dropped;
 };
 
 struct osmo_it_q *osmo_it_q_by_name(const char *name);
@@ -54,9 +60,15 @@ struct llist_head *_osmo_it_q_dequeue(struct osmo_it_q *queue);
 
 struct osmo_it_q *osmo_it_q_alloc(void *ctx, const char *name, unsigned int max_length,
 
+					void (*read_cb)(struct osmo_it_q *q, struct llist_head *item),
+					void *data);
+struct osmo_it_q *osmo_it_q_alloc_ring(void *ctx, const char *name, unsigned int max_length,
 					void (*read_cb)(struct osmo_it_q *q, struct llist_head *item),
 					void *data);
 void osmo_it_q_destroy(struct osmo_it_q *q);
 void osmo_it_q_flush(struct osmo_it_q *q);
 
+unsigned int osmo_it_q_depth(struct osmo_it_q *q);
+uint64_t osmo_it_q_dropped(struct osmo_it_q *q);
+
 /*! @} */
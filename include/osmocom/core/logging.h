@@ -278,6 +278,7 @@ enum log_target_type {
 	LOG_TGT_TYPE_STRRB,	/*!< osmo_strrb-backed logging */
 	LOG_TGT_TYPE_GSMTAP,	/*!< GSMTAP network logging */
 	LOG_TGT_TYPE_SYSTEMD,	/*!< systemd journal logging */
+	LOG_TGT_TYPE_BINARY,	/*!< binary logging to a memory mapped file */
 };
 
 /*! Whether/how to log the source filename (and line number). */
@@ -354,6 +355,14 @@ struct log_target {
 		struct {
 			bool raw;
 		} sd_journal;
+
+		struct {
+			/* memory mapped file, see logging_bin.c */
+			struct log_bin_file *file;
+			const char *fname;
+			/* ring size as requested, before rounding up */
+			size_t ring_size;
+		} tgt_bin;
 	};
 
 	/*! call-back function to be called when the logging framework
@@ -389,6 +398,8 @@ struct log_target {
 	enum log_filename_type print_filename2;
 	/* Where on a log line to put the source file info. */
 	enum log_filename_pos print_filename_pos;
+	/* Bit of this target in the target mask of asynchronous logging, -1 if none (internal) */
+	int8_t async_bit;
 };
 
 /* use the above macros */
@@ -400,6 +411,7 @@ int log_init(const struct log_info *inf, void *talloc_ctx);
 int log_initialized(void);
 void log_fini(void);
 int log_check_level(int subsys, unsigned int level);
+void log_level_cache_update(void);
 
 /* context management */
 void log_reset_context(void);
@@ -452,6 +464,22 @@ struct log_target *log_target_find(enum log_target_type type, const char *fname)
 
 void log_enable_multithread(void);
 
+/*! Counters of asynchronous logging, in the rate counter group "log:async" */
+enum log_async_ctr {
+	LOG_ASYNC_CTR_QUEUED,		/*!< messages queued for the writer thread */
+	LOG_ASYNC_CTR_DROP_FULL,	/*!< messages dropped, the ring of the logging thread was full */
+	LOG_ASYNC_CTR_DROP_NORING,	/*!< messages dropped, no ring could be allocated for the logging thread */
+	LOG_ASYNC_CTR_DROP_WRITE,	/*!< messages not written to a target due to an error */
+};
+
+/*! Default size of the per-thread rings of asynchronous logging, in bytes */
+#define LOG_ASYNC_RING_SIZE_DEFAULT	(1 << 20)
+
+int log_async_enable(size_t ring_size);
+void log_async_disable(void);
+bool log_async_enabled(void);
+void log_async_flush(void);
+
 void log_tgt_mutex_lock_impl(void);
 void log_tgt_mutex_unlock_impl(void);
 #define LOG_MTX_DEBUG 0
@@ -0,0 +1,133 @@
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+/*! \defgroup logging_bin Osmocom binary logging
+ *  @{
+ * \file logging_bin.h */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+struct log_target;
+
+/*! Magic at the start of a binary log file */
+#define LOG_BIN_MAGIC		"OSMOLOGB"
+/*! Version of the binary log file format */
+#define LOG_BIN_VERSION		1
+/*! Value of log_bin_file_hdr.byte_order as written by the logging host */
+#define LOG_BIN_BYTE_ORDER	0x01020304
+/*! Default size of the record ring of a binary log file */
+#define LOG_BIN_RING_SIZE_DEFAULT	(16 << 20)
+/*! Size of the string dictionary of a binary log file */
+#define LOG_BIN_DICT_SIZE	(1 << 20)
+/*! Maximum length of a record, including its header */
+#define LOG_BIN_REC_MAX		4096
+
+/*! Header at the start of a binary log file.
+ *
+ * A binary log file consists of this header, a string dictionary and a ring
+ * of log records.  All values are in the byte order of the logging host.  The
+ * dictionary holds the format strings, source file names and logging category
+ * names, each of them written once; the records refer to them by id and carry
+ * the raw printf arguments, so that rendering the text can be deferred to the
+ * decoder.  When the ring is full, the oldest records are overwritten. */
+struct log_bin_file_hdr {
+	char magic[8];			/*!< LOG_BIN_MAGIC, not NUL terminated */
+	uint32_t version;		/*!< LOG_BIN_VERSION */
+	uint32_t byte_order;		/*!< LOG_BIN_BYTE_ORDER */
+	uint64_t dict_off;		/*!< offset of the dictionary in the file */
+	uint64_t dict_size;		/*!< size of the dictionary */
+	uint64_t dict_used;		/*!< number of bytes of valid dictionary entries */
+	uint64_t ring_off;		/*!< offset of the record ring in the file */
+	uint64_t ring_size;		/*!< size of the record ring, a power of 2 */
+	uint64_t head;			/*!< position after the newest record, modulo ring_size */
+	uint64_t tail;			/*!< position of the oldest record, modulo ring_size */
+} __attribute__((packed));
+
+/*! Kind of a dictionary entry */
+enum log_bin_dict_kind {
+	LOG_BIN_DICT_FMT,		/*!< printf format string */
+	LOG_BIN_DICT_FILE,		/*!< source file name */
+	LOG_BIN_DICT_CAT,		/*!< logging category name, id is the subsystem */
+	_LOG_BIN_DICT_KIND_NUM
+};
+
+/*! Entry of the dictionary, followed by the NUL terminated string and
+ *  padding to a multiple of 8 bytes */
+struct log_bin_dict_ent {
+	uint16_t len;			/*!< length of the entry including this header */
+	uint8_t kind;			/*!< enum log_bin_dict_kind */
+	uint8_t reserved;
+	uint32_t id;			/*!< id of the string, unique per kind; never 0 for formats and files */
+	char str[0];
+} __attribute__((packed));
+
+/*! Flags of a log record */
+enum log_bin_rec_flags {
+	LOG_BIN_REC_F_PAD	= 0x01,	/*!< padding up to the end of the ring, no log record */
+	LOG_BIN_REC_F_CONT	= 0x02,	/*!< continuation of the previous message */
+};
+
+/*! Header of a log record in the ring, followed by the arguments of the format
+ *  string and padding to a multiple of 8 bytes.
+ *
+ * The arguments are stored in the order the format string consumes them:
+ * integers as 4 bytes, or as 8 bytes with an l, ll, q, j, z or t length
+ * modifier; floating point numbers as 8 byte double; pointers as 8 bytes;
+ * strings as a 2 byte length followed by the characters without NUL.
+ * A format id of 0 denotes a message that was formatted when logging,
+ * because its format string could not be stored; its only argument is the
+ * resulting text, stored like a string. */
+struct log_bin_rec {
+	uint16_t len;			/*!< length of the record including this header */
+	uint8_t flags;			/*!< enum log_bin_rec_flags */
+	uint8_t level;			/*!< log level */
+	uint16_t subsys;		/*!< logging subsystem (index of the category) */
+	uint16_t reserved;
+	uint32_t tid;			/*!< thread id of the logging thread */
+	uint32_t fmt_id;		/*!< dictionary id of the format string */
+	uint32_t file_id;		/*!< dictionary id of the source file name, 0 if unknown */
+	uint32_t line;			/*!< source file line */
+	uint64_t time_ns;		/*!< CLOCK_REALTIME in nanoseconds */
+	uint8_t args[0];
+} __attribute__((packed));
+
+struct log_target *log_target_create_bin(const char *fname, size_t ring_size);
+
+/*! A log message read from a binary log file */
+struct log_bin_msg {
+	struct timespec ts;		/*!< time of the message */
+	uint32_t tid;			/*!< thread id of the logging thread */
+	unsigned int subsys;		/*!< logging subsystem */
+	const char *category;		/*!< name of the logging category, NULL if unknown */
+	unsigned int level;		/*!< log level */
+	const char *file;		/*!< source file name, NULL if unknown */
+	unsigned int line;		/*!< source file line */
+	bool cont;			/*!< continuation of the previous message? */
+	char text[LOG_BIN_REC_MAX * 2];	/*!< the rendered message text */
+};
+
+struct log_bin_reader;
+
+struct log_bin_reader *log_bin_reader_open(void *ctx, const char *fname);
+int log_bin_reader_next(struct log_bin_reader *rd, struct log_bin_msg *msg);
+void log_bin_reader_close(struct log_bin_reader *rd);
+
+/*! @} */
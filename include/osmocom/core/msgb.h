@@ -72,6 +72,20 @@ extern struct msgb *msgb_copy(const struct msgb *msg, const char *name);
 extern struct msgb *msgb_copy_c(const void *ctx, const struct msgb *msg, const char *name);
 static int msgb_test_invariant(const struct msgb *msg) __attribute__((pure));
 
+/*! Zero the entire data buffer of msgbs allocated from the pool, like msgb_alloc_c() does */
+#define MSGB_POOL_F_ZERO	0x0001
+
+struct msgb_pool;
+struct rate_ctr_group;
+struct osmo_stat_item_group;
+struct msgb_pool *msgb_pool_create(void *ctx, unsigned int idx, const uint16_t *sizes, unsigned int num_sizes,
+				   unsigned int prealloc, unsigned int flags);
+void msgb_pool_destroy(struct msgb_pool *pool);
+struct msgb *msgb_alloc_pool(struct msgb_pool *pool, uint16_t size, const char *name);
+unsigned int msgb_pool_in_use(const struct msgb_pool *pool);
+struct rate_ctr_group *msgb_pool_get_ctrg(struct msgb_pool *pool);
+struct osmo_stat_item_group *msgb_pool_get_statg(struct msgb_pool *pool);
+
 /*! Free all msgbs from a queue built with msgb_enqueue().
  * \param[in] queue  list head of a msgb queue.
  */
@@ -0,0 +1,79 @@
+/*! \file msgb_chain.h
+ * Chains of reference counted msgb segments. */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <osmocom/core/linuxlist.h>
+#include <osmocom/core/msgb.h>
+
+/*! \defgroup msgb_chain Chained message buffers
+ *  @{
+ * \file msgb_chain.h */
+
+struct msgb_chain_blk;
+
+/*! One segment of a \ref msgb_chain: a range of octets within a (shared) msgb */
+struct msgb_chain_seg {
+	/*! entry in msgb_chain.segs */
+	struct llist_head list;
+	/*! reference counted msgb holding the octets */
+	struct msgb_chain_blk *blk;
+	/*! first octet of the segment */
+	uint8_t *data;
+	/*! number of octets in the segment */
+	unsigned int len;
+};
+
+/*! A message made of a list of segments, which may share msgbs with other chains */
+struct msgb_chain {
+	/*! list of struct msgb_chain_seg, in transmission order */
+	struct llist_head segs;
+	/*! number of entries in segs */
+	unsigned int num_segs;
+	/*! total number of octets in all segments */
+	unsigned int len;
+};
+
+/*! Headroom of msgbs allocated by msgb_chain_push() for prepending headers */
+#define MSGB_CHAIN_HEADROOM 64
+
+struct msgb_chain *msgb_chain_alloc(void *ctx, const char *name);
+void msgb_chain_free(struct msgb_chain *chain);
+
+int msgb_chain_append_msgb(struct msgb_chain *chain, struct msgb *msg);
+int msgb_chain_prepend_msgb(struct msgb_chain *chain, struct msgb *msg);
+uint8_t *msgb_chain_push(struct msgb_chain *chain, unsigned int len);
+int msgb_chain_pull(struct msgb_chain *chain, unsigned int len);
+struct msgb_chain *msgb_chain_split(struct msgb_chain *chain, unsigned int len, const char *name);
+
+int msgb_chain_to_iovec(const struct msgb_chain *chain, struct iovec *iov, unsigned int iov_len);
+struct msgb *msgb_chain_linearize(const struct msgb_chain *chain, void *ctx, uint16_t headroom, const char *name);
+
+/*! Get the total length of a msgb chain
+ * \param[in] chain msgb chain to query
+ * \returns number of octets in all segments of the chain */
+static inline unsigned int msgb_chain_length(const struct msgb_chain *chain)
+{
+	return chain->len;
+}
+
+/*! @} */
@@ -63,6 +63,16 @@ struct rate_ctr_group {
 	unsigned int idx;
 	/*! Optional string-based identifier to be used instead of index at report time */
 	char *name;
+	/*! Per-thread shards of the counter values, NULL unless allocated by rate_ctr_group_alloc_mt() */
+	struct rate_ctr_mt *mt;
+	/*! Hash table node of the group, keyed by group name and index */
+	struct hlist_node hnode;
+	/*! Hash index of the counter names, NULL if not available */
+	struct osmo_name_idx *name_idx;
+	/*! Entry in the list of groups with changed counters, for reporting only those */
+	struct llist_head dirty_list;
+	/*! Entry in the list of groups with the same group name prefix */
+	struct llist_head class_list;
 	/*! Actual counter structures below. Don't access it directly, use APIs below! */
 	struct rate_ctr ctr[0];
 };
@@ -70,11 +80,12 @@ struct rate_ctr_group {
 struct rate_ctr_group *rate_ctr_group_alloc(void *ctx,
 					    const struct rate_ctr_group_desc *desc,
 					    unsigned int idx);
+struct rate_ctr_group *rate_ctr_group_alloc_mt(void *ctx,
+					       const struct rate_ctr_group_desc *desc,
+					       unsigned int idx);
+void rate_ctr_group_sync(struct rate_ctr_group *ctrg);
 
-static inline void rate_ctr_group_upd_idx(struct rate_ctr_group *grp, unsigned int idx)
-{
-	grp->idx = idx;
-}
+void rate_ctr_group_upd_idx(struct rate_ctr_group *grp, unsigned int idx);
 void rate_ctr_group_set_name(struct rate_ctr_group *grp, const char *name);
 
 struct rate_ctr *rate_ctr_group_get_ctr(struct rate_ctr_group *grp, unsigned int idx);
@@ -93,12 +104,33 @@ static inline void rate_ctr_inc(struct rate_ctr *ctr)
 	rate_ctr_add(ctr, 1);
 }
 
+void _rate_ctr_add2_mt(struct rate_ctr_group *ctrg, unsigned int idx, int inc);
+void _rate_ctr_group_mark_dirty(struct rate_ctr_group *ctrg);
+
+/*! Add a number to a counter of a group
+ *  \param ctrg \ref rate_ctr_group of counter
+ *  \param idx index into \a ctrg counter group
+ *  \param inc quantity to increment the counter by
+ *
+ *  For groups allocated by rate_ctr_group_alloc_mt(), this may be called from
+ *  any thread. */
+static inline void rate_ctr_add2(struct rate_ctr_group *ctrg, unsigned int idx, int inc)
+{
+	if (ctrg->mt) {
+		_rate_ctr_add2_mt(ctrg, idx, inc);
+		return;
+	}
+	ctrg->ctr[idx].current += inc;
+	if (llist_empty(&ctrg->dirty_list))
+		_rate_ctr_group_mark_dirty(ctrg);
+}
+
 /*! Increment the counter by 1
  *  \param ctrg \ref rate_ctr_group of counter
  *  \param idx index into \a ctrg counter group */
 static inline void rate_ctr_inc2(struct rate_ctr_group *ctrg, unsigned int idx)
 {
-	rate_ctr_inc(rate_ctr_group_get_ctr(ctrg, idx));
+	rate_ctr_add2(ctrg, idx, 1);
 }
 
 
@@ -43,6 +43,19 @@ struct osmo_fd {
 	void *data;
 	/*! private number, extending \a data */
 	unsigned int priv_nr;
+	/*! \a when flags as currently programmed into the kernel by the
+	 * epoll back-end; internal use only */
+	unsigned int when_kernel;
+};
+
+/*! I/O multiplexing back-ends which osmo_select_main() can use */
+enum osmo_select_backend {
+	/*! build an array of pollfd from all registered osmo_fd and
+	 * call poll() on each iteration (default) */
+	OSMO_SELECT_BACKEND_POLL,
+	/*! keep a persistent epoll set which is updated incrementally
+	 * and dispatch directly to the osmo_fd of each event */
+	OSMO_SELECT_BACKEND_EPOLL,
 };
 
 void osmo_fd_setup(struct osmo_fd *ofd, int fd, unsigned int when,
@@ -74,6 +87,8 @@ void osmo_fd_close(struct osmo_fd *fd);
 int osmo_select_main(int polling);
 int osmo_select_main_ctx(int polling);
 void osmo_select_init(void);
+int osmo_select_backend_set(enum osmo_select_backend backend);
+enum osmo_select_backend osmo_select_backend_get(void);
 
 struct osmo_fd *osmo_fd_get_by_fd(int fd);
 
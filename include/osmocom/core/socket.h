@@ -20,6 +20,8 @@
 struct sockaddr_in;
 struct sockaddr;
 struct osmo_fd;
+struct iovec;
+struct msgb_chain;
 
 struct osmo_sockaddr {
 	union {
@@ -140,5 +142,12 @@ char *osmo_sockaddr_to_str_c(void *ctx, const struct osmo_sockaddr *sockaddr);
 int osmo_sock_set_dscp(int fd, uint8_t dscp);
 int osmo_sock_set_priority(int fd, int prio);
 
+/*! maximum number of segments of a msgb_chain sent by osmo_sock_send_chain() */
+#define OSMO_SOCK_CHAIN_MAX_SEGS 64
+
+int osmo_sock_sendiov(int fd, const struct iovec *iov, unsigned int iovcnt,
+		      const struct osmo_sockaddr *dst, int flags);
+int osmo_sock_send_chain(int fd, const struct msgb_chain *chain, const struct osmo_sockaddr *dst, int flags);
+
 #endif /* (!EMBEDDED) */
 /*! @} */
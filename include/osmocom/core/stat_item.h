@@ -51,6 +51,16 @@ struct osmo_stat_item_group {
 	unsigned int idx;
 	/*! Optional string-based identifier to be used instead of index at report time */
 	char *name;
+	/*! Hash table node of the group, keyed by group name and index */
+	struct hlist_node hnode;
+	/*! Hash table node of the group, keyed by group name and name; unused without a name */
+	struct hlist_node hnode_name;
+	/*! Hash index of the item names, NULL if not available */
+	struct osmo_name_idx *name_idx;
+	/*! Entry in the list of groups with changed items, for reporting only those */
+	struct llist_head dirty_list;
+	/*! Entry in the list of groups with the same group name prefix */
+	struct llist_head class_list;
 	/*! Actual counter structures below */
 	struct osmo_stat_item *items[0];
 };
@@ -60,11 +70,7 @@ struct osmo_stat_item_group *osmo_stat_item_group_alloc(
 	const struct osmo_stat_item_group_desc *group_desc,
 	unsigned int idx);
 
-static inline void osmo_stat_item_group_udp_idx(
-	struct osmo_stat_item_group *grp, unsigned int idx)
-{
-	grp->idx = idx;
-}
+void osmo_stat_item_group_udp_idx(struct osmo_stat_item_group *grp, unsigned int idx);
 struct osmo_stat_item *osmo_stat_item_group_get_item(struct osmo_stat_item_group *grp, unsigned int idx);
 void osmo_stat_item_group_set_name(struct osmo_stat_item_group *statg, const char *name);
 void osmo_stat_item_group_free(struct osmo_stat_item_group *statg);
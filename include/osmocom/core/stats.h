@@ -31,6 +31,7 @@
 
 #include <osmocom/core/linuxlist.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 
 struct msgb;
@@ -86,6 +87,8 @@ struct osmo_stats_reporter {
 	int agg_enabled;		/*!< is aggregation enabled? */
 	int force_single_flush;		/*!< set to 1 to force a flush (send even unchanged stats values) */
 	unsigned int flush_period_counter;	/*!< count sends between forced flushes */
+	struct llist_head tx_queue;	/*!< full buffers to be sent, see osmo_stats_reporter_send_buffer() */
+	unsigned int tx_queue_len;	/*!< number of buffers in \a tx_queue */
 
 	struct llist_head list;
 	int (*open)(struct osmo_stats_reporter *srep);
@@ -102,6 +105,8 @@ struct osmo_stats_reporter {
 
 struct osmo_stats_config {
 	int interval;
+	/*! only visit groups with changed counters or items when reporting */
+	bool dirty_tracking;
 };
 
 extern struct llist_head osmo_stats_reporter_list;
@@ -111,6 +116,7 @@ void osmo_stats_init(void *ctx);
 int osmo_stats_report(void);
 
 int osmo_stats_set_interval(int interval);
+void osmo_stats_set_dirty_tracking(bool enable);
 
 struct osmo_stats_reporter *osmo_stats_reporter_alloc(enum osmo_stats_reporter_type type,
 	const char *name);
@@ -138,6 +144,7 @@ struct osmo_stats_reporter *osmo_stats_reporter_create_statsd(const char *name);
 int osmo_stats_reporter_send(struct osmo_stats_reporter *srep, const char *data,
 	int data_len);
 int osmo_stats_reporter_send_buffer(struct osmo_stats_reporter *srep);
+int osmo_stats_reporter_queue_buffer(struct osmo_stats_reporter *srep);
 int osmo_stats_reporter_udp_open(struct osmo_stats_reporter *srep);
 int osmo_stats_reporter_udp_close(struct osmo_stats_reporter *srep);
 
@@ -0,0 +1,37 @@
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+/*! \addtogroup stats
+ *  @{
+ * \file stats_prometheus.h */
+
+#include <stdint.h>
+
+struct osmo_stats_prometheus_config {
+	/*! local IP address the exporter listens on, NULL if it is not listening */
+	char *local_ip;
+	/*! local TCP port the exporter listens on */
+	uint16_t local_port;
+};
+extern struct osmo_stats_prometheus_config *osmo_stats_prometheus_config;
+
+int osmo_stats_prometheus_listen(void *ctx, const char *local_ip, uint16_t local_port);
+void osmo_stats_prometheus_close(void);
+
+/*! @} */
@@ -85,6 +85,17 @@ void osmo_timers_prepare(void);
 int osmo_timers_update(void);
 int osmo_timers_check(void);
 
+/*! Timer management back-ends, see osmo_timers_backend_set() */
+enum osmo_timers_backend {
+	/*! timers sorted by expiration time in a red-black tree (default) */
+	OSMO_TIMERS_BACKEND_RBTREE,
+	/*! hierarchical timer wheel with millisecond granularity */
+	OSMO_TIMERS_BACKEND_WHEEL,
+};
+
+int osmo_timers_backend_set(enum osmo_timers_backend backend);
+enum osmo_timers_backend osmo_timers_backend_get(void);
+
 int osmo_gettimeofday(struct timeval *tv, struct timezone *tz);
 int osmo_clock_gettime(clockid_t clk_id, struct timespec *tp);
 
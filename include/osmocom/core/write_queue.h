@@ -23,6 +23,9 @@
  *  @{
  * \file write_queue.h */
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <osmocom/core/select.h>
 #include <osmocom/core/msgb.h>
 
@@ -44,12 +47,27 @@ struct osmo_wqueue {
 	int (*write_cb)(struct osmo_fd *fd, struct msgb *msg);
 	/*! call-back in case qeueue has exceptions. Return -EBADF if fd is freed inside cb. */
 	int (*except_cb)(struct osmo_fd *fd);
+
+	/*! Write the queued msgbs with one writev() per writable event instead of calling write_cb
+	 *  for each of them.  Only for stream sockets, pipes and files.  Set after osmo_wqueue_init().
+	 *  write_cb is only called when writev() wrote nothing, e.g. to close a connection. */
+	bool vectored;
+	/*! number of bytes written in vectored mode */
+	uint64_t tx_bytes;
+	/*! number of writev() calls in vectored mode */
+	uint64_t tx_batches;
+	/*! number of msgbs written completely in vectored mode */
+	uint64_t tx_msgs;
+	/*! number of msgbs dropped due to a write error in vectored mode */
+	uint64_t tx_dropped;
 };
 
 void osmo_wqueue_init(struct osmo_wqueue *queue, int max_length);
 void osmo_wqueue_clear(struct osmo_wqueue *queue);
 int osmo_wqueue_enqueue(struct osmo_wqueue *queue, struct msgb *data);
 int osmo_wqueue_enqueue_quiet(struct osmo_wqueue *queue, struct msgb *data);
+struct msgb_chain;
+int osmo_wqueue_enqueue_chain(struct osmo_wqueue *queue, struct msgb_chain *chain);
 int osmo_wqueue_bfd_cb(struct osmo_fd *fd, unsigned int what);
 
 /*! @} */
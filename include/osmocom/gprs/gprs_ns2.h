@@ -247,6 +247,10 @@ const struct osmo_sockaddr *gprs_ns2_ip_bind_sockaddr(struct gprs_ns2_vc_bind *b
 int gprs_ns2_is_ip_bind(struct gprs_ns2_vc_bind *bind);
 int gprs_ns2_ip_bind_set_dscp(struct gprs_ns2_vc_bind *bind, int dscp);
 int gprs_ns2_ip_bind_set_priority(struct gprs_ns2_vc_bind *bind, uint8_t priority);
+/*! maximum number of datagrams per recvmmsg()/sendmmsg() call of a UDP bind */
+#define NS2_IP_BATCH_MAX 1024
+int gprs_ns2_ip_bind_set_rx_batch(struct gprs_ns2_vc_bind *bind, unsigned int batch);
+int gprs_ns2_ip_bind_set_tx_batch(struct gprs_ns2_vc_bind *bind, unsigned int batch);
 struct gprs_ns2_vc *gprs_ns2_nsvc_by_sockaddr_bind(
 		struct gprs_ns2_vc_bind *bind,
 		const struct osmo_sockaddr *saddr);
@@ -20,6 +20,7 @@
 
 #include <osmocom/core/defs.h>
 #include <osmocom/core/bits.h>
+#include <osmocom/core/utils.h>
 
 /*! \defgroup a5 GSM A5 ciphering algorithm
  *  @{
@@ -48,4 +49,25 @@ int osmo_a5(int n, const uint8_t *key, uint32_t fn, ubit_t *dl, ubit_t *ul);
 void osmo_a5_1(const uint8_t *key, uint32_t fn, ubit_t *dl, ubit_t *ul) OSMO_DEPRECATED("Use generic osmo_a5() instead");
 void osmo_a5_2(const uint8_t *key, uint32_t fn, ubit_t *dl, ubit_t *ul) OSMO_DEPRECATED("Use generic osmo_a5() instead");
 
+/*! Kernels generating the A5/1 and A5/2 cipher streams of osmo_a5_batch() */
+enum osmo_a5_batch_kernel {
+	/*! the fastest kernel supported by the CPU (default) */
+	OSMO_A5_BATCH_KERNEL_AUTO,
+	/*! portable C, 64 cipher streams at a time */
+	OSMO_A5_BATCH_KERNEL_GENERIC,
+	/*! 128-bit vectors (SSE2, NEON), 128 cipher streams at a time */
+	OSMO_A5_BATCH_KERNEL_VEC128,
+	/*! x86 AVX2, 256 cipher streams at a time */
+	OSMO_A5_BATCH_KERNEL_AVX2,
+};
+
+extern const struct value_string osmo_a5_batch_kernel_names[];
+
+int osmo_a5_batch_kernel_set(enum osmo_a5_batch_kernel kernel);
+enum osmo_a5_batch_kernel osmo_a5_batch_kernel_get(void);
+unsigned int osmo_a5_batch_lanes(void);
+
+int osmo_a5_batch(int n, const uint8_t * const *keys, const uint32_t *fns,
+		  ubit_t * const *dl, ubit_t * const *ul, unsigned int num);
+
 /*! @} */
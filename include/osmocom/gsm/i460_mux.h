@@ -39,9 +39,9 @@ typedef void (*out_cb_bytes_t)(struct osmo_i460_subchan *schan, void *user_data,
 			       const uint8_t *bytes, unsigned int num_bytes);
 
 struct osmo_i460_subchan_demux {
-	/*! bit-buffer for output bits */
+	/*! bit-buffer for output bits; unpacked, or packed if there is only out_cb_bytes */
 	uint8_t *out_bitbuf;
-	/*! size of out_bitbuf in bytes */
+	/*! size of out_bitbuf in bits */
 	unsigned int out_bitbuf_size;
 	/*! offset of next bit to be written in out_bitbuf */
 	unsigned int out_idx;
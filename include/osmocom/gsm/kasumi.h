@@ -34,6 +34,18 @@ uint64_t _kasumi(uint64_t P, const uint16_t *KLi1, const uint16_t *KLi2, const u
  */
 void _kasumi_kgcore(uint8_t CA, uint8_t cb, uint32_t cc, uint8_t cd, const uint8_t *ck, uint8_t *co, uint16_t cl);
 
+/*! KGCORE of several (cc, ck) pairs at once, see _kasumi_kgcore()
+ *  \param[in] CA
+ *  \param[in] cb
+ *  \param[in] cc array of num count values
+ *  \param[in] cd
+ *  \param[in] ck array of num keys
+ *  \param[out] co array of num outputs, each cl-dependent
+ *  \param[in] cl
+ *  \param[in] num number of pairs
+ */
+void _kasumi_kgcore_multi(uint8_t CA, uint8_t cb, const uint32_t *cc, uint8_t cd, const uint8_t * const *ck, uint8_t * const *co, uint16_t cl, unsigned int num);
+
 /*! Expand key into set of subkeys - see TS 135 202 for details
  *  \param[in] key (128 bits) as array of bytes
  *  \param[out] KLi1 Expanded subkeys
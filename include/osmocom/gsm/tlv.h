@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 
 #include <osmocom/core/msgb.h>
@@ -46,6 +47,7 @@ enum osmo_tlv_parser_error {
 	OSMO_TLVP_ERR_OFS_BEYOND_BUFFER		= -1,
 	OSMO_TLVP_ERR_OFS_LEN_BEYOND_BUFFER	= -2,
 	OSMO_TLVP_ERR_UNKNOWN_TLV_TYPE		= -3,
+	OSMO_TLVP_ERR_TOO_MANY_IES		= -4,
 
 	OSMO_TLVP_ERR_MAND_IE_MISSING		= -50,
 	OSMO_TLVP_ERR_IE_TOO_SHORT		= -51,
@@ -642,6 +644,92 @@ static inline uint32_t tlvp_val32be(const struct tlv_parsed *tp, int pos)
 }
 
 
+/*! Maximum number of IEs (including repeated IEs) in a \ref tlv_parsed_compact */
+#define TLV_PARSED_COMPACT_MAX_IES	64
+
+/*! Compact result of the TLV parser.
+ *  Unlike \ref tlv_parsed, only the presence bitmap needs to be cleared before
+ *  parsing, and all occurrences of repeated IEs are kept.  Use the TLVPC_*()
+ *  accessors, which mirror the TLVP_*() ones. */
+struct tlv_parsed_compact {
+	/*! bitmap of tags present; bit (tag % 64) of present[tag / 64] */
+	uint64_t present[4];
+	/*! index into ie[] of the first occurrence of each tag; only valid if present */
+	uint8_t first[256];
+	/*! number of entries in tag[] and ie[] */
+	unsigned int num_ies;
+	/*! tag of each IE, in order of occurrence */
+	uint8_t tag[TLV_PARSED_COMPACT_MAX_IES];
+	/*! length and value of each IE, in order of occurrence */
+	struct tlv_p_entry ie[TLV_PARSED_COMPACT_MAX_IES];
+};
+
+/*! Determine whether an IE is present in a \ref tlv_parsed_compact
+ *  \param[in] tp pointer to \ref tlv_parsed_compact
+ *  \param[in] tag the Tag to look for
+ *  \returns true if at least one IE with \a tag is present */
+static inline bool tlvpc_present(const struct tlv_parsed_compact *tp, uint8_t tag)
+{
+	return tp->present[tag / 64] & ((uint64_t)1 << (tag % 64));
+}
+
+/*! Return pointer to the first occurrence of an IE in a \ref tlv_parsed_compact
+ *  \param[in] tp pointer to \ref tlv_parsed_compact
+ *  \param[in] tag the Tag to look for
+ *  \returns struct tlv_p_entry pointer, or NULL if not present */
+static inline const struct tlv_p_entry *tlvpc_get(const struct tlv_parsed_compact *tp, uint8_t tag)
+{
+	return tlvpc_present(tp, tag) ? &tp->ie[tp->first[tag]] : NULL;
+}
+
+const struct tlv_p_entry *tlvpc_get_nth(const struct tlv_parsed_compact *tp, uint8_t tag, unsigned int n);
+
+#define TLVPC_PRESENT(x, y)	tlvpc_present(x, y)
+#define TLVPC_LEN(x, y)		(tlvpc_present(x, y) ? (x)->ie[(x)->first[y]].len : 0)
+#define TLVPC_VAL(x, y)		(tlvpc_present(x, y) ? (x)->ie[(x)->first[y]].val : NULL)
+
+#define TLVPC_PRES_LEN(tp, tag, min_len) \
+	(TLVPC_PRESENT(tp, tag) && TLVPC_LEN(tp, tag) >= min_len)
+
+/*! Like TLVP_GET(), for \ref tlv_parsed_compact. */
+#define TLVPC_GET(_tp, tag)	tlvpc_get(_tp, tag)
+
+/*! Like TLVP_GET_MINLEN(), for \ref tlv_parsed_compact. */
+#define TLVPC_GET_MINLEN(_tp, tag, min_len) \
+	(TLVPC_PRES_LEN(_tp, tag, min_len)? tlvpc_get(_tp, tag) : NULL)
+
+/*! Like TLVP_VAL_MINLEN(), for \ref tlv_parsed_compact. */
+#define TLVPC_VAL_MINLEN(_tp, tag, min_len) \
+	(TLVPC_PRES_LEN(_tp, tag, min_len)? TLVPC_VAL(_tp, tag) : NULL)
+
+/*! Like tlvp_val8(), for \ref tlv_parsed_compact. */
+static inline uint8_t tlvpc_val8(const struct tlv_parsed_compact *tp, uint8_t tag, uint8_t default_val)
+{
+	const uint8_t *res = TLVPC_VAL_MINLEN(tp, tag, 1);
+
+	if (res)
+		return res[0];
+
+	return default_val;
+}
+
+/*! Like tlvp_val16be(), for \ref tlv_parsed_compact. */
+static inline uint16_t tlvpc_val16be(const struct tlv_parsed_compact *tp, uint8_t tag)
+{
+	return osmo_load16be(TLVPC_VAL(tp, tag));
+}
+
+/*! Like tlvp_val32be(), for \ref tlv_parsed_compact. */
+static inline uint32_t tlvpc_val32be(const struct tlv_parsed_compact *tp, uint8_t tag)
+{
+	return osmo_load32be(TLVPC_VAL(tp, tag));
+}
+
+int tlv_parse_compact(struct tlv_parsed_compact *dec, const struct tlv_definition *def,
+		      const uint8_t *buf, int buf_len, uint8_t lv_tag, uint8_t lv_tag2);
+void osmo_tlvpc_to_tlvp(struct tlv_parsed *dec, int dec_multiples, const struct tlv_parsed_compact *tpc);
+
+
 struct tlv_parsed *osmo_tlvp_copy(const struct tlv_parsed *tp_orig, void *ctx);
 int osmo_tlvp_merge(struct tlv_parsed *dst, const struct tlv_parsed *src);
 int osmo_shift_v_fixed(uint8_t **data, size_t *data_len,
@@ -699,6 +787,14 @@ int osmo_tlv_prot_parse(const struct osmo_tlv_prot_def *pdef,
 			const uint8_t *buf, unsigned int buf_len, uint8_t lv_tag, uint8_t lv_tag2,
 			int log_subsys, const char *log_pfx);
 
+int osmo_tlv_prot_validate_tpc(const struct osmo_tlv_prot_def *pdef, uint8_t msg_type,
+			       const struct tlv_parsed_compact *tp, int log_subsys, const char *log_pfx);
+
+int osmo_tlv_prot_parse_compact(const struct osmo_tlv_prot_def *pdef,
+				struct tlv_parsed_compact *dec, uint8_t msg_type,
+				const uint8_t *buf, unsigned int buf_len, uint8_t lv_tag, uint8_t lv_tag2,
+				int log_subsys, const char *log_pfx);
+
 static inline uint32_t osmo_tlv_prot_msgt_flags(const struct osmo_tlv_prot_def *pdef, uint8_t msg_type)
 {
 	return pdef->msg_def[msg_type].flags;
@@ -19,7 +19,7 @@
 #
 #   And defines:
 #
-#      HAVE_AVX3 / HAVE_SSSE3 / HAVE_SSE4.1
+#      HAVE_AVX3 / HAVE_SSSE3 / HAVE_SSE4.1 / HAVE_AVX512BW
 #
 # LICENSE
 #
@@ -44,6 +44,7 @@ AC_DEFUN([AX_CHECK_SIMD],
   AM_CONDITIONAL(HAVE_AVX2, false)
   AM_CONDITIONAL(HAVE_SSSE3, false)
   AM_CONDITIONAL(HAVE_SSE4_1, false)
+  AM_CONDITIONAL(HAVE_AVX512BW, false)
 
   case $host_cpu in
     i[[3456]]86*|x86_64*|amd64*)
@@ -76,6 +77,16 @@ AC_DEFUN([AX_CHECK_SIMD],
       else
         AC_MSG_WARN([Your compiler does not support SSE4.1 instructions])
       fi
+
+      AX_CHECK_COMPILE_FLAG(-mavx512bw, ax_cv_support_avx512bw_ext=yes, [])
+      if test x"$ax_cv_support_avx512bw_ext" = x"yes"; then
+        SIMD_FLAGS="$SIMD_FLAGS -mavx512bw"
+        AC_DEFINE(HAVE_AVX512BW,,
+          [Support AVX-512BW (AVX-512 Byte and Word) instructions])
+        AM_CONDITIONAL(HAVE_AVX512BW, true)
+      else
+        AC_MSG_WARN([Your compiler does not support AVX-512BW instructions])
+      fi
   ;;
   esac
 
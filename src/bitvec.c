@@ -40,6 +40,7 @@
 
 #include <osmocom/core/bits.h>
 #include <osmocom/core/bitvec.h>
+#include <osmocom/core/endian.h>
 #include <osmocom/core/panic.h>
 #include <osmocom/core/utils.h>
 
@@ -69,6 +70,122 @@ static uint8_t bitval2mask(enum bit_value bit, uint8_t bitnum)
 	}
 }
 
+/* the L/H padding pattern, so that an L bit equals the pattern bit and an
+ * H bit its inverse; any rotation by whole bits gives the pattern starting
+ * at that bit within a byte */
+#define LH_PATTERN	0x2b2b2b2b2b2b2b2bULL
+
+/* mask of the lowest len (1..64) bits */
+static inline uint64_t low_mask(unsigned int len)
+{
+	return ~(uint64_t)0 >> (64 - len);
+}
+
+/* the L/H pattern for len (1..64) bits starting at bit number bitnr */
+static inline uint64_t lh_pattern(unsigned int bitnr, unsigned int len)
+{
+	unsigned int rot = bitnr % 8;
+	uint64_t p = rot ? (LH_PATTERN << rot) | (LH_PATTERN >> (64 - rot)) : LH_PATTERN;
+
+	return p >> (64 - len);
+}
+
+/* unaligned big-endian 64 bit word load and store */
+static inline uint64_t load_be64(const uint8_t *p)
+{
+	uint64_t w;
+
+	memcpy(&w, p, sizeof(w));
+#if OSMO_IS_LITTLE_ENDIAN
+	w = __builtin_bswap64(w);
+#endif
+	return w;
+}
+
+static inline void store_be64(uint64_t w, uint8_t *p)
+{
+#if OSMO_IS_LITTLE_ENDIAN
+	w = __builtin_bswap64(w);
+#endif
+	memcpy(p, &w, sizeof(w));
+}
+
+/* Read len (1..64) bits MSB first, starting at bit number bitnr, using
+ * big-endian word loads.  The caller ensures that the bits are within the
+ * data_len bytes of data. */
+static inline uint64_t read_bits(const uint8_t *data, unsigned int data_len,
+			  unsigned int bitnr, unsigned int len)
+{
+	const uint8_t *p = data + bitnr / 8;
+	unsigned int avail = data_len - bitnr / 8;
+	unsigned int shift = bitnr % 8;
+	uint64_t w;
+
+	if (avail >= 8)
+		w = load_be64(p);
+	else if (data_len >= 8)
+		w = load_be64(data + data_len - 8) << (8 * (8 - avail));
+	else
+		w = osmo_load64be_ext(p, avail);
+	w <<= shift;
+	/* a 9th byte is only needed, and then present, for more than 56 bits */
+	if (shift + len > 64)
+		w |= p[8] >> (8 - shift);
+
+	return w >> (64 - len);
+}
+
+/* Write the lowest len (1..64) bits of val MSB first, starting at bit
+ * number bitnr, using big-endian word loads and stores.  The caller ensures
+ * that the bits are within the data_len bytes of data. */
+static void write_bits(uint8_t *data, unsigned int data_len,
+		       unsigned int bitnr, uint64_t val, unsigned int len)
+{
+	uint8_t *p = data + bitnr / 8;
+	unsigned int avail = data_len - bitnr / 8;
+	unsigned int shift = bitnr % 8;
+	unsigned int i, nbytes;
+	uint64_t mask, w;
+
+	if (shift + len > 64) {
+		/* spans 9 bytes: write the last 8 bits separately */
+		write_bits(data, data_len, bitnr, val >> 8, len - 8);
+		write_bits(data, data_len, bitnr + len - 8, val & 0xff, 8);
+		return;
+	}
+
+	mask = low_mask(len) << (64 - shift - len);
+	val = (val << (64 - shift - len)) & mask;
+
+	if (avail >= 8) {
+		w = load_be64(p);
+		store_be64((w & ~mask) | val, p);
+		return;
+	}
+
+	if (data_len >= 8) {
+		/* the last 8 bytes of data, which end with the field's bytes */
+		unsigned int s = 8 * (8 - avail);
+
+		p = data + data_len - 8;
+		w = load_be64(p);
+		store_be64((w & ~(mask >> s)) | (val >> s), p);
+		return;
+	}
+
+	nbytes = (shift + len + 7) / 8;
+	for (i = 0; i < nbytes; i++) {
+		unsigned int s = 56 - 8 * i;
+		p[i] = (p[i] & ~(uint8_t)(mask >> s)) | (uint8_t)(val >> s);
+	}
+}
+
+/* whether len bits starting at bit number bitnr are within the vector */
+static inline bool bits_fit(const struct bitvec *bv, unsigned int bitnr, unsigned int len)
+{
+	return bitnr <= bv->data_len * 8 && len <= bv->data_len * 8 - bitnr;
+}
+
 /*! check if the bit is 0 or 1 for a given position inside a bitvec
  *  \param[in] bv the bit vector on which to check
  *  \param[in] bitnr the bit number inside the bit vector to check
@@ -222,6 +339,15 @@ int bitvec_set_u64(struct bitvec *bv, uint64_t v, uint8_t num_bits, bool use_lh)
 	if (num_bits > 64)
 		return -E2BIG;
 
+	if (num_bits && bits_fit(bv, bv->cur_bit, num_bits)) {
+		if (use_lh)
+			v ^= lh_pattern(bv->cur_bit, num_bits);
+		write_bits(bv->data, bv->data_len, bv->cur_bit, v, num_bits);
+		bv->cur_bit += num_bits;
+		return 0;
+	}
+
+	/* bit by bit up to the end of the vector */
 	for (i = 0; i < num_bits; i++) {
 		int rc;
 		enum bit_value bit = use_lh ? L : 0;
@@ -264,6 +390,13 @@ int bitvec_get_uint(struct bitvec *bv, unsigned int num_bits)
 	unsigned int i;
 	unsigned int ui = 0;
 
+	if (num_bits && num_bits <= 32 && bits_fit(bv, bv->cur_bit, num_bits)) {
+		ui = read_bits(bv->data, bv->data_len, bv->cur_bit, num_bits);
+		bv->cur_bit += num_bits;
+		return ui;
+	}
+
+	/* bit by bit up to the end of the vector */
 	for (i = 0; i < num_bits; i++) {
 		int bit = bitvec_get_bit_pos(bv, bv->cur_bit);
 		if (bit < 0)
@@ -282,6 +415,19 @@ int bitvec_get_uint(struct bitvec *bv, unsigned int num_bits)
 int bitvec_fill(struct bitvec *bv, unsigned int num_bits, enum bit_value fill)
 {
 	unsigned i, stop = bv->cur_bit + num_bits;
+
+	if (bits_fit(bv, bv->cur_bit, num_bits) && fill >= ZERO && fill <= H) {
+		uint64_t v = (fill == ONE || fill == H) ? ~(uint64_t)0 : 0;
+
+		while (num_bits) {
+			unsigned int n = OSMO_MIN(num_bits, 64);
+
+			bitvec_set_u64(bv, v, n, fill == L || fill == H);
+			num_bits -= n;
+		}
+		return 0;
+	}
+
 	for (i = bv->cur_bit; i < stop; i++)
 		if (bitvec_set_bit(bv, fill) < 0)
 			return -EINVAL;
@@ -475,9 +621,13 @@ int bitvec_unhex(struct bitvec *bv, const char *src)
  */
 uint64_t bitvec_read_field(struct bitvec *bv, unsigned int *read_index, unsigned int len)
 {
-	unsigned int i;
 	uint64_t ui = 0;
 
+	if (len > 64) {
+		errno = E2BIG;
+		return 0;
+	}
+
 	/* Prevent bitvec overrun due to incorrect index and/or length */
 	if (len && bytenum_from_bitnum(*read_index + len - 1) >= bv->data_len) {
 		errno = EOVERFLOW;
@@ -487,13 +637,9 @@ uint64_t bitvec_read_field(struct bitvec *bv, unsigned int *read_index, unsigned
 	bv->cur_bit = *read_index;
 	errno = 0;
 
-	for (i = 0; i < len; i++) {
-		unsigned int bytenum = bytenum_from_bitnum(bv->cur_bit);
-		unsigned int bitnum = 7 - (bv->cur_bit % 8);
-
-		if (bv->data[bytenum] & (1 << bitnum))
-			ui |= ((uint64_t)1 << (len - i - 1));
-		bv->cur_bit++;
+	if (len) {
+		ui = read_bits(bv->data, bv->data_len, bv->cur_bit, len);
+		bv->cur_bit += len;
 	}
 	*read_index += len;
 	return ui;
@@ -520,6 +666,125 @@ int bitvec_write_field(struct bitvec *bv, unsigned int *write_index, uint64_t va
 	return 0;
 }
 
+/*! Initialize a cursor for reading and writing a bit vector
+ *  \param[out] c the cursor to initialize
+ *  \param[in] bv the bit vector to operate on
+ *  \param[in] bitnr number of the first bit to read or write
+ *
+ *  The cursor reads and writes fields of up to 64 bits per call with word
+ *  loads and stores, checking the bounds once per field.  It works on the
+ *  data of \a bv but doesn't update \a bv's cur_bit; to continue with the
+ *  other bitvec functions, set it to the cursor's pos. */
+void bitvec_cursor_init(struct bitvec_cursor *c, struct bitvec *bv, unsigned int bitnr)
+{
+	c->data = bv->data;
+	c->data_len = bv->data_len;
+	c->pos = bitnr;
+	c->err = 0;
+}
+
+/* Check a cursor access, recording the first error in c->err */
+static inline int cursor_check(struct bitvec_cursor *c, unsigned int num_bits)
+{
+	if (num_bits > 64) {
+		if (!c->err)
+			c->err = -E2BIG;
+		return -E2BIG;
+	}
+	if (c->pos > c->data_len * 8 || num_bits > c->data_len * 8 - c->pos) {
+		if (!c->err)
+			c->err = -EOVERFLOW;
+		return -EOVERFLOW;
+	}
+	return 0;
+}
+
+/*! Read a field at the cursor position, MSB first
+ *  \param[inout] c the cursor, advanced by \a num_bits on success
+ *  \param[in] num_bits number of bits to read (0..64)
+ *  \returns the bits read; 0 on error, in which case the cursor stays
+ *  	     where it is and c->err is set unless already set
+ *
+ *  c->err tells whether any of the accesses since bitvec_cursor_init()
+ *  failed, so that a decoder can check once after reading many fields. */
+uint64_t bitvec_cursor_read(struct bitvec_cursor *c, unsigned int num_bits)
+{
+	uint64_t v;
+
+	if (cursor_check(c, num_bits) || !num_bits)
+		return 0;
+
+	v = read_bits(c->data, c->data_len, c->pos, num_bits);
+	c->pos += num_bits;
+	return v;
+}
+
+/*! Write a field at the cursor position, MSB first
+ *  \param[inout] c the cursor, advanced by \a num_bits on success
+ *  \param[in] val value, whose lowest \a num_bits bits are written
+ *  \param[in] num_bits number of bits to write (0..64)
+ *  \returns 0 on success; negative on error, in which case nothing is
+ *  	     written and c->err is set unless already set */
+int bitvec_cursor_write(struct bitvec_cursor *c, uint64_t val, unsigned int num_bits)
+{
+	int rc = cursor_check(c, num_bits);
+
+	if (rc || !num_bits)
+		return rc;
+
+	write_bits(c->data, c->data_len, c->pos, val, num_bits);
+	c->pos += num_bits;
+	return 0;
+}
+
+/*! Write a field of CSN.1 L/H bits at the cursor position, MSB first
+ *  \param[inout] c the cursor, advanced by \a num_bits on success
+ *  \param[in] val value, whose lowest \a num_bits bits are written, a 1
+ *  	       as H and a 0 as L
+ *  \param[in] num_bits number of bits to write (0..64)
+ *  \returns 0 on success; negative on error, as for bitvec_cursor_write() */
+int bitvec_cursor_write_lh(struct bitvec_cursor *c, uint64_t val, unsigned int num_bits)
+{
+	int rc = cursor_check(c, num_bits);
+
+	if (rc || !num_bits)
+		return rc;
+
+	val ^= lh_pattern(c->pos, num_bits);
+	write_bits(c->data, c->data_len, c->pos, val, num_bits);
+	c->pos += num_bits;
+	return 0;
+}
+
+/*! Fill bits at the cursor position with the same value
+ *  \param[inout] c the cursor, advanced by \a num_bits on success
+ *  \param[in] num_bits number of bits to fill
+ *  \param[in] fill the value of all bits, e.g. L for spare padding
+ *  \returns 0 on success; negative on error, in which case nothing is
+ *  	     written and c->err is set unless already set */
+int bitvec_cursor_fill(struct bitvec_cursor *c, unsigned int num_bits, enum bit_value fill)
+{
+	uint64_t v = (fill == ONE || fill == H) ? ~(uint64_t)0 : 0;
+	bool lh = fill == L || fill == H;
+
+	if (c->pos > c->data_len * 8 || num_bits > c->data_len * 8 - c->pos) {
+		if (!c->err)
+			c->err = -EOVERFLOW;
+		return -EOVERFLOW;
+	}
+
+	while (num_bits) {
+		unsigned int n = OSMO_MIN(num_bits, 64);
+
+		if (lh)
+			bitvec_cursor_write_lh(c, v, n);
+		else
+			bitvec_cursor_write(c, v, n);
+		num_bits -= n;
+	}
+	return 0;
+}
+
 /*! convert enum to corresponding character
  *  \param v input value (bit)
  *  \return single character, either 0, 1, L or H */
@@ -0,0 +1,405 @@
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ *
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define _GNU_SOURCE
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/conv.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+
+#include <osmocom/gsm/gsm0503.h>
+
+#include <osmocom/coding/gsm0503_interleaving.h>
+#include <osmocom/coding/gsm0503_coding.h>
+#include <osmocom/coding/gsm0503_batch.h>
+
+#include "gsm0503_coding_internal.h"
+
+#if (!EMBEDDED)
+#include <pthread.h>
+#endif
+
+/*! \addtogroup coding
+ *  @{
+ *
+ * \file gsm0503_batch.c
+ * Decoding of many blocks at once, e.g. all the blocks a BTS received
+ * on all timeslots of a TDMA frame.
+ *
+ * The jobs passed to gsm0503_decode_batch() are spread across the
+ * threads of a gsm0503_decode_pool, the calling thread included.  xCCH
+ * blocks, which all use the same convolutional code, are additionally
+ * decoded osmo_conv_batch_lanes() at a time by osmo_conv_decode_batch().
+ * The results are the same as those of the single block functions.
+ */
+
+/* xCCH blocks decoded by one osmo_conv_decode_batch() call at most */
+#define XCCH_LANES_MAX	32
+
+struct gsm0503_decode_pool {
+#if (!EMBEDDED)
+	pthread_mutex_t lock;
+	/* signalled when a batch is started or the pool is stopped */
+	pthread_cond_t start_cond;
+	/* signalled when the last worker thread finished its part of a batch */
+	pthread_cond_t done_cond;
+	pthread_t *threads;
+	unsigned int num_threads;
+	/* incremented for every batch */
+	unsigned int gen;
+	/* number of worker threads still working on the current batch */
+	unsigned int busy;
+	bool stop;
+
+	/* the current batch: xCCH jobs first, in chunks of lanes, then the
+	 * others one by one */
+	struct gsm0503_decode_job **order;
+	unsigned int order_size;
+	unsigned int num_xcch;
+	unsigned int lanes;
+	unsigned int num_chunks;
+	unsigned int num_items;
+	/* next work item to be claimed by a thread */
+	unsigned int next_item;
+#endif
+};
+
+static void decode_job(struct gsm0503_decode_job *job)
+{
+	job->n_errors = 0;
+	job->n_bits_total = 0;
+	job->usf = 0;
+
+	switch (job->chan) {
+	case GSM0503_DECODE_XCCH:
+		job->rc = gsm0503_xcch_decode(job->data, job->bursts,
+			&job->n_errors, &job->n_bits_total);
+		break;
+	case GSM0503_DECODE_PDTCH:
+		job->rc = gsm0503_pdtch_decode(job->data, job->bursts, &job->usf,
+			&job->n_errors, &job->n_bits_total);
+		break;
+	case GSM0503_DECODE_PDTCH_EGPRS:
+		job->rc = gsm0503_pdtch_egprs_decode(job->data, job->bursts,
+			job->u.pdtch_egprs.nbits, &job->usf,
+			&job->n_errors, &job->n_bits_total);
+		break;
+	case GSM0503_DECODE_TCH_FR:
+		job->rc = gsm0503_tch_fr_decode(job->data, job->bursts,
+			job->u.tch_fr.net_order, job->u.tch_fr.efr,
+			&job->n_errors, &job->n_bits_total);
+		break;
+	case GSM0503_DECODE_TCH_HR:
+		job->rc = gsm0503_tch_hr_decode(job->data, job->bursts,
+			job->u.tch_hr.odd, &job->n_errors, &job->n_bits_total);
+		break;
+	case GSM0503_DECODE_TCH_AFS:
+		job->rc = gsm0503_tch_afs_decode_dtx(job->data, job->bursts,
+			job->u.amr.codec_mode_req, job->u.amr.codec,
+			job->u.amr.codecs, job->u.amr.ft, job->u.amr.cmr,
+			&job->n_errors, &job->n_bits_total, job->u.amr.dtx);
+		break;
+	case GSM0503_DECODE_TCH_AHS:
+		job->rc = gsm0503_tch_ahs_decode_dtx(job->data, job->bursts,
+			job->u.amr.odd, job->u.amr.codec_mode_req,
+			job->u.amr.codec, job->u.amr.codecs, job->u.amr.ft,
+			job->u.amr.cmr, &job->n_errors, &job->n_bits_total,
+			job->u.amr.dtx);
+		break;
+	default:
+		job->rc = -EINVAL;
+		break;
+	}
+}
+
+/* Decode up to XCCH_LANES_MAX xCCH blocks, sharing the trellis passes */
+static void decode_xcch_chunk(struct gsm0503_decode_job **jobs, unsigned int num)
+{
+	sbit_t cB[XCCH_LANES_MAX][456];
+	ubit_t conv[XCCH_LANES_MAX][224];
+	const sbit_t *in[XCCH_LANES_MAX] = { NULL };
+	ubit_t *out[XCCH_LANES_MAX] = { NULL };
+	unsigned int i;
+
+	OSMO_ASSERT(num <= XCCH_LANES_MAX);
+
+	if (num == 1) {
+		decode_job(jobs[0]);
+		return;
+	}
+
+	for (i = 0; i < num; i++) {
+		gsm0503_xcch_burst_unmap_deinterleave(cB[i], jobs[i]->bursts);
+		in[i] = cB[i];
+		out[i] = conv[i];
+	}
+
+	osmo_conv_decode_batch(&gsm0503_xcch, in, out, num);
+
+	for (i = 0; i < num; i++) {
+		struct gsm0503_decode_job *job = jobs[i];
+
+		job->usf = 0;
+		job->rc = _gsm0503_xcch_decode_conv(job->data, cB[i], conv[i],
+			&job->n_errors, &job->n_bits_total);
+	}
+}
+
+static unsigned int xcch_lanes(void)
+{
+	return OSMO_MIN(osmo_conv_batch_lanes(), XCCH_LANES_MAX);
+}
+
+/* Decode all jobs in the calling thread */
+static void decode_serial(struct gsm0503_decode_job *jobs, unsigned int num)
+{
+	struct gsm0503_decode_job *chunk[XCCH_LANES_MAX];
+	unsigned int i, n = 0, lanes = xcch_lanes();
+
+	for (i = 0; i < num; i++) {
+		if (jobs[i].chan != GSM0503_DECODE_XCCH) {
+			decode_job(&jobs[i]);
+			continue;
+		}
+		chunk[n++] = &jobs[i];
+		if (n == lanes) {
+			decode_xcch_chunk(chunk, n);
+			n = 0;
+		}
+	}
+
+	if (n)
+		decode_xcch_chunk(chunk, n);
+}
+
+#if (!EMBEDDED)
+
+static void decode_item(struct gsm0503_decode_pool *pool, unsigned int item)
+{
+	unsigned int first;
+
+	if (item < pool->num_chunks) {
+		first = item * pool->lanes;
+		decode_xcch_chunk(&pool->order[first],
+			OSMO_MIN(pool->num_xcch - first, pool->lanes));
+	} else {
+		decode_job(pool->order[pool->num_xcch + item - pool->num_chunks]);
+	}
+}
+
+/* Claim and decode work items of the current batch until none are left */
+static void decode_items(struct gsm0503_decode_pool *pool)
+{
+	unsigned int item;
+
+	while ((item = __atomic_fetch_add(&pool->next_item, 1, __ATOMIC_RELAXED)) < pool->num_items)
+		decode_item(pool, item);
+}
+
+static void *worker_main(void *arg)
+{
+	struct gsm0503_decode_pool *pool = arg;
+	unsigned int gen = 0;
+
+#ifdef HAVE_PTHREAD_GETNAME_NP
+	pthread_setname_np(pthread_self(), "gsm0503_decode");
+#endif
+
+	pthread_mutex_lock(&pool->lock);
+	while (1) {
+		while (!pool->stop && pool->gen == gen)
+			pthread_cond_wait(&pool->start_cond, &pool->lock);
+		if (pool->stop)
+			break;
+		gen = pool->gen;
+		pthread_mutex_unlock(&pool->lock);
+
+		decode_items(pool);
+
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->busy == 0)
+			pthread_cond_signal(&pool->done_cond);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+static void pool_stop(struct gsm0503_decode_pool *pool)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->start_cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->num_threads; i++)
+		pthread_join(pool->threads[i], NULL);
+	pool->num_threads = 0;
+}
+
+static int decode_parallel(struct gsm0503_decode_pool *pool,
+	struct gsm0503_decode_job *jobs, unsigned int num)
+{
+	unsigned int i, x, o;
+
+	if (num > pool->order_size) {
+		struct gsm0503_decode_job **order;
+
+		order = talloc_realloc(pool, pool->order, struct gsm0503_decode_job *, num);
+		if (!order)
+			return -ENOMEM;
+		pool->order = order;
+		pool->order_size = num;
+	}
+
+	for (i = 0, x = 0; i < num; i++)
+		x += jobs[i].chan == GSM0503_DECODE_XCCH;
+	for (i = 0, o = x, x = 0; i < num; i++) {
+		if (jobs[i].chan == GSM0503_DECODE_XCCH)
+			pool->order[x++] = &jobs[i];
+		else
+			pool->order[o++] = &jobs[i];
+	}
+
+	pool->num_xcch = x;
+	pool->lanes = xcch_lanes();
+	pool->num_chunks = (x + pool->lanes - 1) / pool->lanes;
+	pool->num_items = pool->num_chunks + num - x;
+	pool->next_item = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->gen++;
+	pool->busy = pool->num_threads;
+	pthread_cond_broadcast(&pool->start_cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	decode_items(pool);
+
+	pthread_mutex_lock(&pool->lock);
+	while (pool->busy)
+		pthread_cond_wait(&pool->done_cond, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+
+	return 0;
+}
+
+#endif /* !EMBEDDED */
+
+/*! Allocate a pool of threads for gsm0503_decode_batch()
+ *  \param[in] ctx talloc context to allocate the pool from
+ *  \param[in] num_threads number of worker threads in addition to the
+ *  	       thread calling gsm0503_decode_batch(); 0 decodes in the
+ *  	       calling thread only
+ *  \returns the pool; NULL on error, with errno set
+ *
+ *  Without thread support (embedded builds), num_threads is ignored. */
+struct gsm0503_decode_pool *gsm0503_decode_pool_alloc(void *ctx, unsigned int num_threads)
+{
+	struct gsm0503_decode_pool *pool;
+#if (!EMBEDDED)
+	unsigned int i;
+	int rc;
+#endif
+
+	pool = talloc_zero(ctx, struct gsm0503_decode_pool);
+	if (!pool) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+#if (!EMBEDDED)
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start_cond, NULL);
+	pthread_cond_init(&pool->done_cond, NULL);
+
+	if (!num_threads)
+		return pool;
+
+	pool->threads = talloc_array(pool, pthread_t, num_threads);
+	if (!pool->threads) {
+		gsm0503_decode_pool_free(pool);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	for (i = 0; i < num_threads; i++) {
+		rc = pthread_create(&pool->threads[i], NULL, worker_main, pool);
+		if (rc) {
+			gsm0503_decode_pool_free(pool);
+			errno = rc;
+			return NULL;
+		}
+		pool->num_threads++;
+	}
+#endif
+
+	return pool;
+}
+
+/*! Stop the threads of a pool and free it
+ *  \param[in] pool the pool to free; may be NULL */
+void gsm0503_decode_pool_free(struct gsm0503_decode_pool *pool)
+{
+	if (!pool)
+		return;
+
+#if (!EMBEDDED)
+	pool_stop(pool);
+	pthread_cond_destroy(&pool->done_cond);
+	pthread_cond_destroy(&pool->start_cond);
+	pthread_mutex_destroy(&pool->lock);
+#endif
+
+	talloc_free(pool);
+}
+
+/*! Decode a batch of blocks of any channel types
+ *  \param[in] pool threads to decode with; NULL to decode in the calling
+ *  	       thread only
+ *  \param[inout] jobs blocks to decode, receiving the results
+ *  \param[in] num number of jobs
+ *  \returns 0 on success, with the result of each block in its job;
+ *  	     negative on error, in which case no job was decoded
+ *
+ *  Each job receives the return value, the number of bit errors and the
+ *  number of coded bits of the decoding function selected by its channel
+ *  type, rc being -EINVAL for an unknown channel type.  The function
+ *  returns when all jobs are decoded.  It must not be called concurrently
+ *  for the same pool. */
+int gsm0503_decode_batch(struct gsm0503_decode_pool *pool,
+	struct gsm0503_decode_job *jobs, unsigned int num)
+{
+#if (!EMBEDDED)
+	if (pool && pool->num_threads && num > 1)
+		return decode_parallel(pool, jobs, num);
+#endif
+
+	decode_serial(jobs, num);
+	return 0;
+}
+
+/*! @} */
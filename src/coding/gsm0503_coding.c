@@ -45,6 +45,8 @@
 #include <osmocom/coding/gsm0503_parity.h>
 #include <osmocom/coding/gsm0503_amr_dtx.h>
 
+#include "gsm0503_coding_internal.h"
+
 /*! \mainpage libosmocoding Documentation
  *
  * \section sec_intro Introduction
@@ -102,6 +104,32 @@
  *
  * \file gsm0503_coding.c */
 
+/* Lookup tables for the table-driven CRC computation of the codes in gsm0503_parity.c */
+static struct osmo_crc64gen_table gsm0503_fire_crc40_tbl;
+static struct osmo_crc16gen_table gsm0503_cs234_crc16_tbl;
+static struct osmo_crc8gen_table gsm0503_mcs_crc8_hdr_tbl;
+static struct osmo_crc16gen_table gsm0503_mcs_crc12_tbl;
+static struct osmo_crc8gen_table gsm0503_rach_crc6_tbl;
+static struct osmo_crc16gen_table gsm0503_sch_crc10_tbl;
+static struct osmo_crc8gen_table gsm0503_tch_fr_crc3_tbl;
+static struct osmo_crc8gen_table gsm0503_tch_efr_crc8_tbl;
+static struct osmo_crc8gen_table gsm0503_amr_crc6_tbl;
+static struct osmo_crc16gen_table gsm0503_amr_crc14_tbl;
+
+static __attribute__((constructor)) void on_dso_load_gsm0503_crc(void)
+{
+	osmo_crc64gen_table_init(&gsm0503_fire_crc40_tbl, &gsm0503_fire_crc40);
+	osmo_crc16gen_table_init(&gsm0503_cs234_crc16_tbl, &gsm0503_cs234_crc16);
+	osmo_crc8gen_table_init(&gsm0503_mcs_crc8_hdr_tbl, &gsm0503_mcs_crc8_hdr);
+	osmo_crc16gen_table_init(&gsm0503_mcs_crc12_tbl, &gsm0503_mcs_crc12);
+	osmo_crc8gen_table_init(&gsm0503_rach_crc6_tbl, &gsm0503_rach_crc6);
+	osmo_crc16gen_table_init(&gsm0503_sch_crc10_tbl, &gsm0503_sch_crc10);
+	osmo_crc8gen_table_init(&gsm0503_tch_fr_crc3_tbl, &gsm0503_tch_fr_crc3);
+	osmo_crc8gen_table_init(&gsm0503_tch_efr_crc8_tbl, &gsm0503_tch_efr_crc8);
+	osmo_crc8gen_table_init(&gsm0503_amr_crc6_tbl, &gsm0503_amr_crc6);
+	osmo_crc16gen_table_init(&gsm0503_amr_crc14_tbl, &gsm0503_amr_crc14);
+}
+
 /*
  * EGPRS coding limits
  */
@@ -525,26 +553,24 @@ const struct gsm0503_mcs_code gsm0503_mcs_dl_codes[EGPRS_NUM_MCS] = {
 	},
 };
 
-/*! Convolutional Decode + compute BER for punctured codes
+/*! Compute the BER of a convolutional decoding by re-encoding its output
  *  \param[in] code Description of Convolutional Code
- *  \param[in] input Input soft-bits (-127...127)
- *  \param[out] output bits
+ *  \param[in] input Input soft-bits (-127...127) the output was decoded from
+ *  \param[in] output decoded bits
  *  \param[out] n_errors Number of bit-errors
  *  \param[out] n_bits_total Number of bits
  *  \param[in] data_punc Puncturing mask array. Can be NULL.
  */
-static int osmo_conv_decode_ber_punctured(const struct osmo_conv_code *code,
-	const sbit_t *input, ubit_t *output,
+static void osmo_conv_ber_punctured(const struct osmo_conv_code *code,
+	const sbit_t *input, const ubit_t *output,
 	int *n_errors, int *n_bits_total,
 	const uint8_t *data_punc)
 {
-	int res, i, coded_len;
+	int i, coded_len;
 	ubit_t recoded[EGPRS_DATA_C_MAX];
 
-	res = osmo_conv_decode(code, input, output);
-
 	if (!n_bits_total && !n_errors)
-		return res;
+		return;
 
 	coded_len = osmo_conv_encode(code, output, recoded);
 	OSMO_ASSERT(ARRAY_SIZE(recoded) >= coded_len);
@@ -562,6 +588,26 @@ static int osmo_conv_decode_ber_punctured(const struct osmo_conv_code *code,
 
 	if (n_bits_total)
 		*n_bits_total = coded_len;
+}
+
+/*! Convolutional Decode + compute BER for punctured codes
+ *  \param[in] code Description of Convolutional Code
+ *  \param[in] input Input soft-bits (-127...127)
+ *  \param[out] output bits
+ *  \param[out] n_errors Number of bit-errors
+ *  \param[out] n_bits_total Number of bits
+ *  \param[in] data_punc Puncturing mask array. Can be NULL.
+ */
+static int osmo_conv_decode_ber_punctured(const struct osmo_conv_code *code,
+	const sbit_t *input, ubit_t *output,
+	int *n_errors, int *n_bits_total,
+	const uint8_t *data_punc)
+{
+	int res;
+
+	res = osmo_conv_decode(code, input, output);
+	osmo_conv_ber_punctured(code, input, output,
+		n_errors, n_bits_total, data_punc);
 
 	return res;
 }
@@ -591,12 +637,30 @@ static int _xcch_decode_cB(uint8_t *l2_data, const sbit_t *cB,
 	int *n_errors, int *n_bits_total)
 {
 	ubit_t conv[224];
+
+	osmo_conv_decode(&gsm0503_xcch, cB, conv);
+
+	return _gsm0503_xcch_decode_conv(l2_data, cB, conv,
+		n_errors, n_bits_total);
+}
+
+/*! Finish decoding an xCCH block whose coded bits were already
+ *  convolutionally decoded, e.g. by osmo_conv_decode_batch()
+ *  \param[out] l2_data caller-allocated buffer for L2 Frame
+ *  \param[in] cB 456 coded (soft) bits as per TS 05.03 4.1.3
+ *  \param[in] conv 224 bits decoded from cB
+ *  \param[out] n_errors Number of detected errors
+ *  \param[out] n_bits_total Number of total coded bits
+ *  \returns 0 on success; -1 on CRC error */
+int _gsm0503_xcch_decode_conv(uint8_t *l2_data, const sbit_t *cB,
+	const ubit_t *conv, int *n_errors, int *n_bits_total)
+{
 	int rv;
 
-	osmo_conv_decode_ber(&gsm0503_xcch, cB,
-		conv, n_errors, n_bits_total);
+	osmo_conv_ber_punctured(&gsm0503_xcch, cB, conv,
+		n_errors, n_bits_total, NULL);
 
-	rv = osmo_crc64gen_check_bits(&gsm0503_fire_crc40,
+	rv = osmo_crc64gen_check_bits_tbl(&gsm0503_fire_crc40_tbl,
 		conv, 184, conv + 184);
 	if (rv)
 		return -1;
@@ -616,7 +680,7 @@ static int _xcch_encode_cB(ubit_t *cB, const uint8_t *l2_data)
 
 	osmo_pbit2ubit_ext(conv, 0, l2_data, 0, 184, 1);
 
-	osmo_crc64gen_set_bits(&gsm0503_fire_crc40, conv, 184, conv + 184);
+	osmo_crc64gen_set_bits_tbl(&gsm0503_fire_crc40_tbl, conv, 184, conv + 184);
 
 	osmo_conv_encode(&gsm0503_xcch, conv, cB);
 
@@ -636,13 +700,9 @@ static int _xcch_encode_cB(ubit_t *cB, const uint8_t *l2_data)
 int gsm0503_xcch_decode(uint8_t *l2_data, const sbit_t *bursts,
 	int *n_errors, int *n_bits_total)
 {
-	sbit_t iB[456], cB[456];
-	int i;
-
-	for (i = 0; i < 4; i++)
-		gsm0503_xcch_burst_unmap(&iB[i * 114], &bursts[i * 116], NULL, NULL);
+	sbit_t cB[456];
 
-	gsm0503_xcch_deinterleave(cB, iB);
+	gsm0503_xcch_burst_unmap_deinterleave(cB, bursts);
 
 	return _xcch_decode_cB(l2_data, cB, n_errors, n_bits_total);
 }
@@ -740,15 +800,73 @@ static int egprs_type1_unmap(const sbit_t *bursts, sbit_t *hc,
 	return 0;
 }
 
+/*
+ * Burst positions of the EGPRS UL header and data bits
+ *
+ * For each bit of the header (hc) and data (dc, or c1 followed by c2 for
+ * MCS-7,8,9) sections, the position of the soft bit in the bursts it is
+ * unmapped and deinterleaved from. The decoder uses them to depuncture the
+ * sections directly from the bursts, so that the burst data is read once
+ * instead of being copied by unmapping, deinterleaving and depuncturing.
+ *
+ * The positions are derived from the unmapping functions above when the
+ * library is loaded: running them on bursts which hold bit b of the burst
+ * position of each soft bit yields bit b of the position of each output bit.
+ */
+struct egprs_ul_pos {
+	uint16_t hc[EGPRS_HDR_HC_MAX];
+	uint16_t dc[EGPRS_DATA_DC_MAX];
+};
+
+static struct egprs_ul_pos egprs_ul_pos_type3;
+static struct egprs_ul_pos egprs_ul_pos_type2;
+static struct egprs_ul_pos egprs_ul_pos_mcs7;
+static struct egprs_ul_pos egprs_ul_pos_mcs89;
+
+static void egprs_ul_pos_init(struct egprs_ul_pos *pos, int mcs)
+{
+	sbit_t bursts[GSM0503_EGPRS_BURSTS_NBITS];
+	sbit_t hc[EGPRS_HDR_HC_MAX] = { 0 }, dc[EGPRS_DATA_DC_MAX] = { 0 };
+	int b, i;
+
+	memset(pos, 0, sizeof(*pos));
+
+	for (b = 0; (1 << b) < GSM0503_EGPRS_BURSTS_NBITS; b++) {
+		for (i = 0; i < GSM0503_EGPRS_BURSTS_NBITS; i++)
+			bursts[i] = (i >> b) & 1;
+
+		if (mcs <= EGPRS_MCS4)
+			egprs_type3_unmap(bursts, hc, dc);
+		else if (mcs <= EGPRS_MCS6)
+			egprs_type2_unmap(bursts, hc, dc);
+		else
+			egprs_type1_unmap(bursts, hc, dc, dc + EGPRS_DATA_C1, mcs);
+
+		for (i = 0; i < EGPRS_HDR_HC_MAX; i++)
+			pos->hc[i] |= (hc[i] & 1) << b;
+		for (i = 0; i < EGPRS_DATA_DC_MAX; i++)
+			pos->dc[i] |= (dc[i] & 1) << b;
+	}
+}
+
+static __attribute__((constructor)) void on_dso_load_gsm0503_egprs(void)
+{
+	egprs_ul_pos_init(&egprs_ul_pos_type3, EGPRS_MCS1);
+	egprs_ul_pos_init(&egprs_ul_pos_type2, EGPRS_MCS5);
+	egprs_ul_pos_init(&egprs_ul_pos_mcs7, EGPRS_MCS7);
+	egprs_ul_pos_init(&egprs_ul_pos_mcs89, EGPRS_MCS8);
+}
+
 /*
  * Decode EGPRS UL header section
  *
- * 1. Depuncture
+ * 1. Unmapping, deinterleaving and depuncturing, gathering the bits at the
+ *    burst positions pos
  * 2. Convolutional decoding
  * 3. CRC check
  */
-static int _egprs_decode_hdr(const sbit_t *hc, int mcs,
-	union gprs_rlc_ul_hdr_egprs *hdr)
+static int _egprs_decode_hdr(const sbit_t *bursts, const uint16_t *pos,
+	int mcs, union gprs_rlc_ul_hdr_egprs *hdr)
 {
 	sbit_t C[EGPRS_HDR_C_MAX];
 	ubit_t upp[EGPRS_HDR_UPP_MAX];
@@ -759,7 +877,8 @@ static int _egprs_decode_hdr(const sbit_t *hc, int mcs,
 
 	/* Skip depuncturing on MCS-5,6 header */
 	if ((mcs == EGPRS_MCS5) || (mcs == EGPRS_MCS6)) {
-		memcpy(C, hc, code->hdr_code_len);
+		for (i = 0; i < code->hdr_code_len; i++)
+			C[i] = bursts[pos[i]];
 		goto hdr_conv_decode;
 	}
 
@@ -773,14 +892,14 @@ static int _egprs_decode_hdr(const sbit_t *hc, int mcs,
 
 	for (; i >= 0; i--) {
 		if (!code->hdr_punc[i])
-			C[i] = hc[j--];
+			C[i] = bursts[pos[j--]];
 		else
 			C[i] = 0;
 	}
 
 hdr_conv_decode:
 	osmo_conv_decode_ber(code->hdr_conv, C, upp, NULL, NULL);
-	rc = osmo_crc8gen_check_bits(&gsm0503_mcs_crc8_hdr, upp,
+	rc = osmo_crc8gen_check_bits_tbl(&gsm0503_mcs_crc8_hdr_tbl, upp,
 		code->hdr_len, upp + code->hdr_len);
 	if (rc)
 		return -1;
@@ -799,24 +918,20 @@ static int egprs_decode_hdr(union gprs_rlc_ul_hdr_egprs *hdr,
 	const sbit_t *bursts, uint16_t nbits)
 {
 	int rc;
-	sbit_t hc[EGPRS_HDR_HC_MAX];
 
 	if (nbits == GSM0503_GPRS_BURSTS_NBITS) {
 		/* MCS-1,2,3,4 */
-		egprs_type3_unmap(bursts, hc, NULL);
-		rc = _egprs_decode_hdr(hc, EGPRS_MCS1, hdr);
+		rc = _egprs_decode_hdr(bursts, egprs_ul_pos_type3.hc, EGPRS_MCS1, hdr);
 		if (!rc)
 			return EGPRS_HDR_TYPE3;
 	} else if (nbits == GSM0503_EGPRS_BURSTS_NBITS) {
 		/* MCS-5,6 */
-		egprs_type2_unmap(bursts, hc, NULL);
-		rc = _egprs_decode_hdr(hc, EGPRS_MCS5, hdr);
+		rc = _egprs_decode_hdr(bursts, egprs_ul_pos_type2.hc, EGPRS_MCS5, hdr);
 		if (!rc)
 			return EGPRS_HDR_TYPE2;
 
 		/* MCS-7,8,9 */
-		egprs_type1_unmap(bursts, hc, NULL, NULL, EGPRS_MCS7);
-		rc = _egprs_decode_hdr(hc, EGPRS_MCS7, hdr);
+		rc = _egprs_decode_hdr(bursts, egprs_ul_pos_mcs7.hc, EGPRS_MCS7, hdr);
 		if (!rc)
 			return EGPRS_HDR_TYPE1;
 	}
@@ -856,13 +971,15 @@ static int egprs_parse_ul_cps(struct egprs_cps *cps,
 /*
  * Decode EGPRS UL data section
  *
- * 1. Depuncture
+ * 1. Unmapping, deinterleaving and depuncturing, gathering the bits at the
+ *    burst positions pos
  * 2. Convolutional decoding
  * 3. CRC check
  * 4. Block combining (MCS-7,8,9 only)
  */
-static int egprs_decode_data(uint8_t *l2_data, const sbit_t *c,
-	int mcs, int p, int blk, int *n_errors, int *n_bits_total)
+static int egprs_decode_data(uint8_t *l2_data, const sbit_t *bursts,
+	const uint16_t *pos, int mcs, int p, int blk, int *n_errors,
+	int *n_bits_total)
 {
 	ubit_t u[EGPRS_DATA_U_MAX];
 	sbit_t C[EGPRS_DATA_C_MAX];
@@ -895,14 +1012,14 @@ static int egprs_decode_data(uint8_t *l2_data, const sbit_t *c,
 
 	for (; i >= 0; i--) {
 		if (!code->data_punc[p][i])
-			C[i] = c[j--];
+			C[i] = bursts[pos[j--]];
 		else
 			C[i] = 0;
 	}
 
 	osmo_conv_decode_ber_punctured(code->data_conv, C, u,
 		n_errors, n_bits_total, code->data_punc[p]);
-	rc = osmo_crc16gen_check_bits(&gsm0503_mcs_crc12, u,
+	rc = osmo_crc16gen_check_bits_tbl(&gsm0503_mcs_crc12_tbl, u,
 		data_len, u + data_len);
 	if (rc)
 		return -1;
@@ -930,8 +1047,7 @@ static int egprs_decode_data(uint8_t *l2_data, const sbit_t *c,
 int gsm0503_pdtch_egprs_decode(uint8_t *l2_data, const sbit_t *bursts, uint16_t nbits,
 	uint8_t *usf_p, int *n_errors, int *n_bits_total)
 {
-	sbit_t dc[EGPRS_DATA_DC_MAX];
-	sbit_t c1[EGPRS_DATA_C1], c2[EGPRS_DATA_C2];
+	const struct egprs_ul_pos *pos;
 	int type, rc;
 	struct egprs_cps cps;
 	union gprs_rlc_ul_hdr_egprs *hdr;
@@ -959,16 +1075,18 @@ int gsm0503_pdtch_egprs_decode(uint8_t *l2_data, const sbit_t *bursts, uint16_t
 	case EGPRS_MCS2:
 	case EGPRS_MCS3:
 	case EGPRS_MCS4:
-		egprs_type3_unmap(bursts, NULL, dc);
+		pos = &egprs_ul_pos_type3;
 		break;
 	case EGPRS_MCS5:
 	case EGPRS_MCS6:
-		egprs_type2_unmap(bursts, NULL, dc);
+		pos = &egprs_ul_pos_type2;
 		break;
 	case EGPRS_MCS7:
+		pos = &egprs_ul_pos_mcs7;
+		break;
 	case EGPRS_MCS8:
 	case EGPRS_MCS9:
-		egprs_type1_unmap(bursts, NULL, c1, c2, cps.mcs);
+		pos = &egprs_ul_pos_mcs89;
 		break;
 	default:
 		/* Invalid MCS-X */
@@ -977,8 +1095,8 @@ int gsm0503_pdtch_egprs_decode(uint8_t *l2_data, const sbit_t *bursts, uint16_t
 
 	/* Decode MCS-X block, where X = cps.mcs */
 	if (cps.mcs < EGPRS_MCS7) {
-		rc = egprs_decode_data(l2_data, dc, cps.mcs, cps.p[0],
-			0, n_errors, n_bits_total);
+		rc = egprs_decode_data(l2_data, bursts, pos->dc, cps.mcs,
+			cps.p[0], 0, n_errors, n_bits_total);
 		if (rc < 0)
 			return -EFAULT;
 	} else {
@@ -986,14 +1104,15 @@ int gsm0503_pdtch_egprs_decode(uint8_t *l2_data, const sbit_t *bursts, uint16_t
 		int n_errors2, n_bits_total2;
 
 		/* MCS-7,8,9 block 1 */
-		rc = egprs_decode_data(l2_data, c1, cps.mcs, cps.p[0],
-			0, n_errors, n_bits_total);
+		rc = egprs_decode_data(l2_data, bursts, pos->dc, cps.mcs,
+			cps.p[0], 0, n_errors, n_bits_total);
 		if (rc < 0)
 			return -EFAULT;
 
 		/* MCS-7,8,9 block 2 */
-		rc = egprs_decode_data(l2_data, c2, cps.mcs, cps.p[1],
-			1, &n_errors2, &n_bits_total2);
+		rc = egprs_decode_data(l2_data, bursts,
+			pos->dc + EGPRS_DATA_C1, cps.mcs, cps.p[1], 1,
+			&n_errors2, &n_bits_total2);
 		if (n_errors)
 			*n_errors += n_errors2;
 		if (n_bits_total)
@@ -1019,12 +1138,12 @@ int gsm0503_pdtch_egprs_decode(uint8_t *l2_data, const sbit_t *bursts, uint16_t
 int gsm0503_pdtch_decode(uint8_t *l2_data, const sbit_t *bursts, uint8_t *usf_p,
 	int *n_errors, int *n_bits_total)
 {
-	sbit_t iB[456], cB[676], hl_hn[8];
+	sbit_t cB[676], hl_hn[8];
 	ubit_t conv[456];
 	int i, j, k, rv, best = 0, cs = 0, usf = 0; /* make GCC happy */
 
 	for (i = 0; i < 4; i++)
-		gsm0503_xcch_burst_unmap(&iB[i * 114], &bursts[i * 116],
+		gsm0503_xcch_burst_unmap(NULL, &bursts[i * 116],
 			hl_hn + i * 2, hl_hn + i * 2 + 1);
 
 	for (i = 0; i < 4; i++) {
@@ -1037,14 +1156,14 @@ int gsm0503_pdtch_decode(uint8_t *l2_data, const sbit_t *bursts, uint8_t *usf_p,
 		}
 	}
 
-	gsm0503_xcch_deinterleave(cB, iB);
+	gsm0503_xcch_burst_unmap_deinterleave(cB, bursts);
 
 	switch (cs) {
 	case 1:
 		osmo_conv_decode_ber(&gsm0503_xcch, cB,
 			conv, n_errors, n_bits_total);
 
-		rv = osmo_crc64gen_check_bits(&gsm0503_fire_crc40,
+		rv = osmo_crc64gen_check_bits_tbl(&gsm0503_fire_crc40_tbl,
 			conv, 184, conv + 184);
 		if (rv)
 			return -1;
@@ -1079,7 +1198,7 @@ int gsm0503_pdtch_decode(uint8_t *l2_data, const sbit_t *bursts, uint8_t *usf_p,
 		if (usf_p)
 			*usf_p = usf;
 
-		rv = osmo_crc16gen_check_bits(&gsm0503_cs234_crc16,
+		rv = osmo_crc16gen_check_bits_tbl(&gsm0503_cs234_crc16_tbl,
 			conv + 3, 271, conv + 3 + 271);
 		if (rv)
 			return -1;
@@ -1114,7 +1233,7 @@ int gsm0503_pdtch_decode(uint8_t *l2_data, const sbit_t *bursts, uint8_t *usf_p,
 		if (usf_p)
 			*usf_p = usf;
 
-		rv = osmo_crc16gen_check_bits(&gsm0503_cs234_crc16,
+		rv = osmo_crc16gen_check_bits_tbl(&gsm0503_cs234_crc16_tbl,
 			conv + 3, 315, conv + 3 + 315);
 		if (rv)
 			return -1;
@@ -1142,7 +1261,7 @@ int gsm0503_pdtch_decode(uint8_t *l2_data, const sbit_t *bursts, uint8_t *usf_p,
 		if (usf_p)
 			*usf_p = usf;
 
-		rv = osmo_crc16gen_check_bits(&gsm0503_cs234_crc16,
+		rv = osmo_crc16gen_check_bits_tbl(&gsm0503_cs234_crc16_tbl,
 			conv + 9, 431, conv + 9 + 431);
 		if (rv) {
 			*n_bits_total = 456 - 12;
@@ -1234,7 +1353,7 @@ static int egprs_encode_hdr(ubit_t *hc, const uint8_t *l2_data, int mcs)
 	code = &gsm0503_mcs_dl_codes[mcs];
 
 	osmo_pbit2ubit_ext(upp, 0, l2_data, code->usf_len, code->hdr_len, 1);
-	osmo_crc8gen_set_bits(&gsm0503_mcs_crc8_hdr, upp,
+	osmo_crc8gen_set_bits_tbl(&gsm0503_mcs_crc8_hdr_tbl, upp,
 		code->hdr_len, upp + code->hdr_len);
 
 	osmo_conv_encode(code->hdr_conv, upp, C);
@@ -1280,7 +1399,7 @@ static int egprs_encode_data(ubit_t *c, const uint8_t *l2_data,
 	osmo_pbit2ubit_ext(u, 0, l2_data,
 		code->usf_len + code->hdr_len + blk * data_len, data_len, 1);
 
-	osmo_crc16gen_set_bits(&gsm0503_mcs_crc12, u, data_len, u + data_len);
+	osmo_crc16gen_set_bits_tbl(&gsm0503_mcs_crc12_tbl, u, data_len, u + data_len);
 
 	osmo_conv_encode(code->data_conv, u, C);
 
@@ -1437,7 +1556,7 @@ int gsm0503_pdtch_encode(ubit_t *bursts, const uint8_t *l2_data, uint8_t l2_len)
 	case 23:
 		osmo_pbit2ubit_ext(conv, 0, l2_data, 0, 184, 1);
 
-		osmo_crc64gen_set_bits(&gsm0503_fire_crc40, conv, 184, conv + 184);
+		osmo_crc64gen_set_bits_tbl(&gsm0503_fire_crc40_tbl, conv, 184, conv + 184);
 
 		osmo_conv_encode(&gsm0503_xcch, conv, cB);
 
@@ -1448,7 +1567,7 @@ int gsm0503_pdtch_encode(ubit_t *bursts, const uint8_t *l2_data, uint8_t l2_len)
 		osmo_pbit2ubit_ext(conv, 3, l2_data, 0, 271, 1);
 		usf = l2_data[0] & 0x7;
 
-		osmo_crc16gen_set_bits(&gsm0503_cs234_crc16, conv + 3,
+		osmo_crc16gen_set_bits_tbl(&gsm0503_cs234_crc16_tbl, conv + 3,
 			271, conv + 3 + 271);
 
 		memcpy(conv, gsm0503_usf2six[usf], 6);
@@ -1466,7 +1585,7 @@ int gsm0503_pdtch_encode(ubit_t *bursts, const uint8_t *l2_data, uint8_t l2_len)
 		osmo_pbit2ubit_ext(conv, 3, l2_data, 0, 315, 1);
 		usf = l2_data[0] & 0x7;
 
-		osmo_crc16gen_set_bits(&gsm0503_cs234_crc16, conv + 3,
+		osmo_crc16gen_set_bits_tbl(&gsm0503_cs234_crc16_tbl, conv + 3,
 			315, conv + 3 + 315);
 
 		memcpy(conv, gsm0503_usf2six[usf], 6);
@@ -1484,7 +1603,7 @@ int gsm0503_pdtch_encode(ubit_t *bursts, const uint8_t *l2_data, uint8_t l2_len)
 		osmo_pbit2ubit_ext(cB, 9, l2_data, 0, 431, 1);
 		usf = l2_data[0] & 0x7;
 
-		osmo_crc16gen_set_bits(&gsm0503_cs234_crc16, cB + 9,
+		osmo_crc16gen_set_bits_tbl(&gsm0503_cs234_crc16_tbl, cB + 9,
 			431, cB + 9 + 431);
 
 		memcpy(cB, gsm0503_usf2twelve_ubit[usf], 12);
@@ -1839,20 +1958,19 @@ static void tch_amr_unmerge(ubit_t *d, ubit_t *p, const ubit_t *u, int len, int
 int gsm0503_tch_fr_decode(uint8_t *tch_data, const sbit_t *bursts,
 	int net_order, int efr, int *n_errors, int *n_bits_total)
 {
-	sbit_t iB[912], cB[456], h;
+	sbit_t cB[456], h;
 	ubit_t conv[185], s[244], w[260], b[65], d[260], p[8];
 	int i, rv, len, steal = 0;
 
-	/* map from 8 bursts to interleaved data bits (iB) */
+	/* stealing flags of the 8 bursts */
 	for (i = 0; i < 8; i++) {
-		gsm0503_tch_burst_unmap(&iB[i * 114],
-			&bursts[i * 116], &h, i >> 2);
+		gsm0503_tch_burst_unmap(NULL, &bursts[i * 116], &h, i >> 2);
 		steal -= h;
 	}
-	/* we now have the bits of the four bursts (interface 4 in
-	 * Figure 1a of TS 05.03 */
 
-	gsm0503_tch_fr_deinterleave(cB, iB);
+	/* unmap the bits of the 8 bursts (interface 4 in Figure 1a of
+	 * TS 05.03) and deinterleave them in one pass */
+	gsm0503_tch_fr_burst_unmap_deinterleave(cB, bursts);
 	/* we now have the coded bits c(B): interface 3 in Fig. 1a */
 
 	if (steal > 0) {
@@ -1875,7 +1993,7 @@ int gsm0503_tch_fr_decode(uint8_t *tch_data, const sbit_t *bursts,
 		d[i + 182] = (cB[i + 378] < 0) ? 1 : 0;
 
 	/* check if parity of first 50 (class 1) 'd'-bits match 'p' */
-	rv = osmo_crc8gen_check_bits(&gsm0503_tch_fr_crc3, d, 50, p);
+	rv = osmo_crc8gen_check_bits_tbl(&gsm0503_tch_fr_crc3_tbl, d, 50, p);
 	if (rv) {
 		/* Error checking CRC8 for the FR part of an EFR/FR frame */
 		return -1;
@@ -1894,7 +2012,7 @@ int gsm0503_tch_fr_decode(uint8_t *tch_data, const sbit_t *bursts,
 
 		/* perform CRC-8 on 65 most important bits (50 bits of
 		 * class 1a + 15 bits of class 1b) */
-		rv = osmo_crc8gen_check_bits(&gsm0503_tch_efr_crc8, b, 65, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_tch_efr_crc8_tbl, b, 65, p);
 		if (rv) {
 			/* Error checking CRC8 for the EFR part of an EFR frame */
 			return -1;
@@ -1934,7 +2052,7 @@ int gsm0503_tch_fr_encode(ubit_t *bursts, const uint8_t *tch_data,
 
 		tch_efr_protected(s, b);
 
-		osmo_crc8gen_set_bits(&gsm0503_tch_efr_crc8, b, 65, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_tch_efr_crc8_tbl, b, 65, p);
 
 		tch_efr_reorder(w, s, p);
 
@@ -1947,7 +2065,7 @@ int gsm0503_tch_fr_encode(ubit_t *bursts, const uint8_t *tch_data,
 		tch_fr_b_to_d(d, w);
 
 coding_efr_fr:
-		osmo_crc8gen_set_bits(&gsm0503_tch_fr_crc3, d, 50, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_tch_fr_crc3_tbl, d, 50, p);
 
 		tch_fr_reorder(conv, d, p);
 
@@ -2042,7 +2160,7 @@ int gsm0503_tch_hr_decode(uint8_t *tch_data, const sbit_t *bursts, int odd,
 	for (i = 0; i < 17; i++)
 		d[i + 95] = (cB[i + 211] < 0) ? 1 : 0;
 
-	rv = osmo_crc8gen_check_bits(&gsm0503_tch_fr_crc3, d + 73, 22, p);
+	rv = osmo_crc8gen_check_bits_tbl(&gsm0503_tch_fr_crc3_tbl, d + 73, 22, p);
 	if (rv) {
 		/* Error checking CRC8 for an HR frame */
 		return -1;
@@ -2072,7 +2190,7 @@ int gsm0503_tch_hr_encode(ubit_t *bursts, const uint8_t *tch_data, int len)
 
 		tch_hr_b_to_d(d, b);
 
-		osmo_crc8gen_set_bits(&gsm0503_tch_fr_crc3, d + 73, 22, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_tch_fr_crc3_tbl, d + 73, 22, p);
 
 		tch_hr_reorder(conv, d, p);
 
@@ -2175,7 +2293,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 	int codec_mode_req, uint8_t *codec, int codecs, uint8_t *ft,
 	uint8_t *cmr, int *n_errors, int *n_bits_total, uint8_t *dtx)
 {
-	sbit_t iB[912], cB[456], h;
+	sbit_t cB[456], h;
 	ubit_t d[244], p[6], conv[250];
 	int i, rv, len, steal = 0, id = -1;
 	*n_errors = 0; *n_bits_total = 0;
@@ -2183,11 +2301,11 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 	sbit_t sid_update_enc[256];
 
 	for (i=0; i<8; i++) {
-		gsm0503_tch_burst_unmap(&iB[i * 114], &bursts[i * 116], &h, i >> 2);
+		gsm0503_tch_burst_unmap(NULL, &bursts[i * 116], &h, i >> 2);
 		steal -= h;
 	}
 
-	gsm0503_tch_fr_deinterleave(cB, iB);
+	gsm0503_tch_fr_burst_unmap_deinterleave(cB, bursts);
 
 	if (steal > 0) {
 		/* If not NULL, dtx indicates type of previously decoded TCH/AFS frame.
@@ -2227,7 +2345,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 			osmo_conv_decode_ber(&gsm0503_tch_axs_sid_update,
 					     sid_update_enc, conv, n_errors,
 					     n_bits_total);
-			rv = osmo_crc16gen_check_bits(&gsm0503_amr_crc14, conv,
+			rv = osmo_crc16gen_check_bits_tbl(&gsm0503_amr_crc14_tbl, conv,
 						      35, conv + 35);
 			if (rv != 0) {
 				/* Error checking CRC14 for an AMR SID_UPDATE frame */
@@ -2269,7 +2387,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 
 		tch_amr_unmerge(d, p, conv, 244, 81);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 81, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 81, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 12.2 frame */
 			return -1;
@@ -2286,7 +2404,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 
 		tch_amr_unmerge(d, p, conv, 204, 65);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 65, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 65, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 10.2 frame */
 			return -1;
@@ -2303,7 +2421,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 
 		tch_amr_unmerge(d, p, conv, 159, 75);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 75, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 75, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 7.95 frame */
 			return -1;
@@ -2320,7 +2438,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 
 		tch_amr_unmerge(d, p, conv, 148, 61);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 61, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 61, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 7.4 frame */
 			return -1;
@@ -2337,7 +2455,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 
 		tch_amr_unmerge(d, p, conv, 134, 55);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 55, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 55, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 6.7 frame */
 			return -1;
@@ -2354,7 +2472,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 
 		tch_amr_unmerge(d, p, conv, 118, 55);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 55, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 55, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 5.9 frame */
 			return -1;
@@ -2371,7 +2489,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 
 		tch_amr_unmerge(d, p, conv, 103, 49);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 49, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 49, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 5.15 frame */
 			return -1;
@@ -2388,7 +2506,7 @@ int gsm0503_tch_afs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts,
 
 		tch_amr_unmerge(d, p, conv, 95, 39);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 39, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 39, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 4.75 frame */
 			return -1;
@@ -2468,7 +2586,7 @@ int gsm0503_tch_afs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 244);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 81, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 81, p);
 
 		tch_amr_merge(conv, d, p, 244, 81);
 
@@ -2481,7 +2599,7 @@ int gsm0503_tch_afs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 204);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 65, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 65, p);
 
 		tch_amr_merge(conv, d, p, 204, 65);
 
@@ -2494,7 +2612,7 @@ int gsm0503_tch_afs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 159);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 75, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 75, p);
 
 		tch_amr_merge(conv, d, p, 159, 75);
 
@@ -2507,7 +2625,7 @@ int gsm0503_tch_afs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 148);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 61, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 61, p);
 
 		tch_amr_merge(conv, d, p, 148, 61);
 
@@ -2520,7 +2638,7 @@ int gsm0503_tch_afs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 134);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 55, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 55, p);
 
 		tch_amr_merge(conv, d, p, 134, 55);
 
@@ -2533,7 +2651,7 @@ int gsm0503_tch_afs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 118);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 55, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 55, p);
 
 		tch_amr_merge(conv, d, p, 118, 55);
 
@@ -2546,7 +2664,7 @@ int gsm0503_tch_afs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 103);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 49, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 49, p);
 
 		tch_amr_merge(conv, d, p, 103, 49);
 
@@ -2559,7 +2677,7 @@ int gsm0503_tch_afs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 95);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 39, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 39, p);
 
 		tch_amr_merge(conv, d, p, 95, 39);
 
@@ -2737,7 +2855,7 @@ int gsm0503_tch_ahs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts, int odd,
 				*n_errors += n_errors_sid;
 			if (n_bits_total != NULL)
 				*n_bits_total += n_bits_total_sid;
-			rv = osmo_crc16gen_check_bits(&gsm0503_amr_crc14, conv,
+			rv = osmo_crc16gen_check_bits_tbl(&gsm0503_amr_crc14_tbl, conv,
 						      35, conv + 35);
 			if (rv != 0) {
 				/* Error checking CRC14 for an AMR SID_UPDATE frame */
@@ -2781,7 +2899,7 @@ int gsm0503_tch_ahs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts, int odd,
 
 		tch_amr_unmerge(d, p, conv, 123, 67);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 67, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 67, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 7.95 frame */
 			return -1;
@@ -2801,7 +2919,7 @@ int gsm0503_tch_ahs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts, int odd,
 
 		tch_amr_unmerge(d, p, conv, 120, 61);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 61, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 61, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 7.4 frame */
 			return -1;
@@ -2821,7 +2939,7 @@ int gsm0503_tch_ahs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts, int odd,
 
 		tch_amr_unmerge(d, p, conv, 110, 55);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 55, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 55, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 6.7 frame */
 			return -1;
@@ -2841,7 +2959,7 @@ int gsm0503_tch_ahs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts, int odd,
 
 		tch_amr_unmerge(d, p, conv, 102, 55);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 55, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 55, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 5.9 frame */
 			return -1;
@@ -2861,7 +2979,7 @@ int gsm0503_tch_ahs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts, int odd,
 
 		tch_amr_unmerge(d, p, conv, 91, 49);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 49, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 49, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 5.15 frame */
 			return -1;
@@ -2881,7 +2999,7 @@ int gsm0503_tch_ahs_decode_dtx(uint8_t *tch_data, const sbit_t *bursts, int odd,
 
 		tch_amr_unmerge(d, p, conv, 83, 39);
 
-		rv = osmo_crc8gen_check_bits(&gsm0503_amr_crc6, d, 39, p);
+		rv = osmo_crc8gen_check_bits_tbl(&gsm0503_amr_crc6_tbl, d, 39, p);
 		if (rv) {
 			/* Error checking CRC8 for an AMR 4.75 frame */
 			return -1;
@@ -2973,7 +3091,7 @@ int gsm0503_tch_ahs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 159);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 67, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 67, p);
 
 		tch_amr_merge(conv, d, p, 123, 67);
 
@@ -2988,7 +3106,7 @@ int gsm0503_tch_ahs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 148);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 61, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 61, p);
 
 		tch_amr_merge(conv, d, p, 120, 61);
 
@@ -3003,7 +3121,7 @@ int gsm0503_tch_ahs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 134);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 55, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 55, p);
 
 		tch_amr_merge(conv, d, p, 110, 55);
 
@@ -3018,7 +3136,7 @@ int gsm0503_tch_ahs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 118);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 55, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 55, p);
 
 		tch_amr_merge(conv, d, p, 102, 55);
 
@@ -3033,7 +3151,7 @@ int gsm0503_tch_ahs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 103);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 49, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 49, p);
 
 		tch_amr_merge(conv, d, p, 91, 49);
 
@@ -3048,7 +3166,7 @@ int gsm0503_tch_ahs_encode(ubit_t *bursts, const uint8_t *tch_data, int len,
 
 		tch_amr_disassemble(d, tch_data, 95);
 
-		osmo_crc8gen_set_bits(&gsm0503_amr_crc6, d, 39, p);
+		osmo_crc8gen_set_bits_tbl(&gsm0503_amr_crc6_tbl, d, 39, p);
 
 		tch_amr_merge(conv, d, p, 83, 39);
 
@@ -3108,7 +3226,7 @@ static inline int16_t rach_decode_ber(const sbit_t *burst, uint8_t bsic, bool is
 
 	rach_apply_bsic(conv, bsic, nbits);
 
-	rv = osmo_crc8gen_check_bits(&gsm0503_rach_crc6, conv, nbits, conv + nbits);
+	rv = osmo_crc8gen_check_bits_tbl(&gsm0503_rach_crc6_tbl, conv, nbits, conv + nbits);
 	if (rv)
 		return -1;
 
@@ -3217,7 +3335,7 @@ int gsm0503_rach_ext_encode(ubit_t *burst, uint16_t ra11, uint8_t bsic, bool is_
 
 	osmo_pbit2ubit_ext(conv, 0, ra, 0, nbits, 1);
 
-	osmo_crc8gen_set_bits(&gsm0503_rach_crc6, conv, nbits, conv + nbits);
+	osmo_crc8gen_set_bits_tbl(&gsm0503_rach_crc6_tbl, conv, nbits, conv + nbits);
 
 	rach_apply_bsic(conv, bsic, nbits);
 
@@ -3241,7 +3359,7 @@ int gsm0503_sch_decode(uint8_t *sb_info, const sbit_t *burst)
 
 	osmo_conv_decode(&gsm0503_sch, burst, conv);
 
-	rv = osmo_crc16gen_check_bits(&gsm0503_sch_crc10, conv, 25, conv + 25);
+	rv = osmo_crc16gen_check_bits_tbl(&gsm0503_sch_crc10_tbl, conv, 25, conv + 25);
 	if (rv)
 		return -1;
 
@@ -3260,7 +3378,7 @@ int gsm0503_sch_encode(ubit_t *burst, const uint8_t *sb_info)
 
 	osmo_pbit2ubit_ext(conv, 0, sb_info, 0, 25, 1);
 
-	osmo_crc16gen_set_bits(&gsm0503_sch_crc10, conv, 25, conv + 25);
+	osmo_crc16gen_set_bits_tbl(&gsm0503_sch_crc10_tbl, conv, 25, conv + 25);
 
 	osmo_conv_encode(&gsm0503_sch, conv, burst);
 
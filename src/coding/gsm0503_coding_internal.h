@@ -0,0 +1,16 @@
+/*! \file gsm0503_coding_internal.h
+ * internal definitions shared by the GSM TS 05.03 coding routines */
+#pragma once
+
+#include <stdint.h>
+
+#include <osmocom/core/bits.h>
+
+/*! \addtogroup coding
+ *  @{
+ */
+
+int _gsm0503_xcch_decode_conv(uint8_t *l2_data, const sbit_t *cB,
+	const ubit_t *conv, int *n_errors, int *n_bits_total);
+
+/*! @} */
@@ -76,18 +76,116 @@
  *
  * \file gsm0503_interleaving.c */
 
-/*! De-Interleave burst bits according to TS 05.03 4.1.4
- *  \param[out] cB caller-allocated output buffer for 456 soft coded bits
- *  \param[in] iB 456 soft input bits */
-void gsm0503_xcch_deinterleave(sbit_t *cB, const sbit_t *iB)
+/* Permutation tables, computed from the formulas of TS 05.03 when the
+ * library is loaded, so that (de)interleaving a block is a plain gather or
+ * scatter. Each table holds the interleaved position of every coded bit. */
+
+/* xCCH: B * 114 + j of c(k), 4 blocks */
+static uint16_t xcch_perm[456];
+/* TCH FR/EFR/AFS: B * 114 + j of c(k), 8 blocks */
+static uint16_t tch_fr_perm[456];
+/* TCH HR/AHS: B * 114 + j of c(k), 4 blocks */
+static uint16_t tch_hr_perm[228];
+/* MCS-1..4: position in the xCCH interleaved block of each of the 452 coded
+ * bits, skipping the 4 positions which carry no coded bits */
+static uint16_t mcs1_perm[452];
+/* MCS-5,6 UL and DL header */
+static uint16_t mcs5_ul_hdr_perm[136];
+static uint16_t mcs5_dl_hdr_perm[100];
+/* MCS-7,8,9 UL and DL header */
+static uint16_t mcs7_ul_hdr_perm[160];
+static uint16_t mcs7_dl_hdr_perm[124];
+/* MCS-7 and MCS-8,9 data */
+static uint16_t mcs7_data_perm[1224];
+static uint16_t mcs8_data_perm[1224];
+/* xCCH and TCH FR/EFR/AFS: position of c(k) in the bursts of 116 bits,
+ * i.e. including the burst mapping */
+static uint16_t xcch_burst_perm[456];
+static uint16_t tch_fr_burst_perm[456];
+
+/* Position of i(B, j) in the bursts of 116 bits, see the mapping above */
+static inline uint16_t burst_pos(int B, int j)
 {
-	int j, k, B;
+	return B * 116 + (j < 57 ? j : j + 2);
+}
+
+/* Runs before the default priority constructors, as gsm0503_coding.c derives
+ * tables from the (de)interleaving functions when the library is loaded */
+static __attribute__((constructor(101))) void on_dso_load_gsm0503_interleaving(void)
+{
+	int j, k, n, B;
 
 	for (k = 0; k < 456; k++) {
-		B = k & 3;
 		j = 2 * ((49 * k) % 57) + ((k & 7) >> 2);
-		cB[k] = iB[B * 114 + j];
+		xcch_perm[k] = (k & 3) * 114 + j;
+		xcch_burst_perm[k] = burst_pos(k & 3, j);
+		tch_fr_perm[k] = (k & 7) * 114 + j;
+		tch_fr_burst_perm[k] = burst_pos(k & 7, j);
+	}
+
+	for (k = 0; k < 228; k++) {
+		B = gsm0503_tch_hr_interleaving[k][1];
+		j = gsm0503_tch_hr_interleaving[k][0];
+		tch_hr_perm[k] = B * 114 + j;
 	}
+
+	for (k = 0, n = 0; k < 456; k++) {
+		if (k == 25 || k == 82 || k == 139 || k == 424)
+			continue;
+		mcs1_perm[n++] = xcch_perm[k];
+	}
+
+	for (k = 0; k < 136; k++)
+		mcs5_ul_hdr_perm[k] = 34 * (k % 4) + 2 * (11 * k % 17) + k % 8 / 4;
+	for (k = 0; k < 100; k++)
+		mcs5_dl_hdr_perm[k] = 25 * (k % 4) + ((17 * k) % 25);
+	for (k = 0; k < 160; k++)
+		mcs7_ul_hdr_perm[k] = 40 * (k % 4) + 2 * (13 * (k / 8) % 20) + k % 8 / 4;
+	for (k = 0; k < 124; k++)
+		mcs7_dl_hdr_perm[k] = 31 * (k % 4) + ((17 * k) % 31);
+
+	for (k = 0; k < 1224; k++) {
+		mcs7_data_perm[k] = 306 * (k % 4) + 3 * (44 * k % 102 + k / 4 % 2) +
+			(k + 2 - k / 408) % 3;
+		mcs8_data_perm[k] = 306 * (2 * (k / 612) + (k % 2)) +
+			3 * (74 * k % 102 + k / 2 % 2) + (k + 2 - k / 204) % 3;
+	}
+}
+
+static inline void perm_gather(sbit_t *out, const sbit_t *in,
+	const uint16_t *perm, int n)
+{
+	int k;
+
+	for (k = 0; k < n; k++)
+		out[k] = in[perm[k]];
+}
+
+static inline void perm_scatter(ubit_t *out, const ubit_t *in,
+	const uint16_t *perm, int n)
+{
+	int k;
+
+	for (k = 0; k < n; k++)
+		out[perm[k]] = in[k];
+}
+
+/* Clear the 4 bits of the xCCH interleaved block which carry no MCS-1..4
+ * coded bits */
+static inline void mcs1_clear_unused(ubit_t *iB)
+{
+	iB[xcch_perm[25]] = 0;
+	iB[xcch_perm[82]] = 0;
+	iB[xcch_perm[139]] = 0;
+	iB[xcch_perm[424]] = 0;
+}
+
+/*! De-Interleave burst bits according to TS 05.03 4.1.4
+ *  \param[out] cB caller-allocated output buffer for 456 soft coded bits
+ *  \param[in] iB 456 soft input bits */
+void gsm0503_xcch_deinterleave(sbit_t *cB, const sbit_t *iB)
+{
+	perm_gather(cB, iB, xcch_perm, 456);
 }
 
 /*! Interleave burst bits according to TS 05.03 4.1.4
@@ -95,13 +193,19 @@ void gsm0503_xcch_deinterleave(sbit_t *cB, const sbit_t *iB)
  *  \param[in] cB 456 soft input coded bits */
 void gsm0503_xcch_interleave(const ubit_t *cB, ubit_t *iB)
 {
-	int j, k, B;
+	perm_scatter(iB, cB, xcch_perm, 456);
+}
 
-	for (k = 0; k < 456; k++) {
-		B = k & 3;
-		j = 2 * ((49 * k) % 57) + ((k & 7) >> 2);
-		iB[B * 114 + j] = cB[k];
-	}
+/*! Burst unmapping and De-Interleaving of xCCH bits in one pass
+ *
+ * Same as gsm0503_xcch_burst_unmap() for each of the bursts, followed by
+ * gsm0503_xcch_deinterleave(), but reads each soft bit of the bursts once
+ * and doesn't need the intermediate buffer.
+ *  \param[out] cB caller-allocated output buffer for 456 soft coded bits
+ *  \param[in] bursts 4 bursts of 116 soft bits */
+void gsm0503_xcch_burst_unmap_deinterleave(sbit_t *cB, const sbit_t *bursts)
+{
+	perm_gather(cB, bursts, xcch_burst_perm, 456);
 }
 
 /*! De-Interleave MCS1 DL burst bits according to TS 05.03 5.1.5.1.5
@@ -112,37 +216,14 @@ void gsm0503_xcch_interleave(const ubit_t *cB, ubit_t *iB)
 void gsm0503_mcs1_dl_deinterleave(sbit_t *u, sbit_t *hc,
 	sbit_t *dc, const sbit_t *iB)
 {
-	int k;
-	sbit_t c[452];
-	sbit_t cp[456];
-
-	gsm0503_xcch_deinterleave(cp, iB);
-
-	for (k = 0; k < 25; k++)
-		c[k] = cp[k];
-	for (k = 26; k < 82; k++)
-		c[k - 1] = cp[k];
-	for (k = 83; k < 139; k++)
-		c[k - 2] = cp[k];
-	for (k = 140; k < 424; k++)
-		c[k - 3] = cp[k];
-	for (k = 425; k < 456; k++)
-		c[k - 4] = cp[k];
-
-	if (u) {
-		for (k = 0; k < 12; k++)
-			u[k] = c[k];
-	}
+	if (u)
+		perm_gather(u, iB, mcs1_perm, 12);
 
-	if (hc) {
-		for (k = 12; k < 80; k++)
-			hc[k - 12] = c[k];
-	}
+	if (hc)
+		perm_gather(hc, iB, mcs1_perm + 12, 68);
 
-	if (dc) {
-		for (k = 80; k < 452; k++)
-			dc[k - 80] = c[k];
-	}
+	if (dc)
+		perm_gather(dc, iB, mcs1_perm + 80, 372);
 }
 
 /*! Interleave MCS1 DL burst bits according to TS 05.03 5.1.5.1.5
@@ -153,34 +234,11 @@ void gsm0503_mcs1_dl_deinterleave(sbit_t *u, sbit_t *hc,
 void gsm0503_mcs1_dl_interleave(const ubit_t *up, const ubit_t *hc,
 	const ubit_t *dc, ubit_t *iB)
 {
-	int k;
-	ubit_t c[452];
-	ubit_t cp[456];
-
-	for (k = 0; k < 12; k++)
-		c[k] = up[k];
-	for (k = 12; k < 80; k++)
-		c[k] = hc[k - 12];
-	for (k = 80; k < 452; k++)
-		c[k] = dc[k - 80];
-
-	for (k = 0; k < 25; k++)
-		cp[k] = c[k];
-	for (k = 26; k < 82; k++)
-		cp[k] = c[k - 1];
-	for (k = 83; k < 139; k++)
-		cp[k] = c[k - 2];
-	for (k = 140; k < 424; k++)
-		cp[k] = c[k - 3];
-	for (k = 425; k < 456; k++)
-		cp[k] = c[k - 4];
-
-	cp[25] = 0;
-	cp[82] = 0;
-	cp[139] = 0;
-	cp[424] = 0;
-
-	gsm0503_xcch_interleave(cp, iB);
+	perm_scatter(iB, up, mcs1_perm, 12);
+	perm_scatter(iB, hc, mcs1_perm + 12, 68);
+	perm_scatter(iB, dc, mcs1_perm + 80, 372);
+
+	mcs1_clear_unused(iB);
 }
 
 /*! Interleave MCS1 UL burst bits according to TS 05.03 5.1.5.2.4
@@ -189,32 +247,11 @@ void gsm0503_mcs1_dl_interleave(const ubit_t *up, const ubit_t *hc,
  *  \param[in] iB 456 interleaved soft input bits */
 void gsm0503_mcs1_ul_deinterleave(sbit_t *hc, sbit_t *dc, const sbit_t *iB)
 {
-	int k;
-	sbit_t c[452];
-	sbit_t cp[456];
-
-	gsm0503_xcch_deinterleave(cp, iB);
-
-	for (k = 0; k < 25; k++)
-		c[k] = cp[k];
-	for (k = 26; k < 82; k++)
-		c[k - 1] = cp[k];
-	for (k = 83; k < 139; k++)
-		c[k - 2] = cp[k];
-	for (k = 140; k < 424; k++)
-		c[k - 3] = cp[k];
-	for (k = 425; k < 456; k++)
-		c[k - 4] = cp[k];
-
-	if (hc) {
-		for (k = 0; k < 80; k++)
-			hc[k] = c[k];
-	}
+	if (hc)
+		perm_gather(hc, iB, mcs1_perm, 80);
 
-	if (dc) {
-		for (k = 80; k < 452; k++)
-			dc[k - 80] = c[k];
-	}
+	if (dc)
+		perm_gather(dc, iB, mcs1_perm + 80, 372);
 }
 
 /*! Interleave MCS1 DL burst bits according to TS 05.03 5.1.5.2.4
@@ -223,32 +260,10 @@ void gsm0503_mcs1_ul_deinterleave(sbit_t *hc, sbit_t *dc, const sbit_t *iB)
  *  \param[out] iB 456 interleaved output bits */
 void gsm0503_mcs1_ul_interleave(const ubit_t *hc, const ubit_t *dc, ubit_t *iB)
 {
-	int k;
-	ubit_t c[452];
-	ubit_t cp[456];
-
-	for (k = 0; k < 80; k++)
-		c[k] = hc[k];
-	for (k = 80; k < 452; k++)
-		c[k] = dc[k - 80];
-
-	for (k = 0; k < 25; k++)
-		cp[k] = c[k];
-	for (k = 26; k < 82; k++)
-		cp[k] = c[k - 1];
-	for (k = 83; k < 139; k++)
-		cp[k] = c[k - 2];
-	for (k = 140; k < 424; k++)
-		cp[k] = c[k - 3];
-	for (k = 425; k < 456; k++)
-		cp[k] = c[k - 4];
-
-	cp[25] = 0;
-	cp[82] = 0;
-	cp[139] = 0;
-	cp[424] = 0;
-
-	gsm0503_xcch_interleave(cp, iB);
+	perm_scatter(iB, hc, mcs1_perm, 80);
+	perm_scatter(iB, dc, mcs1_perm + 80, 372);
+
+	mcs1_clear_unused(iB);
 }
 
 /*! Interleave MCS5 UL burst bits according to TS 05.03 5.1.9.2.4
@@ -259,19 +274,11 @@ void gsm0503_mcs1_ul_interleave(const ubit_t *hc, const ubit_t *dc, ubit_t *iB)
 void gsm0503_mcs5_ul_interleave(const ubit_t *hc, const ubit_t *dc,
 	ubit_t *hi, ubit_t *di)
 {
-	int j, k;
-
 	/* Header */
-	for (k = 0; k < 136; k++) {
-		j = 34 * (k % 4) + 2 * (11 * k % 17) + k % 8 / 4;
-		hi[j] = hc[k];
-	}
+	perm_scatter(hi, hc, mcs5_ul_hdr_perm, 136);
 
 	/* Data */
-	for (k = 0; k < 1248; k++) {
-		j = gsm0503_interleave_mcs5[k];
-		di[j] = dc[k];
-	}
+	perm_scatter(di, dc, gsm0503_interleave_mcs5, 1248);
 }
 
 /*! De-Interleave MCS5 UL burst bits according to TS 05.03 5.1.9.2.4
@@ -281,23 +288,13 @@ void gsm0503_mcs5_ul_interleave(const ubit_t *hc, const ubit_t *dc,
 void gsm0503_mcs5_ul_deinterleave(sbit_t *hc, sbit_t *dc,
 	const sbit_t *hi, const sbit_t *di)
 {
-	int j, k;
-
 	/* Header */
-	if (hc) {
-		for (k = 0; k < 136; k++) {
-			j = 34 * (k % 4) + 2 * (11 * k % 17) + k % 8 / 4;
-			hc[k] = hi[j];
-		}
-	}
+	if (hc)
+		perm_gather(hc, hi, mcs5_ul_hdr_perm, 136);
 
 	/* Data */
-	if (dc) {
-		for (k = 0; k < 1248; k++) {
-			j = gsm0503_interleave_mcs5[k];
-			dc[k] = di[j];
-		}
-	}
+	if (dc)
+		perm_gather(dc, di, gsm0503_interleave_mcs5, 1248);
 }
 
 /*! Interleave MCS5 DL burst bits according to TS 05.03 5.1.9.1.5
@@ -308,19 +305,11 @@ void gsm0503_mcs5_ul_deinterleave(sbit_t *hc, sbit_t *dc,
 void gsm0503_mcs5_dl_interleave(const ubit_t *hc, const ubit_t *dc,
 	ubit_t *hi, ubit_t *di)
 {
-	int j, k;
-
 	/* Header */
-	for (k = 0; k < 100; k++) {
-		j = 25 * (k % 4) + ((17 * k) % 25);
-		hi[j] = hc[k];
-	}
+	perm_scatter(hi, hc, mcs5_dl_hdr_perm, 100);
 
 	/* Data */
-	for (k = 0; k < 1248; k++) {
-		j = gsm0503_interleave_mcs5[k];
-		di[j] = dc[k];
-	}
+	perm_scatter(di, dc, gsm0503_interleave_mcs5, 1248);
 }
 
 /*! De-Interleave MCS5 UL burst bits according to TS 05.03 5.1.9.1.5
@@ -330,23 +319,13 @@ void gsm0503_mcs5_dl_interleave(const ubit_t *hc, const ubit_t *dc,
 void gsm0503_mcs5_dl_deinterleave(sbit_t *hc, sbit_t *dc,
 	const sbit_t *hi, const sbit_t *di)
 {
-	int j, k;
-
 	/* Header */
-	if (hc) {
-		for (k = 0; k < 100; k++) {
-			j = 25 * (k % 4) + ((17 * k) % 25);
-			hc[k] = hi[j];
-		}
-	}
+	if (hc)
+		perm_gather(hc, hi, mcs5_dl_hdr_perm, 100);
 
 	/* Data */
-	if (dc) {
-		for (k = 0; k < 1248; k++) {
-			j = gsm0503_interleave_mcs5[k];
-			dc[k] = di[j];
-		}
-	}
+	if (dc)
+		perm_gather(dc, di, gsm0503_interleave_mcs5, 1248);
 }
 
 /*! Interleave MCS7 DL burst bits according to TS 05.03 5.1.11.1.5
@@ -358,24 +337,12 @@ void gsm0503_mcs5_dl_deinterleave(sbit_t *hc, sbit_t *dc,
 void gsm0503_mcs7_dl_interleave(const ubit_t *hc, const ubit_t *c1,
 	const ubit_t *c2, ubit_t *hi, ubit_t *di)
 {
-	int j, k;
-	ubit_t dc[1224];
-
 	/* Header */
-	for (k = 0; k < 124; k++) {
-		j = 31 * (k % 4) + ((17 * k) % 31);
-		hi[j] = hc[k];
-	}
-
-	memcpy(&dc[0], c1, 612);
-	memcpy(&dc[612], c2, 612);
+	perm_scatter(hi, hc, mcs7_dl_hdr_perm, 124);
 
 	/* Data */
-	for (k = 0; k < 1224; k++) {
-		j = 306 * (k % 4) + 3 * (44 * k % 102 + k / 4 % 2) +
-			(k + 2 - k / 408) % 3;
-		di[j] = dc[k];
-	}
+	perm_scatter(di, c1, mcs7_data_perm, 612);
+	perm_scatter(di, c2, mcs7_data_perm + 612, 612);
 }
 
 /*! De-Interleave MCS7 DL burst bits according to TS 05.03 5.1.11.1.5
@@ -387,27 +354,14 @@ void gsm0503_mcs7_dl_interleave(const ubit_t *hc, const ubit_t *c1,
 void gsm0503_mcs7_dl_deinterleave(sbit_t *hc, sbit_t *c1, sbit_t *c2,
 	const sbit_t *hi, const sbit_t *di)
 {
-	int j, k;
-	ubit_t dc[1224];
-
 	/* Header */
-	if (hc) {
-		for (k = 0; k < 124; k++) {
-			j = 31 * (k % 4) + ((17 * k) % 31);
-			hc[k] = hi[j];
-		}
-	}
+	if (hc)
+		perm_gather(hc, hi, mcs7_dl_hdr_perm, 124);
 
 	/* Data */
 	if (c1 && c2) {
-		for (k = 0; k < 1224; k++) {
-			j = 306 * (k % 4) + 3 * (44 * k % 102 + k / 4 % 2) +
-	(k + 2 - k / 408) % 3;
-			dc[k] = di[j];
-		}
-
-		memcpy(c1, &dc[0], 612);
-		memcpy(c2, &dc[612], 612);
+		perm_gather(c1, di, mcs7_data_perm, 612);
+		perm_gather(c2, di, mcs7_data_perm + 612, 612);
 	}
 }
 
@@ -420,24 +374,12 @@ void gsm0503_mcs7_dl_deinterleave(sbit_t *hc, sbit_t *c1, sbit_t *c2,
 void gsm0503_mcs7_ul_interleave(const ubit_t *hc, const ubit_t *c1,
 	const ubit_t *c2, ubit_t *hi, ubit_t *di)
 {
-	int j, k;
-	ubit_t dc[1224];
-
 	/* Header */
-	for (k = 0; k < 160; k++) {
-		j = 40 * (k % 4) + 2 * (13 * (k / 8) % 20) + k % 8 / 4;
-		hi[j] = hc[k];
-	}
-
-	memcpy(&dc[0], c1, 612);
-	memcpy(&dc[612], c2, 612);
+	perm_scatter(hi, hc, mcs7_ul_hdr_perm, 160);
 
 	/* Data */
-	for (k = 0; k < 1224; k++) {
-		j = 306 * (k % 4) + 3 * (44 * k % 102 + k / 4 % 2) +
-			(k + 2 - k / 408) % 3;
-		di[j] = dc[k];
-	}
+	perm_scatter(di, c1, mcs7_data_perm, 612);
+	perm_scatter(di, c2, mcs7_data_perm + 612, 612);
 }
 
 /*! De-Interleave MCS7 UL burst bits according to TS 05.03 5.1.11.2.4
@@ -449,27 +391,14 @@ void gsm0503_mcs7_ul_interleave(const ubit_t *hc, const ubit_t *c1,
 void gsm0503_mcs7_ul_deinterleave(sbit_t *hc, sbit_t *c1, sbit_t *c2,
 	const sbit_t *hi, const sbit_t *di)
 {
-	int j, k;
-	ubit_t dc[1224];
-
 	/* Header */
-	if (hc) {
-		for (k = 0; k < 160; k++) {
-			j = 40 * (k % 4) + 2 * (13 * (k / 8) % 20) + k % 8 / 4;
-			hc[k] = hi[j];
-		}
-	}
+	if (hc)
+		perm_gather(hc, hi, mcs7_ul_hdr_perm, 160);
 
 	/* Data */
 	if (c1 && c2) {
-		for (k = 0; k < 1224; k++) {
-			j = 306 * (k % 4) + 3 * (44 * k % 102 + k / 4 % 2) +
-	(k + 2 - k / 408) % 3;
-			dc[k] = di[j];
-		}
-
-		memcpy(c1, &dc[0], 612);
-		memcpy(c2, &dc[612], 612);
+		perm_gather(c1, di, mcs7_data_perm, 612);
+		perm_gather(c2, di, mcs7_data_perm + 612, 612);
 	}
 }
 
@@ -482,24 +411,12 @@ void gsm0503_mcs7_ul_deinterleave(sbit_t *hc, sbit_t *c1, sbit_t *c2,
 void gsm0503_mcs8_ul_interleave(const ubit_t *hc, const ubit_t *c1,
 	const ubit_t *c2, ubit_t *hi, ubit_t *di)
 {
-	int j, k;
-	ubit_t dc[1224];
-
 	/* Header */
-	for (k = 0; k < 160; k++) {
-		j = 40 * (k % 4) + 2 * (13 * (k / 8) % 20) + k % 8 / 4;
-		hi[j] = hc[k];
-	}
-
-	memcpy(&dc[0], c1, 612);
-	memcpy(&dc[612], c2, 612);
+	perm_scatter(hi, hc, mcs7_ul_hdr_perm, 160);
 
 	/* Data */
-	for (k = 0; k < 1224; k++) {
-		j = 306 * (2 * (k / 612) + (k % 2)) +
-			3 * (74 * k % 102 + k / 2 % 2) + (k + 2 - k / 204) % 3;
-		di[j] = dc[k];
-	}
+	perm_scatter(di, c1, mcs8_data_perm, 612);
+	perm_scatter(di, c2, mcs8_data_perm + 612, 612);
 }
 
 
@@ -512,27 +429,14 @@ void gsm0503_mcs8_ul_interleave(const ubit_t *hc, const ubit_t *c1,
 void gsm0503_mcs8_ul_deinterleave(sbit_t *hc, sbit_t *c1, sbit_t *c2,
 	const sbit_t *hi, const sbit_t *di)
 {
-	int j, k;
-	ubit_t dc[1224];
-
 	/* Header */
-	if (hc) {
-		for (k = 0; k < 160; k++) {
-			j = 40 * (k % 4) + 2 * (13 * (k / 8) % 20) + k % 8 / 4;
-			hc[k] = hi[j];
-		}
-	}
+	if (hc)
+		perm_gather(hc, hi, mcs7_ul_hdr_perm, 160);
 
 	/* Data */
 	if (c1 && c2) {
-		for (k = 0; k < 1224; k++) {
-			j = 306 * (2 * (k / 612) + (k % 2)) +
-	3 * (74 * k % 102 + k / 2 % 2) + (k + 2 - k / 204) % 3;
-			dc[k] = di[j];
-		}
-
-		memcpy(c1, &dc[0], 612);
-		memcpy(c2, &dc[612], 612);
+		perm_gather(c1, di, mcs8_data_perm, 612);
+		perm_gather(c2, di, mcs8_data_perm + 612, 612);
 	}
 }
 
@@ -545,24 +449,12 @@ void gsm0503_mcs8_ul_deinterleave(sbit_t *hc, sbit_t *c1, sbit_t *c2,
 void gsm0503_mcs8_dl_interleave(const ubit_t *hc, const ubit_t *c1,
 	const ubit_t *c2, ubit_t *hi, ubit_t *di)
 {
-	int j, k;
-	ubit_t dc[1224];
-
 	/* Header */
-	for (k = 0; k < 124; k++) {
-		j = 31 * (k % 4) + ((17 * k) % 31);
-		hi[j] = hc[k];
-	}
-
-	memcpy(&dc[0], c1, 612);
-	memcpy(&dc[612], c2, 612);
+	perm_scatter(hi, hc, mcs7_dl_hdr_perm, 124);
 
 	/* Data */
-	for (k = 0; k < 1224; k++) {
-		j = 306 * (2 * (k / 612) + (k % 2)) +
-			3 * (74 * k % 102 + k / 2 % 2) + (k + 2 - k / 204) % 3;
-		di[j] = dc[k];
-	}
+	perm_scatter(di, c1, mcs8_data_perm, 612);
+	perm_scatter(di, c2, mcs8_data_perm + 612, 612);
 }
 
 /*! De-Interleave MCS8 DL burst bits according to TS 05.03 5.1.12.1.5
@@ -574,27 +466,14 @@ void gsm0503_mcs8_dl_interleave(const ubit_t *hc, const ubit_t *c1,
 void gsm0503_mcs8_dl_deinterleave(sbit_t *hc, sbit_t *c1, sbit_t *c2,
 	const sbit_t *hi, const sbit_t *di)
 {
-	int j, k;
-	ubit_t dc[1224];
-
 	/* Header */
-	if (hc) {
-		for (k = 0; k < 124; k++) {
-			j = 31 * (k % 4) + ((17 * k) % 31);
-			hc[k] = hi[j];
-		}
-	}
+	if (hc)
+		perm_gather(hc, hi, mcs7_dl_hdr_perm, 124);
 
 	/* Data */
 	if (c1 && c2) {
-		for (k = 0; k < 1224; k++) {
-			j = 306 * (2 * (k / 612) + (k % 2)) +
-	3 * (74 * k % 102 + k / 2 % 2) + (k + 2 - k / 204) % 3;
-			dc[k] = di[j];
-		}
-
-		memcpy(c1, &dc[0], 612);
-		memcpy(c2, &dc[612], 612);
+		perm_gather(c1, di, mcs8_data_perm, 612);
+		perm_gather(c2, di, mcs8_data_perm + 612, 612);
 	}
 }
 
@@ -627,13 +506,7 @@ void gsm0503_mcs8_dl_deinterleave(sbit_t *hc, sbit_t *c1, sbit_t *c2,
  *  \param[in] iB 456 unpacked interleaved input bits */
 void gsm0503_tch_fr_deinterleave(sbit_t *cB, const sbit_t *iB)
 {
-	int j, k, B;
-
-	for (k = 0; k < 456; k++) {
-		B = k & 7;
-		j = 2 * ((49 * k) % 57) + ((k & 7) >> 2);
-		cB[k] = iB[B * 114 + j];
-	}
+	perm_gather(cB, iB, tch_fr_perm, 456);
 }
 
 /*! GSM TCH FR/EFR/AFS Interleaving and burst mapping
@@ -641,13 +514,20 @@ void gsm0503_tch_fr_deinterleave(sbit_t *cB, const sbit_t *iB)
  *  \param[out] iB 456 unpacked interleaved output bits */
 void gsm0503_tch_fr_interleave(const ubit_t *cB, ubit_t *iB)
 {
-	int j, k, B;
+	perm_scatter(iB, cB, tch_fr_perm, 456);
+}
 
-	for (k = 0; k < 456; k++) {
-		B = k & 7;
-		j = 2 * ((49 * k) % 57) + ((k & 7) >> 2);
-		iB[B * 114 + j] = cB[k];
-	}
+/*! GSM TCH FR/EFR/AFS burst unmapping and De-Interleaving in one pass
+ *
+ * Same as gsm0503_tch_burst_unmap() for each of the bursts (the first 4
+ * even, the last 4 odd), followed by gsm0503_tch_fr_deinterleave(), but
+ * reads each soft bit of the bursts once and doesn't need the intermediate
+ * buffer. The stealing flags are not unmapped.
+ *  \param[out] cB caller-allocated buffer for 456 unpacked output bits
+ *  \param[in] bursts 8 bursts of 116 soft bits */
+void gsm0503_tch_fr_burst_unmap_deinterleave(sbit_t *cB, const sbit_t *bursts)
+{
+	perm_gather(cB, bursts, tch_fr_burst_perm, 456);
 }
 
 /*! GSM TCH HR/AHS De-Interleaving and burst mapping
@@ -655,13 +535,7 @@ void gsm0503_tch_fr_interleave(const ubit_t *cB, ubit_t *iB)
  *  \param[in] iB 228 unpacked interleaved input bits */
 void gsm0503_tch_hr_deinterleave(sbit_t *cB, const sbit_t *iB)
 {
-	int j, k, B;
-
-	for (k = 0; k < 228; k++) {
-		B = gsm0503_tch_hr_interleaving[k][1];
-		j = gsm0503_tch_hr_interleaving[k][0];
-		cB[k] = iB[B * 114 + j];
-	}
+	perm_gather(cB, iB, tch_hr_perm, 228);
 }
 
 /*! GSM TCH HR/AHS Interleaving and burst mapping
@@ -669,13 +543,7 @@ void gsm0503_tch_hr_deinterleave(sbit_t *cB, const sbit_t *iB)
  *  \param[out] iB 228 unpacked interleaved output bits */
 void gsm0503_tch_hr_interleave(const ubit_t *cB, ubit_t *iB)
 {
-	int j, k, B;
-
-	for (k = 0; k < 228; k++) {
-		B = gsm0503_tch_hr_interleaving[k][1];
-		j = gsm0503_tch_hr_interleaving[k][0];
-		iB[B * 114 + j] = cB[k];
-	}
+	perm_scatter(iB, cB, tch_hr_perm, 228);
 }
 
 /*! @} */
@@ -36,8 +36,10 @@
 void gsm0503_xcch_burst_unmap(sbit_t *iB, const sbit_t *eB,
 	sbit_t *hl, sbit_t *hn)
 {
-	memcpy(iB,      eB,      57);
-	memcpy(iB + 57, eB + 59, 57);
+	if (iB) {
+		memcpy(iB,      eB,      57);
+		memcpy(iB + 57, eB + 59, 57);
+	}
 
 	if (hl)
 		*hl = eB[57];
@@ -46,6 +46,7 @@ static int init_complete = 0;
 __attribute__ ((visibility("hidden"))) int avx2_supported = 0;
 __attribute__ ((visibility("hidden"))) int ssse3_supported = 0;
 __attribute__ ((visibility("hidden"))) int sse41_supported = 0;
+__attribute__ ((visibility("hidden"))) int avx512bw_supported = 0;
 
 /**
  * These pointers are being initialized at runtime by the
@@ -145,6 +146,23 @@ void osmo_conv_neon_metrics_k7_n4(const int8_t *seq, const int16_t *out,
 	int16_t *sums, int16_t *paths, int norm);
 #endif
 
+/* Forward Batch Metric Units */
+void osmo_conv_gen_batch_metrics(int num_states, int n, const int8_t *seq,
+	const int16_t *out, const int16_t *sums, int16_t *new_sums,
+	uint32_t *paths, int norm);
+
+#if defined(HAVE_SSSE3) && defined(HAVE_AVX2)
+void osmo_conv_sse_avx_batch_metrics(int num_states, int n, const int8_t *seq,
+	const int16_t *out, const int16_t *sums, int16_t *new_sums,
+	uint32_t *paths, int norm);
+#endif
+
+#if defined(HAVE_AVX512BW)
+void osmo_conv_avx512_batch_metrics(int num_states, int n, const int8_t *seq,
+	const int16_t *out, const int16_t *sums, int16_t *new_sums,
+	uint32_t *paths, int norm);
+#endif
+
 /* Trellis State
  * state - Internal lshift register value
  * prev  - Register values of previous 0 and 1 states
@@ -700,6 +718,10 @@ static void osmo_conv_init(void)
 	#ifdef HAVE_SSE4_1
 		sse41_supported = __builtin_cpu_supports("sse4.1");
 	#endif
+
+	#ifdef HAVE_AVX512BW
+		avx512bw_supported = __builtin_cpu_supports("avx512bw");
+	#endif
 #endif
 
 /**
@@ -752,3 +774,366 @@ int osmo_conv_decode_acc(const struct osmo_conv_code *code,
 
 	return rc;
 }
+
+/* Batch Viterbi Decoder
+ * Decode multiple codewords of the same code at once, one codeword per SIMD
+ * lane. The trellis of all codewords is traversed in lock-step, so that the
+ * per-call setup (trellis generation, memory allocation) and the per-stage
+ * overhead are shared by all codewords of a batch. The path metrics and the
+ * decisions are bit-exact with osmo_conv_decode_acc().
+ */
+struct conv_batch_kernel {
+	enum osmo_conv_batch_kernel id;
+	unsigned int lanes;
+	void (*metrics)(int num_states, int n, const int8_t *seq,
+		const int16_t *out, const int16_t *sums, int16_t *new_sums,
+		uint32_t *paths, int norm);
+};
+
+/* largest number of lanes of any kernel */
+#define BATCH_LANES_MAX 32
+
+static const struct conv_batch_kernel batch_kernels[] = {
+#if defined(HAVE_AVX512BW)
+	{ OSMO_CONV_BATCH_KERNEL_AVX512, 32, osmo_conv_avx512_batch_metrics },
+#endif
+#if defined(HAVE_SSSE3) && defined(HAVE_AVX2)
+	{ OSMO_CONV_BATCH_KERNEL_AVX2, 16, osmo_conv_sse_avx_batch_metrics },
+#endif
+	{ OSMO_CONV_BATCH_KERNEL_GENERIC, 16, osmo_conv_gen_batch_metrics },
+};
+
+static enum osmo_conv_batch_kernel batch_kernel_sel = OSMO_CONV_BATCH_KERNEL_AUTO;
+
+const struct value_string osmo_conv_batch_kernel_names[] = {
+	{ OSMO_CONV_BATCH_KERNEL_AUTO,		"auto" },
+	{ OSMO_CONV_BATCH_KERNEL_GENERIC,	"generic" },
+	{ OSMO_CONV_BATCH_KERNEL_AVX2,		"avx2" },
+	{ OSMO_CONV_BATCH_KERNEL_AVX512,	"avx512" },
+	{ 0, NULL }
+};
+
+/* Batch Decoder
+ * lanes    - Number of codewords decoded at once by the kernel
+ * dec      - Code parameters and trellis; dec.paths is unused
+ * kern     - Kernel computing one trellis stage of all lanes
+ * sums     - Accumulated path metrics [num_states][lanes]
+ * new_sums - Accumulated path metrics of the next stage
+ * paths    - Path selections [len][num_states], one bit per lane
+ * seq      - Depunctured input [len][n][lanes]
+ * depunc   - Depunctured input of punctured codes [lanes][len][n]
+ */
+struct vbatch {
+	unsigned int lanes;
+	struct vdecoder dec;
+	const struct conv_batch_kernel *kern;
+	int16_t *sums;
+	int16_t *new_sums;
+	uint32_t *paths;
+	int8_t *seq;
+	int8_t *depunc;
+};
+
+static int batch_kernel_supported(enum osmo_conv_batch_kernel id)
+{
+	switch (id) {
+	case OSMO_CONV_BATCH_KERNEL_GENERIC:
+		return 1;
+	case OSMO_CONV_BATCH_KERNEL_AVX2:
+		return avx2_supported;
+	case OSMO_CONV_BATCH_KERNEL_AVX512:
+		return avx512bw_supported;
+	default:
+		return 0;
+	}
+}
+
+/* Find the selected kernel, or the first (fastest) supported one */
+static const struct conv_batch_kernel *batch_kernel_find(enum osmo_conv_batch_kernel id)
+{
+	int i;
+
+	if (!init_complete)
+		osmo_conv_init();
+
+	for (i = 0; i < ARRAY_SIZE(batch_kernels); i++) {
+		if (id != OSMO_CONV_BATCH_KERNEL_AUTO && batch_kernels[i].id != id)
+			continue;
+		if (batch_kernel_supported(batch_kernels[i].id))
+			return &batch_kernels[i];
+	}
+
+	return NULL;
+}
+
+/* Kernel used by osmo_conv_decode_batch(); NULL if the codewords are decoded one by one,
+ * as with automatic selection, the generic kernel is slower than osmo_conv_decode() */
+static const struct conv_batch_kernel *batch_kernel_active(void)
+{
+	const struct conv_batch_kernel *kern = batch_kernel_find(batch_kernel_sel);
+
+	if (batch_kernel_sel == OSMO_CONV_BATCH_KERNEL_AUTO && kern->id == OSMO_CONV_BATCH_KERNEL_GENERIC)
+		return NULL;
+	return kern;
+}
+
+/*! Select the trellis kernel used by osmo_conv_decode_batch()
+ *  \param[in] kernel kernel to use; OSMO_CONV_BATCH_KERNEL_AUTO for the fastest one
+ *  \returns 0 on success; -ENOTSUP if not built in or not supported by the CPU */
+int osmo_conv_batch_kernel_set(enum osmo_conv_batch_kernel kernel)
+{
+	if (!batch_kernel_find(kernel))
+		return -ENOTSUP;
+
+	batch_kernel_sel = kernel;
+	return 0;
+}
+
+/*! Get the trellis kernel used by osmo_conv_decode_batch()
+ *  \returns kernel in use; never OSMO_CONV_BATCH_KERNEL_AUTO */
+enum osmo_conv_batch_kernel osmo_conv_batch_kernel_get(void)
+{
+	return batch_kernel_find(batch_kernel_sel)->id;
+}
+
+/*! Get the number of codewords decoded at once by osmo_conv_decode_batch()
+ *  \returns number of SIMD lanes of the kernel in use; 1 if the codewords
+ *	     are decoded one by one
+ *
+ *  Batches of a multiple of this number use the kernel most efficiently. */
+unsigned int osmo_conv_batch_lanes(void)
+{
+	const struct conv_batch_kernel *kern = batch_kernel_active();
+
+	return kern ? kern->lanes : 1;
+}
+
+static void vbatch_deinit(struct vbatch *b)
+{
+	free_trellis(&b->dec.trellis);
+	free(b->sums);
+	free(b->new_sums);
+	free(b->paths);
+	free(b->seq);
+	free(b->depunc);
+}
+
+static int vbatch_init(struct vbatch *b, const struct osmo_conv_code *code,
+	const struct conv_batch_kernel *kern)
+{
+	struct vdecoder *dec = &b->dec;
+	int ns = NUM_STATES(code->K);
+	int rc;
+
+	memset(b, 0, sizeof(*b));
+	b->kern = kern;
+	b->lanes = kern->lanes;
+
+	dec->n = code->N;
+	dec->k = code->K;
+	dec->recursive = conv_code_recursive(code);
+	dec->intrvl = INT16_MAX / (dec->n * INT8_MAX) - dec->k;
+
+	if (code->term == CONV_TERM_FLUSH)
+		dec->len = code->len + code->K - 1;
+	else
+		dec->len = code->len;
+
+	rc = generate_trellis(dec, code);
+	if (rc)
+		return rc;
+
+	b->sums = malloc(sizeof(int16_t) * ns * b->lanes);
+	b->new_sums = malloc(sizeof(int16_t) * ns * b->lanes);
+	b->paths = malloc(sizeof(uint32_t) * ns * dec->len);
+	b->seq = malloc(dec->n * dec->len * b->lanes);
+	if (code->puncture)
+		b->depunc = malloc(dec->n * dec->len * b->lanes);
+
+	if (!b->sums || !b->new_sums || !b->paths || !b->seq || (code->puncture && !b->depunc)) {
+		vbatch_deinit(b);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/* Path selection of a single lane, in the format of vdecoder.paths plus one */
+static inline unsigned vbatch_path(const struct vbatch *b, int i,
+	unsigned state, unsigned lane)
+{
+	return (~b->paths[i * b->dec.trellis.num_states + state] >> lane) & 1;
+}
+
+/* Traceback of a single lane, see traceback() */
+static int vbatch_traceback(const struct vbatch *b, unsigned lane,
+	uint8_t *out, int term, int len)
+{
+	const struct vdecoder *dec = &b->dec;
+	int i, j, sum, max = -1;
+	unsigned path, state = 0, state_scan, mask;
+
+	if (term == CONV_TERM_TAIL_BITING) {
+		for (i = 0; i < dec->trellis.num_states; i++) {
+			state_scan = i;
+			for (j = len - 1; j >= 0; j--) {
+				path = vbatch_path(b, j, state_scan, lane);
+				state_scan = vstate_lshift(state_scan, dec->k, path);
+			}
+			if (state_scan != i)
+				continue;
+			sum = b->sums[i * b->lanes + lane];
+			if (sum > max) {
+				max = sum;
+				state = i;
+			}
+		}
+	}
+
+	if ((max < 0) && (term != CONV_TERM_FLUSH)) {
+		for (i = 0; i < dec->trellis.num_states; i++) {
+			sum = b->sums[i * b->lanes + lane];
+			if (sum > max) {
+				max = sum;
+				state = i;
+			}
+		}
+
+		if (max < 0)
+			return -EPROTO;
+	}
+
+	for (i = dec->len - 1; i >= len; i--) {
+		path = vbatch_path(b, i, state, lane);
+		state = vstate_lshift(state, dec->k, path);
+	}
+
+	/* Same as _traceback() and _traceback_rec(), with vstate_lshift() inlined */
+	mask = dec->trellis.num_states - 2;
+	for (i = len - 1; i >= 0; i--) {
+		path = vbatch_path(b, i, state, lane);
+		out[i] = dec->trellis.vals[state];
+		if (dec->recursive)
+			out[i] ^= path;
+		state = ((state << 1) & mask) | path;
+	}
+
+	return 0;
+}
+
+static void vbatch_forward_traverse(struct vbatch *b)
+{
+	const struct vdecoder *dec = &b->dec;
+	int ns = dec->trellis.num_states;
+	int16_t *tmp;
+	int i;
+
+	for (i = 0; i < dec->len; i++) {
+		b->kern->metrics(ns, dec->n,
+			&b->seq[i * dec->n * b->lanes],
+			dec->trellis.outputs,
+			b->sums, b->new_sums,
+			&b->paths[i * ns],
+			!(i % dec->intrvl));
+
+		tmp = b->sums;
+		b->sums = b->new_sums;
+		b->new_sums = tmp;
+	}
+}
+
+/* Decode up to b->lanes codewords; unused lanes decode an all-zero input */
+static int vbatch_decode(struct vbatch *b, const struct osmo_conv_code *code,
+	const sbit_t * const *input, ubit_t * const *output, unsigned int num)
+{
+	struct vdecoder *dec = &b->dec;
+	int slen = dec->len * dec->n;
+	const int8_t *seq[BATCH_LANES_MAX];
+	unsigned int lane;
+	int i, j, rc = 0;
+
+	/* Transpose the input to one codeword per lane */
+	for (lane = 0; lane < b->lanes; lane++) {
+		if (lane >= num) {
+			seq[lane] = NULL;
+		} else if (code->puncture) {
+			depuncture(input[lane], code->puncture, &b->depunc[lane * slen], slen);
+			seq[lane] = &b->depunc[lane * slen];
+		} else {
+			seq[lane] = input[lane];
+		}
+	}
+
+	for (i = 0; i < slen; i++) {
+		int8_t *dst = &b->seq[i * b->lanes];
+		for (lane = 0; lane < b->lanes; lane++)
+			dst[lane] = seq[lane] ? seq[lane][i] : 0;
+	}
+
+	for (i = 0; i < dec->trellis.num_states; i++) {
+		for (j = 0; j < b->lanes; j++)
+			b->sums[i * b->lanes + j] = dec->trellis.sums[i];
+	}
+
+	vbatch_forward_traverse(b);
+
+	if (code->term == CONV_TERM_TAIL_BITING)
+		vbatch_forward_traverse(b);
+
+	for (lane = 0; lane < num; lane++) {
+		int lrc = vbatch_traceback(b, lane, output[lane], code->term, code->len);
+		if (lrc < 0 && rc == 0)
+			rc = lrc;
+	}
+
+	return rc;
+}
+
+/*! Convolutional decoding of multiple codewords of the same code
+ *  \param[in] code description of convolutional code to be used
+ *  \param[in] input array of \a num arrays of soft bits (coded)
+ *  \param[out] output array of \a num arrays of unpacked bits (decoded)
+ *  \param[in] num number of codewords to decode
+ *  \returns 0 on success; negative on error, in which case codewords may be
+ *  	     decoded partially
+ *
+ *  This produces the same output as calling osmo_conv_decode() for each
+ *  codeword, but decodes osmo_conv_batch_lanes() codewords at once, one per
+ *  SIMD lane, sharing the per-call setup.  Codes not supported by the
+ *  accelerated decoder are decoded one by one, and so are all codes if the
+ *  kernel is selected automatically and no SIMD kernel is available.
+ */
+int osmo_conv_decode_batch(const struct osmo_conv_code *code,
+	const sbit_t * const *input, ubit_t * const *output, unsigned int num)
+{
+	const struct conv_batch_kernel *kern = batch_kernel_active();
+	struct vbatch b;
+	unsigned int i, cnt;
+	int rc = 0, brc;
+
+	if (!kern || (code->N < 2) || (code->N > 4) || (code->len < 1) ||
+		((code->K != 5) && (code->K != 7))) {
+		for (i = 0; i < num; i++) {
+			brc = osmo_conv_decode(code, input[i], output[i]);
+			if (brc < 0 && rc == 0)
+				rc = brc;
+		}
+		return rc;
+	}
+
+	OSMO_ASSERT(kern->lanes <= BATCH_LANES_MAX);
+	rc = vbatch_init(&b, code, kern);
+	if (rc)
+		return rc;
+
+	for (i = 0; i < num; i += cnt) {
+		cnt = OSMO_MIN(num - i, b.lanes);
+		brc = vbatch_decode(&b, code, &input[i], &output[i], cnt);
+		if (brc < 0 && rc == 0)
+			rc = brc;
+	}
+
+	vbatch_deinit(&b);
+
+	return rc;
+}
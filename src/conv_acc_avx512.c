@@ -0,0 +1,78 @@
+/*! \file conv_acc_avx512.c
+ * Accelerated Viterbi decoder implementation:
+ * AVX-512BW batch kernel. */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdint.h>
+#include "config.h"
+
+#include <immintrin.h>
+
+/* Batch path metrics unit
+ * Process one trellis stage of 32 codewords at once, one codeword per
+ * 16-bit element of a 512-bit register. See the generic version in
+ * conv_acc_generic.c for the memory layout. The compare instructions of
+ * AVX-512 yield the path selections directly as bit masks.
+ */
+#define AVX512_BATCH_LANES	32
+
+__attribute__ ((visibility("hidden")))
+void osmo_conv_avx512_batch_metrics(int num_states, int n, const int8_t *seq,
+	const int16_t *out, const int16_t *sums, int16_t *new_sums,
+	uint32_t *paths, int norm)
+{
+	const int olen = (n == 2) ? 2 : 4;
+	const int half = num_states / 2;
+	__m512i val[4], m0, m1, m2, m3, m4;
+	int i, j;
+
+	for (j = 0; j < n; j++)
+		val[j] = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *) &seq[j * AVX512_BATCH_LANES]));
+
+	for (i = 0; i < half; i++) {
+		/* Branch metrics */
+		m2 = _mm512_mullo_epi16(val[0], _mm512_set1_epi16(out[olen * i]));
+		for (j = 1; j < n; j++)
+			m2 = _mm512_adds_epi16(m2, _mm512_mullo_epi16(val[j], _mm512_set1_epi16(out[olen * i + j])));
+
+		/* Add-compare-select */
+		m0 = _mm512_loadu_si512(&sums[(2 * i + 0) * AVX512_BATCH_LANES]);
+		m1 = _mm512_loadu_si512(&sums[(2 * i + 1) * AVX512_BATCH_LANES]);
+
+		m3 = _mm512_adds_epi16(m0, m2);
+		m4 = _mm512_subs_epi16(m1, m2);
+		m0 = _mm512_subs_epi16(m0, m2);
+		m1 = _mm512_adds_epi16(m1, m2);
+
+		_mm512_storeu_si512(&new_sums[i * AVX512_BATCH_LANES], _mm512_max_epi16(m3, m4));
+		_mm512_storeu_si512(&new_sums[(i + half) * AVX512_BATCH_LANES], _mm512_max_epi16(m0, m1));
+		paths[i] = _mm512_cmpge_epi16_mask(m3, m4);
+		paths[i + half] = _mm512_cmpge_epi16_mask(m0, m1);
+	}
+
+	if (norm) {
+		m0 = _mm512_loadu_si512(new_sums);
+		for (i = 1; i < num_states; i++)
+			m0 = _mm512_min_epi16(m0, _mm512_loadu_si512(&new_sums[i * AVX512_BATCH_LANES]));
+
+		for (i = 0; i < num_states; i++) {
+			int16_t *p = &new_sums[i * AVX512_BATCH_LANES];
+			_mm512_storeu_si512(p, _mm512_subs_epi16(_mm512_loadu_si512(p), m0));
+		}
+	}
+}
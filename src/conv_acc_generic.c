@@ -204,3 +204,75 @@ void osmo_conv_gen_metrics_k7_n4(const int8_t *seq, const int16_t *out,
 	gen_branch_metrics_n4(64, seq, out, metrics);
 	gen_path_metrics(64, sums, metrics, paths, norm);
 }
+
+/* Batch path metrics unit
+ * Process one trellis stage of GEN_BATCH_LANES codewords at once. Path
+ * metrics are stored state-major with one 16-bit integer per codeword, so
+ * that the inner loops over codewords can be vectorized by the compiler.
+ * Path selections are stored as one bit per codeword, set where the
+ * generic/SSE implementations store -1.
+ */
+#define GEN_BATCH_LANES	16
+
+__attribute__ ((visibility("hidden")))
+void osmo_conv_gen_batch_metrics(int num_states, int n, const int8_t *seq,
+	const int16_t *out, const int16_t *sums, int16_t *new_sums,
+	uint32_t *paths, int norm)
+{
+	const int olen = (n == 2) ? 2 : 4;
+	const int half = num_states / 2;
+	int i, j, l;
+
+	for (i = 0; i < half; i++) {
+		const int16_t *sum0 = &sums[(2 * i + 0) * GEN_BATCH_LANES];
+		const int16_t *sum1 = &sums[(2 * i + 1) * GEN_BATCH_LANES];
+		int16_t *new0 = &new_sums[i * GEN_BATCH_LANES];
+		int16_t *new1 = &new_sums[(i + half) * GEN_BATCH_LANES];
+		int16_t metric[GEN_BATCH_LANES] = { 0 };
+		uint8_t sel0[GEN_BATCH_LANES], sel1[GEN_BATCH_LANES];
+		uint32_t path0 = 0, path1 = 0;
+
+		for (j = 0; j < n; j++) {
+			for (l = 0; l < GEN_BATCH_LANES; l++)
+				metric[l] += seq[j * GEN_BATCH_LANES + l] * out[olen * i + j];
+		}
+
+		for (l = 0; l < GEN_BATCH_LANES; l++) {
+			int16_t s0 = sum0[l] + metric[l];
+			int16_t s1 = sum1[l] - metric[l];
+			int16_t s2 = sum0[l] - metric[l];
+			int16_t s3 = sum1[l] + metric[l];
+
+			new0[l] = s0 >= s1 ? s0 : s1;
+			new1[l] = s2 >= s3 ? s2 : s3;
+			sel0[l] = s0 >= s1;
+			sel1[l] = s2 >= s3;
+		}
+
+		/* kept apart from the loop above, which is vectorized */
+		for (l = 0; l < GEN_BATCH_LANES; l++) {
+			path0 |= (uint32_t)sel0[l] << l;
+			path1 |= (uint32_t)sel1[l] << l;
+		}
+
+		paths[i] = path0;
+		paths[i + half] = path1;
+	}
+
+	if (norm) {
+		int16_t min[GEN_BATCH_LANES];
+
+		memcpy(min, new_sums, sizeof(min));
+		for (i = 1; i < num_states; i++) {
+			for (l = 0; l < GEN_BATCH_LANES; l++) {
+				if (new_sums[i * GEN_BATCH_LANES + l] < min[l])
+					min[l] = new_sums[i * GEN_BATCH_LANES + l];
+			}
+		}
+
+		for (i = 0; i < num_states; i++) {
+			for (l = 0; l < GEN_BATCH_LANES; l++)
+				new_sums[i * GEN_BATCH_LANES + l] -= min[l];
+		}
+	}
+}
@@ -126,3 +126,64 @@ void osmo_conv_sse_avx_metrics_k7_n4(const int8_t *val,
 
 	_sse_metrics_k7_n4(_val, out, sums, paths, norm);
 }
+
+/* Batch path metrics unit
+ * Process one trellis stage of 16 codewords at once, one codeword per
+ * 16-bit element of a 256-bit AVX2 register. See the generic version in
+ * conv_acc_generic.c for the memory layout.
+ */
+#define AVX2_BATCH_LANES	16
+
+/* Convert a 16 element compare mask to one bit per element */
+static __always_inline uint32_t avx2_mask_bits(__m256i m)
+{
+	uint32_t bits = _mm256_movemask_epi8(_mm256_packs_epi16(m, m));
+
+	return (bits & 0xff) | ((bits >> 8) & 0xff00);
+}
+
+__attribute__ ((visibility("hidden")))
+void osmo_conv_sse_avx_batch_metrics(int num_states, int n, const int8_t *seq,
+	const int16_t *out, const int16_t *sums, int16_t *new_sums,
+	uint32_t *paths, int norm)
+{
+	const int olen = (n == 2) ? 2 : 4;
+	const int half = num_states / 2;
+	__m256i val[4], m0, m1, m2, m3, m4;
+	int i, j;
+
+	for (j = 0; j < n; j++)
+		val[j] = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) &seq[j * AVX2_BATCH_LANES]));
+
+	for (i = 0; i < half; i++) {
+		/* Branch metrics */
+		m2 = _mm256_mullo_epi16(val[0], _mm256_set1_epi16(out[olen * i]));
+		for (j = 1; j < n; j++)
+			m2 = _mm256_adds_epi16(m2, _mm256_mullo_epi16(val[j], _mm256_set1_epi16(out[olen * i + j])));
+
+		/* Add-compare-select */
+		m0 = _mm256_loadu_si256((const __m256i *) &sums[(2 * i + 0) * AVX2_BATCH_LANES]);
+		m1 = _mm256_loadu_si256((const __m256i *) &sums[(2 * i + 1) * AVX2_BATCH_LANES]);
+
+		m3 = _mm256_adds_epi16(m0, m2);
+		m4 = _mm256_subs_epi16(m1, m2);
+		m0 = _mm256_subs_epi16(m0, m2);
+		m1 = _mm256_adds_epi16(m1, m2);
+
+		_mm256_storeu_si256((__m256i *) &new_sums[i * AVX2_BATCH_LANES], _mm256_max_epi16(m3, m4));
+		_mm256_storeu_si256((__m256i *) &new_sums[(i + half) * AVX2_BATCH_LANES], _mm256_max_epi16(m0, m1));
+		paths[i] = ~avx2_mask_bits(_mm256_cmpgt_epi16(m4, m3)) & 0xffff;
+		paths[i + half] = ~avx2_mask_bits(_mm256_cmpgt_epi16(m1, m0)) & 0xffff;
+	}
+
+	if (norm) {
+		m0 = _mm256_loadu_si256((const __m256i *) new_sums);
+		for (i = 1; i < num_states; i++)
+			m0 = _mm256_min_epi16(m0, _mm256_loadu_si256((const __m256i *) &new_sums[i * AVX2_BATCH_LANES]));
+
+		for (i = 0; i < num_states; i++) {
+			__m256i *p = (__m256i *) &new_sums[i * AVX2_BATCH_LANES];
+			_mm256_storeu_si256(p, _mm256_subs_epi16(_mm256_loadu_si256(p), m0));
+		}
+	}
+}
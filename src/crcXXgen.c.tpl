@@ -25,8 +25,10 @@
  *  \file crcXXgen.c.tpl */
 
 #include <stdint.h>
+#include <string.h>
 
 #include <osmocom/core/bits.h>
+#include <osmocom/core/endian.h>
 #include <osmocom/core/crcXXgen.h>
 
 
@@ -109,6 +111,245 @@ osmo_crcXXgen_set_bits(const struct osmo_crcXXgen_code *code,
 		crc_bits[i] = ((crc >> (code->bits-i-1)) & 1);
 }
 
+/* Table-driven computation
+ *
+ * The CRC state is kept in the XX bit register with its MSB in the MSB of the
+ * register, and the polynomial is shifted the same way. This way the register
+ * never has to be masked, and a byte of input is processed with one lookup:
+ * t[0][b] is the state after shifting in the byte b, starting from 0. t[k][b]
+ * is the state after shifting in b followed by k zero bytes, which allows to
+ * process four bytes with four independent lookups ("slicing-by-4"). */
+
+static inline uintXX_t
+_crcXX_step_bit(uintXX_t r, uintXX_t poly, int bit)
+{
+	r ^= (uintXX_t)bit << (XX - 1);
+	if (r & ((uintXX_t)1 << (XX - 1)))
+		return (uintXX_t)(r << 1) ^ poly;
+	return (uintXX_t)(r << 1);
+}
+
+static inline uintXX_t
+_crcXX_step_byte(const struct osmo_crcXXgen_table *tbl, uintXX_t r, uint8_t b)
+{
+#if XX == 8
+	return tbl->t[0][r ^ b];
+#else
+	return (uintXX_t)(r << 8) ^ tbl->t[0][(r >> (XX - 8)) ^ b];
+#endif
+}
+
+/* w holds four bytes of input, the first one in the MSB */
+static inline uintXX_t
+_crcXX_step_word(const struct osmo_crcXXgen_table *tbl, uintXX_t r, uint32_t w)
+{
+#if XX > 32
+	w ^= r >> (XX - 32);
+	r <<= 32;
+#else
+	w ^= (uint32_t)r << (32 - XX);
+	r = 0;
+#endif
+	return r ^ tbl->t[3][w >> 24] ^ tbl->t[2][(w >> 16) & 0xff] ^
+	       tbl->t[1][(w >> 8) & 0xff] ^ tbl->t[0][w & 0xff];
+}
+
+/* Pack 8 unpacked bits, the first one into the MSB. With soft set, the bits
+ * are soft-bits and are hard-decided by their sign. */
+static inline uint8_t
+_crcXX_pack8(const uint8_t *in, int soft)
+{
+	uint64_t x;
+
+	memcpy(&x, in, sizeof(x));
+#if OSMO_IS_BIG_ENDIAN
+	x = __builtin_bswap64(x);
+#endif
+	if (soft)
+		x >>= 7;
+	x &= 0x0101010101010101ULL;
+	/* moves the LSB of byte i to bit 63 - i, without any carries */
+	return (x * 0x8040201008040201ULL) >> 56;
+}
+
+static inline uintXX_t
+_crcXX_compute_unpacked(const struct osmo_crcXXgen_table *tbl,
+                        const uint8_t *in, int len, int soft)
+{
+	const struct osmo_crcXXgen_code *code = tbl->code;
+	const int shift = XX - code->bits;
+	uintXX_t r = (uintXX_t)(code->init << shift);
+	int i;
+
+	for (; len >= 32; len -= 32, in += 32) {
+		uint32_t w = ((uint32_t)_crcXX_pack8(in, soft) << 24) |
+		             ((uint32_t)_crcXX_pack8(in + 8, soft) << 16) |
+		             ((uint32_t)_crcXX_pack8(in + 16, soft) << 8) |
+		             _crcXX_pack8(in + 24, soft);
+		r = _crcXX_step_word(tbl, r, w);
+	}
+
+	for (; len >= 8; len -= 8, in += 8)
+		r = _crcXX_step_byte(tbl, r, _crcXX_pack8(in, soft));
+
+	for (i = 0; i < len; i++) {
+		int bit = soft ? ((const sbit_t *)in)[i] < 0 : in[i] & 1;
+		r = _crcXX_step_bit(r, (uintXX_t)(code->poly << shift), bit);
+	}
+
+	return (r >> shift) ^ code->remainder;
+}
+
+
+/*! Compute the lookup tables for the table-driven computation of a CRC code
+ *  \param[out] tbl The lookup tables to fill
+ *  \param[in] code The CRC code description, must outlive the tables
+ */
+void
+osmo_crcXXgen_table_init(struct osmo_crcXXgen_table *tbl,
+                         const struct osmo_crcXXgen_code *code)
+{
+	const uintXX_t poly = (uintXX_t)(code->poly << (XX - code->bits));
+	int b, i, k;
+
+	tbl->code = code;
+
+	for (b = 0; b < 256; b++) {
+		uintXX_t r = 0;
+		for (i = 0; i < 8; i++)
+			r = _crcXX_step_bit(r, poly, (b >> (7 - i)) & 1);
+		tbl->t[0][b] = r;
+	}
+
+	for (k = 1; k < 4; k++)
+		for (b = 0; b < 256; b++)
+			tbl->t[k][b] = _crcXX_step_byte(tbl, tbl->t[k - 1][b], 0);
+}
+
+
+/*! Compute the CRC value of a given array of packed bits
+ *  \param[in] tbl The lookup tables of the CRC code to apply
+ *  \param[in] in Array of packed bits, the first bit in the MSB of in[0]
+ *  \param[in] len Number of bits in the array
+ *  \returns The CRC value
+ */
+uintXX_t
+osmo_crcXXgen_compute_pbits(const struct osmo_crcXXgen_table *tbl,
+                            const pbit_t *in, int len)
+{
+	const struct osmo_crcXXgen_code *code = tbl->code;
+	const int shift = XX - code->bits;
+	uintXX_t r = (uintXX_t)(code->init << shift);
+	int i;
+
+	for (; len >= 32; len -= 32, in += 4)
+		r = _crcXX_step_word(tbl, r, osmo_load32be(in));
+
+	for (; len >= 8; len -= 8, in++)
+		r = _crcXX_step_byte(tbl, r, *in);
+
+	for (i = 0; i < len; i++)
+		r = _crcXX_step_bit(r, (uintXX_t)(code->poly << shift), (*in >> (7 - i)) & 1);
+
+	return (r >> shift) ^ code->remainder;
+}
+
+
+/*! Compute the CRC value of a given array of hard-bits, table-driven
+ *  \param[in] tbl The lookup tables of the CRC code to apply
+ *  \param[in] in Array of hard bits
+ *  \param[in] len Length of the array of hard bits
+ *  \returns The CRC value
+ *
+ * Same as osmo_crcXXgen_compute_bits(), but packs the bits on the fly and
+ * processes them a byte at a time.
+ */
+uintXX_t
+osmo_crcXXgen_compute_bits_tbl(const struct osmo_crcXXgen_table *tbl,
+                               const ubit_t *in, int len)
+{
+	return _crcXX_compute_unpacked(tbl, in, len, 0);
+}
+
+
+/*! Checks the CRC value of a given array of hard-bits, table-driven
+ *  \param[in] tbl The lookup tables of the CRC code to apply
+ *  \param[in] in Array of hard bits
+ *  \param[in] len Length of the array of hard bits
+ *  \param[in] crc_bits Array of hard bits with the alleged CRC
+ *  \returns 0 if CRC matches. 1 in case of error.
+ *
+ * The crc_bits array must have a length of code->len
+ */
+int
+osmo_crcXXgen_check_bits_tbl(const struct osmo_crcXXgen_table *tbl,
+                             const ubit_t *in, int len, const ubit_t *crc_bits)
+{
+	const int n = tbl->code->bits;
+	uintXX_t crc;
+	int i;
+
+	crc = _crcXX_compute_unpacked(tbl, in, len, 0);
+
+	for (i=0; i<n; i++)
+		if (crc_bits[i] ^ ((crc >> (n-i-1)) & 1))
+			return 1;
+
+	return 0;
+}
+
+
+/*! Computes and writes the CRC value of a given array of bits, table-driven
+ *  \param[in] tbl The lookup tables of the CRC code to apply
+ *  \param[in] in Array of hard bits
+ *  \param[in] len Length of the array of hard bits
+ *  \param[in] crc_bits Array of hard bits to write the computed CRC to
+ *
+ * The crc_bits array must have a length of code->len
+ */
+void
+osmo_crcXXgen_set_bits_tbl(const struct osmo_crcXXgen_table *tbl,
+                           const ubit_t *in, int len, ubit_t *crc_bits)
+{
+	const int n = tbl->code->bits;
+	uintXX_t crc;
+	int i;
+
+	crc = _crcXX_compute_unpacked(tbl, in, len, 0);
+
+	for (i=0; i<n; i++)
+		crc_bits[i] = ((crc >> (n-i-1)) & 1);
+}
+
+
+/*! Checks the CRC value of a given array of soft-bits, table-driven
+ *  \param[in] tbl The lookup tables of the CRC code to apply
+ *  \param[in] in Array of soft bits
+ *  \param[in] len Length of the array of soft bits
+ *  \param[in] crc_sbits Array of soft bits with the alleged CRC
+ *  \returns 0 if CRC matches. 1 in case of error.
+ *
+ * The soft bits are hard-decided like osmo_sbit2ubit() does, i.e. negative
+ * values are 1, without converting them to an intermediate array first.
+ * The crc_sbits array must have a length of code->len
+ */
+int
+osmo_crcXXgen_check_sbits_tbl(const struct osmo_crcXXgen_table *tbl,
+                              const sbit_t *in, int len, const sbit_t *crc_sbits)
+{
+	const int n = tbl->code->bits;
+	uintXX_t crc;
+	int i;
+
+	crc = _crcXX_compute_unpacked(tbl, (const uint8_t *)in, len, 1);
+
+	for (i=0; i<n; i++)
+		if ((crc_sbits[i] < 0) ^ ((crc >> (n-i-1)) & 1))
+			return 1;
+
+	return 0;
+}
+
 /*! @} */
 
 /* vim: set syntax=c: */
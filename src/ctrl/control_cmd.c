@@ -32,6 +32,7 @@
 
 #include <osmocom/ctrl/control_cmd.h>
 
+#include <osmocom/core/linuxlist.h>
 #include <osmocom/core/msgb.h>
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/utils.h>
@@ -54,35 +55,209 @@ const struct value_string ctrl_type_vals[] = {
 /* Functions from libosmocom */
 extern vector cmd_make_descvec(const char *string, const char *descstr);
 
+/* The installed commands of a CTRL node are compiled into a prefix trie of
+ * their words, so that finding the command matching a request takes one
+ * binary search per word instead of comparing every installed command.  A
+ * command whose name contains a wildcard word ("*") is kept at the trie node of
+ * the words preceding the wildcard; it matches any request that has these
+ * words and at least as many words as the command name.  Among all matching
+ * commands, the one installed first wins, like in a linear scan. */
+struct ctrl_trie_wild {
+	unsigned int index;		/* index in the node vector */
+	unsigned int nr_commands;	/* number of words of the command name */
+};
+
+struct ctrl_trie_node {
+	const char *word;
+	/* children sorted by word */
+	struct ctrl_trie_node **children;
+	unsigned int num_children;
+	/* command ending at this node, -1 if none */
+	int term;
+	/* commands with a wildcard following this node, sorted by index */
+	struct ctrl_trie_wild *wild;
+	unsigned int num_wild;
+};
+
+struct ctrl_trie {
+	struct llist_head list;
+	vector node;			/* node vector the trie was built from */
+	void **index;			/* its slots and number of slots at that time */
+	unsigned int active;
+	struct ctrl_trie_node *root;
+};
+
+static LLIST_HEAD(ctrl_tries);
+
+static struct ctrl_trie_node *ctrl_trie_node_alloc(void *ctx, const char *word)
+{
+	struct ctrl_trie_node *tn = talloc_zero(ctx, struct ctrl_trie_node);
+
+	if (!tn)
+		return NULL;
+	tn->word = word;
+	tn->term = -1;
+	return tn;
+}
+
+/* Find the child of \a tn for \a word; return the insert position in \a pos if not found */
+static struct ctrl_trie_node *ctrl_trie_child(const struct ctrl_trie_node *tn, const char *word,
+					      unsigned int *pos)
+{
+	unsigned int lo = 0, hi = tn->num_children;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+		int rc = strcmp(word, tn->children[mid]->word);
+
+		if (rc == 0)
+			return tn->children[mid];
+		if (rc < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	if (pos)
+		*pos = lo;
+	return NULL;
+}
+
+static int ctrl_trie_add(struct ctrl_trie_node *root, const struct ctrl_cmd_struct *strcmd,
+			 unsigned int index)
+{
+	struct ctrl_trie_node *tn = root;
+	int j;
+
+	for (j = 0; j < strcmd->nr_commands; j++) {
+		const char *word = strcmd->command[j];
+		struct ctrl_trie_node *child;
+		unsigned int pos;
+
+		if (word[0] == '*') {
+			tn->wild = talloc_realloc(tn, tn->wild, struct ctrl_trie_wild, tn->num_wild + 1);
+			if (!tn->wild)
+				return -ENOMEM;
+			tn->wild[tn->num_wild++] = (struct ctrl_trie_wild){
+				.index = index,
+				.nr_commands = strcmd->nr_commands,
+			};
+			return 0;
+		}
+
+		child = ctrl_trie_child(tn, word, &pos);
+		if (!child) {
+			child = ctrl_trie_node_alloc(tn, word);
+			if (!child)
+				return -ENOMEM;
+			tn->children = talloc_realloc(tn, tn->children, struct ctrl_trie_node *,
+						      tn->num_children + 1);
+			if (!tn->children)
+				return -ENOMEM;
+			memmove(&tn->children[pos + 1], &tn->children[pos],
+				(tn->num_children - pos) * sizeof(tn->children[0]));
+			tn->children[pos] = child;
+			tn->num_children++;
+		}
+		tn = child;
+	}
+
+	if (tn->term < 0)
+		tn->term = index;
+	return 0;
+}
+
+static void ctrl_trie_free(struct ctrl_trie *trie)
+{
+	llist_del(&trie->list);
+	talloc_free(trie);
+}
+
+/* Drop all compiled tries, e.g. because commands were installed */
+static void ctrl_tries_invalidate(void)
+{
+	struct ctrl_trie *trie, *trie2;
+
+	llist_for_each_entry_safe(trie, trie2, &ctrl_tries, list)
+		ctrl_trie_free(trie);
+}
+
+/* Get the trie of the node vector \a node, (re)building it if necessary */
+static struct ctrl_trie *ctrl_trie_get(vector node)
+{
+	struct ctrl_trie *trie;
+	unsigned int index;
+
+	llist_for_each_entry(trie, &ctrl_tries, list) {
+		if (trie->node != node)
+			continue;
+		if (trie->index == node->index && trie->active == vector_active(node))
+			return trie;
+		ctrl_trie_free(trie);
+		break;
+	}
+
+	trie = talloc_zero(tall_vty_vec_ctx, struct ctrl_trie);
+	if (!trie)
+		return NULL;
+	trie->node = node;
+	trie->index = node->index;
+	trie->active = vector_active(node);
+	trie->root = ctrl_trie_node_alloc(trie, "");
+	if (!trie->root)
+		goto err;
+
+	for (index = 0; index < vector_active(node); index++) {
+		struct ctrl_cmd_element *cmd_el = vector_slot(node, index);
+
+		if (!cmd_el)
+			continue;
+		if (ctrl_trie_add(trie->root, &cmd_el->strcmd, index) < 0)
+			goto err;
+	}
+
+	llist_add(&trie->list, &ctrl_tries);
+	return trie;
+err:
+	talloc_free(trie);
+	return NULL;
+}
+
 /* Get the ctrl_cmd_element that matches this command */
 static struct ctrl_cmd_element *ctrl_cmd_get_element_match(vector vline, vector node)
 {
-	int index, j;
-	const char *desc;
-	struct ctrl_cmd_element *cmd_el;
-	struct ctrl_cmd_struct *cmd_desc;
-	char *str;
+	struct ctrl_trie *trie;
+	const struct ctrl_trie_node *tn;
+	unsigned int n = vector_active(vline);
+	unsigned int j, k;
+	int best;
+
+	trie = ctrl_trie_get(node);
+	if (!trie)
+		return NULL;
 
-	for (index = 0; index < vector_active(node); index++) {
-		if ((cmd_el = vector_slot(node, index))) {
-			cmd_desc = &cmd_el->strcmd;
-			if (cmd_desc->nr_commands > vector_active(vline))
+	tn = trie->root;
+	best = tn->term;
+	for (j = 0; j < n; j++) {
+		const char *str = vector_slot(vline, j);
+
+		/* the first wildcard command not longer than the request */
+		for (k = 0; k < tn->num_wild; k++) {
+			if (tn->wild[k].nr_commands > n)
 				continue;
-			for (j =0; j < vector_active(vline) && j < cmd_desc->nr_commands; j++) {
-				str = vector_slot(vline, j);
-				desc = cmd_desc->command[j];
-				if (desc[0] == '*')
-					return cmd_el; /* Partial match */
-				if (strcmp(desc, str) != 0)
-					break;
-			}
-			/* We went through all the elements and all matched */
-			if (j == cmd_desc->nr_commands)
-				return cmd_el;
+			if (best < 0 || tn->wild[k].index < best)
+				best = tn->wild[k].index;
+			break;
 		}
+
+		if (!str || !(tn = ctrl_trie_child(tn, str, NULL)))
+			break;
+		if (tn->term >= 0 && (best < 0 || tn->term < best))
+			best = tn->term;
 	}
 
-	return NULL;
+	if (best < 0)
+		return NULL;
+	return vector_slot(node, best);
 }
 
 /*! Execute a given received command
@@ -224,6 +399,7 @@ int ctrl_cmd_install(enum ctrl_node_type node, struct ctrl_cmd_element *cmd)
 	vector_set(cmds_vec, cmd);
 
 	create_cmd_struct(&cmd->strcmd, cmd->name);
+	ctrl_tries_invalidate();
 	return 0;
 }
 
@@ -307,6 +483,27 @@ static bool id_str_valid(const char *str)
 	return true;
 }
 
+/* Check the variable of a GET, which may be a comma separated list of
+ * variables to get in bulk */
+static bool get_variables_valid(const char *var)
+{
+	char buf[256];
+	const char *end;
+
+	do {
+		end = strchr(var, ',');
+		if (!end)
+			return osmo_separated_identifiers_valid(var, ".");
+		if (end == var || end - var >= sizeof(buf))
+			return false;
+		memcpy(buf, var, end - var);
+		buf[end - var] = '\0';
+		if (!osmo_separated_identifiers_valid(buf, "."))
+			return false;
+		var = end + 1;
+	} while (1);
+}
+
 /*! Parse/Decode CTRL from \ref msgb into command struct.
  *  \param[in] ctx talloc context from which to allocate
  *  \param[in] msg message buffer containing command to be decoded
@@ -398,7 +595,7 @@ struct ctrl_cmd *ctrl_cmd_parse3(void *ctx, struct msgb *msg, bool *parse_failed
 				     osmo_escape_str(str, -1));
 				goto err;
 			}
-			if (!osmo_separated_identifiers_valid(var, ".")) {
+			if (!get_variables_valid(var)) {
 				cmd->type = CTRL_TYPE_ERROR;
 				cmd->reply = "GET variable contains invalid characters";
 				LOGP(DLCTRL, LOGL_NOTICE, "GET variable contains invalid characters: \"%s\"\n",
@@ -557,6 +754,11 @@ struct msgb *ctrl_cmd_make(struct ctrl_cmd *cmd)
 		goto ret;
 	}
 	len = strlen(strbuf);
+	/* the size of a msgb is a 16 bit value */
+	if (len + 128 > UINT16_MAX) {
+		LOGP(DLCTRL, LOGL_ERROR, "%s %s too long to encode (%zu bytes)\n", type, cmd->id, len);
+		goto ret;
+	}
 
 	msg = msgb_alloc_headroom(len + 128, 128, "ctrl ERROR command make");
 	if (!msg)
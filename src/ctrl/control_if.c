@@ -66,6 +66,10 @@ extern int osmo_fsm_ctrl_cmds_install(void);
 
 vector ctrl_node_vec;
 
+/* The encoded reply to a bulk GET has to fit into the msgb of ctrl_cmd_make(),
+ * whose size is a 16 bit value and which has 128 octets of headroom */
+#define CTRL_BULK_MSG_MAX	(UINT16_MAX - 128)
+
 /* global list of control interface lookup helpers */
 struct lookup_helper {
 	struct llist_head list;
@@ -205,6 +209,89 @@ static void control_close_conn(struct ctrl_connection *ccon)
 	talloc_free(ccon);
 }
 
+/* Handle a GET of a comma separated list of variables: the GET_REPLY has one
+ * line "<variable> <value>" per variable.  If getting any of the variables
+ * fails, the whole request fails with an ERROR naming that variable. */
+static int ctrl_cmd_handle_bulk(struct ctrl_handle *ctrl, struct ctrl_cmd *cmd, void *data)
+{
+	char *vars = NULL, *var, *saveptr = NULL;
+	char *reply;
+	size_t reply_len = 0, reply_size = 256, reply_max, overhead;
+	int rc = CTRL_CMD_ERROR;
+
+	/* "GET_REPLY <id> <variable> <reply>" */
+	overhead = strlen("GET_REPLY") + 1 + strlen(cmd->id ? : "") + 1 + strlen(cmd->variable) + 1;
+	if (overhead > CTRL_BULK_MSG_MAX) {
+		cmd->reply = "Bulk GET reply too long";
+		goto out;
+	}
+	reply_max = CTRL_BULK_MSG_MAX - overhead;
+
+	vars = talloc_strdup(cmd, cmd->variable);
+	reply = talloc_zero_size(cmd, reply_size);
+	if (!vars || !reply) {
+		cmd->reply = "Out of memory";
+		goto out;
+	}
+
+	for (var = strtok_r(vars, ",", &saveptr); var; var = strtok_r(NULL, ",", &saveptr)) {
+		struct ctrl_cmd *sub;
+		const char *value;
+		size_t len;
+		int sub_rc;
+
+		/* without a connection, a GET can't be deferred */
+		sub = ctrl_cmd_create(cmd, CTRL_TYPE_GET);
+		if (!sub) {
+			cmd->reply = "Out of memory";
+			goto out;
+		}
+		sub->id = cmd->id;
+		sub->variable = var;
+
+		sub_rc = ctrl_cmd_handle(ctrl, sub, data);
+		if (sub_rc != CTRL_CMD_REPLY) {
+			const char *err = "No reply";
+			if (sub_rc == CTRL_CMD_ERROR)
+				err = sub->reply ? : "An error has occurred.";
+			cmd->reply = talloc_asprintf(cmd, "%s: %s", var, err);
+			talloc_free(sub);
+			goto out;
+		}
+
+		/* "[\n]<variable> <value>" */
+		value = sub->reply ? : "";
+		len = (reply_len ? 1 : 0) + strlen(var) + 1 + strlen(value);
+		if (reply_len + len > reply_max) {
+			talloc_free(sub);
+			cmd->reply = "Bulk GET reply too long";
+			goto out;
+		}
+		if (reply_len + len + 1 > reply_size) {
+			while (reply_len + len + 1 > reply_size)
+				reply_size *= 2;
+			reply = talloc_realloc_size(cmd, reply, reply_size);
+			if (!reply) {
+				talloc_free(sub);
+				cmd->reply = "Out of memory";
+				goto out;
+			}
+		}
+		snprintf(reply + reply_len, reply_size - reply_len, "%s%s %s", reply_len ? "\n" : "", var, value);
+		reply_len += len;
+		talloc_free(sub);
+	}
+
+	cmd->reply = reply;
+	cmd->type = CTRL_TYPE_GET_REPLY;
+	rc = CTRL_CMD_REPLY;
+out:
+	if (rc == CTRL_CMD_ERROR)
+		cmd->type = CTRL_TYPE_ERROR;
+	talloc_free(vars);
+	return rc;
+}
+
 int ctrl_cmd_handle(struct ctrl_handle *ctrl, struct ctrl_cmd *cmd,
 		    void *data)
 {
@@ -234,6 +321,9 @@ int ctrl_cmd_handle(struct ctrl_handle *ctrl, struct ctrl_cmd *cmd,
 			return CTRL_CMD_HANDLED;
 	}
 
+	if (cmd->type == CTRL_TYPE_GET && cmd->variable && strchr(cmd->variable, ','))
+		return ctrl_cmd_handle_bulk(ctrl, cmd, data);
+
 	ret = CTRL_CMD_ERROR;
 	cmd->reply = NULL;
 	node = CTRL_NODE_ROOT;
@@ -516,6 +606,7 @@ struct ctrl_connection *osmo_ctrl_conn_alloc(void *ctx, void *data)
 	ccon->write_queue.bfd.data = data;
 	ccon->write_queue.bfd.fd = -1;
 	ccon->write_queue.write_cb = control_write_cb;
+	ccon->write_queue.vectored = true;
 	ccon->write_queue.read_cb = handle_control_read;
 
 	return ccon;
@@ -592,6 +683,8 @@ static uint64_t get_rate_ctr_value(const struct rate_ctr *ctr, int intv, const c
 static int get_rate_ctr_group_idx(struct rate_ctr_group *ctrg, int intv, struct ctrl_cmd *cmd)
 {
 	unsigned int i;
+
+	rate_ctr_group_sync(ctrg);
 	for (i = 0; i < ctrg->desc->num_ctr; i++) {
 		ctrl_cmd_reply_printf(cmd, "%s %"PRIu64";", ctrg->desc->ctr_desc[i].name,
 				      get_rate_ctr_value(rate_ctr_group_get_ctr(ctrg, i), intv, ctrg->desc->group_name_prefix));
@@ -691,6 +784,7 @@ static int get_rate_ctr(struct ctrl_cmd *cmd, void *data)
 		return get_rate_ctr_group_idx(ctrg, intv, cmd);
 	}
 
+	rate_ctr_group_sync(ctrg);
 	ctr = rate_ctr_get_by_name(ctrg, saveptr);
 	if (!ctr) {
 		cmd->reply = "Counter name not found.";
@@ -208,6 +208,24 @@ static const struct osmo_stat_item_group_desc nsvc_statg_desc = {
 
 const struct osmo_stat_item_desc nsbind_stat_description[] = {
 	[NS2_BIND_STAT_BACKLOG_LEN] = { "tx_backlog_length",	"Transmit backlog length", "packets", 16, 0 },
+	[NS2_BIND_STAT_RX_BATCH] = { "rx_batch_size",	"Datagrams received per recvmmsg() call", "packets", 16, 0 },
+	[NS2_BIND_STAT_TX_BATCH] = { "tx_batch_size",	"Datagrams sent per sendmmsg() call", "packets", 16, 0 },
+};
+
+static const struct rate_ctr_desc nsbind_ctr_description[] = {
+	[NS2_BIND_CTR_RX_BATCHES]	= { "rx:batches",	"Received recvmmsg() batches" },
+	[NS2_BIND_CTR_RX_DGRAMS]	= { "rx:batch_datagrams", "Datagrams received in batches" },
+	[NS2_BIND_CTR_TX_BATCHES]	= { "tx:batches",	"Sent sendmmsg() batches" },
+	[NS2_BIND_CTR_TX_DGRAMS]	= { "tx:batch_datagrams", "Datagrams sent in batches" },
+	[NS2_BIND_CTR_TX_DROPPED]	= { "tx:batch_dropped",	"Datagrams of batches dropped on send errors" },
+};
+
+static const struct rate_ctr_group_desc nsbind_ctrg_desc = {
+	.group_name_prefix = "ns:bind",
+	.group_description = "NS Bind Statistics",
+	.num_ctr = ARRAY_SIZE(nsbind_ctr_description),
+	.ctr_desc = nsbind_ctr_description,
+	.class_id = OSMO_STATS_CLASS_PEER,
 };
 
 static const struct osmo_stat_item_group_desc nsbind_statg_desc = {
@@ -647,6 +665,8 @@ void gprs_ns2_free_nsvc(struct gprs_ns2_vc *nsvc)
 
 	llist_del(&nsvc->list);
 	llist_del(&nsvc->blist);
+	hash_del(&nsvc->hnode_nsvci);
+	hash_del(&nsvc->hnode_remote);
 
 	/* notify nse this nsvc is unavailable */
 	ns2_nse_notify_unblocked(nsvc, false);
@@ -771,7 +791,7 @@ struct gprs_ns2_nse *gprs_ns2_nse_by_nsei(struct gprs_ns2_inst *nsi, uint16_t ns
 {
 	struct gprs_ns2_nse *nse;
 
-	llist_for_each_entry(nse, &nsi->nse, list) {
+	hash_for_each_possible(nsi->nse_by_nsei, nse, hnode, nsei) {
 		if (nse->nsei == nsei)
 			return nse;
 	}
@@ -785,19 +805,62 @@ struct gprs_ns2_nse *gprs_ns2_nse_by_nsei(struct gprs_ns2_inst *nsi, uint16_t ns
  *  \return NS-VC Entity in successful case; NULL if none found */
 struct gprs_ns2_vc *gprs_ns2_nsvc_by_nsvci(struct gprs_ns2_inst *nsi, uint16_t nsvci)
 {
-	struct gprs_ns2_nse *nse;
 	struct gprs_ns2_vc *nsvc;
 
-	llist_for_each_entry(nse, &nsi->nse, list) {
-		llist_for_each_entry(nsvc, &nse->nsvc, list) {
-			if (nsvc->nsvci_is_valid && nsvc->nsvci == nsvci)
-				return nsvc;
-		}
+	hash_for_each_possible(nsi->nsvc_by_nsvci, nsvc, hnode_nsvci, nsvci) {
+		if (nsvc->nsvci == nsvci)
+			return nsvc;
 	}
 
 	return NULL;
 }
 
+/*! Set the NS-VCI of a NS-VC and mark it valid, updating the NSVCI index
+ *  \param[in] nsvc NS-VC to modify
+ *  \param[in] nsvci NS-VCI to set */
+void ns2_vc_set_nsvci(struct gprs_ns2_vc *nsvc, uint16_t nsvci)
+{
+	hash_del(&nsvc->hnode_nsvci);
+	nsvc->nsvci = nsvci;
+	nsvc->nsvci_is_valid = true;
+	hash_add(nsvc->bind->nsi->nsvc_by_nsvci, &nsvc->hnode_nsvci, nsvci);
+}
+
+/*! Mark the NS-VCI of a NS-VC invalid, removing it from the NSVCI index
+ *  \param[in] nsvc NS-VC to modify */
+void ns2_vc_clear_nsvci(struct gprs_ns2_vc *nsvc)
+{
+	hash_del(&nsvc->hnode_nsvci);
+	nsvc->nsvci_is_valid = false;
+}
+
+/*! Hash a remote socket address for gprs_ns2_inst.nsvc_by_remote
+ *  \param[in] saddr IPv4 or IPv6 socket address
+ *  \returns hash key covering address and port */
+uint32_t ns2_sockaddr_hash(const struct osmo_sockaddr *saddr)
+{
+	const uint32_t *a;
+
+	switch (saddr->u.sa.sa_family) {
+	case AF_INET:
+		return saddr->u.sin.sin_addr.s_addr ^ saddr->u.sin.sin_port;
+	case AF_INET6:
+		a = (const uint32_t *)&saddr->u.sin6.sin6_addr;
+		return a[0] ^ a[1] ^ a[2] ^ a[3] ^ saddr->u.sin6.sin6_port;
+	default:
+		return 0;
+	}
+}
+
+/*! Add an IP NS-VC to the remote address index, see gprs_ns2_nsvc_by_sockaddr_bind()
+ *  \param[in] nsvc NS-VC to add
+ *  \param[in] remote remote address of the NS-VC */
+void ns2_vc_hash_remote(struct gprs_ns2_vc *nsvc, const struct osmo_sockaddr *remote)
+{
+	hash_del(&nsvc->hnode_remote);
+	hash_add(nsvc->bind->nsi->nsvc_by_remote, &nsvc->hnode_remote, ns2_sockaddr_hash(remote));
+}
+
 /*! Create a NS Entity within given NS instance.
  *  \param[in] nsi NS instance in which to create NS Entity
  *  \param[in] nsei NS Entity Identifier of to-be-created NSE
@@ -838,6 +901,7 @@ struct gprs_ns2_nse *gprs_ns2_create_nse2(struct gprs_ns2_inst *nsi, uint16_t ns
 	nse->first = true;
 	nse->mtu = 0;
 	llist_add_tail(&nse->list, &nsi->nse);
+	hash_add(nsi->nse_by_nsei, &nse->hnode, nsei);
 	INIT_LLIST_HEAD(&nse->nsvc);
 	osmo_clock_gettime(CLOCK_MONOTONIC, &nse->ts_alive_change);
 
@@ -918,6 +982,7 @@ void gprs_ns2_free_nse(struct gprs_ns2_nse *nse)
 	ns2_free_nsvcs(nse);
 
 	llist_del(&nse->list);
+	hash_del(&nse->hnode);
 	talloc_free(nse);
 }
 
@@ -987,7 +1052,7 @@ static enum ns2_cs ns2_create_vc_sns(struct gprs_ns2_vc_bind *bind,
 	if (!nsvc)
 		return NS2_CS_SKIPPED;
 
-	nsvc->nsvci_is_valid = false;
+	ns2_vc_clear_nsvci(nsvc);
 
 	*success = nsvc;
 
@@ -1161,8 +1226,7 @@ enum ns2_cs ns2_create_vc(struct gprs_ns2_vc_bind *bind,
 	if (!nsvc)
 		return NS2_CS_SKIPPED;
 
-	nsvc->nsvci = nsvci;
-	nsvc->nsvci_is_valid = true;
+	ns2_vc_set_nsvci(nsvc, nsvci);
 
 	*success = nsvc;
 
@@ -1186,10 +1250,8 @@ struct gprs_ns2_vc *gprs_ns2_ip_connect_inactive(struct gprs_ns2_vc_bind *bind,
 	if (!nsvc)
 		return NULL;
 
-	if (nsvc->mode == GPRS_NS2_VC_MODE_BLOCKRESET) {
-		nsvc->nsvci = nsvci;
-		nsvc->nsvci_is_valid = true;
-	}
+	if (nsvc->mode == GPRS_NS2_VC_MODE_BLOCKRESET)
+		ns2_vc_set_nsvci(nsvc, nsvci);
 
 	return nsvc;
 }
@@ -1251,7 +1313,9 @@ struct gprs_ns2_vc *gprs_ns2_nsvc_by_sockaddr_nse(struct gprs_ns2_nse *nse,
 	OSMO_ASSERT(nse);
 	OSMO_ASSERT(sockaddr);
 
-	llist_for_each_entry(nsvc, &nse->nsvc, list) {
+	hash_for_each_possible(nse->nsi->nsvc_by_remote, nsvc, hnode_remote, ns2_sockaddr_hash(sockaddr)) {
+		if (nsvc->nse != nse)
+			continue;
 		remote = gprs_ns2_ip_vc_remote(nsvc);
 		if (!osmo_sockaddr_cmp(sockaddr, remote))
 			return nsvc;
@@ -1438,6 +1502,9 @@ struct gprs_ns2_inst *gprs_ns2_instantiate(void *ctx, osmo_prim_cb cb, void *cb_
 	nsi->cb_data = cb_data;
 	INIT_LLIST_HEAD(&nsi->binding);
 	INIT_LLIST_HEAD(&nsi->nse);
+	hash_init(nsi->nse_by_nsei);
+	hash_init(nsi->nsvc_by_nsvci);
+	hash_init(nsi->nsvc_by_remote);
 
 	nsi->timeout[NS_TOUT_TNS_BLOCK] = 3;
 	nsi->timeout[NS_TOUT_TNS_BLOCK_RETRIES] = 3;
@@ -1512,6 +1579,7 @@ void gprs_ns2_free_bind(struct gprs_ns2_vc_bind *bind)
 
 	llist_del(&bind->list);
 	osmo_stat_item_group_free(bind->statg);
+	rate_ctr_group_free(bind->ctrg);
 	talloc_free((char *)bind->name);
 	talloc_free(bind);
 }
@@ -1676,6 +1744,13 @@ int ns2_bind_alloc(struct gprs_ns2_inst *nsi, const char *name,
 		return -ENOMEM;
 	}
 
+	bind->ctrg = rate_ctr_group_alloc(bind, &nsbind_ctrg_desc, nsi->bind_rate_ctr_idx);
+	if (!bind->ctrg) {
+		osmo_stat_item_group_free(bind->statg);
+		talloc_free(bind);
+		return -ENOMEM;
+	}
+
 	bind->sns_sig_weight = 1;
 	bind->sns_data_weight = 1;
 	bind->nsi = nsi;
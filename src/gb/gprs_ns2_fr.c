@@ -986,8 +986,7 @@ struct gprs_ns2_vc *gprs_ns2_fr_connect(struct gprs_ns2_vc_bind *bind,
 	if (!priv)
 		goto err;
 
-	nsvc->nsvci = nsvci;
-	nsvc->nsvci_is_valid = true;
+	ns2_vc_set_nsvci(nsvc, nsvci);
 
 	return nsvc;
 
@@ -5,6 +5,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <osmocom/core/hashtable.h>
 #include <osmocom/core/logging.h>
 #include <osmocom/gprs/protocol/gsm_08_16.h>
 #include <osmocom/gprs/gprs_ns2.h>
@@ -107,6 +108,16 @@ enum ns2_vc_stat {
 
 enum ns2_bind_stat {
 	NS2_BIND_STAT_BACKLOG_LEN,
+	NS2_BIND_STAT_RX_BATCH,
+	NS2_BIND_STAT_TX_BATCH,
+};
+
+enum ns2_bind_ctr {
+	NS2_BIND_CTR_RX_BATCHES,
+	NS2_BIND_CTR_RX_DGRAMS,
+	NS2_BIND_CTR_TX_BATCHES,
+	NS2_BIND_CTR_TX_DGRAMS,
+	NS2_BIND_CTR_TX_DROPPED,
 };
 
 /*! Osmocom NS2 VC create status */
@@ -158,6 +169,13 @@ struct gprs_ns2_inst {
 	/*! linked lists of all NSVC in this instance */
 	struct llist_head nse;
 
+	/*! all NSEs, hashed by NSEI */
+	DECLARE_HASHTABLE(nse_by_nsei, 12);
+	/*! all NS-VCs with a valid NSVCI, hashed by NSVCI */
+	DECLARE_HASHTABLE(nsvc_by_nsvci, 12);
+	/*! all IP NS-VCs, hashed by remote address, see ns2_sockaddr_hash() */
+	DECLARE_HASHTABLE(nsvc_by_remote, 12);
+
 	uint16_t timeout[NS_TIMERS_COUNT];
 
 	/*! workaround for rate counter until rate counter accepts char str as index */
@@ -179,6 +197,9 @@ struct gprs_ns2_nse {
 	/*! llist entry for gprs_ns2_inst */
 	struct llist_head list;
 
+	/*! entry in gprs_ns2_inst.nse_by_nsei */
+	struct hlist_node hnode;
+
 	/*! llist head to hold all nsvc */
 	struct llist_head nsvc;
 
@@ -233,6 +254,11 @@ struct gprs_ns2_vc {
 	/*! list of NS-VCs within bind, bind is the owner! */
 	struct llist_head blist;
 
+	/*! entry in gprs_ns2_inst.nsvc_by_nsvci, if nsvci_is_valid */
+	struct hlist_node hnode_nsvci;
+	/*! entry in gprs_ns2_inst.nsvc_by_remote, for IP NS-VCs */
+	struct hlist_node hnode_remote;
+
 	/*! pointer to NS Instance */
 	struct gprs_ns2_nse *nse;
 
@@ -316,6 +342,7 @@ struct gprs_ns2_vc_bind {
 	/*! the IP-SNS data weight when doing dynamic configuration */
 	uint8_t sns_data_weight;
 
+	struct rate_ctr_group *ctrg;
 	struct osmo_stat_item_group *statg;
 
 	/*! recursive anchor */
@@ -369,6 +396,11 @@ int ns2_bind_alloc(struct gprs_ns2_inst *nsi, const char *name,
 
 struct msgb *ns2_msgb_alloc(void);
 
+void ns2_vc_set_nsvci(struct gprs_ns2_vc *nsvc, uint16_t nsvci);
+void ns2_vc_clear_nsvci(struct gprs_ns2_vc *nsvc);
+uint32_t ns2_sockaddr_hash(const struct osmo_sockaddr *saddr);
+void ns2_vc_hash_remote(struct gprs_ns2_vc *nsvc, const struct osmo_sockaddr *remote);
+
 void ns2_sns_write_vty(struct vty *vty, const struct gprs_ns2_nse *nse);
 void ns2_sns_dump_vty(struct vty *vty, const char *prefix, const struct gprs_ns2_nse *nse, bool stats);
 void ns2_prim_status_ind(struct gprs_ns2_nse *nse,
@@ -26,11 +26,24 @@
  *
  */
 
+#include "config.h"
+
+/* recvmmsg() and sendmmsg() require _GNU_SOURCE */
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+#define _GNU_SOURCE
+#define NS2_IP_HAVE_MMSG 1
+#endif
+
 #include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
+#include <osmocom/core/rate_ctr.h>
 #include <osmocom/core/select.h>
 #include <osmocom/core/sockaddr_str.h>
 #include <osmocom/core/socket.h>
+#include <osmocom/core/stat_item.h>
+#include <osmocom/core/talloc.h>
 #include <osmocom/gprs/gprs_ns2.h>
 
 #include "common_vty.h"
@@ -45,13 +58,34 @@ struct gprs_ns2_vc_driver vc_driver_ip = {
 	.free_bind = free_bind,
 };
 
+/* datagrams of one recvmmsg() or sendmmsg() call */
+struct nsip_batch {
+	/* maximum number of datagrams per call; 1 means recvfrom()/sendto() per datagram */
+	unsigned int size;
+	/* tx: number of datagrams queued for the next sendmmsg() */
+	unsigned int num;
+	struct msgb **msg;
+	struct osmo_sockaddr *addr;
+#ifdef NS2_IP_HAVE_MMSG
+	struct mmsghdr *mmsg;
+	struct iovec *iov;
+#endif
+};
+
 struct priv_bind {
 	struct osmo_fd fd;
 	struct osmo_sockaddr addr;
 	int dscp;
 	uint8_t priority;
+	struct nsip_batch rx;
+	struct nsip_batch tx;
+	/* set while received messages are being dispatched; free_bind() sets *rx_freed */
+	bool *rx_freed;
 };
 
+static void nsip_tx_flush(struct gprs_ns2_vc_bind *bind);
+static void nsip_batch_free(struct nsip_batch *b);
+
 struct priv_vc {
 	struct osmo_sockaddr remote;
 };
@@ -68,6 +102,11 @@ static void free_bind(struct gprs_ns2_vc_bind *bind)
 
 	priv = bind->priv;
 
+	nsip_tx_flush(bind);
+	nsip_batch_free(&priv->rx);
+	if (priv->rx_freed)
+		*priv->rx_freed = true;
+
 	osmo_fd_close(&priv->fd);
 	talloc_free(priv);
 }
@@ -81,6 +120,7 @@ static void free_vc(struct gprs_ns2_vc *nsvc)
 		return;
 
 	OSMO_ASSERT(gprs_ns2_is_ip_bind(nsvc->bind));
+	hash_del(&nsvc->hnode_remote);
 	talloc_free(nsvc->priv);
 	nsvc->priv = NULL;
 }
@@ -106,6 +146,8 @@ static void dump_vty(const struct gprs_ns2_vc_bind *bind,
 
 	vty_out(vty, "UDP bind: %s:%d DSCP: %d Priority: %u%s", sockstr.ip, sockstr.port,
 		priv->dscp, priv->priority, VTY_NEWLINE);
+	if (priv->rx.size > 1 || priv->tx.size > 1)
+		vty_out(vty, "  Batch size rx: %u tx: %u%s", priv->rx.size, priv->tx.size, VTY_NEWLINE);
 	vty_out(vty, "  IP-SNS signalling weight: %u data weight: %u%s",
 		bind->sns_sig_weight, bind->sns_data_weight, VTY_NEWLINE);
 	vty_out(vty, "  %lu NS-VC:%s", nsvcs, VTY_NEWLINE);
@@ -128,7 +170,9 @@ struct gprs_ns2_vc *gprs_ns2_nsvc_by_sockaddr_bind(struct gprs_ns2_vc_bind *bind
 
 	OSMO_ASSERT(gprs_ns2_is_ip_bind(bind));
 
-	llist_for_each_entry(nsvc, &bind->nsvc, blist) {
+	hash_for_each_possible(bind->nsi->nsvc_by_remote, nsvc, hnode_remote, ns2_sockaddr_hash(saddr)) {
+		if (nsvc->bind != bind)
+			continue;
 		vcpriv = nsvc->priv;
 		if (vcpriv->remote.u.sa.sa_family != saddr->u.sa.sa_family)
 			continue;
@@ -141,12 +185,118 @@ struct gprs_ns2_vc *gprs_ns2_nsvc_by_sockaddr_bind(struct gprs_ns2_vc_bind *bind
 	return NULL;
 }
 
+static void nsip_batch_free(struct nsip_batch *b)
+{
+	unsigned int i;
+
+	if (b->msg) {
+		for (i = 0; i < b->size; i++)
+			msgb_free(b->msg[i]);
+	}
+	TALLOC_FREE(b->msg);
+	TALLOC_FREE(b->addr);
+#ifdef NS2_IP_HAVE_MMSG
+	TALLOC_FREE(b->mmsg);
+	TALLOC_FREE(b->iov);
+#endif
+	b->num = 0;
+	b->size = 1;
+}
+
+static int nsip_batch_alloc(void *ctx, struct nsip_batch *b, unsigned int size)
+{
+	nsip_batch_free(b);
+	if (size <= 1)
+		return 0;
+
+#ifdef NS2_IP_HAVE_MMSG
+	b->msg = talloc_zero_array(ctx, struct msgb *, size);
+	b->addr = talloc_zero_array(ctx, struct osmo_sockaddr, size);
+	b->mmsg = talloc_zero_array(ctx, struct mmsghdr, size);
+	b->iov = talloc_zero_array(ctx, struct iovec, size);
+	if (!b->msg || !b->addr || !b->mmsg || !b->iov) {
+		nsip_batch_free(b);
+		return -ENOMEM;
+	}
+	b->size = size;
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+/* send all datagrams queued on the bind with as few sendmmsg() calls as possible */
+static void nsip_tx_flush(struct gprs_ns2_vc_bind *bind)
+{
+	struct priv_bind *priv = bind->priv;
+	struct nsip_batch *b = &priv->tx;
+	unsigned int i, sent = 0;
+	int rc;
+
+	if (!b->num)
+		return;
+
+	osmo_fd_write_disable(&priv->fd);
+
+#ifdef NS2_IP_HAVE_MMSG
+	for (i = 0; i < b->num; i++) {
+		b->iov[i].iov_base = msgb_data(b->msg[i]);
+		b->iov[i].iov_len = msgb_length(b->msg[i]);
+		b->mmsg[i].msg_hdr = (struct msghdr) {
+			.msg_name = &b->addr[i].u.sa,
+			.msg_namelen = sizeof(b->addr[i]),
+			.msg_iov = &b->iov[i],
+			.msg_iovlen = 1,
+		};
+	}
+
+	while (sent < b->num) {
+		rc = sendmmsg(priv->fd.fd, &b->mmsg[sent], b->num - sent, 0);
+		if (rc < 0 && errno == EINTR)
+			continue;
+		if (rc <= 0) {
+			LOGBIND(bind, LOGL_ERROR, "send error %s during NSIP sendmmsg %s, dropping %u PDUs\n",
+				strerror(errno), osmo_sock_get_name2(priv->fd.fd), b->num - sent);
+			rate_ctr_add(rate_ctr_group_get_ctr(bind->ctrg, NS2_BIND_CTR_TX_DROPPED), b->num - sent);
+			break;
+		}
+		osmo_stat_item_set(osmo_stat_item_group_get_item(bind->statg, NS2_BIND_STAT_TX_BATCH), rc);
+		rate_ctr_inc(rate_ctr_group_get_ctr(bind->ctrg, NS2_BIND_CTR_TX_BATCHES));
+		rate_ctr_add(rate_ctr_group_get_ctr(bind->ctrg, NS2_BIND_CTR_TX_DGRAMS), rc);
+		sent += rc;
+	}
+#endif
+
+	for (i = 0; i < b->num; i++) {
+		msgb_free(b->msg[i]);
+		b->msg[i] = NULL;
+	}
+	b->num = 0;
+}
+
+/* Send msg to dest and free it.  With tx batching enabled, returns the length of
+ * msg once it is queued; PDUs dropped when the queue is flushed are only
+ * counted by the tx:batch_dropped rate counter of the bind. */
 static inline int nsip_sendmsg(struct gprs_ns2_vc_bind *bind,
 			       struct msgb *msg,
 			       struct osmo_sockaddr *dest)
 {
 	int rc;
 	struct priv_bind *priv = bind->priv;
+	struct nsip_batch *b = &priv->tx;
+
+	if (b->size > 1) {
+		/* coalesce with other PDUs of this select() iteration; sent once the socket is
+		 * reported writable, i.e. on the next iteration, or when the batch is full */
+		rc = msgb_length(msg);
+		b->msg[b->num] = msg;
+		b->addr[b->num] = *dest;
+		if (++b->num == b->size)
+			nsip_tx_flush(bind);
+		else if (b->num == 1)
+			osmo_fd_write_enable(&priv->fd);
+		return rc;
+	}
 
 	rc = sendto(priv->fd.fd, msg->data, msg->len, 0,
 		    &dest->u.sa, sizeof(*dest));
@@ -159,7 +309,7 @@ static inline int nsip_sendmsg(struct gprs_ns2_vc_bind *bind,
 /*! send the msg and free it afterwards.
  * \param nsvc NS-VC on which the message shall be sent
  * \param msg message to be sent
- * \return number of bytes transmitted; negative on error */
+ * \return number of bytes transmitted, or queued for a batched sendmmsg(); negative on error */
 static int nsip_vc_sendmsg(struct gprs_ns2_vc *nsvc, struct msgb *msg)
 {
 	int rc;
@@ -212,28 +362,23 @@ static struct priv_vc *ns2_driver_alloc_vc(struct gprs_ns2_vc_bind *bind, struct
 
 	nsvc->priv = priv;
 	priv->remote = *remote;
+	ns2_vc_hash_remote(nsvc, remote);
 
 	return priv;
 }
 
-static int handle_nsip_read(struct osmo_fd *bfd)
+/* dispatch a received NS-over-IP message to its NS-VC, creating it if needed */
+static int nsip_rx_msg(struct gprs_ns2_vc_bind *bind, struct msgb *msg, struct osmo_sockaddr *saddr)
 {
 	int rc = 0;
-	int error = 0;
-	struct gprs_ns2_vc_bind *bind = bfd->data;
-	struct osmo_sockaddr saddr;
 	struct gprs_ns2_vc *nsvc;
-	struct msgb *msg = read_nsip_msg(bfd, &error, &saddr, bind);
 	struct msgb *reject;
 
-	if (!msg)
-		return -EINVAL;
-
 	/* check if a vc is available */
-	nsvc = gprs_ns2_nsvc_by_sockaddr_bind(bind, &saddr);
+	nsvc = gprs_ns2_nsvc_by_sockaddr_bind(bind, saddr);
 	if (!nsvc) {
 		/* VC not found */
-		rc = ns2_create_vc(bind, msg, &saddr, "newconnection", &reject, &nsvc);
+		rc = ns2_create_vc(bind, msg, saddr, "newconnection", &reject, &nsvc);
 		switch (rc) {
 		case NS2_CS_FOUND:
 			break;
@@ -243,10 +388,10 @@ static int handle_nsip_read(struct osmo_fd *bfd)
 			goto out;
 		case NS2_CS_REJECTED:
 			/* nsip_sendmsg will free reject */
-			rc = nsip_sendmsg(bind, reject, &saddr);
+			rc = nsip_sendmsg(bind, reject, saddr);
 			goto out;
 		case NS2_CS_CREATED:
-			ns2_driver_alloc_vc(bind, nsvc, &saddr);
+			ns2_driver_alloc_vc(bind, nsvc, saddr);
 			/* only start the fsm for non SNS. SNS will take care of its own */
 			if (nsvc->nse->dialect != GPRS_NS2_DIALECT_SNS)
 				ns2_vc_fsm_start(nsvc);
@@ -261,18 +406,117 @@ out:
 	return rc;
 }
 
+#ifdef NS2_IP_HAVE_MMSG
+/* Read up to rx.size NS-over-IP messages with a single recvmmsg() */
+static int handle_nsip_read_batch(struct osmo_fd *bfd)
+{
+	struct gprs_ns2_vc_bind *bind = bfd->data;
+	struct priv_bind *priv = bind->priv;
+	struct nsip_batch *b = &priv->rx;
+	bool freed = false;
+	unsigned int i, num;
+	int rc;
+
+	/* refill the msgbs handed on by the previous call */
+	for (num = 0; num < b->size; num++) {
+		if (!b->msg[num]) {
+			b->msg[num] = ns2_msgb_alloc();
+			if (!b->msg[num])
+				break;
+		}
+		b->iov[num].iov_base = b->msg[num]->data;
+		b->iov[num].iov_len = NS_ALLOC_SIZE - NS_ALLOC_HEADROOM;
+		b->mmsg[num].msg_hdr = (struct msghdr) {
+			.msg_name = &b->addr[num].u.sa,
+			.msg_namelen = sizeof(b->addr[num]),
+			.msg_iov = &b->iov[num],
+			.msg_iovlen = 1,
+		};
+	}
+	if (!num)
+		return -ENOMEM;
+
+	rc = recvmmsg(bfd->fd, b->mmsg, num, MSG_DONTWAIT, NULL);
+	if (rc < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return 0;
+		LOGBIND(bind, LOGL_ERROR, "recv error %s during NSIP recvmmsg %s\n",
+			strerror(errno), osmo_sock_get_name2(bfd->fd));
+		return -errno;
+	}
+	osmo_stat_item_set(osmo_stat_item_group_get_item(bind->statg, NS2_BIND_STAT_RX_BATCH), rc);
+	rate_ctr_inc(rate_ctr_group_get_ctr(bind->ctrg, NS2_BIND_CTR_RX_BATCHES));
+	rate_ctr_add(rate_ctr_group_get_ctr(bind->ctrg, NS2_BIND_CTR_RX_DGRAMS), rc);
+
+	/* the bind might be freed by the user while handling one of the messages */
+	priv->rx_freed = &freed;
+	for (i = 0; i < rc && !freed; i++) {
+		struct msgb *msg = b->msg[i];
+		b->msg[i] = NULL;
+
+		if (b->mmsg[i].msg_len == 0) {
+			msgb_free(msg);
+			continue;
+		}
+		msg->l2h = msg->data;
+		msgb_put(msg, b->mmsg[i].msg_len);
+		nsip_rx_msg(bind, msg, &b->addr[i]);
+	}
+	/* bfd and bind are gone, tell nsip_fd_cb() */
+	if (freed)
+		return -EBADF;
+	priv->rx_freed = NULL;
+
+	return 0;
+}
+#endif
+
+static int handle_nsip_read(struct osmo_fd *bfd)
+{
+	int error = 0;
+	struct gprs_ns2_vc_bind *bind = bfd->data;
+	struct priv_bind *priv = bind->priv;
+	struct osmo_sockaddr saddr;
+	struct msgb *msg;
+	bool freed = false;
+	int rc;
+
+#ifdef NS2_IP_HAVE_MMSG
+	if (priv->rx.size > 1)
+		return handle_nsip_read_batch(bfd);
+#endif
+
+	msg = read_nsip_msg(bfd, &error, &saddr, bind);
+	if (!msg)
+		return -EINVAL;
+
+	/* the bind might be freed by the user while handling the message */
+	priv->rx_freed = &freed;
+	rc = nsip_rx_msg(bind, msg, &saddr);
+	if (freed)
+		return -EBADF;
+	priv->rx_freed = NULL;
+
+	return rc;
+}
+
 static int handle_nsip_write(struct osmo_fd *bfd)
 {
-	/* FIXME: actually send the data here instead of nsip_sendmsg() */
-	return -EIO;
+	/* only enabled while PDUs are queued for batched transmission */
+	nsip_tx_flush(bfd->data);
+	return 0;
 }
 
 static int nsip_fd_cb(struct osmo_fd *bfd, unsigned int what)
 {
 	int rc = 0;
 
-	if (what & OSMO_FD_READ)
+	if (what & OSMO_FD_READ) {
 		rc = handle_nsip_read(bfd);
+		/* the bind was freed while handling the received messages */
+		if (rc == -EBADF)
+			return rc;
+	}
 	if (what & OSMO_FD_WRITE)
 		rc = handle_nsip_write(bfd);
 
@@ -357,6 +601,8 @@ int gprs_ns2_ip_bind(struct gprs_ns2_inst *nsi,
 	priv->fd.data = bind;
 	priv->addr = *local;
 	priv->dscp = dscp;
+	priv->rx.size = 1;
+	priv->tx.size = 1;
 
 	rc = osmo_sock_init_osa_ofd(&priv->fd, SOCK_DGRAM, IPPROTO_UDP,
 				 local, NULL,
@@ -422,6 +668,7 @@ struct gprs_ns2_vc *ns2_ip_bind_connect(struct gprs_ns2_vc_bind *bind,
 
 	priv = nsvc->priv;
 	priv->remote = *remote;
+	ns2_vc_hash_remote(nsvc, remote);
 
 	return nsvc;
 }
@@ -553,6 +800,60 @@ int gprs_ns2_ip_bind_set_priority(struct gprs_ns2_vc_bind *bind, uint8_t priorit
 	return rc;
 }
 
+/*! Set the number of datagrams received per recvmmsg() call of the given bind.
+ *  \param[in] bind the UDP bind to configure
+ *  \param[in] batch maximum number of datagrams read per read event; 1 to read each one with recvfrom()
+ *  \returns 0 on success; -ENOTSUP if recvmmsg() is not available; negative on other errors
+ *
+ * Each read event of the socket drains up to \a batch datagrams into
+ * preallocated msgbs. The batch sizes are reported by the rx_batch_size
+ * stat item of the bind, the number of batches and of datagrams received
+ * in them by its rx:batches and rx:batch_datagrams rate counters. */
+int gprs_ns2_ip_bind_set_rx_batch(struct gprs_ns2_vc_bind *bind, unsigned int batch)
+{
+	struct priv_bind *priv;
+
+	OSMO_ASSERT(gprs_ns2_is_ip_bind(bind));
+	priv = bind->priv;
+
+	if (batch == 0 || batch > NS2_IP_BATCH_MAX)
+		return -EINVAL;
+	if (batch == priv->rx.size)
+		return 0;
+	/* can't replace the msgbs while dispatching them */
+	if (priv->rx_freed)
+		return -EBUSY;
+
+	return nsip_batch_alloc(priv, &priv->rx, batch);
+}
+
+/*! Set the number of datagrams sent per sendmmsg() call of the given bind.
+ *  \param[in] bind the UDP bind to configure
+ *  \param[in] batch maximum number of PDUs to coalesce; 1 to send each one with sendto()
+ *  \returns 0 on success; -ENOTSUP if sendmmsg() is not available; negative on other errors
+ *
+ * PDUs sent on the bind during a select() iteration are queued and sent
+ * together once the socket is writable, i.e. on the next iteration, or
+ * as soon as \a batch PDUs are queued. The batch sizes are reported by
+ * the tx_batch_size stat item of the bind, the number of batches and of
+ * datagrams sent in them by its tx:batches and tx:batch_datagrams rate
+ * counters.  Sending a PDU succeeds once it is queued; PDUs that fail to be
+ * sent later are counted by the tx:batch_dropped rate counter. */
+int gprs_ns2_ip_bind_set_tx_batch(struct gprs_ns2_vc_bind *bind, unsigned int batch)
+{
+	struct priv_bind *priv;
+
+	OSMO_ASSERT(gprs_ns2_is_ip_bind(bind));
+	priv = bind->priv;
+
+	if (batch == 0 || batch > NS2_IP_BATCH_MAX)
+		return -EINVAL;
+	if (batch == priv->tx.size)
+		return 0;
+
+	nsip_tx_flush(bind);
+	return nsip_batch_alloc(priv, &priv->tx, batch);
+}
 
 /*! Count UDP binds compatible with remote */
 int ns2_ip_count_bind(struct gprs_ns2_inst *nsi, struct osmo_sockaddr *remote)
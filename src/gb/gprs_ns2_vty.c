@@ -68,6 +68,8 @@ struct vty_bind {
 	enum gprs_ns2_ll ll;
 	int dscp;
 	uint8_t priority;
+	unsigned int rx_batch;
+	unsigned int tx_batch;
 	bool accept_ipaccess;
 	bool accept_sns;
 	uint8_t ip_sns_sig_weight;
@@ -142,6 +144,8 @@ static struct vty_bind *vty_bind_alloc(const char *name)
 
 	vbind->ip_sns_sig_weight = 1;
 	vbind->ip_sns_data_weight = 1;
+	vbind->rx_batch = 1;
+	vbind->tx_batch = 1;
 	llist_add_tail(&vbind->list, &binds);
 	return vbind;
 }
@@ -473,6 +477,10 @@ static void config_write_vbind(struct vty *vty, struct vty_bind *vbind)
 			vty_out(vty, "  dscp %u%s", vbind->dscp, VTY_NEWLINE);
 		if (vbind->priority)
 			vty_out(vty, "  socket-priority %u%s", vbind->priority, VTY_NEWLINE);
+		if (vbind->rx_batch != 1)
+			vty_out(vty, "  batch rx %u%s", vbind->rx_batch, VTY_NEWLINE);
+		if (vbind->tx_batch != 1)
+			vty_out(vty, "  batch tx %u%s", vbind->tx_batch, VTY_NEWLINE);
 		vty_out(vty, "  ip-sns signalling-weight %u data-weight %u%s",
 			vbind->ip_sns_sig_weight, vbind->ip_sns_data_weight, VTY_NEWLINE);
 		break;
@@ -656,6 +664,13 @@ DEFUN(cfg_ns_bind_listen, cfg_ns_bind_listen_cmd,
 
 	bind->accept_ipaccess = vbind->accept_ipaccess;
 	bind->accept_sns = vbind->accept_sns;
+	rc = gprs_ns2_ip_bind_set_rx_batch(bind, vbind->rx_batch);
+	if (rc == 0)
+		rc = gprs_ns2_ip_bind_set_tx_batch(bind, vbind->tx_batch);
+	if (rc < 0) {
+		vty_out(vty, "Failed to set the batch sizes (rc %d)%s", rc, VTY_NEWLINE);
+		return CMD_WARNING;
+	}
 
 	return CMD_SUCCESS;
 }
@@ -749,6 +764,45 @@ DEFUN(cfg_ns_bind_priority, cfg_ns_bind_priority_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFUN(cfg_ns_bind_batch, cfg_ns_bind_batch_cmd,
+      "batch (rx|tx) <1-1024>",
+      "Configure batched reception/transmission of datagrams on the UDP socket\n"
+      "Number of datagrams to read per recvmmsg() call\n"
+      "Number of PDUs to coalesce per sendmmsg() call\n"
+      "Batch size (1 disables batching)\n")
+{
+	struct vty_bind *vbind = vty->index;
+	struct gprs_ns2_vc_bind *bind;
+	bool rx = argv[0][0] == 'r';
+	unsigned int batch = atoi(argv[1]);
+	int rc = 0;
+
+	if (vbind->ll != GPRS_NS2_LL_UDP) {
+		vty_out(vty, "batch can be only used with UDP bind%s",
+			VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	bind = gprs_ns2_bind_by_name(vty_nsi, vbind->name);
+	if (bind) {
+		if (rx)
+			rc = gprs_ns2_ip_bind_set_rx_batch(bind, batch);
+		else
+			rc = gprs_ns2_ip_bind_set_tx_batch(bind, batch);
+	}
+	if (rc < 0) {
+		vty_out(vty, "Failed to set the %s batch size (rc %d)%s", argv[0], rc, VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	if (rx)
+		vbind->rx_batch = batch;
+	else
+		vbind->tx_batch = batch;
+
+	return CMD_SUCCESS;
+}
+
 DEFUN(cfg_ns_bind_ipaccess, cfg_ns_bind_ipaccess_cmd,
       "accept-ipaccess",
       "Allow to create dynamic NS Entity by NS Reset PDU on UDP (ip.access style)\n"
@@ -2295,6 +2349,7 @@ int gprs_ns2_vty_init(struct gprs_ns2_inst *nsi)
 	install_lib_element(L_NS_BIND_NODE, &cfg_ns_bind_dscp_cmd);
 	install_lib_element(L_NS_BIND_NODE, &cfg_no_ns_bind_dscp_cmd);
 	install_lib_element(L_NS_BIND_NODE, &cfg_ns_bind_priority_cmd);
+	install_lib_element(L_NS_BIND_NODE, &cfg_ns_bind_batch_cmd);
 	install_lib_element(L_NS_BIND_NODE, &cfg_ns_bind_ip_sns_weight_cmd);
 	install_lib_element(L_NS_BIND_NODE, &cfg_ns_bind_ipaccess_cmd);
 	install_lib_element(L_NS_BIND_NODE, &cfg_no_ns_bind_ipaccess_cmd);
@@ -0,0 +1,97 @@
+/*! \file group_class.c
+ * Index of counter and stat item groups by their group name prefix. */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+
+#include "group_class_internal.h"
+#include "name_idx_internal.h"
+
+static struct osmo_group_class *class_find(struct osmo_group_classes *classes, const char *prefix, uint32_t hash)
+{
+	struct osmo_group_class *cls;
+
+	hash_for_each_possible(classes->by_prefix, cls, hnode, hash) {
+		if (!strcmp(cls->prefix, prefix))
+			return cls;
+	}
+	return NULL;
+}
+
+/*! Find the class of a group name prefix
+ *  \param[in] classes index of the groups
+ *  \param[in] prefix group name prefix
+ *  \returns class; NULL if there are no groups with this \a prefix */
+struct osmo_group_class *osmo_group_class_find(struct osmo_group_classes *classes, const char *prefix)
+{
+	return class_find(classes, prefix, osmo_name_idx_hash(prefix));
+}
+
+/*! Add a group to the class of its group name prefix, creating the class if needed
+ *  \param[in] classes index of the groups
+ *  \param[in] ctx talloc context to allocate a new class from
+ *  \param[in] prefix group name prefix of the group
+ *  \param[in] class_list list entry of the group
+ *  \returns 0 on success; -ENOMEM if the class could not be allocated */
+int osmo_group_class_add(struct osmo_group_classes *classes, void *ctx, const char *prefix,
+			 struct llist_head *class_list)
+{
+	uint32_t hash = osmo_name_idx_hash(prefix);
+	struct osmo_group_class *cls = class_find(classes, prefix, hash);
+
+	if (!cls) {
+		cls = talloc_zero(ctx, struct osmo_group_class);
+		if (!cls)
+			return -ENOMEM;
+		cls->prefix = talloc_strdup(cls, prefix);
+		if (!cls->prefix) {
+			talloc_free(cls);
+			return -ENOMEM;
+		}
+		INIT_LLIST_HEAD(&cls->groups);
+		llist_add(&cls->list, &classes->list);
+		hash_add(classes->by_prefix, &cls->hnode, hash);
+	}
+	llist_add(class_list, &cls->groups);
+	return 0;
+}
+
+/*! Remove a group from its class, and free the class with its last group
+ *  \param[in] classes index of the groups
+ *  \param[in] prefix group name prefix of the group
+ *  \param[in] class_list list entry of the group, may be unused if initialized with INIT_LLIST_HEAD() */
+void osmo_group_class_del(struct osmo_group_classes *classes, const char *prefix,
+			  struct llist_head *class_list)
+{
+	struct osmo_group_class *cls;
+
+	if (llist_empty(class_list))
+		return;
+	llist_del(class_list);
+
+	cls = class_find(classes, prefix, osmo_name_idx_hash(prefix));
+	if (cls && llist_empty(&cls->groups)) {
+		llist_del(&cls->list);
+		hash_del(&cls->hnode);
+		talloc_free(cls);
+	}
+}
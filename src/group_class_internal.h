@@ -0,0 +1,35 @@
+/*! \file group_class_internal.h
+ * Internal index of counter and stat item groups by their group name prefix. */
+#pragma once
+
+#include <osmocom/core/hashtable.h>
+#include <osmocom/core/linuxlist.h>
+
+/* All groups sharing a group name prefix.  Groups of the same class may have
+ * different descriptions, when rate_ctr_group_alloc() had to make a copy
+ * with mangled names. */
+struct osmo_group_class {
+	/* entry in osmo_group_classes.list */
+	struct llist_head list;
+	/* entry in osmo_group_classes.by_prefix */
+	struct hlist_node hnode;
+	/* group name prefix, a copy */
+	char *prefix;
+	/* groups of the class, linked by their class_list member, latest first */
+	struct llist_head groups;
+};
+
+/* Classes of one kind of groups; a class exists as long as it has groups */
+struct osmo_group_classes {
+	/* list of struct osmo_group_class, latest first */
+	struct llist_head list;
+	DECLARE_HASHTABLE(by_prefix, 8);
+};
+
+#define OSMO_GROUP_CLASSES_INIT(name) { .list = LLIST_HEAD_INIT((name).list) }
+
+int osmo_group_class_add(struct osmo_group_classes *classes, void *ctx, const char *prefix,
+			 struct llist_head *class_list);
+struct osmo_group_class *osmo_group_class_find(struct osmo_group_classes *classes, const char *prefix);
+void osmo_group_class_del(struct osmo_group_classes *classes, const char *prefix,
+			  struct llist_head *class_list);
@@ -27,10 +27,13 @@
  *  Marc Briceno, Ian Goldberg, and David Wagner.
  */
 
+#include "config.h"
+
 #include <errno.h>
 #include <string.h>
 #include <stdbool.h>
 
+#include <osmocom/core/utils.h>
 #include <osmocom/gsm/a5.h>
 #include <osmocom/gsm/kasumi.h>
 #include <osmocom/crypt/auth.h>
@@ -44,6 +47,24 @@
 /* A5/3&4                                                                   */
 /* ------------------------------------------------------------------------ */
 
+/*! Split the KGCORE output of A5/3&4 into the cipher streams
+ *  \param[in] gamma 228 bits of KGCORE output (114 if ul is NULL)
+ *  \param[out] dl Downlink cipher stream, or NULL
+ *  \param[out] ul Uplink cipher stream, or NULL
+ */
+static inline void
+_a5_4_unpack(const uint8_t *gamma, ubit_t *dl, ubit_t *ul)
+{
+       uint8_t i, uplink[15];
+
+       if (ul) {
+               for(i = 0; i < 15; i++) uplink[i] = (gamma[i + 14] << 2) + (gamma[i + 15] >> 6);
+               osmo_pbit2ubit(ul, uplink, 114);
+       }
+       if (dl)
+               osmo_pbit2ubit(dl, gamma, 114);
+}
+
 /*! Generate a GSM A5/4 cipher stream
  *  \param[in] key 16 byte array for the key (as received from the SIM)
  *  \param[in] fn Frame number
@@ -59,18 +80,15 @@
 void
 _a5_4(const uint8_t *ck, uint32_t fn, ubit_t *dl, ubit_t *ul, bool fn_correct)
 {
-       uint8_t i, gamma[32], uplink[15];
+       uint8_t gamma[32];
        uint32_t fn_count = (fn_correct) ? osmo_a5_fn_count(fn) : fn;
 
-       if (ul) {
-               _kasumi_kgcore(0xF, 0, fn_count, 0, ck, gamma, 228);
-               for(i = 0; i < 15; i++) uplink[i] = (gamma[i + 14] << 2) + (gamma[i + 15] >> 6);
-               osmo_pbit2ubit(ul, uplink, 114);
-       }
-       if (dl) {
-               _kasumi_kgcore(0xF, 0, fn_count, 0, ck, gamma, 114);
-               osmo_pbit2ubit(dl, gamma, 114);
-       }
+       if (!dl && !ul)
+               return;
+
+       /* the downlink stream is the first 114 bits of the uplink one */
+       _kasumi_kgcore(0xF, 0, fn_count, 0, ck, gamma, ul ? 228 : 114);
+       _a5_4_unpack(gamma, dl, ul);
 }
 
 /*! Generate a GSM A5/3 cipher stream
@@ -439,4 +457,217 @@ osmo_a5(int n, const uint8_t *key, uint32_t fn, ubit_t *dl, ubit_t *ul)
 	return 0;
 }
 
+/* ------------------------------------------------------------------------ */
+/* Batch                                                                    */
+/* ------------------------------------------------------------------------ */
+
+/* A5/1&2 bit-sliced across the 64 bits of a word, or across the lanes of a
+ * vector of the compiler (SSE2 on x86, NEON on ARM, plain words otherwise) */
+typedef uint64_t a5_bs_v128 __attribute__ ((vector_size(16)));
+
+#define A5_BS_W		uint64_t
+#define A5_BS_FN	osmo_a5_bs_generic
+#include "a5_bitslice.h"
+
+#define A5_BS_W		a5_bs_v128
+#define A5_BS_FN	osmo_a5_bs_vec128
+#include "a5_bitslice.h"
+
+#if defined(HAVE_AVX2)
+void osmo_a5_bs_avx2(int n, const uint8_t * const *keys, const uint32_t *fn_counts,
+		     ubit_t * const *dl, ubit_t * const *ul, unsigned int num);
+#endif
+
+/* Largest number of lanes of any kernel */
+#define A5_BATCH_LANES_MAX	256
+
+/* Number of pairs of A5/3&4 done by one _kasumi_kgcore_multi() call */
+#define A5_34_BATCH_CHUNK	64
+
+struct a5_batch_kernel {
+	enum osmo_a5_batch_kernel id;
+	unsigned int lanes;
+	void (*fn)(int n, const uint8_t * const *keys, const uint32_t *fn_counts,
+		   ubit_t * const *dl, ubit_t * const *ul, unsigned int num);
+};
+
+/* Kernels, fastest first */
+static const struct a5_batch_kernel a5_batch_kernels[] = {
+#if defined(HAVE_AVX2)
+	{ OSMO_A5_BATCH_KERNEL_AVX2, 256, osmo_a5_bs_avx2 },
+#endif
+	{ OSMO_A5_BATCH_KERNEL_VEC128, 128, osmo_a5_bs_vec128 },
+	{ OSMO_A5_BATCH_KERNEL_GENERIC, 64, osmo_a5_bs_generic },
+};
+
+static enum osmo_a5_batch_kernel a5_batch_kernel_sel = OSMO_A5_BATCH_KERNEL_AUTO;
+
+const struct value_string osmo_a5_batch_kernel_names[] = {
+	{ OSMO_A5_BATCH_KERNEL_AUTO,	"auto" },
+	{ OSMO_A5_BATCH_KERNEL_GENERIC,	"generic" },
+	{ OSMO_A5_BATCH_KERNEL_VEC128,	"vec128" },
+	{ OSMO_A5_BATCH_KERNEL_AVX2,	"avx2" },
+	{ 0, NULL }
+};
+
+static int a5_batch_kernel_supported(enum osmo_a5_batch_kernel id)
+{
+	switch (id) {
+	case OSMO_A5_BATCH_KERNEL_GENERIC:
+	case OSMO_A5_BATCH_KERNEL_VEC128:
+		return 1;
+	case OSMO_A5_BATCH_KERNEL_AVX2:
+#if defined(HAVE_AVX2) && defined(HAVE___BUILTIN_CPU_SUPPORTS)
+		return __builtin_cpu_supports("avx2");
+#else
+		return 0;
+#endif
+	default:
+		return 0;
+	}
+}
+
+/* Find the selected kernel, or the first (fastest) supported one */
+static const struct a5_batch_kernel *a5_batch_kernel_find(enum osmo_a5_batch_kernel id)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(a5_batch_kernels); i++) {
+		if (id != OSMO_A5_BATCH_KERNEL_AUTO && a5_batch_kernels[i].id != id)
+			continue;
+		if (a5_batch_kernel_supported(a5_batch_kernels[i].id))
+			return &a5_batch_kernels[i];
+	}
+
+	return NULL;
+}
+
+/*! Select the A5/1&2 kernel used by osmo_a5_batch()
+ *  \param[in] kernel kernel to use; OSMO_A5_BATCH_KERNEL_AUTO for the fastest one
+ *  \returns 0 on success; -ENOTSUP if not built in or not supported by the CPU */
+int osmo_a5_batch_kernel_set(enum osmo_a5_batch_kernel kernel)
+{
+	if (!a5_batch_kernel_find(kernel))
+		return -ENOTSUP;
+
+	a5_batch_kernel_sel = kernel;
+	return 0;
+}
+
+/*! Get the A5/1&2 kernel used by osmo_a5_batch()
+ *  \returns kernel in use; never OSMO_A5_BATCH_KERNEL_AUTO */
+enum osmo_a5_batch_kernel osmo_a5_batch_kernel_get(void)
+{
+	return a5_batch_kernel_find(a5_batch_kernel_sel)->id;
+}
+
+/*! Get the number of A5/1&2 keystreams generated at once by osmo_a5_batch()
+ *  \returns number of lanes of the kernel in use
+ *
+ *  Batches of a multiple of this number use the kernel most efficiently. */
+unsigned int osmo_a5_batch_lanes(void)
+{
+	return a5_batch_kernel_find(a5_batch_kernel_sel)->lanes;
+}
+
+static void
+_a5_12_batch(int n, const uint8_t * const *keys, const uint32_t *fns,
+	     ubit_t * const *dl, ubit_t * const *ul, unsigned int num)
+{
+	const struct a5_batch_kernel *kern = a5_batch_kernel_find(a5_batch_kernel_sel);
+	uint32_t fn_counts[A5_BATCH_LANES_MAX];
+	unsigned int i, j, chunk;
+
+	for (i = 0; i < num; i += chunk) {
+		chunk = OSMO_MIN(num - i, kern->lanes);
+		for (j = 0; j < chunk; j++)
+			fn_counts[j] = osmo_a5_fn_count(fns[i + j]);
+		kern->fn(n, keys + i, fn_counts, dl ? dl + i : NULL, ul ? ul + i : NULL, chunk);
+	}
+}
+
+static void
+_a5_34_batch(int n, const uint8_t * const *keys, const uint32_t *fns,
+	     ubit_t * const *dl, ubit_t * const *ul, unsigned int num)
+{
+	uint8_t ck[A5_34_BATCH_CHUNK][16], gamma[A5_34_BATCH_CHUNK][32];
+	const uint8_t *ckp[A5_34_BATCH_CHUNK];
+	uint8_t *gammap[A5_34_BATCH_CHUNK];
+	uint32_t fn_counts[A5_34_BATCH_CHUNK];
+	unsigned int i, j, chunk;
+
+	for (j = 0; j < A5_34_BATCH_CHUNK; j++)
+		gammap[j] = gamma[j];
+
+	for (i = 0; i < num; i += chunk) {
+		chunk = OSMO_MIN(num - i, A5_34_BATCH_CHUNK);
+		for (j = 0; j < chunk; j++) {
+			fn_counts[j] = osmo_a5_fn_count(fns[i + j]);
+			if (n == 3) {
+				/* 128 bit key from the 64 bit one, as in _a5_3() */
+				osmo_c4(ck[j], keys[i + j]);
+				ckp[j] = ck[j];
+			} else {
+				ckp[j] = keys[i + j];
+			}
+		}
+
+		/* the downlink stream is the first 114 bits of the uplink one */
+		_kasumi_kgcore_multi(0xF, 0, fn_counts, 0, ckp, gammap, ul ? 228 : 114, chunk);
+
+		for (j = 0; j < chunk; j++)
+			_a5_4_unpack(gamma[j], dl ? dl[i + j] : NULL, ul ? ul[i + j] : NULL);
+	}
+}
+
+/*! Generate the A5/x cipher streams of many (key, frame number) pairs
+ *  \param[in] n Which A5/x method to use
+ *  \param[in] keys array of num keys as in osmo_a5(); may be NULL for A5/0
+ *  \param[in] fns array of num frame numbers
+ *  \param[out] dl array of num downlink cipher streams of 114 ubits, or NULL
+ *  \param[out] ul array of num uplink cipher streams of 114 ubits, or NULL
+ *  \param[in] num number of (key, frame number) pairs
+ *  \returns 0 for success, -ENOTSUP for invalid cipher selection.
+ *
+ * The result is the same as calling osmo_a5() for each pair, but A5/1&2 run
+ * bit-sliced, with one pair per bit of the lanes of the kernel selected by
+ * osmo_a5_batch_kernel_set(), and the KASUMI rounds of several A5/3&4 pairs
+ * are interleaved. dl and ul, as well as any of their entries, can be NULL
+ * if not needed.
+ */
+int
+osmo_a5_batch(int n, const uint8_t * const *keys, const uint32_t *fns,
+	      ubit_t * const *dl, ubit_t * const *ul, unsigned int num)
+{
+	unsigned int i;
+
+	switch (n)
+	{
+	case 0:
+		for (i = 0; i < num; i++) {
+			if (dl && dl[i])
+				memset(dl[i], 0x00, 114);
+			if (ul && ul[i])
+				memset(ul[i], 0x00, 114);
+		}
+		break;
+
+	case 1:
+	case 2:
+		_a5_12_batch(n, keys, fns, dl, ul, num);
+		break;
+
+	case 3:
+	case 4:
+		_a5_34_batch(n, keys, fns, dl, ul, num);
+		break;
+
+	default:
+		/* a5/[5..7] not supported here/yet */
+		return -ENOTSUP;
+	}
+
+	return 0;
+}
+
 /*! @} */
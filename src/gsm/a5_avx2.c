@@ -0,0 +1,29 @@
+/*! \file a5_avx2.c
+ * Bit-sliced A5/1 and A5/2 keystream generator: AVX2 kernel. */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdint.h>
+#include "config.h"
+
+/* 256 keystreams at a time, one per bit of a 256-bit register. This file is
+ * built with -mavx2 and only called if the CPU supports AVX2. */
+typedef uint64_t a5_bs_v256 __attribute__ ((vector_size(32)));
+
+#define A5_BS_W		a5_bs_v256
+#define A5_BS_FN	osmo_a5_bs_avx2
+#include "a5_bitslice.h"
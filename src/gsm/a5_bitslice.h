@@ -0,0 +1,282 @@
+/*! \file a5_bitslice.h
+ * Bit-sliced A5/1 and A5/2 keystream generator.
+ *
+ * Template included by a5.c and a5_avx2.c, which define before including it
+ *  - A5_BS_W:  the lane word type, uint64_t or a GCC vector of uint64_t,
+ *  - A5_BS_FN: the name of the generated keystream function.
+ *
+ * Bit j of each LFSR of the scalar implementation in a5.c is kept in a word
+ * r[j] holding that bit for all lanes, one keystream per bit lane, so that a
+ * clock of all generators takes a few dozen logic operations on whole words.
+ * Conditional clocking multiplexes, per lane, between the shifted and the
+ * unchanged register.
+ */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef A5_BITSLICE_H
+#define A5_BITSLICE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/bit64gen.h>
+#include <osmocom/core/endian.h>
+#include <osmocom/core/utils.h>
+
+#define A5_BS_R1_LEN	19
+#define A5_BS_R2_LEN	22
+#define A5_BS_R3_LEN	23
+#define A5_BS_R4_LEN	17
+
+/* Feedback of the registers, see A5_Rx_TAPS in a5.c */
+#define A5_BS_R1_FB(r)	(r[18] ^ r[17] ^ r[16] ^ r[13])
+#define A5_BS_R2_FB(r)	(r[21] ^ r[20])
+#define A5_BS_R3_FB(r)	(r[22] ^ r[21] ^ r[20] ^ r[7])
+#define A5_BS_R4_FB(r)	(r[16] ^ r[11])
+
+#define A5_BS_MAJ(a, b, c)	(((a) & (b)) | ((a) & (c)) | ((b) & (c)))
+
+/* Clock register r of len bits with feedback fb in all lanes */
+#define A5_BS_SHIFT(r, len, fb) do {					\
+		__typeof__(r[0]) _fb = (fb);				\
+		int _j;							\
+		for (_j = (len) - 1; _j > 0; _j--)			\
+			r[_j] = r[_j - 1];				\
+		r[0] = _fb;						\
+	} while (0)
+
+/* Clock register r of len bits with feedback fb in the lanes set in e */
+#define A5_BS_CLOCK(r, len, fb, e) do {				\
+		__typeof__(r[0]) _fb = (fb), _e = (e);			\
+		int _j;							\
+		for (_j = (len) - 1; _j > 0; _j--)			\
+			r[_j] ^= (r[_j] ^ r[_j - 1]) & _e;		\
+		r[0] ^= (r[0] ^ _fb) & _e;				\
+	} while (0)
+
+#define A5_BS_PASTE2(a, b)	a##b
+#define A5_BS_PASTE(a, b)	A5_BS_PASTE2(a, b)
+
+/* Transpose the 64x64 bit matrix a[]: bit j of a[i] becomes bit i of a[j] */
+static inline void a5_bs_transpose64(uint64_t *a)
+{
+	uint64_t m = 0x00000000ffffffffULL, t;
+	unsigned int j, k;
+
+	for (j = 32; j; j >>= 1, m ^= m << j) {
+		for (k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+			t = ((a[k] >> j) ^ a[k | j]) & m;
+			a[k] ^= t << j;
+			a[k | j] ^= t;
+		}
+	}
+}
+
+/* Transpose the low bits of v[num] into bit planes t[bits][words] */
+static inline void a5_bs_planes(uint64_t *t, unsigned int words, unsigned int bits,
+				const uint64_t *v, unsigned int num)
+{
+	uint64_t a[64];
+	unsigned int i, w;
+
+	for (w = 0; w < words; w++) {
+		memset(a, 0, sizeof(a));
+		if (w * 64 < num) {
+			memcpy(a, &v[w * 64], OSMO_MIN(num - w * 64, 64) * sizeof(*v));
+			a5_bs_transpose64(a);
+		}
+		for (i = 0; i < bits; i++)
+			t[i * words + w] = a[i];
+	}
+}
+
+/* Unpack the len (up to 64) low bits of x to out[] */
+static inline void a5_bs_unpack(ubit_t *out, uint64_t x, unsigned int len)
+{
+	unsigned int i;
+	uint64_t y;
+
+	for (i = 0; i + 8 <= len; i += 8, x >>= 8) {
+		/* byte k of y is bit k of the low byte of x */
+		y = ((x & 0xff) * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+		y = ((y + 0x7f7f7f7f7f7f7f7fULL) >> 7) & 0x0101010101010101ULL;
+#if !OSMO_IS_LITTLE_ENDIAN
+		y = __builtin_bswap64(y);
+#endif
+		memcpy(&out[i], &y, sizeof(y));
+	}
+	for (; i < len; i++, x >>= 1)
+		out[i] = x & 1;
+}
+
+/* Unpack the len bits of the bit planes t[len][words] to the streams out[num] */
+static inline void a5_bs_unplanes(ubit_t * const *out, const uint64_t *t, unsigned int words,
+				  unsigned int len, unsigned int num)
+{
+	uint64_t a[64];
+	unsigned int i, l, w, base, n;
+
+	for (w = 0; w * 64 < num; w++) {
+		for (base = 0; base < len; base += 64) {
+			n = OSMO_MIN(len - base, 64);
+			memset(a, 0, sizeof(a));
+			for (i = 0; i < n; i++)
+				a[i] = t[(base + i) * words + w];
+			a5_bs_transpose64(a);
+			for (l = 0; l < 64 && w * 64 + l < num; l++) {
+				if (out[w * 64 + l])
+					a5_bs_unpack(out[w * 64 + l] + base, a[l], n);
+			}
+		}
+	}
+}
+
+#endif /* A5_BITSLICE_H */
+
+#define A5_BS_WORDS	(sizeof(A5_BS_W) / sizeof(uint64_t))
+#define A5_BS_LANES	(A5_BS_WORDS * 64)
+
+/* Key and frame count loading: clock all registers and xor in the bit b */
+static inline __attribute__ ((always_inline))
+void A5_BS_PASTE(A5_BS_FN, _load)(int n, A5_BS_W *r1, A5_BS_W *r2,
+						 A5_BS_W *r3, A5_BS_W *r4, A5_BS_W b)
+{
+	A5_BS_SHIFT(r1, A5_BS_R1_LEN, A5_BS_R1_FB(r1) ^ b);
+	A5_BS_SHIFT(r2, A5_BS_R2_LEN, A5_BS_R2_FB(r2) ^ b);
+	A5_BS_SHIFT(r3, A5_BS_R3_LEN, A5_BS_R3_FB(r3) ^ b);
+	if (n == 2)
+		A5_BS_SHIFT(r4, A5_BS_R4_LEN, A5_BS_R4_FB(r4) ^ b);
+}
+
+/* Majority clocking of A5/1 (n = 1) or A5/2 (n = 2), see _a5_1_clock() and
+ * _a5_2_clock() in a5.c */
+static inline __attribute__ ((always_inline))
+void A5_BS_PASTE(A5_BS_FN, _clock)(int n, A5_BS_W *r1, A5_BS_W *r2,
+						  A5_BS_W *r3, A5_BS_W *r4)
+{
+	A5_BS_W c1, c2, c3, maj;
+
+	if (n == 1) {
+		c1 = r1[8];
+		c2 = r2[10];
+		c3 = r3[10];
+	} else {
+		c1 = r4[10];
+		c2 = r4[3];
+		c3 = r4[7];
+		A5_BS_SHIFT(r4, A5_BS_R4_LEN, A5_BS_R4_FB(r4));
+	}
+
+	maj = A5_BS_MAJ(c1, c2, c3);
+	A5_BS_CLOCK(r1, A5_BS_R1_LEN, A5_BS_R1_FB(r1), ~(c1 ^ maj));
+	A5_BS_CLOCK(r2, A5_BS_R2_LEN, A5_BS_R2_FB(r2), ~(c2 ^ maj));
+	A5_BS_CLOCK(r3, A5_BS_R3_LEN, A5_BS_R3_FB(r3), ~(c3 ^ maj));
+}
+
+/* Output bit, see _a5_1_get_output() and _a5_2_get_output() in a5.c */
+static inline __attribute__ ((always_inline))
+A5_BS_W A5_BS_PASTE(A5_BS_FN, _output)(int n, const A5_BS_W *r1,
+						      const A5_BS_W *r2, const A5_BS_W *r3)
+{
+	A5_BS_W o = r1[18] ^ r2[21] ^ r3[22];
+
+	if (n == 2) {
+		o ^= A5_BS_MAJ(r1[15], ~r1[14], r1[12]) ^
+		     A5_BS_MAJ(~r2[16], r2[13], r2[9]) ^
+		     A5_BS_MAJ(r3[18], r3[16], ~r3[13]);
+	}
+
+	return o;
+}
+
+static inline __attribute__ ((always_inline))
+void A5_BS_PASTE(A5_BS_FN, _gen)(const int n, const uint8_t * const *keys, const uint32_t *fn_counts,
+				 ubit_t * const *dl, ubit_t * const *ul, unsigned int num)
+{
+	A5_BS_W r1[A5_BS_R1_LEN], r2[A5_BS_R2_LEN], r3[A5_BS_R3_LEN], r4[A5_BS_R4_LEN];
+	A5_BS_W b, ones;
+	uint64_t planes[228][A5_BS_WORDS];
+	uint64_t v[A5_BS_LANES];
+	unsigned int i, l;
+
+	memset(r1, 0, sizeof(r1));
+	memset(r2, 0, sizeof(r2));
+	memset(r3, 0, sizeof(r3));
+	memset(r4, 0, sizeof(r4));
+	memset(&ones, 0xff, sizeof(ones));
+
+	/* Key load */
+	for (l = 0; l < num; l++)
+		v[l] = osmo_load64be(keys[l]);
+	a5_bs_planes(&planes[0][0], A5_BS_WORDS, 64, v, num);
+	for (i = 0; i < 64; i++) {
+		memcpy(&b, planes[i], sizeof(b));
+		A5_BS_PASTE(A5_BS_FN, _load)(n, r1, r2, r3, r4, b);
+	}
+
+	/* Frame count load */
+	for (l = 0; l < num; l++)
+		v[l] = fn_counts[l];
+	a5_bs_planes(&planes[0][0], A5_BS_WORDS, 22, v, num);
+	for (i = 0; i < 22; i++) {
+		memcpy(&b, planes[i], sizeof(b));
+		A5_BS_PASTE(A5_BS_FN, _load)(n, r1, r2, r3, r4, b);
+	}
+
+	if (n == 2) {
+		r1[15] = ones;
+		r2[16] = ones;
+		r3[18] = ones;
+		r4[10] = ones;
+	}
+
+	/* Mix */
+	for (i = 0; i < (n == 1 ? 100 : 99); i++)
+		A5_BS_PASTE(A5_BS_FN, _clock)(n, r1, r2, r3, r4);
+
+	/* Output, downlink then uplink */
+	for (i = 0; i < 228; i++) {
+		A5_BS_PASTE(A5_BS_FN, _clock)(n, r1, r2, r3, r4);
+		b = A5_BS_PASTE(A5_BS_FN, _output)(n, r1, r2, r3);
+		memcpy(planes[i], &b, sizeof(b));
+	}
+
+	if (dl)
+		a5_bs_unplanes(dl, &planes[0][0], A5_BS_WORDS, 114, num);
+	if (ul)
+		a5_bs_unplanes(ul, &planes[114][0], A5_BS_WORDS, 114, num);
+}
+
+/* Generate the A5/1 (n = 1) or A5/2 (n = 2) keystreams of up to A5_BS_LANES
+ * (key, fn_count) pairs, see osmo_a5_batch() for the parameters. */
+__attribute__ ((visibility("hidden")))
+void A5_BS_FN(int n, const uint8_t * const *keys, const uint32_t *fn_counts,
+	      ubit_t * const *dl, ubit_t * const *ul, unsigned int num)
+{
+	/* one instance per algorithm, without the tests on n in the loops */
+	if (n == 1)
+		A5_BS_PASTE(A5_BS_FN, _gen)(1, keys, fn_counts, dl, ul, num);
+	else
+		A5_BS_PASTE(A5_BS_FN, _gen)(2, keys, fn_counts, dl, ul, num);
+}
+
+#undef A5_BS_WORDS
+#undef A5_BS_LANES
+#undef A5_BS_W
+#undef A5_BS_FN
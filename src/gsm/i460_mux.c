@@ -17,6 +17,7 @@
  */
 
 #include <errno.h>
+#include <string.h>
 
 #include <osmocom/core/bits.h>
 #include <osmocom/core/utils.h>
@@ -52,71 +53,115 @@ static bool osmo_i460_has_single_64k_schan(struct osmo_i460_timeslot *ts)
  * Demultiplexer
  ***********************************************************************/
 
+/* number of bits per octet of the timeslot used by a sub-channel of given rate */
+static const uint8_t i460_rate_bits[] = {
+	[OSMO_I460_RATE_64k] = 8,
+	[OSMO_I460_RATE_32k] = 4,
+	[OSMO_I460_RATE_16k] = 2,
+	[OSMO_I460_RATE_8k] = 1,
+};
+
+/* unpacked bits of each nibble value, msb first */
+static const ubit_t nibble_ubits[16][4] = {
+	{ 0, 0, 0, 0 }, { 0, 0, 0, 1 }, { 0, 0, 1, 0 }, { 0, 0, 1, 1 },
+	{ 0, 1, 0, 0 }, { 0, 1, 0, 1 }, { 0, 1, 1, 0 }, { 0, 1, 1, 1 },
+	{ 1, 0, 0, 0 }, { 1, 0, 0, 1 }, { 1, 0, 1, 0 }, { 1, 0, 1, 1 },
+	{ 1, 1, 0, 0 }, { 1, 1, 0, 1 }, { 1, 1, 1, 0 }, { 1, 1, 1, 1 },
+};
+
+/* hand the full out_bitbuf of a sub-channel to the user */
+static void demux_subchan_deliver(struct osmo_i460_subchan *schan)
+{
+	struct osmo_i460_subchan_demux *demux = &schan->demux;
+
+	if (demux->out_cb_bits)
+		demux->out_cb_bits(schan, demux->user_data, demux->out_bitbuf, demux->out_idx);
+	else {
+		/* bits have been packed into bytes on the fly */
+		OSMO_ASSERT((demux->out_idx % 8) == 0);
+		demux->out_cb_bytes(schan, demux->user_data, demux->out_bitbuf, demux->out_idx / 8);
+	}
+	demux->out_idx = 0;
+}
+
 /* append a single bit to a sub-channel */
 static void demux_subchan_append_bit(struct osmo_i460_subchan *schan, uint8_t bit)
 {
 	struct osmo_i460_subchan_demux *demux = &schan->demux;
 
-	OSMO_ASSERT(demux->out_bitbuf);
 	OSMO_ASSERT(demux->out_idx < demux->out_bitbuf_size);
 
 	demux->out_bitbuf[demux->out_idx++] = bit ? 1 : 0;
 
-	if (demux->out_idx >= demux->out_bitbuf_size) {
-		if (demux->out_cb_bits)
-			demux->out_cb_bits(schan, demux->user_data, demux->out_bitbuf, demux->out_idx);
-		else {
-			/* pack bits into bytes */
-			OSMO_ASSERT((demux->out_idx % 8) == 0);
-			unsigned int num_bytes = demux->out_idx / 8;
-			uint8_t bytes[num_bytes];
-			osmo_ubit2pbit(bytes, demux->out_bitbuf, demux->out_idx);
-			demux->out_cb_bytes(schan, demux->user_data, bytes, num_bytes);
+	if (demux->out_idx >= demux->out_bitbuf_size)
+		demux_subchan_deliver(schan);
+}
+
+/* extract those bits relevant to this schan of each byte in 'data' and store them as unpacked bits */
+static void demux_subchan_extract_ubits(struct osmo_i460_subchan *schan, const uint8_t *data, size_t data_len)
+{
+	struct osmo_i460_subchan_demux *demux = &schan->demux;
+	unsigned int num_bits = i460_rate_bits[schan->rate];
+	ubit_t *out = demux->out_bitbuf;
+	unsigned int idx = demux->out_idx;
+	int i, j;
+
+	for (i = 0; i < data_len; i++) {
+		/* I.460 defines sub-channel 0 is using bit positions 1+2 (the two
+		 * most significant bits, hence we extract msb-first */
+		uint8_t inbits = data[i] << schan->bit_offset;
+
+		if (demux->out_bitbuf_size - idx <= 8) {
+			/* close to the end of the buffer, whose size need not be a multiple of num_bits */
+			demux->out_idx = idx;
+			for (j = 0; j < num_bits; j++)
+				demux_subchan_append_bit(schan, inbits & (0x80 >> j));
+			idx = demux->out_idx;
+			continue;
 		}
-		demux->out_idx = 0;
+
+		/* always store 8 bits; those beyond num_bits are overwritten by the next octet */
+		memcpy(&out[idx], nibble_ubits[inbits >> 4], 4);
+		memcpy(&out[idx + 4], nibble_ubits[inbits & 0x0f], 4);
+		idx += num_bits;
 	}
+	demux->out_idx = idx;
 }
 
-/* extract those bits relevant to this schan of each byte in 'data' */
-static void demux_subchan_extract_bits(struct osmo_i460_subchan *schan, const uint8_t *data, size_t data_len)
+/* extract those bits relevant to this schan of each byte in 'data' and store them as packed bits */
+static void demux_subchan_extract_pbits(struct osmo_i460_subchan *schan, const uint8_t *data, size_t data_len)
 {
+	struct osmo_i460_subchan_demux *demux = &schan->demux;
+	unsigned int num_bits = i460_rate_bits[schan->rate];
+	unsigned int shift = 8 - num_bits;
+	unsigned int idx = demux->out_idx;
+	uint8_t *out = &demux->out_bitbuf[idx / 8];
+	uint8_t acc = *out;
 	int i;
 
+	/* out_bitbuf_size is a multiple of 8, and num_bits divides 8, so
+	 * each octet of output is completed within the buffer */
+	OSMO_ASSERT((demux->out_bitbuf_size % 8) == 0);
+
 	for (i = 0; i < data_len; i++) {
-		uint8_t inbyte = data[i];
-		/* I.460 defines sub-channel 0 is using bit positions 1+2 (the two
-		 * most significant bits, hence we extract msb-first */
-		uint8_t inbits = inbyte << schan->bit_offset;
+		uint8_t inbits = (uint8_t)(data[i] << schan->bit_offset) >> shift;
 
-		/* extract the bits relevant to the given schan */
-		switch (schan->rate) {
-		case OSMO_I460_RATE_8k:
-			demux_subchan_append_bit(schan, inbits & 0x80);
-			break;
-		case OSMO_I460_RATE_16k:
-			demux_subchan_append_bit(schan, inbits & 0x80);
-			demux_subchan_append_bit(schan, inbits & 0x40);
-			break;
-		case OSMO_I460_RATE_32k:
-			demux_subchan_append_bit(schan, inbits & 0x80);
-			demux_subchan_append_bit(schan, inbits & 0x40);
-			demux_subchan_append_bit(schan, inbits & 0x20);
-			demux_subchan_append_bit(schan, inbits & 0x10);
-			break;
-		case OSMO_I460_RATE_64k:
-			demux_subchan_append_bit(schan, inbits & 0x80);
-			demux_subchan_append_bit(schan, inbits & 0x40);
-			demux_subchan_append_bit(schan, inbits & 0x20);
-			demux_subchan_append_bit(schan, inbits & 0x10);
-			demux_subchan_append_bit(schan, inbits & 0x08);
-			demux_subchan_append_bit(schan, inbits & 0x04);
-			demux_subchan_append_bit(schan, inbits & 0x02);
-			demux_subchan_append_bit(schan, inbits & 0x01);
-			break;
-		default:
-			OSMO_ASSERT(0);
+		acc = (acc << num_bits) | inbits;
+		idx += num_bits;
+		if (idx % 8)
+			continue;
+
+		*out++ = acc;
+		if (idx >= demux->out_bitbuf_size) {
+			demux->out_idx = idx;
+			demux_subchan_deliver(schan);
+			out = demux->out_bitbuf;
+			idx = 0;
 		}
 	}
+	/* keep the incomplete octet for the next call */
+	*out = acc;
+	demux->out_idx = idx;
 }
 
 /*! Data from E1 timeslot into de-multiplexer
@@ -148,7 +193,11 @@ void osmo_i460_demux_in(struct osmo_i460_timeslot *ts, const uint8_t *data, size
 		schan = &ts->schan[i];
 		if (schan->rate == OSMO_I460_RATE_NONE)
 			continue;
-		demux_subchan_extract_bits(schan, data, data_len);
+		OSMO_ASSERT(schan->demux.out_bitbuf);
+		if (schan->demux.out_cb_bits)
+			demux_subchan_extract_ubits(schan, data, data_len);
+		else
+			demux_subchan_extract_pbits(schan, data, data_len);
 	}
 }
 
@@ -193,74 +242,80 @@ static ubit_t mux_schan_provide_bit(struct osmo_i460_subchan *schan)
 	return bit;
 }
 
-/*! provide one byte with the subchan-specific bits of given sub-channel.
- *  \param[in] schan sub-channel that is to provide bits
- *  \parma[out] mask bitmask of those bits filled in
- *  \returns bits of given sub-channel */
-static uint8_t mux_subchan_provide_bits(struct osmo_i460_subchan *schan, uint8_t *mask)
+/* pack num_bits unpacked bits into the most significant bits of an octet */
+static inline uint8_t mux_pack_bits(const ubit_t *bits, unsigned int num_bits)
 {
 	uint8_t outbits = 0;
-	uint8_t outmask;
+	int i;
 
-	/* I.460 defines sub-channel 0 is using bit positions 1+2 (the two
-	 * most significant bits, hence we provide msb-first */
+	for (i = 0; i < num_bits; i++)
+		outbits |= bits[i] << (7 - i);
+	return outbits;
+}
 
-	switch (schan->rate) {
-	case OSMO_I460_RATE_8k:
-		outbits = mux_schan_provide_bit(schan) << 7;
-		outmask = 0x80;
-		break;
-	case OSMO_I460_RATE_16k:
-		outbits |= mux_schan_provide_bit(schan) << 7;
-		outbits |= mux_schan_provide_bit(schan) << 6;
-		outmask = 0xC0;
-		break;
-	case OSMO_I460_RATE_32k:
-		outbits |= mux_schan_provide_bit(schan) << 7;
-		outbits |= mux_schan_provide_bit(schan) << 6;
-		outbits |= mux_schan_provide_bit(schan) << 5;
-		outbits |= mux_schan_provide_bit(schan) << 4;
-		outmask = 0xF0;
-		break;
-	case OSMO_I460_RATE_64k:
-		outbits |= mux_schan_provide_bit(schan) << 7;
-		outbits |= mux_schan_provide_bit(schan) << 6;
-		outbits |= mux_schan_provide_bit(schan) << 5;
-		outbits |= mux_schan_provide_bit(schan) << 4;
-		outbits |= mux_schan_provide_bit(schan) << 3;
-		outbits |= mux_schan_provide_bit(schan) << 2;
-		outbits |= mux_schan_provide_bit(schan) << 1;
-		outbits |= mux_schan_provide_bit(schan) << 0;
-		outmask = 0xFF;
-		break;
-	default:
-		OSMO_ASSERT(0);
-	}
-	*mask = outmask >> schan->bit_offset;
-	return outbits >> schan->bit_offset;
+/* pack num_bits bits per octet from 'bits' into 'out', for 'n' octets */
+static inline void mux_pack_block(uint8_t *out, const ubit_t *bits, size_t n,
+				  unsigned int num_bits, uint8_t bit_offset)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		out[i] |= mux_pack_bits(&bits[i * num_bits], num_bits) >> bit_offset;
 }
 
-/* provide one byte of multiplexed I.460 bits */
-static uint8_t mux_timeslot_provide_bits(struct osmo_i460_timeslot *ts)
+/*! provide the subchan-specific bits of given sub-channel for a block of octets.
+ *  \param[in] schan sub-channel that is to provide bits
+ *  \param[inout] out octets in which to set the bits of the sub-channel (must be zero)
+ *  \param[in] out_len number of octets at out */
+static void mux_subchan_provide_block(struct osmo_i460_subchan *schan, uint8_t *out, size_t out_len)
 {
-	int i, count = 0;
-	uint8_t ret = 0xff; /* unused bits must be '1' as per I.460 */
+	struct osmo_i460_subchan_mux *mux = &schan->mux;
+	unsigned int num_bits = i460_rate_bits[schan->rate];
+	struct msgb *msg;
+	size_t i = 0, n;
 
-	for (i = 0; i < ARRAY_SIZE(ts->schan); i++) {
-		struct osmo_i460_subchan *schan = &ts->schan[i];
-		uint8_t bits, mask;
+	/* I.460 defines sub-channel 0 is using bit positions 1+2 (the two
+	 * most significant bits, hence we provide msb-first */
 
-		if (schan->rate == OSMO_I460_RATE_NONE)
+	while (i < out_len) {
+		msg = llist_first_entry_or_null(&mux->tx_queue, struct msgb, list);
+		if (!msg || msgb_length(msg) < num_bits) {
+			/* the bits are spread over several msgbs, or the queue needs refilling */
+			ubit_t bits[8];
+			for (n = 0; n < num_bits; n++)
+				bits[n] = mux_schan_provide_bit(schan);
+			out[i++] |= mux_pack_bits(bits, num_bits) >> schan->bit_offset;
 			continue;
-		count++;
-		bits = mux_subchan_provide_bits(schan, &mask);
-		ret &= ~mask;
-		ret |= bits;
-	}
+		}
 
-	return ret;
-}
+		/* take as many whole octets worth of bits from this msgb as possible */
+		n = OSMO_MIN(out_len - i, msgb_length(msg) / num_bits);
+		switch (num_bits) {
+		case 1:
+			mux_pack_block(&out[i], msgb_data(msg), n, 1, schan->bit_offset);
+			break;
+		case 2:
+			mux_pack_block(&out[i], msgb_data(msg), n, 2, schan->bit_offset);
+			break;
+		case 4:
+			mux_pack_block(&out[i], msgb_data(msg), n, 4, schan->bit_offset);
+			break;
+		case 8:
+			mux_pack_block(&out[i], msgb_data(msg), n, 8, schan->bit_offset);
+			break;
+		default:
+			OSMO_ASSERT(0);
+		}
+		msgb_pull(msg, n * num_bits);
+		i += n;
 
+		/* free msgb if we have pulled the last bit */
+		if (msgb_length(msg) <= 0) {
+			llist_del(&msg->list);
+			talloc_free(msg);
+		}
+	}
+}
 
 /*! Data from E1 timeslot into de-multiplexer
  *  \param[in] ts timeslot state
@@ -269,13 +324,31 @@ static uint8_t mux_timeslot_provide_bits(struct osmo_i460_timeslot *ts)
  */
 int osmo_i460_mux_out(struct osmo_i460_timeslot *ts, uint8_t *out, size_t out_len)
 {
+	uint8_t idle = 0xff; /* unused bits must be '1' as per I.460 */
 	int i;
 
-	/* fast path if entire 64k slot is used */
-	//if (osmo_i460_has_single_64k_schan(ts)) { }
+	for (i = 0; i < ARRAY_SIZE(ts->schan); i++) {
+		struct osmo_i460_subchan *schan = &ts->schan[i];
+		uint8_t mask;
+
+		if (schan->rate == OSMO_I460_RATE_NONE)
+			continue;
+		mask = (uint8_t)(0xff << (8 - i460_rate_bits[schan->rate]));
+		idle &= ~(mask >> schan->bit_offset);
+	}
+
+	/* fill the block one sub-channel at a time */
+	memset(out, 0, out_len);
+	for (i = 0; i < ARRAY_SIZE(ts->schan); i++) {
+		struct osmo_i460_subchan *schan = &ts->schan[i];
+
+		if (schan->rate == OSMO_I460_RATE_NONE)
+			continue;
+		mux_subchan_provide_block(schan, out, out_len);
+	}
 
 	for (i = 0; i < out_len; i++)
-		out[i] = mux_timeslot_provide_bits(ts);
+		out[i] |= idle;
 
 	return out_len;
 }
@@ -19,6 +19,7 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 #include <osmocom/core/bits.h>
 #include <osmocom/gsm/kasumi.h>
 
@@ -191,3 +192,95 @@ void _kasumi_kgcore(uint8_t CA, uint8_t cb, uint32_t cc, uint8_t cd, const uint8
 		osmo_store64be_ext(BLK, co + (cl / 64 * 8), bytes_remain);
 	}
 }
+
+/* Number of KGCORE instances _kasumi_kgcore_multi() interleaves */
+#define KASUMI_MULTI_LANES	8
+
+struct kasumi_subkeys {
+	uint16_t KLi1[8], KLi2[8], KOi1[8], KOi2[8], KOi3[8], KIi1[8], KIi2[8], KIi3[8];
+};
+
+static void kasumi_key_expand_sk(const uint8_t *key, struct kasumi_subkeys *k)
+{
+	_kasumi_key_expand(key, k->KLi1, k->KLi2, k->KOi1, k->KOi2, k->KOi3, k->KIi1, k->KIi2, k->KIi3);
+}
+
+/* _kasumi() of n blocks under their own keys, round by round. The S-box lookups
+ * of one block form a long dependency chain; doing the same round of several
+ * blocks back to back lets the CPU overlap the chains. */
+static void kasumi_multi(uint64_t *P, const struct kasumi_subkeys *k, unsigned int n)
+{
+	uint32_t L[KASUMI_MULTI_LANES], R[KASUMI_MULTI_LANES];
+	unsigned int i, l;
+
+	for (l = 0; l < n; l++) {
+		L[l] = P[l] >> 32;
+		R[l] = P[l];
+	}
+
+	for (i = 0; i < 8; i++) {
+		for (l = 0; l < n; l++) /* odd round */
+			R[l] ^= kasumi_FO(kasumi_FL(L[l], k[l].KLi1, k[l].KLi2, i),
+					  k[l].KOi1, k[l].KOi2, k[l].KOi3, k[l].KIi1, k[l].KIi2, k[l].KIi3, i);
+		i++;
+		for (l = 0; l < n; l++) /* even round */
+			L[l] ^= kasumi_FL(kasumi_FO(R[l], k[l].KOi1, k[l].KOi2, k[l].KOi3,
+						    k[l].KIi1, k[l].KIi2, k[l].KIi3, i),
+					  k[l].KLi1, k[l].KLi2, i);
+	}
+
+	for (l = 0; l < n; l++)
+		P[l] = (((uint64_t)L[l]) << 32) + R[l];
+}
+
+/* _kasumi_kgcore() of up to KASUMI_MULTI_LANES (cc, ck) pairs at once */
+static void kasumi_kgcore_lanes(uint8_t CA, uint8_t cb, const uint32_t *cc, uint8_t cd,
+				const uint8_t * const *ck, uint8_t * const *co, uint16_t cl, unsigned int n)
+{
+	struct kasumi_subkeys k[KASUMI_MULTI_LANES];
+	uint64_t A[KASUMI_MULTI_LANES], BLK[KASUMI_MULTI_LANES];
+	uint8_t ck_km[16], last[8];
+	uint8_t bytes_remain = cl/8%8 + (cl%8 ? 1 : 0);
+	unsigned int i, j, l;
+
+	for (l = 0; l < n; l++) {
+		A[l] = ((uint64_t)cc[l]) << 32 | ((uint64_t)CA << 16) |
+		       (uint64_t)((cb << 3) | (cd << 2)) << 24;
+		for (j = 0; j < 16; j++)
+			ck_km[j] = ck[l][j] ^ 0x55;
+		kasumi_key_expand_sk(ck_km, &k[l]);
+	}
+	/* preliminary round with modified key */
+	kasumi_multi(A, k, n);
+
+	for (l = 0; l < n; l++) {
+		kasumi_key_expand_sk(ck[l], &k[l]);
+		BLK[l] = 0;
+	}
+
+	for (i = 0; i < cl / 64 + (bytes_remain ? 1 : 0); i++) {
+		for (l = 0; l < n; l++)
+			BLK[l] ^= A[l] ^ i;
+		kasumi_multi(BLK, k, n);
+		for (l = 0; l < n; l++) {
+			if (i < cl / 64) {
+				osmo_store64be(BLK[l], co[l] + (i * 8));
+			} else {
+				osmo_store64be(BLK[l], last);
+				memcpy(co[l] + (i * 8), last, bytes_remain);
+			}
+		}
+	}
+}
+
+/* Same output as one _kasumi_kgcore() call per pair, with the KASUMI rounds of
+ * KASUMI_MULTI_LANES pairs at a time interleaved */
+void _kasumi_kgcore_multi(uint8_t CA, uint8_t cb, const uint32_t *cc, uint8_t cd,
+			  const uint8_t * const *ck, uint8_t * const *co, uint16_t cl, unsigned int num)
+{
+	unsigned int i;
+
+	for (i = 0; i < num; i += KASUMI_MULTI_LANES)
+		kasumi_kgcore_lanes(CA, cb, cc + i, cd, ck + i, co + i, cl,
+				    num - i < KASUMI_MULTI_LANES ? num - i : KASUMI_MULTI_LANES);
+}
@@ -27,6 +27,8 @@
 #include <osmocom/core/logging.h>
 #include <osmocom/gsm/tlv.h>
 
+#include "tlv_parser_internal.h"
+
 /*! \addtogroup tlv
  *  @{
  *  Osmocom TLV Parser
@@ -360,77 +362,78 @@ int tlv_parse2(struct tlv_parsed *dec, int dec_multiples,
 	       const struct tlv_definition *def, const uint8_t *buf, int buf_len,
 	       uint8_t lv_tag, uint8_t lv_tag2)
 {
-	int ofs = 0, num_parsed = 0;
-	uint16_t len;
-	int dec_i;
+	const struct tlv_parser_gen *gen = tlv_parser_gen_find(def);
 
-	for (dec_i = 0; dec_i < dec_multiples; dec_i++)
-		memset(&dec[dec_i], 0, sizeof(*dec));
+	if (gen)
+		return gen->parse2(dec, dec_multiples, def, buf, buf_len, lv_tag, lv_tag2);
+	return tlv_parse2_with(tlv_parse_one, dec, dec_multiples, def, buf, buf_len, lv_tag, lv_tag2);
+}
 
-	if (lv_tag) {
-		const uint8_t *val;
-		uint16_t parsed_len;
-		if (ofs > buf_len)
-			return OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;
-		val = &buf[ofs+1];
-		len = buf[ofs];
-		parsed_len = len + 1;
-		if (ofs + parsed_len > buf_len)
-			return OSMO_TLVP_ERR_OFS_LEN_BEYOND_BUFFER;
-		num_parsed++;
-		ofs += parsed_len;
-		/* store the resulting val and len */
-		for (dec_i = 0; dec_i < dec_multiples; dec_i++) {
-			if (dec[dec_i].lv[lv_tag].val != NULL)
-				continue;
-			dec->lv[lv_tag].val = val;
-			dec->lv[lv_tag].len = len;
-			break;
-		}
-	}
-	if (lv_tag2) {
-		const uint8_t *val;
-		uint16_t parsed_len;
-		if (ofs > buf_len)
-			return OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;
-		val = &buf[ofs+1];
-		len = buf[ofs];
-		parsed_len = len + 1;
-		if (ofs + parsed_len > buf_len)
-			return OSMO_TLVP_ERR_OFS_LEN_BEYOND_BUFFER;
-		num_parsed++;
-		ofs += parsed_len;
-		/* store the resulting val and len */
-		for (dec_i = 0; dec_i < dec_multiples; dec_i++) {
-			if (dec[dec_i].lv[lv_tag2].val != NULL)
-				continue;
-			dec->lv[lv_tag2].val = val;
-			dec->lv[lv_tag2].len = len;
-			break;
-		}
+/*! Like tlv_parse2(), but storing the result in a \ref tlv_parsed_compact.
+ * All occurrences of each IE are stored in order of occurrence.  Only the
+ * presence bitmap of \a dec is cleared, so parsing a message of a few IEs
+ * does not touch the entire 4 KiB of a \ref tlv_parsed.
+ *  \param[out] dec caller-allocated pointer to \ref tlv_parsed_compact
+ *  \param[in] def structure defining the valid TLV tags / configurations
+ *  \param[in] buf the input data buffer to be parsed
+ *  \param[in] buf_len length of the input data buffer
+ *  \param[in] lv_tag an initial LV tag at the start of the buffer
+ *  \param[in] lv_tag2 a second initial LV tag following the \a lv_tag
+ *  \returns number of TLV entries parsed; negative in case of error
+ */
+int tlv_parse_compact(struct tlv_parsed_compact *dec, const struct tlv_definition *def,
+		      const uint8_t *buf, int buf_len, uint8_t lv_tag, uint8_t lv_tag2)
+{
+	const struct tlv_parser_gen *gen = tlv_parser_gen_find(def);
+
+	if (gen)
+		return gen->parse_compact(dec, def, buf, buf_len, lv_tag, lv_tag2);
+	return tlv_parse_compact_with(tlv_parse_one, dec, def, buf, buf_len, lv_tag, lv_tag2);
+}
+
+/*! Get the n-th occurrence of an IE in a \ref tlv_parsed_compact
+ *  \param[in] tp pointer to \ref tlv_parsed_compact
+ *  \param[in] tag the Tag to look for
+ *  \param[in] n occurrence to return, starting at 0 for the first one
+ *  \returns struct tlv_p_entry pointer, or NULL if there are not as many occurrences */
+const struct tlv_p_entry *tlvpc_get_nth(const struct tlv_parsed_compact *tp, uint8_t tag, unsigned int n)
+{
+	unsigned int i;
+
+	if (!tlvpc_present(tp, tag))
+		return NULL;
+
+	for (i = tp->first[tag]; i < tp->num_ies; i++) {
+		if (tp->tag[i] != tag)
+			continue;
+		if (n-- == 0)
+			return &tp->ie[i];
 	}
+	return NULL;
+}
 
-	while (ofs < buf_len) {
-		int rv;
-		uint8_t tag;
-		const uint8_t *val;
+/*! Convert a \ref tlv_parsed_compact to \ref tlv_parsed, for code not migrated yet
+ *  \param[out] dec caller-allocated pointer to \ref tlv_parsed
+ *  \param[in] dec_multiples length of the tlv_parsed[] in \a dec, as with tlv_parse2()
+ *  \param[in] tpc compact parser result to convert */
+void osmo_tlvpc_to_tlvp(struct tlv_parsed *dec, int dec_multiples, const struct tlv_parsed_compact *tpc)
+{
+	unsigned int i;
+	int dec_i;
 
-		rv = tlv_parse_one(&tag, &len, &val, def,
-		                   &buf[ofs], buf_len-ofs);
-		if (rv < 0)
-			return rv;
+	for (dec_i = 0; dec_i < dec_multiples; dec_i++)
+		memset(&dec[dec_i], 0, sizeof(*dec));
+
+	for (i = 0; i < tpc->num_ies; i++) {
+		uint8_t tag = tpc->tag[i];
 		for (dec_i = 0; dec_i < dec_multiples; dec_i++) {
 			if (dec[dec_i].lv[tag].val != NULL)
 				continue;
-			dec[dec_i].lv[tag].val = val;
-			dec[dec_i].lv[tag].len = len;
+			dec[dec_i].lv[tag].val = tpc->ie[i].val;
+			dec[dec_i].lv[tag].len = tpc->ie[i].len;
 			break;
 		}
-		ofs += rv;
-		num_parsed++;
 	}
-	//tlv_dump(dec);
-	return num_parsed;
 }
 
 /*! take a master (src) tlv_definition and fill up all empty slots in 'dst'
@@ -703,6 +706,55 @@ int osmo_tlv_prot_validate_tp(const struct osmo_tlv_prot_def *pdef, uint8_t msg_
 	return err;
 }
 
+/*! Like osmo_tlv_prot_validate_tp(), but for a \ref tlv_parsed_compact.
+ *  Only the first occurrence of each IE is checked against the minimum length.
+ *  \param[in] pdef protocol definition of given protocol
+ *  \param[in] msg_type message type of the parsed message
+ *  \param[in] tp compact TLV parser result
+ *  \param[in] log_subsys logging sub-system for log messages
+ *  \param[in] log_pfx prefix for log messages
+ *  \returns 0 in case of success; negative osmo_tlv_parser_error in case of error
+ */
+int osmo_tlv_prot_validate_tpc(const struct osmo_tlv_prot_def *pdef, uint8_t msg_type,
+			       const struct tlv_parsed_compact *tp, int log_subsys, const char *log_pfx)
+{
+	const struct osmo_tlv_prot_msg_def *msg_def= &pdef->msg_def[msg_type];
+	unsigned int err = 0;
+	unsigned int i;
+
+	if (msg_def->mand_ies) {
+		for (i = 0; i < msg_def->mand_count; i++) {
+			uint8_t iei = msg_def->mand_ies[i];
+			if (!TLVPC_PRESENT(tp, iei)) {
+				LOGP(log_subsys, LOGL_ERROR, "%s %s %s: Missing Mandatory IE: %s\n",
+				     log_pfx, pdef->name, osmo_tlv_prot_msg_name(pdef, msg_type),
+				     osmo_tlv_prot_ie_name(pdef, iei));
+				if (!err)
+					err = OSMO_TLVP_ERR_MAND_IE_MISSING;
+			}
+		}
+	}
+
+	for (i = 0; i < tp->num_ies; i++) {
+		uint8_t iei = tp->tag[i];
+		uint16_t min_len;
+
+		if (tp->first[iei] != i)
+			continue;
+
+		min_len = pdef->ie_def[iei].min_len;
+		if (tp->ie[i].len < min_len) {
+			LOGP(log_subsys, LOGL_ERROR, "%s %s %s: Short IE %s: %u < %u\n", log_pfx,
+			     pdef->name, osmo_tlv_prot_msg_name(pdef, msg_type),
+			     osmo_tlv_prot_ie_name(pdef, iei), tp->ie[i].len, min_len);
+			if (!err)
+				err = OSMO_TLVP_ERR_IE_TOO_SHORT;
+		}
+	}
+
+	return err;
+}
+
 /*! Parse + Validate a TLV-encoded message against the protocol definition.
  *  \param[in] pdef protocol definition of given protocol
  *  \param[out] dec caller-allocated pointer to \ref tlv_parsed
@@ -733,4 +785,33 @@ int osmo_tlv_prot_parse(const struct osmo_tlv_prot_def *pdef,
 	return osmo_tlv_prot_validate_tp(pdef, msg_type, dec, log_subsys, log_pfx);
 }
 
+/*! Like osmo_tlv_prot_parse(), but storing the result in a \ref tlv_parsed_compact.
+ *  \param[in] pdef protocol definition of given protocol
+ *  \param[out] dec caller-allocated pointer to \ref tlv_parsed_compact
+ *  \param[in] msg_type message type of the parsed message
+ *  \param[in] buf the input data buffer to be parsed
+ *  \param[in] buf_len length of the input data buffer
+ *  \param[in] lv_tag an initial LV tag at the start of the buffer
+ *  \param[in] lv_tag2 a second initial LV tag following the \a lv_tag
+ *  \param[in] log_subsys logging sub-system for log messages
+ *  \param[in] log_pfx prefix for log messages
+ *  \returns 0 in case of success; negative osmo_tlv_parser_error in case of error
+ */
+int osmo_tlv_prot_parse_compact(const struct osmo_tlv_prot_def *pdef,
+				struct tlv_parsed_compact *dec, uint8_t msg_type,
+				const uint8_t *buf, unsigned int buf_len, uint8_t lv_tag, uint8_t lv_tag2,
+				int log_subsys, const char *log_pfx)
+{
+	int rc;
+
+	rc = tlv_parse_compact(dec, pdef->tlv_def, buf, buf_len, lv_tag, lv_tag2);
+	if (rc < 0) {
+		LOGP(log_subsys, LOGL_ERROR, "%s %s %s: TLV parser error %d\n", log_pfx,
+		     pdef->name, osmo_tlv_prot_msg_name(pdef, msg_type), rc);
+		return rc;
+	}
+
+	return osmo_tlv_prot_validate_tpc(pdef, msg_type, dec, log_subsys, log_pfx);
+}
+
 /*! @} */
@@ -0,0 +1,186 @@
+/*! \file tlv_parser_internal.h
+ * Parts of the TLV parser shared with the generated, protocol specific parsers. */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <osmocom/core/utils.h>
+#include <osmocom/gsm/tlv.h>
+
+/* signature of tlv_parse_one() */
+typedef int (*tlv_parse_one_fn)(uint8_t *o_tag, uint16_t *o_len, const uint8_t **o_val,
+				const struct tlv_definition *def, const uint8_t *buf, int buf_len);
+
+/* A parser generated by utils/tlv_gen.py for one particular (constant) tlv_definition */
+struct tlv_parser_gen {
+	const char *name;
+	int (*parse2)(struct tlv_parsed *dec, int dec_multiples, const struct tlv_definition *def,
+		      const uint8_t *buf, int buf_len, uint8_t lv_tag, uint8_t lv_tag2);
+	int (*parse_compact)(struct tlv_parsed_compact *dec, const struct tlv_definition *def,
+			     const uint8_t *buf, int buf_len, uint8_t lv_tag, uint8_t lv_tag2);
+};
+
+/* in the generated tlv_parser_gen.c; NULL if there is no generated parser for def */
+const struct tlv_parser_gen *tlv_parser_gen_find(const struct tlv_definition *def);
+
+/* Body of tlv_parse2(), with the parser of a single IE as parameter.  Always
+ * inlined, so that a generated parse_one is inlined into it as well. */
+static inline __attribute__((always_inline))
+int tlv_parse2_with(tlv_parse_one_fn parse_one, struct tlv_parsed *dec, int dec_multiples,
+		    const struct tlv_definition *def, const uint8_t *buf, int buf_len,
+		    uint8_t lv_tag, uint8_t lv_tag2)
+{
+	int ofs = 0, num_parsed = 0;
+	uint16_t len;
+	int dec_i;
+
+	for (dec_i = 0; dec_i < dec_multiples; dec_i++)
+		memset(&dec[dec_i], 0, sizeof(*dec));
+
+	if (lv_tag) {
+		const uint8_t *val;
+		uint16_t parsed_len;
+		if (ofs > buf_len)
+			return OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;
+		val = &buf[ofs+1];
+		len = buf[ofs];
+		parsed_len = len + 1;
+		if (ofs + parsed_len > buf_len)
+			return OSMO_TLVP_ERR_OFS_LEN_BEYOND_BUFFER;
+		num_parsed++;
+		ofs += parsed_len;
+		/* store the resulting val and len */
+		for (dec_i = 0; dec_i < dec_multiples; dec_i++) {
+			if (dec[dec_i].lv[lv_tag].val != NULL)
+				continue;
+			dec->lv[lv_tag].val = val;
+			dec->lv[lv_tag].len = len;
+			break;
+		}
+	}
+	if (lv_tag2) {
+		const uint8_t *val;
+		uint16_t parsed_len;
+		if (ofs > buf_len)
+			return OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;
+		val = &buf[ofs+1];
+		len = buf[ofs];
+		parsed_len = len + 1;
+		if (ofs + parsed_len > buf_len)
+			return OSMO_TLVP_ERR_OFS_LEN_BEYOND_BUFFER;
+		num_parsed++;
+		ofs += parsed_len;
+		/* store the resulting val and len */
+		for (dec_i = 0; dec_i < dec_multiples; dec_i++) {
+			if (dec[dec_i].lv[lv_tag2].val != NULL)
+				continue;
+			dec->lv[lv_tag2].val = val;
+			dec->lv[lv_tag2].len = len;
+			break;
+		}
+	}
+
+	while (ofs < buf_len) {
+		int rv;
+		uint8_t tag;
+		const uint8_t *val;
+
+		rv = parse_one(&tag, &len, &val, def,
+		               &buf[ofs], buf_len-ofs);
+		if (rv < 0)
+			return rv;
+		for (dec_i = 0; dec_i < dec_multiples; dec_i++) {
+			if (dec[dec_i].lv[tag].val != NULL)
+				continue;
+			dec[dec_i].lv[tag].val = val;
+			dec[dec_i].lv[tag].len = len;
+			break;
+		}
+		ofs += rv;
+		num_parsed++;
+	}
+	return num_parsed;
+}
+
+/* append an IE to a compact parser result */
+static inline int tlvpc_add(struct tlv_parsed_compact *dec, uint8_t tag, uint16_t len, const uint8_t *val)
+{
+	unsigned int i = dec->num_ies;
+
+	if (i >= ARRAY_SIZE(dec->ie))
+		return OSMO_TLVP_ERR_TOO_MANY_IES;
+
+	if (!tlvpc_present(dec, tag)) {
+		dec->present[tag / 64] |= (uint64_t)1 << (tag % 64);
+		dec->first[tag] = i;
+	}
+	dec->tag[i] = tag;
+	dec->ie[i].len = len;
+	dec->ie[i].val = val;
+	dec->num_ies++;
+	return 0;
+}
+
+/* Body of tlv_parse_compact(), like tlv_parse2_with() */
+static inline __attribute__((always_inline))
+int tlv_parse_compact_with(tlv_parse_one_fn parse_one, struct tlv_parsed_compact *dec,
+			   const struct tlv_definition *def, const uint8_t *buf, int buf_len,
+			   uint8_t lv_tag, uint8_t lv_tag2)
+{
+	uint8_t lv_tags[2] = { lv_tag, lv_tag2 };
+	int ofs = 0;
+	int i, rc;
+
+	memset(dec->present, 0, sizeof(dec->present));
+	dec->num_ies = 0;
+
+	for (i = 0; i < ARRAY_SIZE(lv_tags); i++) {
+		uint16_t len;
+
+		if (!lv_tags[i])
+			continue;
+		if (ofs >= buf_len)
+			return OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;
+		len = buf[ofs];
+		if (ofs + 1 + len > buf_len)
+			return OSMO_TLVP_ERR_OFS_LEN_BEYOND_BUFFER;
+		rc = tlvpc_add(dec, lv_tags[i], len, &buf[ofs + 1]);
+		if (rc < 0)
+			return rc;
+		ofs += 1 + len;
+	}
+
+	while (ofs < buf_len) {
+		uint8_t tag;
+		uint16_t len;
+		const uint8_t *val;
+
+		rc = parse_one(&tag, &len, &val, def, &buf[ofs], buf_len - ofs);
+		if (rc < 0)
+			return rc;
+		ofs += rc;
+		rc = tlvpc_add(dec, tag, len, val);
+		if (rc < 0)
+			return rc;
+	}
+
+	return dec->num_ies;
+}
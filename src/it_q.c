@@ -30,6 +30,11 @@
  * The receiving thread is woken up from its osmo_select_main() loop by eventfd,
  * and a general osmo_fd callback function for the eventfd will dequeue each item
  * and call a queue-specific callback function.
+ *
+ * Queues allocated by osmo_it_q_alloc_ring() use a bounded lock-free ring
+ * instead of a mutex-protected list, for a single consuming thread.  The
+ * eventfd is only written when the queue goes from empty to non-empty, and
+ * the receiving thread dequeues all queued items at once on each wake-up.
  */
 
 #include "../config.h"
@@ -40,6 +45,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <sys/eventfd.h>
 
 #include <osmocom/core/linuxlist.h>
@@ -59,6 +65,104 @@ static int eventfd_increment(int fd, uint64_t inc)
 	return 0;
 }
 
+/* size of a cache line, to keep the state of producers and consumer apart */
+#define IT_Q_CACHELINE	64
+
+/* One slot of the ring.  seq == position: free for the producer enqueueing at
+ * this position; seq == position + 1: filled, for the consumer. */
+struct it_q_cell {
+	uint64_t seq;
+	struct llist_head *item;
+};
+
+/* Bounded multi-producer, single-consumer ring, after Dmitry Vyukov's bounded MPMC queue */
+struct osmo_it_q_ring {
+	/* next position to be reserved by a producer */
+	uint64_t enqueue_pos;
+	uint8_t pad0[IT_Q_CACHELINE - sizeof(uint64_t)];
+	/* number of items published minus number of items dequeued; transiently
+	 * negative as producers count their item only after publishing it */
+	int64_t count;
+	uint8_t pad1[IT_Q_CACHELINE - sizeof(int64_t)];
+	/* next position to be dequeued; only used by the consumer */
+	uint64_t dequeue_pos;
+	/* number of cells */
+	unsigned int size;
+	struct it_q_cell cell[0];
+};
+
+static int ring_enqueue(struct osmo_it_q *q, struct llist_head *item)
+{
+	struct osmo_it_q_ring *r = q->ring;
+	struct it_q_cell *cell;
+	uint64_t pos = __atomic_load_n(&r->enqueue_pos, __ATOMIC_RELAXED);
+	int64_t diff;
+
+	while (1) {
+		cell = &r->cell[pos % r->size];
+		diff = (int64_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+		if (diff == 0) {
+			/* on failure, pos is updated to the current enqueue_pos */
+			if (__atomic_compare_exchange_n(&r->enqueue_pos, &pos, pos + 1, true,
+							__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			/* the consumer didn't release this cell yet */
+			__atomic_fetch_add(&q->dropped, 1, __ATOMIC_RELAXED);
+			return -ENOSPC;
+		} else
+			pos = __atomic_load_n(&r->enqueue_pos, __ATOMIC_RELAXED);
+	}
+
+	cell->item = item;
+	__atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+	/* wake up the consumer only on the transition from empty to non-empty */
+	if (__atomic_fetch_add(&r->count, 1, __ATOMIC_ACQ_REL) == 0 && q->event_ofd.fd >= 0)
+		eventfd_increment(q->event_ofd.fd, 1);
+	return 0;
+}
+
+/* dequeue one item without updating count; only to be called by the consumer */
+static struct llist_head *ring_dequeue(struct osmo_it_q_ring *r)
+{
+	uint64_t pos = r->dequeue_pos;
+	struct it_q_cell *cell = &r->cell[pos % r->size];
+	struct llist_head *item;
+
+	if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != pos + 1)
+		return NULL;
+	item = cell->item;
+	__atomic_store_n(&cell->seq, pos + r->size, __ATOMIC_RELEASE);
+	r->dequeue_pos = pos + 1;
+	return item;
+}
+
+/* dequeue all items present in the ring and call read_cb for each */
+static void ring_drain(struct osmo_it_q *q)
+{
+	struct osmo_it_q_ring *r = q->ring;
+	struct llist_head batch, *item, *tmp;
+	unsigned int n = 0;
+
+	INIT_LLIST_HEAD(&batch);
+	while (n < r->size && (item = ring_dequeue(r))) {
+		llist_add_tail(item, &batch);
+		n++;
+	}
+
+	/* A producer which reserved a cell before the one we stopped at may not
+	 * have published it yet.  Its items are counted without having caused a
+	 * wake-up, so wake up ourselves to try again. */
+	if (__atomic_sub_fetch(&r->count, n, __ATOMIC_ACQ_REL) > 0)
+		eventfd_increment(q->event_ofd.fd, 1);
+
+	llist_for_each_safe(item, tmp, &batch) {
+		llist_del(item);
+		q->read_cb(q, item);
+	}
+}
+
 /* global (for all threads) list of message queues in a program + associated lock */
 static LLIST_HEAD(it_queues);
 static pthread_rwlock_t it_queues_rwlock = PTHREAD_RWLOCK_INITIALIZER;
@@ -98,6 +202,11 @@ static int osmo_it_q_fd_cb(struct osmo_fd *ofd, unsigned int what)
 	if (rc < sizeof(val))
 		return rc;
 
+	if (q->ring) {
+		ring_drain(q);
+		return 0;
+	}
+
 	for (i = 0; i < val; i++) {
 		struct llist_head *item = _osmo_it_q_dequeue(q);
 		/* in case the user might have called osmo_it_q_flush() we may
@@ -111,20 +220,17 @@ static int osmo_it_q_fd_cb(struct osmo_fd *ofd, unsigned int what)
 	return 0;
 }
 
-/*! Allocate a new inter-thread message queue.
- *  \param[in] ctx talloc context from which to allocate the queue
- *  \param[in] name human-readable string name of the queue; function creates a copy.
- *  \param[in] read_cb call-back function to be called for each de-queued message; may be
- *  			NULL in case you don't want eventfd/osmo_select integration and
- *  			will manually take care of noticing if and when to dequeue.
- *  \returns a newly-allocated inter-thread message queue; NULL in case of error */
-struct osmo_it_q *osmo_it_q_alloc(void *ctx, const char *name, unsigned int max_length,
-					void (*read_cb)(struct osmo_it_q *q, struct llist_head *item),
-					void *data)
+static struct osmo_it_q *it_q_alloc(void *ctx, const char *name, unsigned int max_length,
+				    void (*read_cb)(struct osmo_it_q *q, struct llist_head *item),
+				    void *data, bool use_ring)
 {
 	struct osmo_it_q *q;
+	unsigned int i;
 	int fd;
 
+	if (use_ring && max_length == 0)
+		return NULL;
+
 	q = talloc_zero(ctx, struct osmo_it_q);
 	if (!q)
 		return NULL;
@@ -137,6 +243,17 @@ struct osmo_it_q *osmo_it_q_alloc(void *ctx, const char *name, unsigned int max_
 	pthread_mutex_init(&q->mutex, NULL);
 	q->event_ofd.fd = -1;
 
+	if (use_ring) {
+		q->ring = talloc_zero_size(q, sizeof(*q->ring) + max_length * sizeof(q->ring->cell[0]));
+		if (!q->ring) {
+			talloc_free(q);
+			return NULL;
+		}
+		q->ring->size = max_length;
+		for (i = 0; i < max_length; i++)
+			q->ring->cell[i].seq = i;
+	}
+
 	if (q->read_cb) {
 		/* create eventfd *if* the user has provided a read_cb function */
 		fd = eventfd(0, 0);
@@ -165,6 +282,38 @@ struct osmo_it_q *osmo_it_q_alloc(void *ctx, const char *name, unsigned int max_
 	return q;
 }
 
+/*! Allocate a new inter-thread message queue.
+ *  \param[in] ctx talloc context from which to allocate the queue
+ *  \param[in] name human-readable string name of the queue; function creates a copy.
+ *  \param[in] read_cb call-back function to be called for each de-queued message; may be
+ *  			NULL in case you don't want eventfd/osmo_select integration and
+ *  			will manually take care of noticing if and when to dequeue.
+ *  \returns a newly-allocated inter-thread message queue; NULL in case of error */
+struct osmo_it_q *osmo_it_q_alloc(void *ctx, const char *name, unsigned int max_length,
+					void (*read_cb)(struct osmo_it_q *q, struct llist_head *item),
+					void *data)
+{
+	return it_q_alloc(ctx, name, max_length, read_cb, data, false);
+}
+
+/*! Allocate a new inter-thread message queue using a lock-free ring.
+ *  \param[in] ctx talloc context from which to allocate the queue
+ *  \param[in] name human-readable string name of the queue; function creates a copy.
+ *  \param[in] max_length maximum number of items in the queue; memory for it is allocated up front.
+ *  \param[in] read_cb call-back function to be called for each de-queued message; may be
+ *  			NULL in case you don't want eventfd/osmo_select integration and
+ *  			will manually take care of noticing if and when to dequeue.
+ *  \returns a newly-allocated inter-thread message queue; NULL in case of error
+ *
+ *  Any number of threads may enqueue without taking a lock, but only a
+ *  single thread may dequeue, flush or destroy the queue. */
+struct osmo_it_q *osmo_it_q_alloc_ring(void *ctx, const char *name, unsigned int max_length,
+					void (*read_cb)(struct osmo_it_q *q, struct llist_head *item),
+					void *data)
+{
+	return it_q_alloc(ctx, name, max_length, read_cb, data, true);
+}
+
 static void *item_dequeue(struct llist_head *queue)
 {
 	struct llist_head *lh;
@@ -195,6 +344,15 @@ void osmo_it_q_flush(struct osmo_it_q *q)
 {
 	OSMO_ASSERT(q);
 
+	if (q->ring) {
+		struct llist_head *item;
+		while ((item = ring_dequeue(q->ring))) {
+			__atomic_sub_fetch(&q->ring->count, 1, __ATOMIC_ACQ_REL);
+			talloc_free(item);
+		}
+		return;
+	}
+
 	pthread_mutex_lock(&q->mutex);
 	_osmo_it_q_flush(q);
 	pthread_mutex_unlock(&q->mutex);
@@ -228,9 +386,13 @@ int _osmo_it_q_enqueue(struct osmo_it_q *queue, struct llist_head *item)
 	OSMO_ASSERT(queue);
 	OSMO_ASSERT(item);
 
+	if (queue->ring)
+		return ring_enqueue(queue, item);
+
 	pthread_mutex_lock(&queue->mutex);
 	if (queue->current_length+1 > queue->max_length) {
 		pthread_mutex_unlock(&queue->mutex);
+		__atomic_fetch_add(&queue->dropped, 1, __ATOMIC_RELAXED);
 		return -ENOSPC;
 	}
 	llist_add_tail(item, &queue->list);
@@ -252,6 +414,13 @@ struct llist_head *_osmo_it_q_dequeue(struct osmo_it_q *queue)
 	struct llist_head *l;
 	OSMO_ASSERT(queue);
 
+	if (queue->ring) {
+		l = ring_dequeue(queue->ring);
+		if (l)
+			__atomic_sub_fetch(&queue->ring->count, 1, __ATOMIC_ACQ_REL);
+		return l;
+	}
+
 	pthread_mutex_lock(&queue->mutex);
 
 	if (llist_empty(&queue->list))
@@ -267,6 +436,28 @@ struct llist_head *_osmo_it_q_dequeue(struct osmo_it_q *queue)
 }
 
 
+/*! Get the number of items currently in an inter-thread message queue.
+ *  \param[in] queue Inter-thread queue to query
+ *  \returns number of queued items; for lock-free rings, this is a snapshot */
+unsigned int osmo_it_q_depth(struct osmo_it_q *queue)
+{
+	int64_t count;
+
+	if (!queue->ring)
+		return queue->current_length;
+
+	count = __atomic_load_n(&queue->ring->count, __ATOMIC_RELAXED);
+	return count > 0 ? count : 0;
+}
+
+/*! Get the number of items rejected by an inter-thread message queue as it was full.
+ *  \param[in] queue Inter-thread queue to query
+ *  \returns number of failed enqueue operations since allocation */
+uint64_t osmo_it_q_dropped(struct osmo_it_q *queue)
+{
+	return __atomic_load_n(&queue->dropped, __ATOMIC_RELAXED);
+}
+
 #endif /* HAVE_SYS_EVENTFD_H */
 
 /*! @} */
@@ -71,6 +71,8 @@
 
 #include <osmocom/vty/logging.h>	/* for LOGGING_STR. */
 
+#include "logging_async_internal.h"
+
 /* maximum length of the log string of a single log event (typically  line) */
 #define MAX_LOG_SIZE	4096
 
@@ -90,8 +92,38 @@ static struct log_context log_context;
 void *tall_log_ctx = NULL;
 LLIST_HEAD(osmo_log_target_list);
 
+/* Minimum level of the messages of each (mapped) subsystem that any target
+ * would log, regardless of its filters; LOG_LEVEL_MIN_NONE if no target logs
+ * the subsystem.  Written with osmo_log_tgt_mutex held, read without. */
+static uint8_t *log_level_min;
+#define LOG_LEVEL_MIN_NONE	UINT8_MAX
+
 static __thread long int logging_tid;
 
+/*! Time stamp and thread of the message being output by the current thread, if
+ *  it was queued by asynchronous logging; NULL otherwise. */
+__thread const struct log_msg_meta *log_msg_meta_cur;
+
+/*! Time stamp of the log message being output
+ *  \param[out] tv time at which the message was logged */
+void log_msg_time(struct timeval *tv)
+{
+	if (log_msg_meta_cur)
+		*tv = log_msg_meta_cur->tv;
+	else
+		osmo_gettimeofday(tv, NULL);
+}
+
+/*! Thread ID of the thread which logged the message being output */
+long int log_msg_tid(void)
+{
+	if (log_msg_meta_cur)
+		return log_msg_meta_cur->tid;
+	if (logging_tid == 0)
+		logging_tid = (long int)osmo_gettid();
+	return logging_tid;
+}
+
 #if (!EMBEDDED)
 /*! This mutex must be held while using osmo_log_target_list or any of its
   log_targets in a multithread program. Prevents race conditions between threads
@@ -421,6 +453,7 @@ void log_parse_category_mask(struct log_target* target, const char *_mask)
 	} while ((category_token = strtok(NULL, ":")));
 
 	free(mask);
+	log_level_cache_update();
 }
 
 static const char* color(int subsys)
@@ -498,7 +531,7 @@ static int _output_buf(char *buf, int buf_len, struct log_target *target, unsign
 #ifdef HAVE_LOCALTIME_R
 			struct tm tm;
 			struct timeval tv;
-			osmo_gettimeofday(&tv, NULL);
+			log_msg_time(&tv);
 			localtime_r(&tv.tv_sec, &tm);
 			ret = snprintf(buf + offset, rem, "%04d%02d%02d%02d%02d%02d%03d ",
 					tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
@@ -510,7 +543,9 @@ static int _output_buf(char *buf, int buf_len, struct log_target *target, unsign
 #endif
 		} else if (target->print_timestamp) {
 			time_t tm;
-			if ((tm = time(NULL)) == (time_t) -1)
+			if (log_msg_meta_cur)
+				tm = log_msg_meta_cur->tv.tv_sec;
+			else if ((tm = time(NULL)) == (time_t) -1)
 				goto err;
 			/* Get human-readable representation of time.
 			   man ctime: we need at least 26 bytes in buf */
@@ -524,9 +559,7 @@ static int _output_buf(char *buf, int buf_len, struct log_target *target, unsign
 			OSMO_SNPRINTF_RET(ret, rem, offset, len);
 		}
 		if (target->print_tid) {
-			if (logging_tid == 0)
-				logging_tid = (long int)osmo_gettid();
-			ret = snprintf(buf + offset, rem, "%ld ", logging_tid);
+			ret = snprintf(buf + offset, rem, "%ld ", log_msg_tid());
 			if (ret < 0)
 				goto err;
 			OSMO_SNPRINTF_RET(ret, rem, offset, len);
@@ -634,6 +667,93 @@ static void _output(struct log_target *target, unsigned int subsys,
 		target->output(target, level, buf);
 }
 
+static int _output_buf_fmt(char *buf, int buf_len, struct log_target *target, unsigned int subsys,
+			   unsigned int level, const char *file, int line, int cont,
+			   const char *format, ...)
+{
+	va_list ap;
+	int rc;
+
+	va_start(ap, format);
+	rc = _output_buf(buf, buf_len, target, subsys, level, file, line, cont, format, ap);
+	va_end(ap);
+	return rc;
+}
+
+static void _raw_output_fmt(struct log_target *target, int subsys, unsigned int level,
+			    const char *file, int line, int cont, const char *format, ...)
+{
+	va_list ap;
+
+	va_start(ap, format);
+	target->raw_output(target, subsys, level, file, line, cont, format, ap);
+	va_end(ap);
+}
+
+#if (!EMBEDDED)
+static int _file_wq_output(struct log_target *target, struct msgb *msg);
+#endif
+
+/*! Output an already formatted message to a log target, from the writer
+ *  thread of asynchronous logging.  Must be called with log_async_io_lock().
+ *  \param[in] target log target to output to
+ *  \param[in] subsys Log sub-system index, as mapped by map_subsys()
+ *  \param[in] str the formatted message
+ *  \returns 0 on success; negative if the message could not be written
+ *
+ *  Stream output of file targets is not flushed, see log_target_output_flush(). */
+int log_target_output_str(struct log_target *target, int subsys, unsigned int level,
+			  const char *file, int line, int cont, const char *str)
+{
+	char buf[MAX_LOG_SIZE];
+#if (!EMBEDDED)
+	struct msgb *msg;
+#endif
+	int len;
+
+	switch (target->type) {
+#if (!EMBEDDED)
+	case LOG_TGT_TYPE_FILE:
+	case LOG_TGT_TYPE_STDERR:
+		if (target->tgt_file.out) {
+			_output_buf_fmt(buf, sizeof(buf), target, subsys, level, file, line, cont, "%s", str);
+			return fputs(buf, target->tgt_file.out) < 0 ? -EIO : 0;
+		}
+		/* queue behind the messages already in the write queue, like _file_raw_output() */
+		msg = msgb_alloc_c(target->tgt_file.wqueue, MAX_LOG_SIZE, "log_file_msg");
+		if (!msg)
+			return -ENOMEM;
+		len = _output_buf_fmt((char *)msgb_data(msg), msgb_tailroom(msg), target, subsys, level,
+				      file, line, cont, "%s", str);
+		msgb_put(msg, len);
+		return _file_wq_output(target, msg);
+#endif
+	default:
+		if (target->raw_output) {
+			_raw_output_fmt(target, subsys, level, file, line, cont, "%s", str);
+			return 0;
+		}
+		len = _output_buf_fmt(buf, sizeof(buf), target, subsys, level, file, line, cont, "%s", str);
+		if (len > 0)
+			target->output(target, level, buf);
+		return 0;
+	}
+}
+
+/*! Flush the output of a log target after log_target_output_str() */
+void log_target_output_flush(struct log_target *target)
+{
+	switch (target->type) {
+	case LOG_TGT_TYPE_FILE:
+	case LOG_TGT_TYPE_STDERR:
+		if (target->tgt_file.out)
+			fflush(target->tgt_file.out);
+		break;
+	default:
+		break;
+	}
+}
+
 /* Catch internal logging category indexes as well as out-of-bounds indexes.
  * For internal categories, the ID is negative starting with -1; and internal
  * logging categories are added behind the user categories. For out-of-bounds
@@ -691,6 +811,27 @@ static inline bool should_log_to_target(struct log_target *tar, int subsys,
 	return true;
 }
 
+/* Whether a log target is output to by the writer thread of asynchronous
+ * logging.  VTY and ring buffer targets are read from the main thread, and the
+ * write_queue of GSMTAP belongs to the osmo_select_main() loop. */
+static inline bool target_is_async(const struct log_target *tar)
+{
+	if (tar->async_bit < 0)
+		return false;
+
+	switch (tar->type) {
+	case LOG_TGT_TYPE_FILE:
+	case LOG_TGT_TYPE_STDERR:
+	case LOG_TGT_TYPE_SYSLOG:
+	case LOG_TGT_TYPE_SYSTEMD:
+		return true;
+	case LOG_TGT_TYPE_GSMTAP:
+		return !tar->tgt_gsmtap.gsmtap_inst->ofd_wq_mode;
+	default:
+		return false;
+	}
+}
+
 /*! vararg version of logging function
  *  \param[in] subsys Logging sub-system
  *  \param[in] level Log level
@@ -703,9 +844,13 @@ void osmo_vlogp(int subsys, int level, const char *file, int line,
 		int cont, const char *format, va_list ap)
 {
 	struct log_target *tar;
+	uint64_t async_targets = 0;
 
 	subsys = map_subsys(subsys);
 
+	if (level < __atomic_load_n(&log_level_min[subsys], __ATOMIC_RELAXED))
+		return;
+
 	log_tgt_mutex_lock();
 
 	llist_for_each_entry(tar, &osmo_log_target_list, entry) {
@@ -714,6 +859,12 @@ void osmo_vlogp(int subsys, int level, const char *file, int line,
 		if (!should_log_to_target(tar, subsys, level))
 			continue;
 
+		/* format only once, for all targets of the writer thread */
+		if (log_async_running && target_is_async(tar)) {
+			async_targets |= 1ULL << tar->async_bit;
+			continue;
+		}
+
 		/* According to the manpage, vsnprintf leaves the value of ap
 		 * in undefined state. Since _output uses vsnprintf and it may
 		 * be called several times, we have to pass a copy of ap. */
@@ -725,7 +876,19 @@ void osmo_vlogp(int subsys, int level, const char *file, int line,
 		va_end(bp);
 	}
 
+	/* only the targets are picked with the mutex held; the message is
+	 * formatted and queued without it */
+	if (async_targets && !log_async_reserve())
+		async_targets = 0;
+
 	log_tgt_mutex_unlock();
+
+	if (async_targets) {
+		va_list bp;
+		va_copy(bp, ap);
+		log_async_enqueue(async_targets, subsys, level, file, line, cont, format, bp);
+		va_end(bp);
+	}
 }
 
 /*! logging function used by DEBUGP() macro
@@ -779,7 +942,9 @@ void logp_stub(const char *file, int line, int cont, const char *format, ...)
  */
 void log_add_target(struct log_target *target)
 {
+	log_async_target_add(target);
 	llist_add_tail(&target->entry, &osmo_log_target_list);
+	log_level_cache_update();
 }
 
 /*! Unregister a log target from the logging core
@@ -788,6 +953,8 @@ void log_add_target(struct log_target *target)
 void log_del_target(struct log_target *target)
 {
 	llist_del(&target->entry);
+	log_async_target_del(target);
+	log_level_cache_update();
 }
 
 /*! Reset (clear) the logging context */
@@ -948,6 +1115,7 @@ void log_set_print_level(struct log_target *target, int print_level)
 void log_set_log_level(struct log_target *target, int log_level)
 {
 	target->loglevel = log_level;
+	log_level_cache_update();
 }
 
 /*! Set a category filter on a given log target
@@ -964,6 +1132,7 @@ void log_set_category_filter(struct log_target *target, int category,
 	category = map_subsys(category);
 	target->categories[category].enabled = !!enable;
 	target->categories[category].loglevel = level;
+	log_level_cache_update();
 }
 
 #if (!EMBEDDED)
@@ -994,6 +1163,26 @@ static void _file_output_stream(struct log_target *target, unsigned int level,
 }
 
 /* output via non-blocking write_queue, doing internal buffering */
+/* write a formatted message of a write queue target, or queue it; takes ownership of msg */
+static int _file_wq_output(struct log_target *target, struct msgb *msg)
+{
+	/* attempt a synchronous, non-blocking write, if the write queue is empty */
+	if (target->tgt_file.wqueue->current_length == 0) {
+		if (_file_wq_write_cb(&target->tgt_file.wqueue->bfd, msg) == 0) {
+			/* the write was complete, we can exit early */
+			msgb_free(msg);
+			return 0;
+		}
+	}
+	/* if we reach here, either we already had elements in the write_queue, or the synchronous write
+	 * failed: enqueue the message to the write_queue (backlog) */
+	if (osmo_wqueue_enqueue_quiet(target->tgt_file.wqueue, msg) < 0) {
+		msgb_free(msg);
+		return -ENOBUFS;
+	}
+	return 0;
+}
+
 static void _file_raw_output(struct log_target *target, int subsys, unsigned int level, const char *file,
 			     int line, int cont, const char *format, va_list ap)
 {
@@ -1011,21 +1200,8 @@ static void _file_raw_output(struct log_target *target, int subsys, unsigned int
 	rc = _output_buf((char *)msgb_data(msg), msgb_tailroom(msg), target, subsys, level, file, line, cont, format, ap);
 	msgb_put(msg, rc);
 
-	/* attempt a synchronous, non-blocking write, if the write queue is empty */
-	if (target->tgt_file.wqueue->current_length == 0) {
-		rc = _file_wq_write_cb(&target->tgt_file.wqueue->bfd, msg);
-		if (rc == 0) {
-			/* the write was complete, we can exit early */
-			msgb_free(msg);
-			return;
-		}
-	}
-	/* if we reach here, either we already had elements in the write_queue, or the synchronous write
-	 * failed: enqueue the message to the write_queue (backlog) */
-	if (osmo_wqueue_enqueue_quiet(target->tgt_file.wqueue, msg) < 0) {
-		msgb_free(msg);
-		/* TODO: increment some counter so we can see that messages were dropped */
-	}
+	/* TODO: increment some counter so we can see that messages were dropped */
+	_file_wq_output(target, msg);
 }
 #endif
 
@@ -1055,6 +1231,7 @@ struct log_target *log_target_create(void)
 	}
 
 	INIT_LLIST_HEAD(&target->entry);
+	target->async_bit = -1;
 
 	/* initialize the per-category enabled/loglevel from defaults */
 	for (i = 0; i < osmo_log_info->num_cat; i++) {
@@ -1121,18 +1298,10 @@ struct log_target *log_target_create_file_stream(const char *fname)
 	return target;
 }
 
-/*! switch from non-blocking/write-queue to blocking + buffered stream output
- *  \param[in] target log target which we should switch
- *  \return 0 on success; 1 if already switched before; negative on error
- *  Must be called with mutex osmo_log_tgt_mutex held, see log_tgt_mutex_lock.
- */
-int log_target_file_switch_to_stream(struct log_target *target)
+static int _file_switch_to_stream(struct log_target *target)
 {
 	struct osmo_wqueue *wq;
 
-	if (!target)
-		return -ENODEV;
-
 	if (target->tgt_file.out) {
 		/* target has already been switched over */
 		return 1;
@@ -1172,19 +1341,29 @@ int log_target_file_switch_to_stream(struct log_target *target)
 	return 0;
 }
 
-/*! switch from blocking + buffered file output to non-blocking write-queue based output.
+/*! switch from non-blocking/write-queue to blocking + buffered stream output
  *  \param[in] target log target which we should switch
  *  \return 0 on success; 1 if already switched before; negative on error
  *  Must be called with mutex osmo_log_tgt_mutex held, see log_tgt_mutex_lock.
  */
-int log_target_file_switch_to_wqueue(struct log_target *target)
+int log_target_file_switch_to_stream(struct log_target *target)
 {
-	struct osmo_wqueue *wq;
 	int rc;
 
 	if (!target)
 		return -ENODEV;
 
+	log_async_io_lock();
+	rc = _file_switch_to_stream(target);
+	log_async_io_unlock();
+	return rc;
+}
+
+static int _file_switch_to_wqueue(struct log_target *target)
+{
+	struct osmo_wqueue *wq;
+	int rc;
+
 	if (!target->tgt_file.out) {
 		/* target has already been switched over */
 		return 1;
@@ -1212,6 +1391,7 @@ int log_target_file_switch_to_wqueue(struct log_target *target)
 	wq->bfd.fd = rc;
 	wq->bfd.when = OSMO_FD_WRITE;
 	wq->write_cb = _file_wq_write_cb;
+	wq->vectored = true;
 
 	rc = osmo_fd_register(&wq->bfd);
 	if (rc < 0) {
@@ -1230,6 +1410,24 @@ int log_target_file_switch_to_wqueue(struct log_target *target)
 	return 0;
 }
 
+/*! switch from blocking + buffered file output to non-blocking write-queue based output.
+ *  \param[in] target log target which we should switch
+ *  \return 0 on success; 1 if already switched before; negative on error
+ *  Must be called with mutex osmo_log_tgt_mutex held, see log_tgt_mutex_lock.
+ */
+int log_target_file_switch_to_wqueue(struct log_target *target)
+{
+	int rc;
+
+	if (!target)
+		return -ENODEV;
+
+	log_async_io_lock();
+	rc = _file_switch_to_wqueue(target);
+	log_async_io_unlock();
+	return rc;
+}
+
 /*! Create a new file-based log target using non-blocking write_queue
  *  \param[in] fname File name of the new log file
  *  \returns Log target in case of success, NULL otherwise
@@ -1263,6 +1461,7 @@ struct log_target *log_target_create_file(const char *fname)
 	}
 	wq->bfd.when = OSMO_FD_WRITE;
 	wq->write_cb = _file_wq_write_cb;
+	wq->vectored = true;
 
 	rc = osmo_fd_register(&wq->bfd);
 	if (rc < 0) {
@@ -1301,6 +1500,10 @@ struct log_target *log_target_find(enum log_target_type type, const char *fname)
 			if (!strcmp(fname, tgt->tgt_gsmtap.hostname))
 				return tgt;
 			break;
+		case LOG_TGT_TYPE_BINARY:
+			if (!strcmp(fname, tgt->tgt_bin.fname))
+				return tgt;
+			break;
 		default:
 			return tgt;
 		}
@@ -1315,6 +1518,8 @@ void log_target_destroy(struct log_target *target)
 	/* just in case, to make sure we don't have any references */
 	log_del_target(target);
 
+	/* the writer thread of asynchronous logging may still be writing to it */
+	log_async_io_lock();
 #if (!EMBEDDED)
 	struct osmo_wqueue *wq;
 	switch (target->type) {
@@ -1353,14 +1558,12 @@ void log_target_destroy(struct log_target *target)
 		break;
 	}
 #endif
+	log_async_io_unlock();
 
 	talloc_free(target);
 }
 
-/*! close and re-open a log file (for log file rotation)
- *  \param[in] target log target to re-open
- *  \returns 0 in case of success; negative otherwise */
-int log_target_file_reopen(struct log_target *target)
+static int _file_reopen(struct log_target *target)
 {
 	struct osmo_wqueue *wq;
 	int rc;
@@ -1393,6 +1596,19 @@ int log_target_file_reopen(struct log_target *target)
 	return 0;
 }
 
+/*! close and re-open a log file (for log file rotation)
+ *  \param[in] target log target to re-open
+ *  \returns 0 in case of success; negative otherwise */
+int log_target_file_reopen(struct log_target *target)
+{
+	int rc;
+
+	log_async_io_lock();
+	rc = _file_reopen(target);
+	log_async_io_unlock();
+	return rc;
+}
+
 /*! close and re-open all log files (for log file rotation)
  *  \returns 0 in case of success; negative otherwise */
 int log_targets_reopen(void)
@@ -1479,6 +1695,14 @@ int log_init(const struct log_info *inf, void *ctx)
 
 	osmo_log_info->cat = cat_ptr;
 
+	log_level_min = talloc_array(osmo_log_info, uint8_t, osmo_log_info->num_cat);
+	if (!log_level_min) {
+		talloc_free(osmo_log_info);
+		osmo_log_info = NULL;
+		return -ENOMEM;
+	}
+	memset(log_level_min, LOG_LEVEL_MIN_NONE, osmo_log_info->num_cat);
+
 	return 0;
 }
 
@@ -1488,6 +1712,8 @@ void log_fini(void)
 {
 	struct log_target *tar, *tar2;
 
+	log_async_fini();
+
 	log_tgt_mutex_lock();
 
 	llist_for_each_entry_safe(tar, tar2, &osmo_log_target_list, entry)
@@ -1495,12 +1721,47 @@ void log_fini(void)
 
 	talloc_free(osmo_log_info);
 	osmo_log_info = NULL;
+	log_level_min = NULL;
 	talloc_free(tall_log_ctx);
 	tall_log_ctx = NULL;
 
 	log_tgt_mutex_unlock();
 }
 
+/*! Update the cached minimum log level of each logging subsystem.
+ *
+ *  log_check_level() and osmo_vlogp() drop messages below the minimum level at
+ *  which any log target logs the subsystem, without walking the targets.  The
+ *  functions changing the categories and log levels of targets update it; this
+ *  must be called after changing log_target.categories or log_target.loglevel
+ *  directly.  In a multithreaded program, osmo_log_tgt_mutex must be held, see
+ *  log_tgt_mutex_lock(). */
+void log_level_cache_update(void)
+{
+	struct log_target *tar;
+	int i;
+
+	if (!log_level_min)
+		return;
+
+	for (i = 0; i < osmo_log_info->num_cat; i++) {
+		uint8_t min = LOG_LEVEL_MIN_NONE;
+
+		llist_for_each_entry(tar, &osmo_log_target_list, entry) {
+			const struct log_category *cat = &tar->categories[i];
+			uint8_t level;
+
+			if (!cat->enabled)
+				continue;
+			/* as in should_log_to_target() */
+			level = tar->loglevel ? tar->loglevel : cat->loglevel;
+			if (level < min)
+				min = level;
+		}
+		__atomic_store_n(&log_level_min[i], min, __ATOMIC_RELAXED);
+	}
+}
+
 /*! Check whether a log entry will be generated.
  *  \returns != 0 if a log entry might get generated by at least one target */
 int log_check_level(int subsys, unsigned int level)
@@ -1511,8 +1772,11 @@ int log_check_level(int subsys, unsigned int level)
 
 	subsys = map_subsys(subsys);
 
-	/* TODO: The following could/should be cached (update on config) */
+	/* no target logs the subsystem at this level */
+	if (level < __atomic_load_n(&log_level_min[subsys], __ATOMIC_RELAXED))
+		return 0;
 
+	/* some target may log it, depending on its filters */
 	log_tgt_mutex_lock();
 
 	llist_for_each_entry(tar, &osmo_log_target_list, entry) {
@@ -0,0 +1,708 @@
+/*! \file logging_async.c
+ * Asynchronous logging via per-thread rings and a writer thread. */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*! \addtogroup logging
+ * @{
+ *
+ * Asynchronous logging.
+ *
+ * Once enabled by log_async_enable(), a log message for file, stderr,
+ * syslog, systemd and (non write-queue) GSMTAP targets is formatted once
+ * into a ring of the logging thread, instead of being formatted and written
+ * for each target by the logging thread itself.  A writer thread takes the
+ * messages from the rings of all threads in the order they were logged, and
+ * outputs them to the targets.  VTY and ring buffer targets are still output
+ * synchronously, as they are read from the main thread.
+ *
+ * The rings are single-producer single-consumer and lock-free; a ring is
+ * allocated on the first message logged by a thread.  A message which does
+ * not fit into the ring is dropped.  The numbers of queued and dropped
+ * messages are counted in the rate counter group "log:async".
+ *
+ * Which targets a message goes to is still decided when it is logged, with
+ * the log context and filters at that time.  Only this is done with the log
+ * target mutex held; the message is formatted and queued after releasing it.  The message header (time stamp,
+ * category, ...) is however formatted with the settings of a target at the
+ * time the message is output.
+ *
+ * osmo_panic() outputs all queued messages before terminating the process.
+ *
+ * \file logging_async.c */
+
+#define _GNU_SOURCE
+
+#include "../config.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <osmocom/core/logging.h>
+
+#include "logging_async_internal.h"
+
+#if (!EMBEDDED)
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <osmocom/core/linuxlist.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/stats.h>
+#include <osmocom/core/timer.h>
+#include <osmocom/core/thread.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/logging_internal.h>
+
+/* maximum length of a queued log message, like MAX_LOG_SIZE of logging.c */
+#define LOG_ASYNC_MAX_MSG	4096
+/* alignment of the records in a ring */
+#define LOG_ASYNC_ALIGN		8
+/* size of a cache line, to keep the state of producer and consumer apart */
+#define LOG_ASYNC_CACHELINE	64
+/* the smallest ring takes two messages of maximum length */
+#define LOG_ASYNC_RING_SIZE_MIN	16384
+/* number of messages the writer thread outputs before releasing the io mutex */
+#define LOG_ASYNC_BATCH		256
+/* interval in which an idle writer thread looks for messages without being woken up */
+#define LOG_ASYNC_IDLE_MS	100
+
+/* the record is padding up to the end of the ring */
+#define LOG_ASYNC_REC_F_PAD	0x0001
+
+/* A log message in a ring, followed by the NUL terminated message text */
+struct log_async_rec {
+	/* size of the record including the text, a multiple of LOG_ASYNC_ALIGN */
+	uint32_t len;
+	uint16_t flags;
+	uint8_t level;
+	uint8_t cont;
+	int32_t subsys;
+	int32_t line;
+	uint64_t seq;
+	/* bits of the targets to output to, see log_target.async_bit */
+	uint64_t targets;
+	/* log_async.epoch when the targets were picked */
+	uint64_t epoch;
+	const char *file;
+	struct log_msg_meta meta;
+	char msg[0];
+};
+
+/* Ring of one logging thread */
+struct log_async_ring {
+	/* entry in log_async.rings */
+	struct llist_head list;
+	uint8_t *buf;
+	/* size of buf, a power of two */
+	size_t size;
+	/* the logging thread has terminated; free the ring once it is empty */
+	bool orphaned;
+	/* position up to which records were written, only written by the logging thread */
+	uint64_t head __attribute__((aligned(LOG_ASYNC_CACHELINE)));
+	/* between log_async_reserve() and the end of log_async_enqueue() */
+	int busy;
+	/* log_async.epoch at log_async_reserve() */
+	uint64_t epoch;
+	/* position up to which records were output, only written by the consumer */
+	uint64_t tail __attribute__((aligned(LOG_ASYNC_CACHELINE)));
+};
+
+static const struct rate_ctr_desc log_async_ctr_desc[] = {
+	[LOG_ASYNC_CTR_QUEUED] = { "msgs:queued", "Log messages queued for the writer thread" },
+	[LOG_ASYNC_CTR_DROP_FULL] = { "msgs:dropped:full", "Log messages dropped as the ring was full" },
+	[LOG_ASYNC_CTR_DROP_NORING] = { "msgs:dropped:noring", "Log messages dropped as no ring could be allocated" },
+	[LOG_ASYNC_CTR_DROP_WRITE] = { "msgs:dropped:write", "Log messages not written to a target due to an error" },
+};
+
+static const struct rate_ctr_group_desc log_async_ctrg_desc = {
+	.group_name_prefix = "log:async",
+	.group_description = "Asynchronous logging",
+	.class_id = OSMO_STATS_CLASS_GLOBAL,
+	.num_ctr = ARRAY_SIZE(log_async_ctr_desc),
+	.ctr_desc = log_async_ctr_desc,
+};
+
+/* Whether messages are queued for the writer thread; only changed with the
+ * log target mutex held */
+bool log_async_running;
+
+static struct {
+	/* size of rings allocated from now on */
+	size_t ring_size;
+	pthread_t thread;
+	/* between creating and joining the writer thread */
+	bool writer_active;
+	bool stop;
+	struct rate_ctr_group *ctrg;
+
+	/* rings of all threads which logged so far, except rings_out */
+	struct llist_head rings;
+	/* rings taken out of the list by drain() while outputting */
+	struct llist_head rings_out;
+	pthread_mutex_t rings_mutex;
+	pthread_key_t ring_key;
+	pthread_once_t ring_key_once;
+
+	/* held while consuming the rings and outputting to the targets; protects
+	 * targets[] and the bits */
+	pthread_mutex_t io_mutex;
+	/* targets by their async_bit */
+	struct log_target *targets[64];
+	/* log_async.epoch when the target was added */
+	uint64_t target_epoch[64];
+	/* bits of targets[] in use */
+	uint64_t bits_used;
+	/* number of targets added so far.  A queued message is only output to the
+	 * targets added before it was logged, so that the bit of a deleted target
+	 * can be reused right away. */
+	uint64_t epoch;
+
+	/* waking up the writer thread when it is idle */
+	pthread_mutex_t wake_mutex;
+	pthread_cond_t wake_cond;
+	int writer_idle;
+
+	/* sequence number of the next message, to output messages of all threads in order */
+	uint64_t seq;
+	/* the process is terminating by osmo_panic() */
+	int panic;
+} log_async = {
+	.rings = LLIST_HEAD_INIT(log_async.rings),
+	.rings_out = LLIST_HEAD_INIT(log_async.rings_out),
+	.rings_mutex = PTHREAD_MUTEX_INITIALIZER,
+	.ring_key_once = PTHREAD_ONCE_INIT,
+	.io_mutex = PTHREAD_MUTEX_INITIALIZER,
+	.wake_mutex = PTHREAD_MUTEX_INITIALIZER,
+	.wake_cond = PTHREAD_COND_INITIALIZER,
+};
+
+static __thread struct log_async_ring *log_async_ring_cur;
+
+/* thread specific data destructor: the logging thread terminates */
+static void ring_orphan(void *data)
+{
+	struct log_async_ring *ring = data;
+
+	/* The writer may free the ring as soon as it is orphaned and drained.
+	 * Should the thread log again while exiting, e.g. from another
+	 * destructor, ring_get() allocates it a new ring, which is orphaned in
+	 * turn by the next round of destructors. */
+	log_async_ring_cur = NULL;
+	__atomic_store_n(&ring->orphaned, true, __ATOMIC_RELEASE);
+}
+
+static void ring_key_create(void)
+{
+	pthread_key_create(&log_async.ring_key, ring_orphan);
+}
+
+/* ring of the calling thread, allocated on first use */
+static struct log_async_ring *ring_get(void)
+{
+	struct log_async_ring *ring = log_async_ring_cur;
+	void *mem;
+
+	if (OSMO_LIKELY(ring))
+		return ring;
+
+	if (posix_memalign(&mem, LOG_ASYNC_CACHELINE, sizeof(*ring) + log_async.ring_size))
+		return NULL;
+	ring = mem;
+	memset(ring, 0, sizeof(*ring));
+	ring->buf = (uint8_t *)(ring + 1);
+	ring->size = log_async.ring_size;
+
+	pthread_mutex_lock(&log_async.rings_mutex);
+	llist_add_tail(&ring->list, &log_async.rings);
+	pthread_mutex_unlock(&log_async.rings_mutex);
+	pthread_setspecific(log_async.ring_key, ring);
+
+	log_async_ring_cur = ring;
+	return ring;
+}
+
+/* next record to be output from a ring, skipping padding; NULL if empty */
+static struct log_async_rec *ring_peek(struct log_async_ring *ring)
+{
+	uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	struct log_async_rec *rec;
+
+	while (ring->tail != head) {
+		rec = (struct log_async_rec *)(ring->buf + (ring->tail & (ring->size - 1)));
+		if (!(rec->flags & LOG_ASYNC_REC_F_PAD))
+			return rec;
+		__atomic_store_n(&ring->tail, ring->tail + rec->len, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+/*! Prepare queueing a log message by log_async_enqueue(); called by
+ *  osmo_vlogp() with the log target mutex held, after picking the targets.
+ *  \returns true if the message can be queued */
+bool log_async_reserve(void)
+{
+	struct log_async_ring *ring = ring_get();
+
+	if (!ring) {
+		rate_ctr_inc2(log_async.ctrg, LOG_ASYNC_CTR_DROP_NORING);
+		return false;
+	}
+	ring->epoch = __atomic_load_n(&log_async.epoch, __ATOMIC_RELAXED);
+	/* paired with wait_enqueued() */
+	__atomic_store_n(&ring->busy, 1, __ATOMIC_SEQ_CST);
+	return true;
+}
+
+/*! Queue a log message for the writer thread; called by osmo_vlogp() after
+ *  log_async_reserve(), without the log target mutex held.
+ *  \param[in] targets bits of the targets to output the message to */
+void log_async_enqueue(uint64_t targets, int subsys, unsigned int level, const char *file, int line,
+		       int cont, const char *format, va_list ap)
+{
+	char buf[LOG_ASYNC_MAX_MSG];
+	struct log_async_ring *ring = log_async_ring_cur;
+	struct log_async_rec *rec;
+	uint64_t head, tail;
+	size_t msg_len, len, off, pad = 0;
+	int rc;
+
+	rc = vsnprintf(buf, sizeof(buf), format, ap);
+	if (rc < 0)
+		goto out;
+	msg_len = OSMO_MIN(rc, sizeof(buf) - 1);
+	len = (sizeof(*rec) + msg_len + 1 + LOG_ASYNC_ALIGN - 1) & ~(LOG_ASYNC_ALIGN - 1);
+
+	head = ring->head;
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	off = head & (ring->size - 1);
+	/* records don't wrap around the end of the ring */
+	if (ring->size - off < len)
+		pad = ring->size - off;
+	if (head + pad + len - tail > ring->size) {
+		rate_ctr_inc2(log_async.ctrg, LOG_ASYNC_CTR_DROP_FULL);
+		goto out;
+	}
+	if (pad) {
+		rec = (struct log_async_rec *)(ring->buf + off);
+		rec->len = pad;
+		rec->flags = LOG_ASYNC_REC_F_PAD;
+		head += pad;
+		off = 0;
+	}
+
+	rec = (struct log_async_rec *)(ring->buf + off);
+	rec->len = len;
+	rec->flags = 0;
+	rec->level = level;
+	rec->cont = cont;
+	rec->subsys = subsys;
+	rec->line = line;
+	rec->seq = __atomic_fetch_add(&log_async.seq, 1, __ATOMIC_RELAXED);
+	rec->targets = targets;
+	rec->epoch = ring->epoch;
+	rec->file = file;
+	osmo_gettimeofday(&rec->meta.tv, NULL);
+	rec->meta.tid = log_msg_tid();
+	memcpy(rec->msg, buf, msg_len);
+	rec->msg[msg_len] = '\0';
+
+	/* sequentially consistent, paired with writer_idle */
+	__atomic_store_n(&ring->head, head + len, __ATOMIC_SEQ_CST);
+	rate_ctr_inc2(log_async.ctrg, LOG_ASYNC_CTR_QUEUED);
+
+	if (__atomic_load_n(&log_async.writer_idle, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&log_async.wake_mutex);
+		pthread_cond_signal(&log_async.wake_cond);
+		pthread_mutex_unlock(&log_async.wake_mutex);
+	}
+out:
+	__atomic_store_n(&ring->busy, 0, __ATOMIC_RELEASE);
+}
+
+/* lock a mutex, unless it stays locked by another thread for about a second */
+static bool panic_trylock(pthread_mutex_t *mutex)
+{
+	int i;
+
+	for (i = 0; i < 1000; i++) {
+		if (pthread_mutex_trylock(mutex) == 0)
+			return true;
+		usleep(1000);
+	}
+	return false;
+}
+
+/* lock the rings_mutex; in osmo_panic(), unless it stays locked for too long */
+static bool rings_lock(void)
+{
+	if (__atomic_load_n(&log_async.panic, __ATOMIC_RELAXED))
+		return panic_trylock(&log_async.rings_mutex);
+	pthread_mutex_lock(&log_async.rings_mutex);
+	return true;
+}
+
+/* Output queued messages of all rings in the order they were logged, until the
+ * rings are empty or max messages were output.  Called with io_mutex held; the
+ * rings are moved to log_async.rings_out while outputting, so that threads
+ * logging for the first time are not held up by the output.  Returns the
+ * number of messages output. */
+static unsigned int drain(unsigned int max)
+{
+	struct llist_head *rings = &log_async.rings_out;
+	struct log_async_ring *ring, *ring2, *best_ring;
+	struct log_async_rec *rec, *best;
+	struct log_target *tar;
+	uint64_t touched = 0, targets;
+	unsigned int n = 0;
+	bool locked;
+	int bit;
+
+	locked = rings_lock();
+	llist_splice_init(&log_async.rings, rings);
+	if (locked)
+		pthread_mutex_unlock(&log_async.rings_mutex);
+
+	while (n < max) {
+		best = NULL;
+		best_ring = NULL;
+		llist_for_each_entry(ring, rings, list) {
+			rec = ring_peek(ring);
+			if (rec && (!best || rec->seq < best->seq)) {
+				best = rec;
+				best_ring = ring;
+			}
+		}
+		if (!best)
+			break;
+
+		log_msg_meta_cur = &best->meta;
+		for (targets = best->targets; targets; targets &= targets - 1) {
+			bit = __builtin_ctzll(targets);
+			tar = log_async.targets[bit];
+			/* the target may have been deleted since, and its bit reused */
+			if (!tar || log_async.target_epoch[bit] > best->epoch)
+				continue;
+			if (log_target_output_str(tar, best->subsys, best->level,
+						  best->file, best->line, best->cont, best->msg) < 0)
+				rate_ctr_inc2(log_async.ctrg, LOG_ASYNC_CTR_DROP_WRITE);
+		}
+		log_msg_meta_cur = NULL;
+		touched |= best->targets;
+
+		__atomic_store_n(&best_ring->tail, best_ring->tail + best->len, __ATOMIC_RELEASE);
+		n++;
+	}
+
+	for (targets = touched; targets; targets &= targets - 1) {
+		bit = __builtin_ctzll(targets);
+		if (log_async.targets[bit])
+			log_target_output_flush(log_async.targets[bit]);
+	}
+
+	llist_for_each_entry_safe(ring, ring2, rings, list) {
+		if (__atomic_load_n(&ring->orphaned, __ATOMIC_ACQUIRE) && !ring_peek(ring)) {
+			llist_del(&ring->list);
+			free(ring);
+		}
+	}
+
+	locked = rings_lock();
+	llist_splice_init(rings, &log_async.rings);
+	if (locked)
+		pthread_mutex_unlock(&log_async.rings_mutex);
+
+	return n;
+}
+
+/* Wait for the threads which are queueing a message, after log_async_running
+ * was cleared.  Called with io_mutex held. */
+static void wait_enqueued(void)
+{
+	struct log_async_ring *ring;
+	bool busy;
+
+	do {
+		busy = false;
+		pthread_mutex_lock(&log_async.rings_mutex);
+		llist_for_each_entry(ring, &log_async.rings, list) {
+			if (__atomic_load_n(&ring->busy, __ATOMIC_SEQ_CST))
+				busy = true;
+		}
+		pthread_mutex_unlock(&log_async.rings_mutex);
+		if (busy)
+			sched_yield();
+	} while (busy);
+}
+
+static bool rings_pending(void)
+{
+	struct log_async_ring *ring;
+	bool pending = false;
+
+	pthread_mutex_lock(&log_async.rings_mutex);
+	llist_for_each_entry(ring, &log_async.rings, list) {
+		if (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) != __atomic_load_n(&ring->tail, __ATOMIC_RELAXED)) {
+			pending = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&log_async.rings_mutex);
+	return pending;
+}
+
+/* wait until a message is queued, or for LOG_ASYNC_IDLE_MS */
+static void writer_wait(void)
+{
+	struct timespec ts;
+
+	pthread_mutex_lock(&log_async.wake_mutex);
+	__atomic_store_n(&log_async.writer_idle, 1, __ATOMIC_SEQ_CST);
+	if (!log_async.stop && !rings_pending()) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += LOG_ASYNC_IDLE_MS * 1000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait(&log_async.wake_cond, &log_async.wake_mutex, &ts);
+	}
+	__atomic_store_n(&log_async.writer_idle, 0, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&log_async.wake_mutex);
+}
+
+static void *writer_main(void *arg)
+{
+	unsigned int n;
+	bool stop;
+
+#ifdef HAVE_PTHREAD_GETNAME_NP
+	pthread_setname_np(pthread_self(), "log_async");
+#endif
+
+	while (1) {
+		pthread_mutex_lock(&log_async.wake_mutex);
+		stop = log_async.stop;
+		pthread_mutex_unlock(&log_async.wake_mutex);
+
+		pthread_mutex_lock(&log_async.io_mutex);
+		n = drain(LOG_ASYNC_BATCH);
+		pthread_mutex_unlock(&log_async.io_mutex);
+
+		if (n == LOG_ASYNC_BATCH)
+			continue;
+		/* everything queued before stopping has been output */
+		if (stop)
+			break;
+		writer_wait();
+	}
+	return NULL;
+}
+
+/*! Enable asynchronous logging
+ *  \param[in] ring_size size of the per-thread rings in bytes, a power of two
+ *		and at least 16384; 0 for \ref LOG_ASYNC_RING_SIZE_DEFAULT
+ *  \returns 0 on success; negative on error
+ *
+ *  Starts the writer thread, and enables multithread support of the logging
+ *  core (see log_enable_multithread()).  Must be called after log_init(). */
+int log_async_enable(size_t ring_size)
+{
+	int rc;
+
+	assert_loginfo(__func__);
+
+	if (ring_size == 0)
+		ring_size = LOG_ASYNC_RING_SIZE_DEFAULT;
+	if (ring_size < LOG_ASYNC_RING_SIZE_MIN || (ring_size & (ring_size - 1)))
+		return -EINVAL;
+	if (log_async_enabled())
+		return -EALREADY;
+
+	pthread_once(&log_async.ring_key_once, ring_key_create);
+	if (!log_async.ctrg) {
+		log_async.ctrg = rate_ctr_group_alloc_mt(tall_log_ctx, &log_async_ctrg_desc, 0);
+		if (!log_async.ctrg)
+			return -ENOMEM;
+	}
+
+	log_enable_multithread();
+	log_async.ring_size = ring_size;
+	log_async.stop = false;
+	rc = pthread_create(&log_async.thread, NULL, writer_main, NULL);
+	if (rc)
+		return -rc;
+	log_async.writer_active = true;
+
+	log_tgt_mutex_lock();
+	log_async_running = true;
+	log_tgt_mutex_unlock();
+	return 0;
+}
+
+/*! Disable asynchronous logging
+ *
+ *  Outputs all queued messages and terminates the writer thread.  Rings of
+ *  threads which are still running are kept for a later log_async_enable(). */
+void log_async_disable(void)
+{
+	if (!log_async_enabled())
+		return;
+
+	log_tgt_mutex_lock();
+	log_async_running = false;
+	log_tgt_mutex_unlock();
+
+	pthread_mutex_lock(&log_async.wake_mutex);
+	log_async.stop = true;
+	pthread_cond_signal(&log_async.wake_cond);
+	pthread_mutex_unlock(&log_async.wake_mutex);
+	pthread_join(log_async.thread, NULL);
+	log_async.writer_active = false;
+
+	/* output the messages queued by other threads in the meantime */
+	pthread_mutex_lock(&log_async.io_mutex);
+	wait_enqueued();
+	drain(UINT32_MAX);
+	pthread_mutex_unlock(&log_async.io_mutex);
+}
+
+/*! Whether asynchronous logging is enabled
+ *  \returns true between log_async_enable() and log_async_disable() */
+bool log_async_enabled(void)
+{
+	return log_async_running;
+}
+
+/*! Output all messages queued so far, before returning
+ *
+ *  The messages are output by the calling thread, unless the writer thread is
+ *  currently outputting messages. */
+void log_async_flush(void)
+{
+	if (log_async.writer_active && pthread_equal(pthread_self(), log_async.thread))
+		return;
+
+	pthread_mutex_lock(&log_async.io_mutex);
+	drain(UINT32_MAX);
+	pthread_mutex_unlock(&log_async.io_mutex);
+}
+
+/*! Assign a bit to a log target added by log_add_target() */
+void log_async_target_add(struct log_target *target)
+{
+	int bit;
+
+	pthread_mutex_lock(&log_async.io_mutex);
+	if (~log_async.bits_used) {
+		bit = __builtin_ctzll(~log_async.bits_used);
+		log_async.bits_used |= 1ULL << bit;
+		log_async.targets[bit] = target;
+		/* read by log_async_reserve() with the log target mutex held */
+		log_async.target_epoch[bit] = __atomic_add_fetch(&log_async.epoch, 1, __ATOMIC_RELAXED);
+		target->async_bit = bit;
+	} else {
+		/* all bits in use; log to the target synchronously */
+		target->async_bit = -1;
+	}
+	pthread_mutex_unlock(&log_async.io_mutex);
+}
+
+/*! Release the bit of a log target deleted by log_del_target() */
+void log_async_target_del(struct log_target *target)
+{
+	if (target->async_bit < 0)
+		return;
+
+	pthread_mutex_lock(&log_async.io_mutex);
+	log_async.targets[target->async_bit] = NULL;
+	log_async.bits_used &= ~(1ULL << target->async_bit);
+	target->async_bit = -1;
+	pthread_mutex_unlock(&log_async.io_mutex);
+}
+
+/*! Keep the writer thread from using log targets; to be held while closing
+ *  or re-opening the output of a target, or destroying it */
+void log_async_io_lock(void)
+{
+	pthread_mutex_lock(&log_async.io_mutex);
+}
+
+void log_async_io_unlock(void)
+{
+	pthread_mutex_unlock(&log_async.io_mutex);
+}
+
+/*! Output all queued messages, called by osmo_panic()
+ *
+ *  If the writer thread does not release the rings in time (e.g. because the
+ *  panic happened in the writer thread itself), the messages are output
+ *  without locking. */
+void log_async_panic_flush(void)
+{
+	bool io_locked;
+
+	/* the panic may happen while outputting the queued messages */
+	if (__atomic_exchange_n(&log_async.panic, 1, __ATOMIC_SEQ_CST))
+		return;
+	if (!log_async_running)
+		return;
+
+	io_locked = panic_trylock(&log_async.io_mutex);
+	drain(UINT32_MAX);
+	if (io_locked)
+		pthread_mutex_unlock(&log_async.io_mutex);
+}
+
+/* log_fini(): stop asynchronous logging and release the counters */
+void log_async_fini(void)
+{
+	log_async_disable();
+	if (log_async.ctrg) {
+		rate_ctr_group_free(log_async.ctrg);
+		log_async.ctrg = NULL;
+	}
+}
+
+#else /* if (!EMBEDDED) */
+
+bool log_async_running;
+
+int log_async_enable(size_t ring_size) { return -ENOTSUP; }
+void log_async_disable(void) {}
+bool log_async_enabled(void) { return false; }
+void log_async_flush(void) {}
+bool log_async_reserve(void) { return false; }
+void log_async_enqueue(uint64_t targets, int subsys, unsigned int level, const char *file, int line,
+		       int cont, const char *format, va_list ap) {}
+void log_async_target_add(struct log_target *target) { target->async_bit = -1; }
+void log_async_target_del(struct log_target *target) {}
+void log_async_io_lock(void) {}
+void log_async_io_unlock(void) {}
+void log_async_panic_flush(void) {}
+void log_async_fini(void) {}
+
+#endif /* if (!EMBEDDED) */
+
+/*! @} */
@@ -0,0 +1,37 @@
+/*! \file logging_async_internal.h
+ * Internal interface between the logging core and asynchronous logging. */
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#include <osmocom/core/logging.h>
+
+/* Time stamp and thread of a log message; recorded when the message is queued,
+ * and used instead of the current ones while the writer thread outputs it. */
+struct log_msg_meta {
+	struct timeval tv;
+	long int tid;
+};
+
+/* logging.c */
+extern __thread const struct log_msg_meta *log_msg_meta_cur;
+void log_msg_time(struct timeval *tv);
+long int log_msg_tid(void);
+int log_target_output_str(struct log_target *target, int subsys, unsigned int level,
+			  const char *file, int line, int cont, const char *str);
+void log_target_output_flush(struct log_target *target);
+
+/* logging_async.c */
+extern bool log_async_running;
+bool log_async_reserve(void);
+void log_async_enqueue(uint64_t targets, int subsys, unsigned int level, const char *file, int line,
+		       int cont, const char *format, va_list ap);
+void log_async_target_add(struct log_target *target);
+void log_async_target_del(struct log_target *target);
+void log_async_io_lock(void);
+void log_async_io_unlock(void);
+void log_async_panic_flush(void);
+void log_async_fini(void);
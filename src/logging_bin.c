@@ -0,0 +1,1002 @@
+/*! \file logging_bin.c
+ * Binary logging to a memory mapped ring file. */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*! \addtogroup logging_bin
+ *  @{
+ *
+ * A binary log target does not format log messages.  It records the time
+ * stamp, category, level, source file and line, the format string and the
+ * raw printf arguments of each message into a ring in a memory mapped file.
+ * Format strings and source file names are stored only once, in a dictionary
+ * in the same file, and referred to by id.  Rendering the messages as text is
+ * deferred to the reader API below, e.g. by the osmo-logbin-decode utility.
+ *
+ * This makes logging at a high volume cheap, so that debug logging can be
+ * kept enabled for post-mortem analysis: as the file is mapped shared, its
+ * contents survive a crash of the process.  When a binary log file is
+ * created, an existing file of the same name is renamed to "<name>.1", so
+ * that the log of the previous run is kept after a restart.
+ *
+ * Messages with a format string that can not be decoded without the
+ * arguments at hand (positional arguments, %n, %m, wide characters) are
+ * formatted when logged and stored as text.
+ *
+ * \file logging_bin.c */
+
+#include "../config.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <osmocom/core/logging.h>
+#include <osmocom/core/logging_bin.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+
+#if (!EMBEDDED)
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <osmocom/core/hashtable.h>
+
+#include "logging_async_internal.h"
+
+/* alignment of dictionary entries and records */
+#define LOG_BIN_ALIGN		8
+/* maximum number of arguments of a format string stored in binary */
+#define BIN_FMT_MAX_ARGS	16
+/* maximum number of distinct format strings and source file names */
+#define BIN_STR_MAX		4096
+/* offset of the dictionary, the header is in the first page */
+#define BIN_DICT_OFF		4096
+/* minimum size of the record ring */
+#define BIN_RING_SIZE_MIN	(64 << 10)
+
+#define BIN_ALIGN(len)		(((len) + LOG_BIN_ALIGN - 1) & ~(LOG_BIN_ALIGN - 1))
+
+/* type of a printf argument, determining how it is fetched and stored */
+enum bin_arg_type {
+	BIN_ARG_INT,		/* int, stored as 4 bytes */
+	BIN_ARG_LONG,		/* long, stored as 8 bytes */
+	BIN_ARG_LLONG,		/* long long, stored as 8 bytes */
+	BIN_ARG_INTMAX,		/* intmax_t, stored as 8 bytes */
+	BIN_ARG_SIZE,		/* size_t, stored as 8 bytes */
+	BIN_ARG_PTRDIFF,	/* ptrdiff_t, stored as 8 bytes */
+	BIN_ARG_DOUBLE,		/* double, stored as 8 bytes */
+	BIN_ARG_LDOUBLE,	/* long double, stored as 8 byte double */
+	BIN_ARG_PTR,		/* void *, stored as 8 bytes */
+	BIN_ARG_STR,		/* char *, stored as 2 bytes length and the characters */
+};
+
+/* precision of a string argument taken from the preceding argument */
+#define BIN_PREC_ARG		-2
+
+/* a printf conversion specification, from '%' to the conversion character */
+struct bin_conv {
+	const char *flags;	/* flag characters, flags_len of them */
+	int flags_len;
+	const char *width;	/* width digits, width_len of them; or '*' */
+	int width_len;
+	const char *prec;	/* precision digits after the '.', prec_len of them; or '*' */
+	int prec_len;		/* -1 if there is no precision */
+	const char *len_mod;	/* length modifier as written, len_mod_len characters */
+	int len_mod_len;
+	char conv;		/* conversion character, '%' for a literal '%' */
+	enum bin_arg_type type;	/* type of the argument */
+	const char *end;	/* first character after the specification */
+};
+
+/* Parse the conversion specification starting at the '%' at p.
+ * Returns 0 on success, -ENOTSUP if it can not be stored in binary. */
+static int bin_parse_conv(const char *p, struct bin_conv *c)
+{
+	const char *q = p + 1;
+	int n;
+
+	memset(c, 0, sizeof(*c));
+	c->prec_len = -1;
+
+	if (*q == '%') {
+		c->conv = '%';
+		c->end = q + 1;
+		return 0;
+	}
+
+	c->flags = q;
+	while (*q && strchr("-+ #0'I", *q))
+		q++;
+	c->flags_len = q - c->flags;
+
+	c->width = q;
+	if (*q == '*')
+		q++;
+	else {
+		while (*q >= '0' && *q <= '9')
+			q++;
+	}
+	c->width_len = q - c->width;
+	/* positional arguments, also "*m$" */
+	if (*q == '$' || (*c->width == '*' && *q >= '0' && *q <= '9'))
+		return -ENOTSUP;
+
+	if (*q == '.') {
+		q++;
+		c->prec = q;
+		if (*q == '*') {
+			q++;
+			if (*q >= '0' && *q <= '9')
+				return -ENOTSUP;
+		} else {
+			while (*q >= '0' && *q <= '9')
+				q++;
+		}
+		c->prec_len = q - c->prec;
+	}
+
+	c->len_mod = q;
+	while (*q && strchr("hlLqjzZt", *q))
+		q++;
+	c->len_mod_len = n = q - c->len_mod;
+
+	c->conv = *q;
+	c->end = q + 1;
+
+	switch (c->conv) {
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		if (n == 0 || (n == 1 && c->len_mod[0] == 'h') || (n == 2 && !strncmp(c->len_mod, "hh", 2)))
+			c->type = BIN_ARG_INT;
+		else if (n == 1 && c->len_mod[0] == 'l')
+			c->type = BIN_ARG_LONG;
+		else if ((n == 2 && !strncmp(c->len_mod, "ll", 2)) || (n == 1 && strchr("qL", c->len_mod[0])))
+			c->type = BIN_ARG_LLONG;
+		else if (n == 1 && c->len_mod[0] == 'j')
+			c->type = BIN_ARG_INTMAX;
+		else if (n == 1 && strchr("zZ", c->len_mod[0]))
+			c->type = BIN_ARG_SIZE;
+		else if (n == 1 && c->len_mod[0] == 't')
+			c->type = BIN_ARG_PTRDIFF;
+		else
+			return -ENOTSUP;
+		return 0;
+	case 'c':
+		if (n != 0)
+			return -ENOTSUP;
+		c->type = BIN_ARG_INT;
+		return 0;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		if (n == 0 || (n == 1 && c->len_mod[0] == 'l'))
+			c->type = BIN_ARG_DOUBLE;
+		else if (n == 1 && c->len_mod[0] == 'L')
+			c->type = BIN_ARG_LDOUBLE;
+		else
+			return -ENOTSUP;
+		return 0;
+	case 's':
+		if (n != 0)
+			return -ENOTSUP;
+		c->type = BIN_ARG_STR;
+		return 0;
+	case 'p':
+		if (n != 0)
+			return -ENOTSUP;
+		c->type = BIN_ARG_PTR;
+		return 0;
+	default:
+		/* %n, %m, %S, %C and invalid conversions */
+		return -ENOTSUP;
+	}
+}
+
+/***********************************************************************
+ * Writing
+ ***********************************************************************/
+
+/* an argument of a format string, as fetched from the va_list */
+struct bin_arg {
+	uint8_t type;		/* enum bin_arg_type */
+	int16_t prec;		/* for strings: maximum length, -1 or BIN_PREC_ARG */
+};
+
+/* a format string or source file name known to the target */
+struct bin_str {
+	struct hlist_node hnode;
+	const char *ptr;	/* the string logged, used as key */
+	const char *str;	/* its copy in the dictionary; NULL if id is 0 */
+	uint32_t id;		/* id in the dictionary; 0 to store formatted text */
+	uint8_t num_args;
+	struct bin_arg args[BIN_FMT_MAX_ARGS];
+};
+
+struct log_bin_file {
+	int fd;
+	void *map;
+	size_t map_len;
+	struct log_bin_file_hdr *hdr;
+	uint8_t *dict;
+	uint8_t *ring;
+	uint32_t next_fmt_id;
+	uint32_t next_file_id;
+	/* entries of the hash tables, allocated up front as the hot path
+	 * may be called from any thread */
+	struct bin_str *strs;
+	unsigned int num_strs;
+	DECLARE_HASHTABLE(fmts, 10);
+	DECLARE_HASHTABLE(files, 8);
+};
+
+/* Append a string to the dictionary; return its copy there, or NULL if there is no space */
+static const char *bin_dict_add(struct log_bin_file *lbf, enum log_bin_dict_kind kind, uint32_t id,
+				const char *str)
+{
+	struct log_bin_file_hdr *hdr = lbf->hdr;
+	struct log_bin_dict_ent *ent;
+	size_t str_len = strlen(str) + 1;
+	size_t len = BIN_ALIGN(sizeof(*ent) + str_len);
+
+	if (len > UINT16_MAX || hdr->dict_used + len > hdr->dict_size)
+		return NULL;
+
+	ent = (struct log_bin_dict_ent *)(lbf->dict + hdr->dict_used);
+	memset(ent, 0, len);
+	ent->len = len;
+	ent->kind = kind;
+	ent->id = id;
+	memcpy(ent->str, str, str_len);
+	hdr->dict_used += len;
+	return ent->str;
+}
+
+/* Parse the arguments of the format string at fmt into s, and add it to the dictionary */
+static void bin_fmt_parse(struct log_bin_file *lbf, struct bin_str *s, const char *fmt)
+{
+	struct bin_conv c;
+	const char *p;
+
+	s->ptr = fmt;
+	s->str = NULL;
+	s->id = 0;
+	s->num_args = 0;
+
+	for (p = strchr(fmt, '%'); p; p = strchr(c.end, '%')) {
+		if (bin_parse_conv(p, &c) < 0)
+			return;
+		if (c.conv == '%')
+			continue;
+		/* width, precision and value; each at most once */
+		if (s->num_args + 3 > BIN_FMT_MAX_ARGS)
+			return;
+		if (c.width_len == 1 && *c.width == '*')
+			s->args[s->num_args++] = (struct bin_arg){ .type = BIN_ARG_INT };
+		if (c.prec_len == 1 && *c.prec == '*')
+			s->args[s->num_args++] = (struct bin_arg){ .type = BIN_ARG_INT };
+		s->args[s->num_args] = (struct bin_arg){ .type = c.type, .prec = -1 };
+		if (c.type == BIN_ARG_STR && c.prec_len >= 0) {
+			if (c.prec_len == 1 && *c.prec == '*')
+				s->args[s->num_args].prec = BIN_PREC_ARG;
+			else
+				s->args[s->num_args].prec = OSMO_MIN(atoi(c.prec), LOG_BIN_REC_MAX);
+		}
+		s->num_args++;
+	}
+
+	s->str = bin_dict_add(lbf, LOG_BIN_DICT_FMT, lbf->next_fmt_id, fmt);
+	if (s->str)
+		s->id = lbf->next_fmt_id++;
+}
+
+/* Look up the format string at fmt, and add it to the dictionary if it is new.
+ * Format strings are looked up by their address, but their contents are
+ * compared as well: a format string which is not a literal may have been
+ * replaced by a different one at the same address. */
+static const struct bin_str *bin_fmt_get(struct log_bin_file *lbf, const char *fmt)
+{
+	static const struct bin_str fmt_text = { .id = 0 };
+	struct bin_str *s;
+
+	hash_for_each_possible(lbf->fmts, s, hnode, (unsigned long)fmt) {
+		if (s->ptr != fmt)
+			continue;
+		if (s->id && strcmp(s->str, fmt)) {
+			/* the arguments of s would not match */
+			bin_fmt_parse(lbf, s, fmt);
+		}
+		return s;
+	}
+
+	if (lbf->num_strs >= BIN_STR_MAX)
+		return &fmt_text;
+	s = &lbf->strs[lbf->num_strs++];
+	bin_fmt_parse(lbf, s, fmt);
+	hash_add(lbf->fmts, &s->hnode, (unsigned long)fmt);
+	return s;
+}
+
+/* Return the dictionary id of the source file name, 0 if it can't be stored */
+static uint32_t bin_file_get(struct log_bin_file *lbf, const char *file)
+{
+	struct bin_str *s;
+
+	if (!file)
+		return 0;
+
+	hash_for_each_possible(lbf->files, s, hnode, (unsigned long)file) {
+		if (s->ptr == file)
+			return s->id;
+	}
+
+	if (lbf->num_strs >= BIN_STR_MAX)
+		return 0;
+	s = &lbf->strs[lbf->num_strs++];
+	s->ptr = file;
+	s->id = 0;
+	s->num_args = 0;
+	s->str = bin_dict_add(lbf, LOG_BIN_DICT_FILE, lbf->next_file_id, file);
+	if (s->str)
+		s->id = lbf->next_file_id++;
+	hash_add(lbf->files, &s->hnode, (unsigned long)file);
+	return s->id;
+}
+
+static inline int bin_put(uint8_t *buf, size_t buf_len, size_t *pos, const void *val, size_t len)
+{
+	if (*pos + len > buf_len)
+		return -ENOSPC;
+	memcpy(buf + *pos, val, len);
+	*pos += len;
+	return 0;
+}
+
+static inline int bin_put_str(uint8_t *buf, size_t buf_len, size_t *pos, const char *str, int max_len)
+{
+	uint16_t len;
+
+	if (*pos + sizeof(len) > buf_len)
+		return -ENOSPC;
+	len = strnlen(str, OSMO_MIN(buf_len - *pos - sizeof(len), max_len));
+	memcpy(buf + *pos, &len, sizeof(len));
+	memcpy(buf + *pos + sizeof(len), str, len);
+	*pos += sizeof(len) + len;
+	return 0;
+}
+
+/* Store the arguments of a message according to the format; returns the number
+ * of bytes written to buf, or -ENOSPC if they don't fit */
+static int bin_put_args(uint8_t *buf, size_t buf_len, const struct bin_str *fmt, va_list ap)
+{
+	size_t pos = 0;
+	int last_int = -1;
+	unsigned int i;
+	int rc = 0;
+
+	for (i = 0; i < fmt->num_args && rc == 0; i++) {
+		const struct bin_arg *a = &fmt->args[i];
+		int32_t i32;
+		int64_t i64;
+		uint64_t u64;
+		double d;
+		const char *s;
+		int prec;
+
+		switch (a->type) {
+		case BIN_ARG_INT:
+			last_int = i32 = va_arg(ap, int);
+			rc = bin_put(buf, buf_len, &pos, &i32, sizeof(i32));
+			break;
+		case BIN_ARG_LONG:
+			i64 = va_arg(ap, long);
+			rc = bin_put(buf, buf_len, &pos, &i64, sizeof(i64));
+			break;
+		case BIN_ARG_LLONG:
+			i64 = va_arg(ap, long long);
+			rc = bin_put(buf, buf_len, &pos, &i64, sizeof(i64));
+			break;
+		case BIN_ARG_INTMAX:
+			i64 = va_arg(ap, intmax_t);
+			rc = bin_put(buf, buf_len, &pos, &i64, sizeof(i64));
+			break;
+		case BIN_ARG_SIZE:
+			u64 = va_arg(ap, size_t);
+			rc = bin_put(buf, buf_len, &pos, &u64, sizeof(u64));
+			break;
+		case BIN_ARG_PTRDIFF:
+			i64 = va_arg(ap, ptrdiff_t);
+			rc = bin_put(buf, buf_len, &pos, &i64, sizeof(i64));
+			break;
+		case BIN_ARG_DOUBLE:
+			d = va_arg(ap, double);
+			rc = bin_put(buf, buf_len, &pos, &d, sizeof(d));
+			break;
+		case BIN_ARG_LDOUBLE:
+			d = va_arg(ap, long double);
+			rc = bin_put(buf, buf_len, &pos, &d, sizeof(d));
+			break;
+		case BIN_ARG_PTR:
+			u64 = (uintptr_t)va_arg(ap, void *);
+			rc = bin_put(buf, buf_len, &pos, &u64, sizeof(u64));
+			break;
+		case BIN_ARG_STR:
+			s = va_arg(ap, const char *);
+			if (!s)
+				s = "(null)";
+			prec = a->prec == BIN_PREC_ARG ? last_int : a->prec;
+			rc = bin_put_str(buf, buf_len, &pos, s, prec >= 0 ? prec : LOG_BIN_REC_MAX);
+			break;
+		}
+	}
+
+	return rc < 0 ? rc : pos;
+}
+
+/* Append a record to the ring, overwriting the oldest records if needed */
+static void bin_ring_write(struct log_bin_file *lbf, const struct log_bin_rec *rec)
+{
+	struct log_bin_file_hdr *hdr = lbf->hdr;
+	uint64_t size = hdr->ring_size;
+	uint64_t head = hdr->head;
+	uint64_t tail = hdr->tail;
+	uint64_t off = head & (size - 1);
+	uint64_t pad = 0;
+
+	/* records are contiguous, pad up to the end of the ring */
+	if (size - off < rec->len)
+		pad = size - off;
+
+	while (head + pad + rec->len - tail > size) {
+		const struct log_bin_rec *old = (const struct log_bin_rec *)(lbf->ring + (tail & (size - 1)));
+		tail += old->len;
+	}
+	/* update the tail first, so that the file is consistent at all times */
+	hdr->tail = tail;
+
+	if (pad) {
+		/* as little as LOG_BIN_ALIGN bytes, only len and flags are valid */
+		struct log_bin_rec *p = (struct log_bin_rec *)(lbf->ring + off);
+		p->len = pad;
+		p->flags = LOG_BIN_REC_F_PAD;
+		head += pad;
+		off = 0;
+	}
+
+	memcpy(lbf->ring + off, rec, rec->len);
+	hdr->head = head + rec->len;
+}
+
+static void _bin_raw_output(struct log_target *target, int subsys, unsigned int level, const char *file,
+			    int line, int cont, const char *format, va_list ap)
+{
+	struct log_bin_file *lbf = target->tgt_bin.file;
+	uint64_t buf[LOG_BIN_REC_MAX / sizeof(uint64_t)];
+	struct log_bin_rec *rec = (struct log_bin_rec *)buf;
+	size_t args_max = sizeof(buf) - sizeof(*rec);
+	const struct bin_str *fmt;
+	struct timespec ts;
+	va_list bp;
+	int rc = -ENOTSUP;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	memset(rec, 0, sizeof(*rec));
+	rec->flags = cont ? LOG_BIN_REC_F_CONT : 0;
+	rec->level = level;
+	rec->subsys = subsys;
+	rec->tid = log_msg_tid();
+	rec->file_id = bin_file_get(lbf, file);
+	rec->line = line;
+	rec->time_ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+
+	fmt = bin_fmt_get(lbf, format);
+	if (fmt->id) {
+		va_copy(bp, ap);
+		rc = bin_put_args(rec->args, args_max, fmt, bp);
+		va_end(bp);
+	}
+	if (rc >= 0)
+		rec->fmt_id = fmt->id;
+	else {
+		/* store the formatted text instead */
+		char *text = (char *)rec->args + sizeof(uint16_t);
+		uint16_t len;
+
+		rc = vsnprintf(text, args_max - sizeof(len), format, ap);
+		if (rc < 0)
+			return;
+		len = OSMO_MIN(rc, args_max - sizeof(len) - 1);
+		memcpy(rec->args, &len, sizeof(len));
+		rec->fmt_id = 0;
+		rc = sizeof(len) + len;
+	}
+
+	rec->len = BIN_ALIGN(sizeof(*rec) + rc);
+	bin_ring_write(lbf, rec);
+}
+
+static int bin_file_destructor(struct log_bin_file *lbf)
+{
+	if (lbf->map)
+		munmap(lbf->map, lbf->map_len);
+	if (lbf->fd >= 0)
+		close(lbf->fd);
+	return 0;
+}
+
+/*! Create a new log target writing binary records to a memory mapped file.
+ *  \param[in] fname File name of the new binary log file
+ *  \param[in] ring_size Size of the record ring, rounded up to a power of 2;
+ *			 LOG_BIN_RING_SIZE_DEFAULT if 0
+ *  \returns Log target in case of success, NULL otherwise
+ *
+ *  The file is truncated and sized to hold the header, the dictionary and the
+ *  ring.  An existing file of the same name is renamed to "<fname>.1". */
+struct log_target *log_target_create_bin(const char *fname, size_t ring_size)
+{
+	struct log_target *target;
+	struct log_bin_file *lbf;
+	struct log_bin_file_hdr *hdr;
+	char *old_fname;
+	size_t size;
+	unsigned int i;
+
+	if (ring_size == 0)
+		ring_size = LOG_BIN_RING_SIZE_DEFAULT;
+	for (size = BIN_RING_SIZE_MIN; size < ring_size; size <<= 1) {
+		if (size > SIZE_MAX / 2)
+			return NULL;
+	}
+
+	target = log_target_create();
+	if (!target)
+		return NULL;
+	target->tgt_bin.ring_size = ring_size;
+	ring_size = size;
+
+	lbf = talloc_zero(target, struct log_bin_file);
+	if (!lbf)
+		goto err;
+	lbf->fd = -1;
+	talloc_set_destructor(lbf, bin_file_destructor);
+	lbf->strs = talloc_zero_array(lbf, struct bin_str, BIN_STR_MAX);
+	if (!lbf->strs)
+		goto err;
+	hash_init(lbf->fmts);
+	hash_init(lbf->files);
+	lbf->next_fmt_id = 1;
+	lbf->next_file_id = 1;
+
+	target->tgt_bin.fname = talloc_strdup(target, fname);
+	if (!target->tgt_bin.fname)
+		goto err;
+
+	/* keep the log of the previous run */
+	old_fname = talloc_asprintf(target, "%s.1", fname);
+	if (!old_fname)
+		goto err;
+	if (rename(fname, old_fname) < 0 && errno != ENOENT)
+		LOGP(DLGLOBAL, LOGL_ERROR, "Cannot rename binary log file %s to %s: %s\n",
+		     fname, old_fname, strerror(errno));
+	talloc_free(old_fname);
+
+	lbf->map_len = BIN_DICT_OFF + LOG_BIN_DICT_SIZE + ring_size;
+	lbf->fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0660);
+	if (lbf->fd < 0)
+		goto err;
+	if (ftruncate(lbf->fd, lbf->map_len) < 0)
+		goto err;
+	lbf->map = mmap(NULL, lbf->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, lbf->fd, 0);
+	if (lbf->map == MAP_FAILED) {
+		lbf->map = NULL;
+		goto err;
+	}
+
+	lbf->hdr = hdr = lbf->map;
+	memcpy(hdr->magic, LOG_BIN_MAGIC, sizeof(hdr->magic));
+	hdr->version = LOG_BIN_VERSION;
+	hdr->byte_order = LOG_BIN_BYTE_ORDER;
+	hdr->dict_off = BIN_DICT_OFF;
+	hdr->dict_size = LOG_BIN_DICT_SIZE;
+	hdr->dict_used = 0;
+	hdr->ring_off = BIN_DICT_OFF + LOG_BIN_DICT_SIZE;
+	hdr->ring_size = ring_size;
+	hdr->head = 0;
+	hdr->tail = 0;
+	lbf->dict = (uint8_t *)lbf->map + hdr->dict_off;
+	lbf->ring = (uint8_t *)lbf->map + hdr->ring_off;
+
+	for (i = 0; i < osmo_log_info->num_cat; i++) {
+		const char *name = osmo_log_info->cat[i].name;
+		bin_dict_add(lbf, LOG_BIN_DICT_CAT, i, name ? name : "");
+	}
+
+	target->tgt_bin.file = lbf;
+	target->type = LOG_TGT_TYPE_BINARY;
+	target->raw_output = _bin_raw_output;
+	return target;
+
+err:
+	log_target_destroy(target);
+	return NULL;
+}
+
+/***********************************************************************
+ * Reading
+ ***********************************************************************/
+
+struct log_bin_reader {
+	uint8_t *buf;
+	size_t len;
+	const struct log_bin_file_hdr *hdr;
+	const uint8_t *ring;
+	/* dictionary strings, indexed by id */
+	const char **strs[_LOG_BIN_DICT_KIND_NUM];
+	uint32_t num_strs[_LOG_BIN_DICT_KIND_NUM];
+	/* position of the next record */
+	uint64_t pos;
+};
+
+static int bin_read_file(struct log_bin_reader *rd, const char *fname)
+{
+	struct stat st;
+	size_t pos = 0;
+	ssize_t rc;
+	int fd;
+
+	fd = open(fname, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+	if (fstat(fd, &st) < 0) {
+		rc = -errno;
+		goto out;
+	}
+
+	rd->len = st.st_size;
+	rd->buf = talloc_size(rd, rd->len + 1);
+	if (!rd->buf) {
+		rc = -ENOMEM;
+		goto out;
+	}
+	while (pos < rd->len) {
+		rc = read(fd, rd->buf + pos, rd->len - pos);
+		if (rc < 0 && errno == EINTR)
+			continue;
+		if (rc < 0) {
+			rc = -errno;
+			goto out;
+		}
+		if (rc == 0)
+			break;
+		pos += rc;
+	}
+	rd->len = pos;
+	rc = 0;
+out:
+	close(fd);
+	return rc;
+}
+
+static int bin_read_dict(struct log_bin_reader *rd)
+{
+	const struct log_bin_file_hdr *hdr = rd->hdr;
+	const uint8_t *dict = rd->buf + hdr->dict_off;
+	uint64_t pos = 0;
+
+	while (pos + sizeof(struct log_bin_dict_ent) <= hdr->dict_used) {
+		const struct log_bin_dict_ent *ent = (const struct log_bin_dict_ent *)(dict + pos);
+		const char ***strs;
+		uint32_t *num;
+
+		if (ent->len < sizeof(*ent) + 1 || pos + ent->len > hdr->dict_used
+		    || ent->kind >= _LOG_BIN_DICT_KIND_NUM || ent->id > UINT16_MAX
+		    || !memchr(ent->str, '\0', ent->len - sizeof(*ent)))
+			return -EINVAL;
+
+		strs = &rd->strs[ent->kind];
+		num = &rd->num_strs[ent->kind];
+		if (ent->id >= *num) {
+			const char **n = talloc_realloc(rd, *strs, const char *, ent->id + 1);
+			if (!n)
+				return -ENOMEM;
+			memset(n + *num, 0, (ent->id + 1 - *num) * sizeof(*n));
+			*strs = n;
+			*num = ent->id + 1;
+		}
+		(*strs)[ent->id] = ent->str;
+		pos += ent->len;
+	}
+	return 0;
+}
+
+/*! Open a binary log file for reading.
+ *  \param[in] ctx talloc context to allocate the reader from
+ *  \param[in] fname File name of the binary log file
+ *  \returns reader in case of success, NULL otherwise, with errno set
+ *
+ *  The file is read completely when opened; records logged afterwards are
+ *  not returned. */
+struct log_bin_reader *log_bin_reader_open(void *ctx, const char *fname)
+{
+	struct log_bin_reader *rd;
+	const struct log_bin_file_hdr *hdr;
+	int rc;
+
+	rd = talloc_zero(ctx, struct log_bin_reader);
+	if (!rd) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	rc = bin_read_file(rd, fname);
+	if (rc < 0)
+		goto err;
+
+	rc = -EINVAL;
+	if (rd->len < sizeof(*hdr))
+		goto err;
+	rd->hdr = hdr = (const struct log_bin_file_hdr *)rd->buf;
+	if (memcmp(hdr->magic, LOG_BIN_MAGIC, sizeof(hdr->magic)) || hdr->version != LOG_BIN_VERSION)
+		goto err;
+	if (hdr->byte_order != LOG_BIN_BYTE_ORDER) {
+		rc = -EPROTONOSUPPORT;
+		goto err;
+	}
+	if (hdr->dict_off > rd->len || hdr->dict_size > rd->len - hdr->dict_off || hdr->dict_used > hdr->dict_size)
+		goto err;
+	if (hdr->ring_off > rd->len || hdr->ring_size > rd->len - hdr->ring_off
+	    || hdr->ring_size < LOG_BIN_REC_MAX || (hdr->ring_size & (hdr->ring_size - 1))
+	    || hdr->tail > hdr->head || hdr->head - hdr->tail > hdr->ring_size)
+		goto err;
+	rd->ring = rd->buf + hdr->ring_off;
+	rd->pos = hdr->tail;
+
+	rc = bin_read_dict(rd);
+	if (rc < 0)
+		goto err;
+
+	return rd;
+err:
+	talloc_free(rd);
+	errno = -rc;
+	return NULL;
+}
+
+/*! Close a binary log file reader */
+void log_bin_reader_close(struct log_bin_reader *rd)
+{
+	talloc_free(rd);
+}
+
+static const char *bin_dict_str(const struct log_bin_reader *rd, enum log_bin_dict_kind kind, uint32_t id)
+{
+	if (id >= rd->num_strs[kind])
+		return NULL;
+	return rd->strs[kind][id];
+}
+
+static int bin_get(const uint8_t *args, size_t args_len, size_t *pos, void *val, size_t len)
+{
+	if (*pos + len > args_len)
+		return -EINVAL;
+	memcpy(val, args + *pos, len);
+	*pos += len;
+	return 0;
+}
+
+/* Render the format with the arguments stored in a record into out */
+static int bin_render(char *out, size_t out_len, const char *fmt, const uint8_t *args, size_t args_len)
+{
+	char str[LOG_BIN_REC_MAX + 1];
+	size_t out_pos = 0, pos = 0;
+	struct bin_conv c;
+	const char *p = fmt;
+
+	OSMO_ASSERT(out_len > 0);
+	out[0] = '\0';
+
+#define OUT_APPEND(fmt, args...) do { \
+		int _rc = snprintf(out + out_pos, out_len - out_pos, fmt, ##args); \
+		if (_rc < 0) \
+			return -EINVAL; \
+		out_pos = OSMO_MIN(out_pos + _rc, out_len - 1); \
+	} while (0)
+
+	while (*p) {
+		const char *q = strchr(p, '%');
+		char spec[64];
+		int spec_len;
+		int32_t i32;
+		int64_t i64;
+		double d;
+		uint16_t len;
+
+		if (!q) {
+			OUT_APPEND("%s", p);
+			break;
+		}
+		OUT_APPEND("%.*s", (int)(q - p), p);
+
+		if (bin_parse_conv(q, &c) < 0)
+			return -EINVAL;
+		p = c.end;
+		if (c.conv == '%') {
+			OUT_APPEND("%%");
+			continue;
+		}
+
+		/* build the specification with '*' replaced by the stored values,
+		 * and the length modifier matching the stored type */
+		spec_len = snprintf(spec, sizeof(spec), "%%%.*s", OSMO_MIN(c.flags_len, 8), c.flags);
+		if (c.width_len == 1 && *c.width == '*') {
+			if (bin_get(args, args_len, &pos, &i32, sizeof(i32)) < 0)
+				return -EINVAL;
+			spec_len += snprintf(spec + spec_len, sizeof(spec) - spec_len, "%d", i32);
+		} else
+			spec_len += snprintf(spec + spec_len, sizeof(spec) - spec_len, "%.*s",
+					     OSMO_MIN(c.width_len, 8), c.width);
+		if (c.prec_len == 1 && *c.prec == '*') {
+			if (bin_get(args, args_len, &pos, &i32, sizeof(i32)) < 0)
+				return -EINVAL;
+			/* a negative precision is taken as if it was omitted */
+			if (i32 >= 0)
+				spec_len += snprintf(spec + spec_len, sizeof(spec) - spec_len, ".%d", i32);
+		} else if (c.prec_len >= 0)
+			spec_len += snprintf(spec + spec_len, sizeof(spec) - spec_len, ".%.*s",
+					     OSMO_MIN(c.prec_len, 8), c.prec);
+
+		switch (c.type) {
+		case BIN_ARG_INT:
+			if (bin_get(args, args_len, &pos, &i32, sizeof(i32)) < 0)
+				return -EINVAL;
+			snprintf(spec + spec_len, sizeof(spec) - spec_len, "%.*s%c",
+				 c.len_mod_len, c.len_mod, c.conv);
+			OUT_APPEND(spec, i32);
+			break;
+		case BIN_ARG_LONG:
+		case BIN_ARG_LLONG:
+		case BIN_ARG_INTMAX:
+		case BIN_ARG_SIZE:
+		case BIN_ARG_PTRDIFF:
+			if (bin_get(args, args_len, &pos, &i64, sizeof(i64)) < 0)
+				return -EINVAL;
+			snprintf(spec + spec_len, sizeof(spec) - spec_len, "ll%c", c.conv);
+			if (c.conv == 'd' || c.conv == 'i')
+				OUT_APPEND(spec, (long long)i64);
+			else
+				OUT_APPEND(spec, (unsigned long long)i64);
+			break;
+		case BIN_ARG_DOUBLE:
+		case BIN_ARG_LDOUBLE:
+			if (bin_get(args, args_len, &pos, &d, sizeof(d)) < 0)
+				return -EINVAL;
+			snprintf(spec + spec_len, sizeof(spec) - spec_len, "%c", c.conv);
+			OUT_APPEND(spec, d);
+			break;
+		case BIN_ARG_PTR:
+			if (bin_get(args, args_len, &pos, &i64, sizeof(i64)) < 0)
+				return -EINVAL;
+			snprintf(spec + spec_len, sizeof(spec) - spec_len, "p");
+			OUT_APPEND(spec, (void *)(uintptr_t)i64);
+			break;
+		case BIN_ARG_STR:
+			if (bin_get(args, args_len, &pos, &len, sizeof(len)) < 0
+			    || len > sizeof(str) - 1 || bin_get(args, args_len, &pos, str, len) < 0)
+				return -EINVAL;
+			str[len] = '\0';
+			snprintf(spec + spec_len, sizeof(spec) - spec_len, "s");
+			OUT_APPEND(spec, str);
+			break;
+		}
+	}
+#undef OUT_APPEND
+
+	return out_pos;
+}
+
+/*! Read the next message from a binary log file.
+ *  \param[in] rd reader returned by log_bin_reader_open()
+ *  \param[out] msg the message read
+ *  \returns 1 if a message was read, 0 at the end of the log, negative on error
+ *
+ *  Messages are returned from the oldest to the newest one. */
+int log_bin_reader_next(struct log_bin_reader *rd, struct log_bin_msg *msg)
+{
+	const struct log_bin_file_hdr *hdr = rd->hdr;
+	const struct log_bin_rec *rec;
+	const char *fmt;
+	uint64_t off;
+	size_t args_len;
+	int rc;
+
+	while (rd->pos < hdr->head) {
+		off = rd->pos & (hdr->ring_size - 1);
+		rec = (const struct log_bin_rec *)(rd->ring + off);
+		if (rec->len < LOG_BIN_ALIGN || rec->len > hdr->ring_size - off || rec->len > hdr->head - rd->pos)
+			return -EINVAL;
+		rd->pos += rec->len;
+		if (rec->flags & LOG_BIN_REC_F_PAD)
+			continue;
+		if (rec->len < sizeof(*rec))
+			return -EINVAL;
+
+		memset(msg, 0, offsetof(struct log_bin_msg, text));
+		msg->ts.tv_sec = rec->time_ns / 1000000000;
+		msg->ts.tv_nsec = rec->time_ns % 1000000000;
+		msg->tid = rec->tid;
+		msg->subsys = rec->subsys;
+		msg->category = bin_dict_str(rd, LOG_BIN_DICT_CAT, rec->subsys);
+		msg->level = rec->level;
+		msg->file = rec->file_id ? bin_dict_str(rd, LOG_BIN_DICT_FILE, rec->file_id) : NULL;
+		msg->line = rec->line;
+		msg->cont = rec->flags & LOG_BIN_REC_F_CONT;
+
+		args_len = rec->len - sizeof(*rec);
+		if (rec->fmt_id == 0)
+			fmt = "%s";
+		else if (!(fmt = bin_dict_str(rd, LOG_BIN_DICT_FMT, rec->fmt_id)))
+			return -EINVAL;
+		rc = bin_render(msg->text, sizeof(msg->text), fmt, rec->args, args_len);
+		if (rc < 0)
+			return rc;
+		return 1;
+	}
+	return 0;
+}
+
+#else /* if (!EMBEDDED) */
+
+struct log_target *log_target_create_bin(const char *fname, size_t ring_size)
+{
+	return NULL;
+}
+
+struct log_bin_reader *log_bin_reader_open(void *ctx, const char *fname)
+{
+	errno = ENOTSUP;
+	return NULL;
+}
+
+int log_bin_reader_next(struct log_bin_reader *rd, struct log_bin_msg *msg)
+{
+	return -ENOTSUP;
+}
+
+void log_bin_reader_close(struct log_bin_reader *rd)
+{
+}
+
+#endif /* if (!EMBEDDED) */
+
+/*! @} */
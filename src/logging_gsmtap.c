@@ -49,42 +49,43 @@
 #include <osmocom/core/byteswap.h>
 #include <osmocom/core/thread.h>
 
-#define	GSMTAP_LOG_MAX_SIZE 4096
+#include "logging_async_internal.h"
 
-static __thread uint32_t logging_gsmtap_tid;
+#define	GSMTAP_LOG_MAX_SIZE 4096
 
 static void _gsmtap_raw_output(struct log_target *target, int subsys,
 			       unsigned int level, const char *file,
 			       int line, int cont, const char *format,
 			       va_list ap)
 {
+	struct gsmtap_inst *gti = target->tgt_gsmtap.gsmtap_inst;
+	uint8_t buf[sizeof(struct gsmtap_hdr) + sizeof(struct gsmtap_osmocore_log_hdr) + GSMTAP_LOG_MAX_SIZE];
 	struct msgb *msg;
 	struct gsmtap_hdr *gh;
 	struct gsmtap_osmocore_log_hdr *golh;
 	const char *subsys_name = log_category_name(subsys);
 	struct timeval tv;
-	int rc;
+	int rc, len;
 	const char *file_basename;
 
 	/* get timestamp ASAP */
-	osmo_gettimeofday(&tv, NULL);
+	log_msg_time(&tv);
 
-	msg = msgb_alloc(sizeof(*gh)+sizeof(*golh)+GSMTAP_LOG_MAX_SIZE,
-			 "GSMTAP logging");
+	/* The message is composed on the stack; a msgb is only allocated for
+	 * the write_queue, so that without it this may be called from the writer
+	 * thread of asynchronous logging. */
 
 	/* GSMTAP header */
-	gh = (struct gsmtap_hdr *) msgb_put(msg, sizeof(*gh));
+	gh = (struct gsmtap_hdr *) buf;
 	memset(gh, 0, sizeof(*gh));
 	gh->version = GSMTAP_VERSION;
 	gh->hdr_len = sizeof(*gh)/4;
 	gh->type = GSMTAP_TYPE_OSMOCORE_LOG;
 
 	/* Logging header */
-	golh = (struct gsmtap_osmocore_log_hdr *) msgb_put(msg, sizeof(*golh));
+	golh = (struct gsmtap_osmocore_log_hdr *) (buf + sizeof(*gh));
 	OSMO_STRLCPY_ARRAY(golh->proc_name, target->tgt_gsmtap.ident);
-	if (logging_gsmtap_tid == 0)
-		osmo_store32be((uint32_t)osmo_gettid(), &logging_gsmtap_tid);
-	golh->pid = logging_gsmtap_tid;
+	osmo_store32be((uint32_t)log_msg_tid(), &golh->pid);
 	if (subsys_name)
 		OSMO_STRLCPY_ARRAY(golh->subsys, subsys_name + 1);
 	else
@@ -101,20 +102,30 @@ static void _gsmtap_raw_output(struct log_target *target, int subsys,
 	golh->ts.sec = osmo_htonl(tv.tv_sec);
 	golh->ts.usec = osmo_htonl(tv.tv_usec);
 
-	rc = vsnprintf((char *) msg->tail, msgb_tailroom(msg), format, ap);
+	len = sizeof(*gh) + sizeof(*golh);
+	rc = vsnprintf((char *) buf + len, GSMTAP_LOG_MAX_SIZE, format, ap);
 	if (rc < 0) {
-		msgb_free(msg);
 		return;
-	} else if (rc >= msgb_tailroom(msg)) {
+	} else if (rc >= GSMTAP_LOG_MAX_SIZE) {
 		/* If the output was truncated, vsnprintf() returns the
 		 * number of characters which would have been written
 		 * if enough space had been available (excluding '\0'). */
-		rc = msgb_tailroom(msg);
-		msg->tail[rc - 1]  = '\0';
+		rc = GSMTAP_LOG_MAX_SIZE;
+		buf[len + rc - 1]  = '\0';
 	}
-	msgb_put(msg, rc);
+	len += rc;
 
-	rc = gsmtap_sendmsg(target->tgt_gsmtap.gsmtap_inst, msg);
+	if (!gti->ofd_wq_mode) {
+		/* immediate send, like gsmtap_sendmsg() */
+		rc = write(gsmtap_inst_fd(gti), buf, len);
+		return;
+	}
+
+	msg = msgb_alloc(len, "GSMTAP logging");
+	if (!msg)
+		return;
+	memcpy(msgb_put(msg, len), buf, len);
+	rc = gsmtap_sendmsg(gti, msg);
 	if (rc)
 		msgb_free(msg);
 }
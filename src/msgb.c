@@ -59,6 +59,47 @@
 #include <osmocom/core/msgb.h>
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/logging.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/stat_item.h>
+#include <osmocom/core/stats.h>
+
+/* one size class of a msgb pool */
+struct msgb_pool_class {
+	/* pool this class belongs to */
+	struct msgb_pool *pool;
+	/* size of the data buffer of all msgbs in this class */
+	uint16_t size;
+	/* msgbs available for allocation, linked via msgb.list */
+	struct llist_head free;
+};
+
+/*! A pool of pre-allocated msgbs, see msgb_pool_create() */
+struct msgb_pool {
+	/* next pool of this thread */
+	struct msgb_pool *next;
+	/* msgb_pools of the thread that created the pool, the free lists are not locked */
+	struct msgb_pool **owner;
+	/* MSGB_POOL_F_* */
+	unsigned int flags;
+	/* number of msgbs currently allocated from the pool */
+	unsigned int in_use;
+	/* all-time maximum of in_use */
+	unsigned int in_use_max;
+	/* set while the pool itself is being freed */
+	bool destroying;
+	struct rate_ctr_group *ctrg;
+	struct osmo_stat_item_group *statg;
+	unsigned int num_classes;
+	struct msgb_pool_class classes[0];
+};
+
+/* msgb pools of this thread; msgb_alloc_c() checks its ctx argument against these */
+static __thread struct msgb_pool *msgb_pools;
+
+static struct msgb *msgb_alloc_pool_ctx(struct msgb_pool *pool, uint16_t size, const char *name);
+
+/* is the pool used from the thread that created it? */
+#define MSGB_POOL_ASSERT_OWNER(pool) OSMO_ASSERT((pool)->owner == &msgb_pools)
 
 /*! Allocate a new message buffer from given talloc context
  * \param[in] ctx talloc context from which to allocate
@@ -72,8 +113,15 @@
  */
 struct msgb *msgb_alloc_c(const void *ctx, uint16_t size, const char *name)
 {
+	struct msgb_pool *pool;
 	struct msgb *msg;
 
+	/* transparently serve allocations from a msgb pool passed as talloc context */
+	for (pool = msgb_pools; pool; pool = pool->next) {
+		if (pool == ctx)
+			return msgb_alloc_pool_ctx(pool, size, name);
+	}
+
 	msg = talloc_named_const(ctx, sizeof(*msg) + size, name);
 	if (!msg) {
 		LOGP(DLGLOBAL, LOGL_FATAL, "Unable to allocate a msgb: "
@@ -113,6 +161,8 @@ struct msgb *msgb_alloc(uint16_t size, const char *name)
 
 /*! Release given message buffer
  * \param[in] m Message buffer to be freed
+ *
+ * A msgb allocated from a \ref msgb_pool is returned to its pool.
  */
 void msgb_free(struct msgb *m)
 {
@@ -288,7 +338,8 @@ uint16_t msgb_length(const struct msgb *msg)
 }
 
 /*! Set the talloc context for \ref msgb_alloc
- * Deprecated, use msgb_talloc_ctx_init() instead.
+ * Deprecated, use msgb_talloc_ctx_init() instead.  Passing a \ref msgb_pool
+ * makes msgb_alloc() allocate from that pool.
  *  \param[in] ctx talloc context to be used as root for msgb allocations
  */
 void msgb_set_talloc_ctx(void *ctx)
@@ -314,6 +365,296 @@ void *msgb_talloc_ctx_init(void *root_ctx, unsigned int pool_size)
 	return tall_msgb_ctx;
 }
 
+enum msgb_pool_ctr {
+	MSGB_POOL_CTR_ALLOC_HIT,
+	MSGB_POOL_CTR_ALLOC_MISS,
+	MSGB_POOL_CTR_ALLOC_OVERSIZE,
+};
+
+static const struct rate_ctr_desc msgb_pool_ctr_desc[] = {
+	[MSGB_POOL_CTR_ALLOC_HIT]	= { "alloc:hit",	"Allocations served from the free list" },
+	[MSGB_POOL_CTR_ALLOC_MISS]	= { "alloc:miss",	"Allocations requiring the pool to grow" },
+	[MSGB_POOL_CTR_ALLOC_OVERSIZE]	= { "alloc:oversize",	"Allocations larger than the largest size class" },
+};
+
+static const struct rate_ctr_group_desc msgb_pool_ctrg_desc = {
+	.group_name_prefix = "msgb_pool",
+	.group_description = "msgb pool",
+	.class_id = OSMO_STATS_CLASS_GLOBAL,
+	.num_ctr = ARRAY_SIZE(msgb_pool_ctr_desc),
+	.ctr_desc = msgb_pool_ctr_desc,
+};
+
+enum msgb_pool_stat {
+	MSGB_POOL_STAT_IN_USE,
+	MSGB_POOL_STAT_IN_USE_MAX,
+};
+
+static const struct osmo_stat_item_desc msgb_pool_stat_desc[] = {
+	[MSGB_POOL_STAT_IN_USE]		= { "in_use",		"msgbs currently allocated from the pool", "", 16, 0 },
+	[MSGB_POOL_STAT_IN_USE_MAX]	= { "in_use_max",	"High-water mark of msgbs allocated from the pool", "", 16, 0 },
+};
+
+static const struct osmo_stat_item_group_desc msgb_pool_statg_desc = {
+	.group_name_prefix = "msgb_pool",
+	.group_description = "msgb pool",
+	.class_id = OSMO_STATS_CLASS_GLOBAL,
+	.num_items = ARRAY_SIZE(msgb_pool_stat_desc),
+	.item_desc = msgb_pool_stat_desc,
+};
+
+/* pooled msgbs carry a pointer to their size class behind the data buffer, at the very end of the talloc chunk */
+static inline size_t msgb_pool_chunk_size(const struct msgb_pool_class *cls)
+{
+	return sizeof(struct msgb) + cls->size + sizeof(cls);
+}
+
+static inline struct msgb_pool_class *msgb_pool_class_of(const struct msgb *msg)
+{
+	struct msgb_pool_class *cls;
+	memcpy(&cls, (const uint8_t *)msg + talloc_get_size(msg) - sizeof(cls), sizeof(cls));
+	return cls;
+}
+
+/* talloc_free() of a pooled msgb puts it back on the free list instead of releasing the memory */
+static int msgb_pool_msgb_destructor(struct msgb *msg)
+{
+	struct msgb_pool_class *cls = msgb_pool_class_of(msg);
+	struct msgb_pool *pool = cls->pool;
+
+	if (pool->destroying)
+		return 0;
+	MSGB_POOL_ASSERT_OWNER(pool);
+
+	/* the msgb may have been talloc_steal()ed elsewhere meanwhile */
+	if (talloc_parent(msg) != pool)
+		talloc_steal(pool, msg);
+	talloc_free_children(msg);
+	llist_add(&msg->list, &cls->free);
+
+	pool->in_use--;
+	osmo_stat_item_set(osmo_stat_item_group_get_item(pool->statg, MSGB_POOL_STAT_IN_USE), pool->in_use);
+	return -1;
+}
+
+static struct msgb *msgb_pool_grow(struct msgb_pool_class *cls, const char *name)
+{
+	struct msgb *msg;
+
+	msg = talloc_named_const(cls->pool, msgb_pool_chunk_size(cls), name);
+	if (!msg)
+		return NULL;
+	memcpy((uint8_t *)msg + msgb_pool_chunk_size(cls) - sizeof(cls), &cls, sizeof(cls));
+	talloc_set_destructor(msg, msgb_pool_msgb_destructor);
+	return msg;
+}
+
+static int msgb_pool_destructor(struct msgb_pool *pool)
+{
+	struct msgb_pool **p;
+
+	MSGB_POOL_ASSERT_OWNER(pool);
+	/* let the msgbs owned by the pool be freed along with it */
+	pool->destroying = true;
+
+	for (p = &msgb_pools; *p; p = &(*p)->next) {
+		if (*p == pool) {
+			*p = pool->next;
+			break;
+		}
+	}
+
+	rate_ctr_group_free(pool->ctrg);
+	osmo_stat_item_group_free(pool->statg);
+	return 0;
+}
+
+/*! Create a pool of pre-allocated msgbs for the current thread
+ * \param[in] ctx talloc context from which to allocate the pool
+ * \param[in] idx index of the pool's rate counter and stat item groups
+ * \param[in] sizes data buffer sizes of the size classes, in ascending order
+ * \param[in] num_sizes number of entries in \a sizes
+ * \param[in] prealloc number of msgbs to pre-allocate per size class
+ * \param[in] flags bit-mask of MSGB_POOL_F_*
+ * \returns pool on success; NULL on error
+ *
+ * Allocating a msgb from the pool takes it from the free list of the
+ * smallest size class which fits the requested size; the pool grows on
+ * demand.  Releasing a pooled msgb with msgb_free() or talloc_free()
+ * returns it to the free list.  Unless \ref MSGB_POOL_F_ZERO is set, only
+ * the msgb header is zeroed on allocation, not the data buffer.
+ *
+ * The pool is registered with the current thread: passing it as talloc
+ * context to msgb_alloc_c(), or to msgb_set_talloc_ctx() for
+ * msgb_alloc(), allocates from the pool when done on this thread.  A pool
+ * and its msgbs must only be used from the thread that created it, as its
+ * free lists are not locked; allocating from it or freeing its msgbs on
+ * another thread fails an assertion.  All of its msgbs must have been freed
+ * before the pool is destroyed.
+ */
+struct msgb_pool *msgb_pool_create(void *ctx, unsigned int idx, const uint16_t *sizes, unsigned int num_sizes,
+				   unsigned int prealloc, unsigned int flags)
+{
+	struct msgb_pool *pool;
+	unsigned int i, j;
+
+	if (!num_sizes)
+		return NULL;
+	for (i = 1; i < num_sizes; i++) {
+		if (sizes[i] <= sizes[i - 1])
+			return NULL;
+	}
+
+	pool = talloc_zero_size(ctx, sizeof(*pool) + num_sizes * sizeof(pool->classes[0]));
+	if (!pool)
+		return NULL;
+	talloc_set_name_const(pool, "msgb_pool");
+
+	pool->flags = flags;
+	pool->num_classes = num_sizes;
+	pool->ctrg = rate_ctr_group_alloc(pool, &msgb_pool_ctrg_desc, idx);
+	pool->statg = osmo_stat_item_group_alloc(pool, &msgb_pool_statg_desc, idx);
+	if (!pool->ctrg || !pool->statg) {
+		rate_ctr_group_free(pool->ctrg);
+		osmo_stat_item_group_free(pool->statg);
+		talloc_free(pool);
+		return NULL;
+	}
+
+	pool->owner = &msgb_pools;
+	pool->next = msgb_pools;
+	msgb_pools = pool;
+	talloc_set_destructor(pool, msgb_pool_destructor);
+
+	for (i = 0; i < num_sizes; i++) {
+		struct msgb_pool_class *cls = &pool->classes[i];
+
+		cls->pool = pool;
+		cls->size = sizes[i];
+		INIT_LLIST_HEAD(&cls->free);
+
+		for (j = 0; j < prealloc; j++) {
+			struct msgb *msg = msgb_pool_grow(cls, "msgb_pool");
+			if (!msg) {
+				talloc_free(pool);
+				return NULL;
+			}
+			llist_add_tail(&msg->list, &cls->free);
+		}
+	}
+
+	return pool;
+}
+
+/*! Destroy a msgb pool and release all of its memory
+ * \param[in] pool pool to be destroyed
+ */
+void msgb_pool_destroy(struct msgb_pool *pool)
+{
+	talloc_free(pool);
+}
+
+static struct msgb *msgb_alloc_pool_ctx(struct msgb_pool *pool, uint16_t size, const char *name)
+{
+	struct msgb_pool_class *cls = NULL;
+	struct msgb *msg;
+	unsigned int i;
+
+	MSGB_POOL_ASSERT_OWNER(pool);
+
+	for (i = 0; i < pool->num_classes; i++) {
+		if (pool->classes[i].size >= size) {
+			cls = &pool->classes[i];
+			break;
+		}
+	}
+
+	if (!cls) {
+		/* doesn't fit any size class: plain msgb, owned by the pool ctx but not recycled */
+		rate_ctr_inc2(pool->ctrg, MSGB_POOL_CTR_ALLOC_OVERSIZE);
+		msg = talloc_named_const(pool, sizeof(*msg) + size, name);
+		if (!msg)
+			return NULL;
+		memset(msg, 0, sizeof(*msg) + size);
+		goto init;
+	}
+
+	if (!llist_empty(&cls->free)) {
+		msg = llist_first_entry(&cls->free, struct msgb, list);
+		llist_del(&msg->list);
+		talloc_set_name_const(msg, name);
+		rate_ctr_inc2(pool->ctrg, MSGB_POOL_CTR_ALLOC_HIT);
+	} else {
+		msg = msgb_pool_grow(cls, name);
+		if (!msg) {
+			LOGP(DLGLOBAL, LOGL_FATAL, "Unable to allocate a msgb: "
+				"name='%s', size=%u\n", name, size);
+			return NULL;
+		}
+		rate_ctr_inc2(pool->ctrg, MSGB_POOL_CTR_ALLOC_MISS);
+	}
+
+	if (pool->flags & MSGB_POOL_F_ZERO)
+		memset(msg, 0, sizeof(*msg) + size);
+	else
+		memset(msg, 0, sizeof(*msg));
+
+	pool->in_use++;
+	osmo_stat_item_set(osmo_stat_item_group_get_item(pool->statg, MSGB_POOL_STAT_IN_USE), pool->in_use);
+	if (pool->in_use > pool->in_use_max) {
+		pool->in_use_max = pool->in_use;
+		osmo_stat_item_set(osmo_stat_item_group_get_item(pool->statg, MSGB_POOL_STAT_IN_USE_MAX),
+				   pool->in_use_max);
+	}
+
+init:
+	msg->data_len = size;
+	msg->len = 0;
+	msg->data = msg->_data;
+	msg->head = msg->_data;
+	msg->tail = msg->_data;
+
+	return msg;
+}
+
+/*! Allocate a new message buffer from a msgb pool
+ * \param[in] pool pool from which to allocate, see msgb_pool_create()
+ * \param[in] size Length in octets, including headroom
+ * \param[in] name Human-readable name to be associated with msgb
+ * \returns msgb from the pool; NULL on error
+ */
+struct msgb *msgb_alloc_pool(struct msgb_pool *pool, uint16_t size, const char *name)
+{
+	return msgb_alloc_pool_ctx(pool, size, name);
+}
+
+/*! Get the number of msgbs currently allocated from a pool
+ * \param[in] pool pool to query
+ * \returns number of pooled msgbs not yet freed
+ */
+unsigned int msgb_pool_in_use(const struct msgb_pool *pool)
+{
+	return pool->in_use;
+}
+
+/*! Get the rate counter group of a msgb pool
+ * \param[in] pool pool to query
+ * \returns rate counter group with the pool's hit/miss counters
+ */
+struct rate_ctr_group *msgb_pool_get_ctrg(struct msgb_pool *pool)
+{
+	return pool->ctrg;
+}
+
+/*! Get the stat item group of a msgb pool
+ * \param[in] pool pool to query
+ * \returns stat item group with the pool's usage and high-water mark
+ */
+struct osmo_stat_item_group *msgb_pool_get_statg(struct msgb_pool *pool)
+{
+	return pool->statg;
+}
+
 /*! Copy an msgb.
  *
  *  This function allocates a new msgb, copies the data buffer of msg,
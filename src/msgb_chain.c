@@ -0,0 +1,330 @@
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*! \addtogroup msgb_chain
+ *  @{
+ *
+ *  Scatter/gather message buffers.
+ *
+ *  A \ref msgb_chain is a list of segments, each referring to a range of
+ *  octets within a msgb.  msgbs are reference counted, so that
+ *  splitting a chain (e.g. for fragmentation) does not copy any payload;
+ *  both resulting chains merely refer to the same msgb.  Headers are
+ *  prepended with msgb_chain_push(), which writes into the headroom of
+ *  the first segment when it is not shared, and otherwise adds a small
+ *  header segment in front.
+ *
+ *  A chain is transmitted with a single writev()/sendmsg() using the
+ *  iovec array from msgb_chain_to_iovec(), see osmo_sock_send_chain()
+ *  and osmo_wqueue_enqueue_chain().
+ *
+ * \file msgb_chain.c
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <osmocom/core/msgb_chain.h>
+#include <osmocom/core/talloc.h>
+
+/* A msgb shared by all segments referring to it. Allocated as talloc child of the msgb. */
+struct msgb_chain_blk {
+	unsigned int refcnt;
+	struct msgb *msg;
+};
+
+static struct msgb_chain_blk *blk_alloc(struct msgb *msg)
+{
+	struct msgb_chain_blk *blk = talloc(msg, struct msgb_chain_blk);
+	if (!blk)
+		return NULL;
+	blk->refcnt = 0;
+	blk->msg = msg;
+	return blk;
+}
+
+static void blk_put(struct msgb_chain_blk *blk)
+{
+	if (--blk->refcnt == 0)
+		msgb_free(blk->msg);
+}
+
+static struct msgb_chain_seg *seg_alloc(struct msgb_chain *chain, struct msgb_chain_blk *blk,
+					uint8_t *data, unsigned int len)
+{
+	struct msgb_chain_seg *seg = talloc(chain, struct msgb_chain_seg);
+	if (!seg)
+		return NULL;
+	seg->blk = blk;
+	seg->data = data;
+	seg->len = len;
+	blk->refcnt++;
+	return seg;
+}
+
+static void seg_del(struct msgb_chain *chain, struct msgb_chain_seg *seg)
+{
+	llist_del(&seg->list);
+	chain->num_segs--;
+	chain->len -= seg->len;
+	blk_put(seg->blk);
+	talloc_free(seg);
+}
+
+static int msgb_chain_destructor(struct msgb_chain *chain)
+{
+	struct msgb_chain_seg *seg, *seg2;
+
+	llist_for_each_entry_safe(seg, seg2, &chain->segs, list)
+		seg_del(chain, seg);
+	return 0;
+}
+
+/*! Allocate a new, empty msgb chain
+ * \param[in] ctx talloc context from which to allocate
+ * \param[in] name human-readable name of the chain
+ * \returns newly allocated chain; NULL on error */
+struct msgb_chain *msgb_chain_alloc(void *ctx, const char *name)
+{
+	struct msgb_chain *chain = talloc_zero(ctx, struct msgb_chain);
+	if (!chain)
+		return NULL;
+	talloc_set_name_const(chain, name);
+	INIT_LLIST_HEAD(&chain->segs);
+	talloc_set_destructor(chain, msgb_chain_destructor);
+	return chain;
+}
+
+/*! Release a msgb chain, and all msgbs no longer referenced by another chain
+ * \param[in] chain msgb chain to release */
+void msgb_chain_free(struct msgb_chain *chain)
+{
+	talloc_free(chain);
+}
+
+static int add_msgb(struct msgb_chain *chain, struct msgb *msg, bool at_head)
+{
+	struct msgb_chain_blk *blk;
+	struct msgb_chain_seg *seg;
+
+	if (msgb_length(msg) == 0) {
+		msgb_free(msg);
+		return 0;
+	}
+
+	blk = blk_alloc(msg);
+	if (!blk)
+		return -ENOMEM;
+	seg = seg_alloc(chain, blk, msgb_data(msg), msgb_length(msg));
+	if (!seg) {
+		talloc_free(blk);
+		return -ENOMEM;
+	}
+
+	if (at_head)
+		llist_add(&seg->list, &chain->segs);
+	else
+		llist_add_tail(&seg->list, &chain->segs);
+	chain->num_segs++;
+	chain->len += seg->len;
+	return 0;
+}
+
+/*! Append the data of a msgb to the end of a msgb chain, without copying
+ * \param[in] chain msgb chain to append to
+ * \param[in] msg msgb whose data [data, tail) to append; ownership passes to the chain
+ * \returns 0 on success; negative on error (MESSAGE NOT FREED IN CASE OF ERROR) */
+int msgb_chain_append_msgb(struct msgb_chain *chain, struct msgb *msg)
+{
+	return add_msgb(chain, msg, false);
+}
+
+/*! Prepend the data of a msgb to the start of a msgb chain, without copying
+ * \param[in] chain msgb chain to prepend to
+ * \param[in] msg msgb whose data [data, tail) to prepend; ownership passes to the chain
+ * \returns 0 on success; negative on error (MESSAGE NOT FREED IN CASE OF ERROR) */
+int msgb_chain_prepend_msgb(struct msgb_chain *chain, struct msgb *msg)
+{
+	return add_msgb(chain, msg, true);
+}
+
+/*! Prepend room for a header to a msgb chain, like msgb_push()
+ * \param[in] chain msgb chain to prepend to
+ * \param[in] len number of octets to prepend
+ * \returns pointer to the \a len octets to be filled in by the caller; NULL on error
+ *
+ * If the first segment is the only user of its msgb and has enough headroom,
+ * the header is placed there.  Otherwise a new msgb with \ref
+ * MSGB_CHAIN_HEADROOM octets of headroom for further headers is prepended. */
+uint8_t *msgb_chain_push(struct msgb_chain *chain, unsigned int len)
+{
+	struct msgb_chain_seg *seg = llist_first_entry_or_null(&chain->segs, struct msgb_chain_seg, list);
+	struct msgb *msg;
+
+	if (seg && seg->blk->refcnt == 1 && seg->data - seg->blk->msg->head >= len) {
+		seg->data -= len;
+		seg->len += len;
+		chain->len += len;
+		return seg->data;
+	}
+
+	if (len == 0 || len > UINT16_MAX - MSGB_CHAIN_HEADROOM)
+		return NULL;
+	msg = msgb_alloc_headroom(MSGB_CHAIN_HEADROOM + len, MSGB_CHAIN_HEADROOM, "msgb_chain_push");
+	if (!msg)
+		return NULL;
+	msgb_put(msg, len);
+	if (msgb_chain_prepend_msgb(chain, msg) < 0) {
+		msgb_free(msg);
+		return NULL;
+	}
+	return msgb_data(msg);
+}
+
+/*! Remove octets from the start of a msgb chain, like msgb_pull()
+ * \param[in] chain msgb chain to remove from
+ * \param[in] len number of octets to remove
+ * \returns 0 on success; -EINVAL if the chain is shorter than \a len */
+int msgb_chain_pull(struct msgb_chain *chain, unsigned int len)
+{
+	struct msgb_chain_seg *seg, *seg2;
+
+	if (len > chain->len)
+		return -EINVAL;
+
+	llist_for_each_entry_safe(seg, seg2, &chain->segs, list) {
+		if (len == 0)
+			break;
+		if (seg->len <= len) {
+			len -= seg->len;
+			seg_del(chain, seg);
+		} else {
+			seg->data += len;
+			seg->len -= len;
+			chain->len -= len;
+			break;
+		}
+	}
+	return 0;
+}
+
+/*! Split off the first octets of a msgb chain into a new chain, without copying
+ * \param[in] chain msgb chain to split; keeps the octets after the first \a len
+ * \param[in] len number of octets to move to the new chain
+ * \param[in] name human-readable name of the new chain
+ * \returns new chain, allocated from the talloc context of \a chain; NULL on error
+ *
+ * A segment crossing the split point is shared by both chains. */
+struct msgb_chain *msgb_chain_split(struct msgb_chain *chain, unsigned int len, const char *name)
+{
+	struct msgb_chain *head;
+	struct msgb_chain_seg *seg, *seg2, *shared = NULL;
+	unsigned int whole = 0;
+
+	if (len > chain->len)
+		return NULL;
+
+	head = msgb_chain_alloc(talloc_parent(chain), name);
+	if (!head)
+		return NULL;
+
+	/* octets in segments which go to the new chain entirely */
+	llist_for_each_entry(seg, &chain->segs, list) {
+		if (whole + seg->len > len)
+			break;
+		whole += seg->len;
+	}
+
+	/* a segment crossing the split point; allocate before modifying anything */
+	if (whole < len) {
+		shared = seg_alloc(head, seg->blk, seg->data, len - whole);
+		if (!shared) {
+			msgb_chain_free(head);
+			return NULL;
+		}
+	}
+
+	llist_for_each_entry_safe(seg, seg2, &chain->segs, list) {
+		if (head->len == whole)
+			break;
+		llist_del(&seg->list);
+		chain->num_segs--;
+		chain->len -= seg->len;
+		talloc_steal(head, seg);
+		llist_add_tail(&seg->list, &head->segs);
+		head->num_segs++;
+		head->len += seg->len;
+	}
+
+	if (shared) {
+		seg = llist_first_entry(&chain->segs, struct msgb_chain_seg, list);
+		seg->data += shared->len;
+		seg->len -= shared->len;
+		chain->len -= shared->len;
+		llist_add_tail(&shared->list, &head->segs);
+		head->num_segs++;
+		head->len += shared->len;
+	}
+
+	return head;
+}
+
+/*! Fill an iovec array with the segments of a msgb chain
+ * \param[in] chain msgb chain to export
+ * \param[out] iov array to fill
+ * \param[in] iov_len number of entries in \a iov
+ * \returns number of entries used; -ENOSPC if \a iov has fewer entries than the chain has segments */
+int msgb_chain_to_iovec(const struct msgb_chain *chain, struct iovec *iov, unsigned int iov_len)
+{
+	const struct msgb_chain_seg *seg;
+	unsigned int i = 0;
+
+	if (chain->num_segs > iov_len)
+		return -ENOSPC;
+
+	llist_for_each_entry(seg, &chain->segs, list) {
+		iov[i].iov_base = seg->data;
+		iov[i].iov_len = seg->len;
+		i++;
+	}
+	return i;
+}
+
+/*! Copy the contents of a msgb chain into a single, new msgb
+ * \param[in] chain msgb chain to copy
+ * \param[in] ctx talloc context from which to allocate the msgb
+ * \param[in] headroom headroom to reserve in front of the data
+ * \param[in] name human-readable name of the msgb
+ * \returns newly allocated msgb; NULL on error */
+struct msgb *msgb_chain_linearize(const struct msgb_chain *chain, void *ctx, uint16_t headroom, const char *name)
+{
+	const struct msgb_chain_seg *seg;
+	struct msgb *msg;
+
+	if (chain->len > UINT16_MAX - headroom)
+		return NULL;
+	msg = msgb_alloc_c(ctx, headroom + chain->len, name);
+	if (!msg)
+		return NULL;
+	msgb_reserve(msg, headroom);
+
+	llist_for_each_entry(seg, &chain->segs, list)
+		memcpy(msgb_put(msg, seg->len), seg->data, seg->len);
+	return msg;
+}
+
+/*! @} */
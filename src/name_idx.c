@@ -0,0 +1,104 @@
+/*! \file name_idx.c
+ * Hash index of the names of counters and stat items. */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <osmocom/core/talloc.h>
+
+#include "name_idx_internal.h"
+
+/* Open addressing hash table of the positions of the names */
+struct osmo_name_idx {
+	/* number of slots - 1, the number of slots is a power of 2 */
+	uint32_t mask;
+	/* position of the name in the array + 1, 0 for an unused slot */
+	uint16_t slot[0];
+};
+
+static inline const char *desc_name(const void *descs, size_t stride, unsigned int i)
+{
+	return *(const char * const *)((const uint8_t *)descs + i * stride);
+}
+
+/*! FNV-1a hash of a NUL terminated string */
+uint32_t osmo_name_idx_hash(const char *str)
+{
+	uint32_t h = 2166136261u;
+
+	while (*str) {
+		h ^= (uint8_t)*str++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/*! Build the index of the names of an array of descriptions
+ *  \param[in] ctx talloc context to allocate from
+ *  \param[in] descs array of descriptions, each starting with the name as const char *
+ *  \param[in] stride size of an element of \a descs
+ *  \param[in] num number of elements of \a descs
+ *  \returns index, NULL on allocation failure or if \a num is too large */
+struct osmo_name_idx *osmo_name_idx_alloc(void *ctx, const void *descs, size_t stride, unsigned int num)
+{
+	struct osmo_name_idx *ni;
+	uint32_t size = 4;
+	unsigned int i;
+
+	if (num >= UINT16_MAX)
+		return NULL;
+	/* keep the table at most half full */
+	while (size < 2 * num)
+		size <<= 1;
+
+	ni = talloc_zero_size(ctx, sizeof(*ni) + size * sizeof(ni->slot[0]));
+	if (!ni)
+		return NULL;
+	talloc_set_name_const(ni, "osmo_name_idx");
+	ni->mask = size - 1;
+
+	for (i = 0; i < num; i++) {
+		uint32_t h = osmo_name_idx_hash(desc_name(descs, stride, i)) & ni->mask;
+
+		while (ni->slot[h])
+			h = (h + 1) & ni->mask;
+		ni->slot[h] = i + 1;
+	}
+	return ni;
+}
+
+/*! Find a name in the index
+ *  \param[in] ni index built by osmo_name_idx_alloc()
+ *  \param[in] descs the same array of descriptions as passed to osmo_name_idx_alloc()
+ *  \param[in] stride size of an element of \a descs
+ *  \param[in] name name to look up
+ *  \returns position of the first description with this \a name; -1 if none */
+int osmo_name_idx_find(const struct osmo_name_idx *ni, const void *descs, size_t stride, const char *name)
+{
+	uint32_t h = osmo_name_idx_hash(name) & ni->mask;
+
+	while (ni->slot[h]) {
+		unsigned int i = ni->slot[h] - 1;
+
+		if (!strcmp(desc_name(descs, stride, i), name))
+			return i;
+		h = (h + 1) & ni->mask;
+	}
+	return -1;
+}
@@ -0,0 +1,16 @@
+/*! \file name_idx_internal.h
+ * Internal hash index of the names of counters and stat items. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Index of the names in an array of counter or stat item descriptions.  The
+ * names are read as the first member of each array element, a const char *,
+ * so that the same code serves struct rate_ctr_desc and struct
+ * osmo_stat_item_desc. */
+struct osmo_name_idx;
+
+uint32_t osmo_name_idx_hash(const char *str);
+struct osmo_name_idx *osmo_name_idx_alloc(void *ctx, const void *descs, size_t stride, unsigned int num);
+int osmo_name_idx_find(const struct osmo_name_idx *ni, const void *descs, size_t stride, const char *name);
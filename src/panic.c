@@ -28,6 +28,7 @@
 #include <osmocom/core/backtrace.h>
 
 #include "../config.h"
+#include "logging_async_internal.h"
 
 
 static osmo_panic_handler_t osmo_panic_handler = (void*)0;
@@ -67,11 +68,17 @@ static void osmo_panic_default(const char *fmt, va_list args)
  *
  * The default function on most systems will generate a backtrace and
  * then abort() the process.
+ *
+ * Log messages queued by asynchronous logging are output before calling
+ * the panic handler.
  */
 void osmo_panic(const char *fmt, ...)
 {
 	va_list args;
 
+	/* don't lose the log messages leading up to the panic */
+	log_async_panic_flush();
+
 	va_start(args, fmt);
 
 	if (osmo_panic_handler)
@@ -53,21 +53,69 @@
  *
  * \file rate_ctr.c */
 
+#include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
 #include <osmocom/core/utils.h>
 #include <osmocom/core/linuxlist.h>
+#include <osmocom/core/hashtable.h>
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/timer.h>
 #include <osmocom/core/rate_ctr.h>
 #include <osmocom/core/logging.h>
 
+#include "group_class_internal.h"
+#include "name_idx_internal.h"
+#include "rate_ctr_internal.h"
+
 static LLIST_HEAD(rate_ctr_groups);
 
+/* groups with counters changed since they were last visited by rate_ctr_for_each_dirty_group() */
+static LLIST_HEAD(rate_ctr_groups_dirty);
+
+/* all counter groups with a description, hashed by group name and index */
+static DECLARE_HASHTABLE(rate_ctr_groups_by_name_idx, 12);
+
+/* groups by their group name prefix */
+static struct osmo_group_classes rate_ctr_classes = OSMO_GROUP_CLASSES_INIT(rate_ctr_classes);
+
+/* incremented whenever a group is removed from rate_ctr_groups */
+static unsigned int rate_ctr_groups_gen;
+
 static void *tall_rate_ctr_ctx;
 
+/*! Number of per-thread shards of a multi-thread safe counter group; threads
+ *  beyond this number share shards, which stays correct but may contend. */
+#define RATE_CTR_MT_SHARDS	16
+/*! Size of a cache line; each shard starts on its own cache line */
+#define RATE_CTR_MT_ALIGN	64
+
+/* Per-thread shards of a counter group allocated by rate_ctr_group_alloc_mt().
+ * Each thread adds to its own row using relaxed atomics; the rows are folded
+ * into rate_ctr.current by rate_ctr_group_sync(). */
+struct rate_ctr_mt {
+	/*! number of uint64_t per shard, multiple of a cache line */
+	unsigned int stride;
+	/*! RATE_CTR_MT_SHARDS * stride values, cache line aligned */
+	uint64_t *shard;
+};
+
+/*! Maximum number of groups allocated by rate_ctr_group_alloc_mt() at a time */
+#define RATE_CTR_MT_GROUPS	256
+
+/* Groups allocated by rate_ctr_group_alloc_mt(), for rate_ctr_add() to find the
+ * group of a counter.  Slots are only written by the main thread; freed slots
+ * are set to NULL and reused, rate_ctr_mt_groups_num is the highest used slot
+ * plus one. */
+static struct rate_ctr_group *rate_ctr_mt_groups[RATE_CTR_MT_GROUPS];
+static unsigned int rate_ctr_mt_groups_num;
+
+/* shard used by the current thread, plus one; 0 if not assigned yet */
+static __thread unsigned int rate_ctr_mt_shard;
+static unsigned int rate_ctr_mt_shard_next;
+
 
 static bool rate_ctrl_group_desc_validate(const struct rate_ctr_group_desc *desc)
 {
@@ -180,6 +228,24 @@ err_free:
 	return NULL;
 }
 
+/* remember that counters of the group changed, for rate_ctr_for_each_dirty_group() */
+static inline void rate_ctr_group_mark_dirty(struct rate_ctr_group *ctrg)
+{
+	if (llist_empty(&ctrg->dirty_list))
+		llist_add_tail(&ctrg->dirty_list, &rate_ctr_groups_dirty);
+}
+
+static inline uint32_t group_key(const char *name, unsigned int idx)
+{
+	return osmo_name_idx_hash(name) + idx * 0x9e3779b1u;
+}
+
+static void group_hash_add(struct rate_ctr_group *grp)
+{
+	if (grp->desc)
+		hash_add(rate_ctr_groups_by_name_idx, &grp->hnode, group_key(grp->desc->group_name_prefix, grp->idx));
+}
+
 /*! Find an unused index for this rate counter group.
  *  \param[in] name Name of the counter group
  *  \returns the largest used index number + 1, or 0 if none exist yet. */
@@ -242,12 +308,134 @@ struct rate_ctr_group *rate_ctr_group_alloc(void *ctx,
 
 	group->desc = desc;
 	group->idx = idx;
+	/* without the index, rate_ctr_get_by_name() searches linearly */
+	group->name_idx = osmo_name_idx_alloc(group, desc->ctr_desc, sizeof(desc->ctr_desc[0]), desc->num_ctr);
 
 	llist_add(&group->list, &rate_ctr_groups);
+	INIT_LLIST_HEAD(&group->dirty_list);
+	group_hash_add(group);
+	INIT_LLIST_HEAD(&group->class_list);
+	if (osmo_group_class_add(&rate_ctr_classes, tall_rate_ctr_ctx, desc->group_name_prefix,
+				 &group->class_list) < 0) {
+		rate_ctr_group_free(group);
+		return NULL;
+	}
 
 	return group;
 }
 
+static int mt_group_add(struct rate_ctr_group *grp)
+{
+	unsigned int i;
+
+	for (i = 0; i < RATE_CTR_MT_GROUPS; i++) {
+		if (rate_ctr_mt_groups[i])
+			continue;
+		__atomic_store_n(&rate_ctr_mt_groups[i], grp, __ATOMIC_RELEASE);
+		if (i >= rate_ctr_mt_groups_num)
+			__atomic_store_n(&rate_ctr_mt_groups_num, i + 1, __ATOMIC_RELEASE);
+		return 0;
+	}
+	return -ENOSPC;
+}
+
+static void mt_group_del(struct rate_ctr_group *grp)
+{
+	unsigned int i;
+
+	for (i = 0; i < rate_ctr_mt_groups_num; i++) {
+		if (rate_ctr_mt_groups[i] == grp) {
+			__atomic_store_n(&rate_ctr_mt_groups[i], NULL, __ATOMIC_RELEASE);
+			return;
+		}
+	}
+}
+
+/* Return the multi-thread group containing ctr, NULL if it is not part of one */
+static struct rate_ctr_group *mt_group_find(const struct rate_ctr *ctr)
+{
+	unsigned int i, num = __atomic_load_n(&rate_ctr_mt_groups_num, __ATOMIC_ACQUIRE);
+
+	for (i = 0; i < num; i++) {
+		struct rate_ctr_group *grp = __atomic_load_n(&rate_ctr_mt_groups[i], __ATOMIC_ACQUIRE);
+
+		if (grp && ctr >= grp->ctr && ctr < grp->ctr + grp->desc->num_ctr)
+			return grp;
+	}
+	return NULL;
+}
+
+/*! Allocate a new group of counters which may be incremented from any thread
+ *  \param[in] ctx parent talloc context
+ *  \param[in] desc Rate counter group description
+ *  \param[in] idx Index of new counter group
+ *  \returns newly allocated counter group; NULL on error
+ *
+ *  Counters of such a group are incremented with rate_ctr_add2() or
+ *  rate_ctr_inc2(), which add to a per-thread shard without any locking.
+ *  rate_ctr_add() and rate_ctr_inc() work as well, but first need to look up
+ *  the group of the counter among all such groups.
+ *  The shards are folded into rate_ctr.current once per second, and each time
+ *  the counters are read via rate_ctr_for_each_counter(), the VTY or CTRL.
+ *  Code reading rate_ctr.current directly should call rate_ctr_group_sync()
+ *  first.  All other functions, including rate_ctr_group_free(), must only be
+ *  called from the thread running the osmo_select_main() loop. */
+struct rate_ctr_group *rate_ctr_group_alloc_mt(void *ctx,
+					       const struct rate_ctr_group_desc *desc,
+					       unsigned int idx)
+{
+	struct rate_ctr_group *group = rate_ctr_group_alloc(ctx, desc, idx);
+	struct rate_ctr_mt *mt;
+	unsigned int per_line = RATE_CTR_MT_ALIGN / sizeof(uint64_t);
+	uint8_t *buf;
+
+	if (!group)
+		return NULL;
+
+	mt = talloc_zero(group, struct rate_ctr_mt);
+	if (!mt)
+		goto err_free;
+	mt->stride = (desc->num_ctr + per_line - 1) / per_line * per_line;
+	buf = talloc_zero_size(mt, RATE_CTR_MT_SHARDS * mt->stride * sizeof(uint64_t) + RATE_CTR_MT_ALIGN);
+	if (!buf)
+		goto err_free;
+	mt->shard = (uint64_t *)(((uintptr_t)buf + RATE_CTR_MT_ALIGN - 1) & ~(uintptr_t)(RATE_CTR_MT_ALIGN - 1));
+	group->mt = mt;
+
+	if (mt_group_add(group) < 0) {
+		LOGP(DLGLOBAL, LOGL_ERROR, "counter group '%s': too many multi-thread counter groups\n",
+		     desc->group_name_prefix);
+		goto err_free;
+	}
+	return group;
+
+err_free:
+	rate_ctr_group_free(group);
+	return NULL;
+}
+
+/*! Fold the per-thread shards of a counter group into rate_ctr.current
+ *  \param[in] ctrg counter group; a no-op unless allocated by rate_ctr_group_alloc_mt() */
+void rate_ctr_group_sync(struct rate_ctr_group *ctrg)
+{
+	struct rate_ctr_mt *mt = ctrg->mt;
+	unsigned int s, i;
+
+	if (!mt)
+		return;
+
+	for (s = 0; s < RATE_CTR_MT_SHARDS; s++) {
+		uint64_t *shard = &mt->shard[s * mt->stride];
+
+		for (i = 0; i < ctrg->desc->num_ctr; i++) {
+			/* don't dirty the cache line of idle shards */
+			if (!__atomic_load_n(&shard[i], __ATOMIC_RELAXED))
+				continue;
+			ctrg->ctr[i].current += __atomic_exchange_n(&shard[i], 0, __ATOMIC_RELAXED);
+		}
+	}
+}
+
 /*! Free the memory for the specified group of counters */
 void rate_ctr_group_free(struct rate_ctr_group *grp)
 {
@@ -256,9 +444,30 @@ void rate_ctr_group_free(struct rate_ctr_group *grp)
 
 	if (!llist_empty(&grp->list))
 		llist_del(&grp->list);
+	hash_del(&grp->hnode);
+	llist_del(&grp->dirty_list);
+	osmo_group_class_del(&rate_ctr_classes, grp->desc->group_name_prefix, &grp->class_list);
+	if (grp->mt)
+		mt_group_del(grp);
+	rate_ctr_groups_gen++;
 	talloc_free(grp);
 }
 
+/*! Return the classes of all counter groups, to walk them across several main
+ *  loop iterations.  A position in their lists is only valid as long as
+ *  rate_ctr_group_list_gen() returns the same value. */
+struct osmo_group_classes *rate_ctr_group_classes(void)
+{
+	return &rate_ctr_classes;
+}
+
+/*! Return a number that changes whenever a group is removed from the lists
+ *  of rate_ctr_group_classes(). */
+unsigned int rate_ctr_group_list_gen(void)
+{
+	return rate_ctr_groups_gen;
+}
+
 /*! Get rate counter from group, identified by index idx
  *  \param[in] grp Rate counter group
  *  \param[in] idx Index of the counter to retrieve
@@ -269,6 +478,16 @@ struct rate_ctr *rate_ctr_group_get_ctr(struct rate_ctr_group *grp, unsigned int
 	return &grp->ctr[idx];
 }
 
+/*! Change the index of a group of counters
+ *  \param[in] grp Rate counter group
+ *  \param[in] idx New index of the group */
+void rate_ctr_group_upd_idx(struct rate_ctr_group *grp, unsigned int idx)
+{
+	hash_del(&grp->hnode);
+	grp->idx = idx;
+	group_hash_add(grp);
+}
+
 /*! Set a name for the group of counters be used instead of index value
   at report time.
  *  \param[in] grp Rate counter group
@@ -282,9 +501,36 @@ void rate_ctr_group_set_name(struct rate_ctr_group *grp, const char *name)
 /*! Add a number to the counter */
 void rate_ctr_add(struct rate_ctr *ctr, int inc)
 {
+	struct rate_ctr_group *grp;
+
+	/* counters of multi-thread groups must not be modified directly */
+	if (OSMO_UNLIKELY(__atomic_load_n(&rate_ctr_mt_groups_num, __ATOMIC_RELAXED))
+	    && (grp = mt_group_find(ctr))) {
+		_rate_ctr_add2_mt(grp, ctr - grp->ctr, inc);
+		return;
+	}
 	ctr->current += inc;
 }
 
+/*! Add a number to a counter of a group allocated by rate_ctr_group_alloc_mt().
+ *  Internal, use rate_ctr_add2() instead. */
+void _rate_ctr_add2_mt(struct rate_ctr_group *ctrg, unsigned int idx, int inc)
+{
+	struct rate_ctr_mt *mt = ctrg->mt;
+
+	if (OSMO_UNLIKELY(!rate_ctr_mt_shard))
+		rate_ctr_mt_shard = __atomic_fetch_add(&rate_ctr_mt_shard_next, 1, __ATOMIC_RELAXED)
+				    % RATE_CTR_MT_SHARDS + 1;
+	__atomic_fetch_add(&mt->shard[(rate_ctr_mt_shard - 1) * mt->stride + idx], inc, __ATOMIC_RELAXED);
+}
+
+/*! Queue a group on the list of changed groups, not thread safe.
+ *  Internal, called by rate_ctr_add2(). */
+void _rate_ctr_group_mark_dirty(struct rate_ctr_group *ctrg)
+{
+	rate_ctr_group_mark_dirty(ctrg);
+}
+
 /*! Return the counter difference since the last call to this function */
 int64_t rate_ctr_difference(struct rate_ctr *ctr)
 {
@@ -318,10 +564,15 @@ static void rate_ctr_group_intv(struct rate_ctr_group *grp)
 {
 	unsigned int i;
 
+	rate_ctr_group_sync(grp);
+
 	for (i = 0; i < grp->desc->num_ctr; i++) {
 		struct rate_ctr *ctr = &grp->ctr[i];
 
 		interval_expired(ctr, RATE_CTR_INTV_SEC);
+		/* catch changes by rate_ctr_add() and from other threads */
+		if (ctr->intv[RATE_CTR_INTV_SEC].rate)
+			rate_ctr_group_mark_dirty(grp);
 		if ((timer_ticks % 60) == 0)
 			interval_expired(ctr, RATE_CTR_INTV_MIN);
 		if ((timer_ticks % (60*60)) == 0)
@@ -369,14 +620,9 @@ struct rate_ctr_group *rate_ctr_get_group_by_name_idx(const char *name, const un
 {
 	struct rate_ctr_group *ctrg;
 
-	llist_for_each_entry(ctrg, &rate_ctr_groups, list) {
-		if (!ctrg->desc)
-			continue;
-
-		if (!strcmp(ctrg->desc->group_name_prefix, name) &&
-				ctrg->idx == idx) {
+	hash_for_each_possible(rate_ctr_groups_by_name_idx, ctrg, hnode, group_key(name, idx)) {
+		if (ctrg->idx == idx && !strcmp(ctrg->desc->group_name_prefix, name))
 			return ctrg;
-		}
 	}
 	return NULL;
 }
@@ -394,6 +640,11 @@ const struct rate_ctr *rate_ctr_get_by_name(const struct rate_ctr_group *ctrg, c
 	if (!ctrg->desc)
 		return NULL;
 
+	if (ctrg->name_idx) {
+		i = osmo_name_idx_find(ctrg->name_idx, ctrg->desc->ctr_desc, sizeof(ctrg->desc->ctr_desc[0]), name);
+		return i < 0 ? NULL : &ctrg->ctr[i];
+	}
+
 	for (i = 0; i < ctrg->desc->num_ctr; i++) {
 		ctr_desc = &ctrg->desc->ctr_desc[i];
 
@@ -416,6 +667,8 @@ int rate_ctr_for_each_counter(struct rate_ctr_group *ctrg,
 	int rc = 0;
 	int i;
 
+	rate_ctr_group_sync(ctrg);
+
 	for (i = 0; i < ctrg->desc->num_ctr; i++) {
 		struct rate_ctr *ctr = &ctrg->ctr[i];
 		rc = handle_counter(ctrg,
@@ -446,6 +699,30 @@ int rate_ctr_for_each_group(rate_ctr_group_handler_t handle_group, void *data)
 	return rc;
 }
 
+/*! Iterate over the counter groups changed since the last iteration
+ *  \param[in] handle_group function pointer of callback function
+ *  \param[in] data Data to hand transparently to handle_group()
+ *  \returns 0 on success; negative otherwise
+ *
+ *  Changes are tracked per group: by rate_ctr_add2() immediately, and by the
+ *  one second timer for all other ways of changing a counter.  So a group may
+ *  show up here only up to a second after a change. */
+int rate_ctr_for_each_dirty_group(rate_ctr_group_handler_t handle_group, void *data)
+{
+	struct rate_ctr_group *ctrg;
+	int rc = 0;
+
+	while (!llist_empty(&rate_ctr_groups_dirty)) {
+		ctrg = llist_first_entry(&rate_ctr_groups_dirty, struct rate_ctr_group, dirty_list);
+		llist_del_init(&ctrg->dirty_list);
+		rc = handle_group(ctrg, data);
+		if (rc < 0)
+			return rc;
+	}
+
+	return rc;
+}
+
 /*! Reset a rate counter back to zero
  *  \param[in] ctr counter to reset
  */
@@ -461,6 +738,9 @@ void rate_ctr_group_reset(struct rate_ctr_group *ctrg)
 {
 	int i;
 
+	/* drop increments pending in the shards */
+	rate_ctr_group_sync(ctrg);
+
 	for (i = 0; i < ctrg->desc->num_ctr; i++) {
 		struct rate_ctr *ctr = &ctrg->ctr[i];
                 rate_ctr_reset(ctr);
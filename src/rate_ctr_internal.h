@@ -0,0 +1,18 @@
+/*! \file rate_ctr_internal.h
+ * internal definitions for the rate_ctr API */
+#pragma once
+
+#include <osmocom/core/linuxlist.h>
+#include <osmocom/core/rate_ctr.h>
+
+struct osmo_group_classes;
+
+/*! \addtogroup rate_ctr
+ *  @{
+ */
+
+int rate_ctr_for_each_dirty_group(rate_ctr_group_handler_t handle_group, void *data);
+struct osmo_group_classes *rate_ctr_group_classes(void);
+unsigned int rate_ctr_group_list_gen(void);
+
+/*! @} */
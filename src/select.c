@@ -64,13 +64,163 @@ struct poll_state {
 	unsigned int num_registered;
 };
 static __thread struct poll_state g_poll;
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+
+/* osmo_fd.when_kernel flag: fd is part of the epoll set */
+#define WHEN_K_EPOLL	0x10000
+/* osmo_fd.when_kernel flag: fd refused by epoll (e.g. regular file), always ready like with poll() */
+#define WHEN_K_NOPOLL	0x20000
+
+struct epoll_state {
+	/* epoll instance; -1 if the epoll back-end is not in use */
+	int epfd;
+	/* array of epoll_event, filled by epoll_wait() and then dispatched */
+	struct epoll_event *events;
+	/* number of entries in events allocated */
+	unsigned int events_size;
+	/* number of entries in events currently being dispatched */
+	unsigned int n_events;
+	/* osmo_fd whose call-back is currently executed, NULL once it got unregistered */
+	struct osmo_fd *cur;
+	/* number of registered osmo_fd that cannot be handled by epoll */
+	unsigned int num_nopoll;
+};
+static __thread struct epoll_state g_epoll = { .epfd = -1 };
+#endif /* HAVE_SYS_EPOLL_H */
 #endif /* FORCE_IO_SELECT */
 
+/* osmo_fd registered on this thread, indexed by their fd number */
+static __thread struct osmo_fd **fd_table;
+/* number of entries in fd_table allocated */
+static __thread unsigned int fd_table_size;
+
 /*! See osmo_select_shutdown_request() */
 static int _osmo_select_shutdown_requested = 0;
 /*! See osmo_select_shutdown_request() */
 static bool _osmo_select_shutdown_done = false;
 
+static inline struct osmo_fd *fd_table_lookup(int fd)
+{
+	if (fd < 0 || fd >= fd_table_size)
+		return NULL;
+	return fd_table[fd];
+}
+
+static int fd_table_add(struct osmo_fd *ofd)
+{
+	if (ofd->fd >= fd_table_size) {
+		struct osmo_fd **t;
+		unsigned int new_size = fd_table_size ? fd_table_size : 1024;
+		while (new_size <= ofd->fd)
+			new_size *= 2;
+		t = talloc_realloc(OTC_GLOBAL, fd_table, struct osmo_fd *, new_size);
+		if (!t)
+			return -ENOMEM;
+		memset(t + fd_table_size, 0, (new_size - fd_table_size) * sizeof(*t));
+		fd_table = t;
+		fd_table_size = new_size;
+	}
+	fd_table[ofd->fd] = ofd;
+	return 0;
+}
+
+static void fd_table_del(struct osmo_fd *ofd)
+{
+	unsigned int i;
+
+	if (fd_table_lookup(ofd->fd) == ofd) {
+		fd_table[ofd->fd] = NULL;
+		return;
+	}
+	/* ofd->fd was modified by the user since registration, look for it the slow way */
+	for (i = 0; i < fd_table_size; i++) {
+		if (fd_table[i] == ofd) {
+			fd_table[i] = NULL;
+			return;
+		}
+	}
+}
+
+#if !defined(FORCE_IO_SELECT) && defined(HAVE_SYS_EPOLL_H)
+/* use the same mapping as the Linux kernel does in fs/select.c; EPOLLERR/EPOLLHUP are always reported */
+static uint32_t when_to_epoll(unsigned int when)
+{
+	uint32_t events = 0;
+
+	if (when & OSMO_FD_READ)
+		events |= EPOLLIN;
+	if (when & OSMO_FD_WRITE)
+		events |= EPOLLOUT;
+	if (when & OSMO_FD_EXCEPT)
+		events |= EPOLLPRI;
+
+	return events;
+}
+
+/* bring the kernel's interest set in line with ofd->when, only issuing a syscall on actual changes */
+static int epoll_sync(struct osmo_fd *ofd)
+{
+	unsigned int when = ofd->when & (OSMO_FD_READ | OSMO_FD_WRITE | OSMO_FD_EXCEPT);
+	struct epoll_event ev = {
+		.events = when_to_epoll(when),
+		.data.ptr = ofd,
+	};
+	int op;
+
+	if (ofd->when_kernel & WHEN_K_NOPOLL)
+		return 0;
+	if ((ofd->when_kernel & OSMO_FD_MASK) == when && (!when || (ofd->when_kernel & WHEN_K_EPOLL)))
+		return 0;
+
+	/* osmo_fd without any 'when' flags are removed from the epoll set, as otherwise the kernel would keep
+	 * reporting EPOLLHUP/EPOLLERR for them, which the caller did not ask for */
+	if (!when)
+		op = EPOLL_CTL_DEL;
+	else if (ofd->when_kernel & WHEN_K_EPOLL)
+		op = EPOLL_CTL_MOD;
+	else
+		op = EPOLL_CTL_ADD;
+
+	if (epoll_ctl(g_epoll.epfd, op, ofd->fd, &ev) < 0) {
+		if (op == EPOLL_CTL_ADD && errno == EPERM) {
+			/* regular files and the like: poll() reports them as always ready, and so do we */
+			ofd->when_kernel = WHEN_K_NOPOLL;
+			g_epoll.num_nopoll++;
+			return 0;
+		}
+		return -errno;
+	}
+
+	ofd->when_kernel = when;
+	if (op != EPOLL_CTL_DEL)
+		ofd->when_kernel |= WHEN_K_EPOLL;
+	return 0;
+}
+
+/* remove ofd from the epoll set and from any events pending dispatch */
+static void epoll_remove(struct osmo_fd *ofd)
+{
+	unsigned int i;
+
+	if (ofd->when_kernel & WHEN_K_EPOLL) {
+		/* may fail with EBADF if the user already closed the fd, which removed it from the set */
+		epoll_ctl(g_epoll.epfd, EPOLL_CTL_DEL, ofd->fd, NULL);
+	} else if (ofd->when_kernel & WHEN_K_NOPOLL) {
+		g_epoll.num_nopoll--;
+	}
+	ofd->when_kernel = 0;
+
+	for (i = 0; i < g_epoll.n_events; i++) {
+		if (g_epoll.events[i].data.ptr == ofd)
+			g_epoll.events[i].data.ptr = NULL;
+	}
+	if (g_epoll.cur == ofd)
+		g_epoll.cur = NULL;
+}
+#endif
+
 /*! Set up an osmo-fd. Will not register it.
  *  \param[inout] ofd Osmo FD to be set-up
  *  \param[in] fd OS-level file descriptor number
@@ -97,6 +247,10 @@ void osmo_fd_update_when(struct osmo_fd *ofd, unsigned int when_mask, unsigned i
 {
 	ofd->when &= when_mask;
 	ofd->when |= when;
+#if !defined(FORCE_IO_SELECT) && defined(HAVE_SYS_EPOLL_H)
+	if (g_epoll.epfd >= 0 && fd_table_lookup(ofd->fd) == ofd)
+		epoll_sync(ofd);
+#endif
 }
 
 /*! Check if a file descriptor is already registered
@@ -106,6 +260,10 @@ void osmo_fd_update_when(struct osmo_fd *ofd, unsigned int when_mask, unsigned i
 bool osmo_fd_is_registered(struct osmo_fd *fd)
 {
 	struct osmo_fd *entry;
+
+	if (fd_table_lookup(fd->fd) == fd)
+		return true;
+
 	llist_for_each_entry(entry, &osmo_fds, list) {
 		if (entry == fd) {
 			return true;
@@ -121,7 +279,7 @@ bool osmo_fd_is_registered(struct osmo_fd *fd)
  */
 int osmo_fd_register(struct osmo_fd *fd)
 {
-	int flags;
+	int flags, rc;
 
 	/* make FD nonblocking */
 	flags = fcntl(fd->fd, F_GETFL);
@@ -162,6 +320,34 @@ int osmo_fd_register(struct osmo_fd *fd)
 		g_poll.poll = p;
 		g_poll.poll_size = new_size;
 	}
+#endif /* FORCE_IO_SELECT */
+
+	rc = fd_table_add(fd);
+	if (rc < 0)
+		return rc;
+
+#if !defined(FORCE_IO_SELECT) && defined(HAVE_SYS_EPOLL_H)
+	fd->when_kernel = 0;
+	if (g_epoll.epfd >= 0) {
+		if (g_epoll.events_size < g_poll.poll_size) {
+			struct epoll_event *e;
+			e = talloc_realloc(OTC_GLOBAL, g_epoll.events, struct epoll_event, g_poll.poll_size);
+			if (!e) {
+				fd_table_del(fd);
+				return -ENOMEM;
+			}
+			g_epoll.events = e;
+			g_epoll.events_size = g_poll.poll_size;
+		}
+		rc = epoll_sync(fd);
+		if (rc < 0) {
+			fd_table_del(fd);
+			return rc;
+		}
+	}
+#endif
+
+#ifndef FORCE_IO_SELECT
 	g_poll.num_registered++;
 #endif /* FORCE_IO_SELECT */
 
@@ -180,8 +366,13 @@ void osmo_fd_unregister(struct osmo_fd *fd)
 	 * osmo_fd_is_registered() */
 	unregistered_count++;
 	llist_del(&fd->list);
+	fd_table_del(fd);
 #ifndef FORCE_IO_SELECT
 	g_poll.num_registered--;
+#ifdef HAVE_SYS_EPOLL_H
+	if (g_epoll.epfd >= 0)
+		epoll_remove(fd);
+#endif
 #endif /* FORCE_IO_SELECT */
 
 	/* If existent, free any statistical data */
@@ -368,12 +559,127 @@ static int poll_disp_fds(unsigned int n_fd)
 	return work;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/* dispatch the first n_ev entries of g_epoll.events */
+static int epoll_disp_fds(unsigned int n_ev)
+{
+	struct osmo_fd *ufd;
+	unsigned int i;
+	int work = 0;
+	int shutdown_pending_writes = 0;
+
+	g_epoll.n_events = n_ev;
+
+	for (i = 0; i < n_ev; i++) {
+		struct epoll_event *ev = &g_epoll.events[i];
+		int flags = 0;
+
+		ufd = ev->data.ptr;
+		if (!ufd) {
+			/* osmo_fd was unregistered by a previous call-back */
+			continue;
+		}
+		/* use the same mapping as the Linux kernel does in fs/select.c */
+		if (ev->events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+			flags |= OSMO_FD_READ;
+		if (ev->events & (EPOLLOUT | EPOLLERR))
+			flags |= OSMO_FD_WRITE;
+		if (ev->events & EPOLLPRI)
+			flags |= OSMO_FD_EXCEPT;
+
+		/* make sure we never report more than the user requested */
+		flags &= ufd->when;
+
+		if (_osmo_select_shutdown_requested > 0) {
+			if (ufd->when & OSMO_FD_WRITE)
+				shutdown_pending_writes++;
+		}
+
+		if (flags) {
+			work = 1;
+			/* see poll_disp_fds() */
+			log_reset_context();
+			g_epoll.cur = ufd;
+			ufd->cb(ufd, flags);
+			/* catch up with call-backs modifying ufd->when directly rather than via
+			 * osmo_fd_update_when(); this is the most common place for that to happen */
+			if (g_epoll.cur)
+				epoll_sync(ufd);
+			g_epoll.cur = NULL;
+		}
+	}
+
+	g_epoll.n_events = 0;
+
+	if (_osmo_select_shutdown_requested > 0 && !shutdown_pending_writes)
+		_osmo_select_shutdown_done = true;
+
+	return work;
+}
+
+/* append a pseudo-event for each osmo_fd that epoll refused, they are always ready like with poll() */
+static unsigned int epoll_add_nopoll_events(unsigned int n_ev)
+{
+	struct osmo_fd *ufd;
+
+	llist_for_each_entry(ufd, &osmo_fds, list) {
+		if (!(ufd->when_kernel & WHEN_K_NOPOLL) || !ufd->when)
+			continue;
+		g_epoll.events[n_ev++] = (struct epoll_event){
+			.events = EPOLLIN | EPOLLOUT,
+			.data.ptr = ufd,
+		};
+	}
+	return n_ev;
+}
+
+static int _osmo_select_main_epoll(int polling)
+{
+	int rc;
+	int timeout = 0;
+	unsigned int max_ev = g_epoll.events_size - g_epoll.num_nopoll;
+
+	if (!polling) {
+		osmo_timers_prepare();
+		timeout = osmo_timers_nearest_ms();
+
+		if (_osmo_select_shutdown_requested && timeout == -1)
+			timeout = 0;
+		/* osmo_fd refused by epoll are always ready, don't sleep */
+		if (g_epoll.num_nopoll)
+			timeout = 0;
+	}
+
+	/* epoll_wait() refuses a maxevents of zero, but still has to sleep until the next timer */
+	rc = epoll_wait(g_epoll.epfd, g_epoll.events, OSMO_MAX(max_ev, 1), timeout);
+	if (rc < 0)
+		return 0;
+
+	if (g_epoll.num_nopoll)
+		rc = epoll_add_nopoll_events(rc);
+
+	/* fire timers */
+	if (!_osmo_select_shutdown_requested)
+		osmo_timers_update();
+
+	OSMO_ASSERT(osmo_ctx->select);
+
+	/* call registered callback functions */
+	return epoll_disp_fds(rc);
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
 static int _osmo_select_main(int polling)
 {
 	unsigned int n_poll;
 	int rc;
 	int timeout = 0;
 
+#ifdef HAVE_SYS_EPOLL_H
+	if (g_epoll.epfd >= 0)
+		return _osmo_select_main_epoll(polling);
+#endif
+
 	/* prepare read and write fdsets */
 	n_poll = poll_fill_fds();
 
@@ -464,7 +770,10 @@ int osmo_select_main_ctx(int polling)
  *  \returns \ref osmo_fd for \ref fd; NULL in case it doesn't exist */
 struct osmo_fd *osmo_fd_get_by_fd(int fd)
 {
-	struct osmo_fd *ofd;
+	struct osmo_fd *ofd = fd_table_lookup(fd);
+
+	if (ofd && ofd->fd == fd)
+		return ofd;
 
 	llist_for_each_entry(ofd, &osmo_fds, list) {
 		if (ofd->fd == fd)
@@ -479,6 +788,82 @@ void osmo_select_init(void)
 	INIT_LLIST_HEAD(&osmo_fds);
 }
 
+/*! select the I/O multiplexing back-end used by osmo_select_main() on the current thread
+ *  \param[in] backend back-end to switch to
+ *  \returns 0 on success; negative in case of error
+ *
+ *  Can be called at any time outside of an osmo_fd call-back, all osmo_fd
+ *  already registered are transferred to the new back-end.  With the epoll
+ *  back-end, the kernel is only informed about changes of osmo_fd.when
+ *  which are made through osmo_fd_update_when() (or the
+ *  osmo_fd_{read,write}_{enable,disable}() helpers) or from within the
+ *  call-back of that very osmo_fd.  Code modifying osmo_fd.when directly
+ *  in other places must stay with the default poll back-end. */
+int osmo_select_backend_set(enum osmo_select_backend backend)
+{
+#if !defined(FORCE_IO_SELECT) && defined(HAVE_SYS_EPOLL_H)
+	struct osmo_fd *ufd;
+	int rc;
+
+	if (g_epoll.n_events)
+		return -EBUSY;
+
+	switch (backend) {
+	case OSMO_SELECT_BACKEND_POLL:
+		if (g_epoll.epfd < 0)
+			return 0;
+		close(g_epoll.epfd);
+		g_epoll.epfd = -1;
+		g_epoll.num_nopoll = 0;
+		TALLOC_FREE(g_epoll.events);
+		g_epoll.events_size = 0;
+		llist_for_each_entry(ufd, &osmo_fds, list)
+			ufd->when_kernel = 0;
+		return 0;
+	case OSMO_SELECT_BACKEND_EPOLL:
+		if (g_epoll.epfd >= 0)
+			return 0;
+		g_epoll.events_size = OSMO_MAX(g_poll.poll_size, 1024);
+		g_epoll.events = talloc_zero_array(OTC_GLOBAL, struct epoll_event, g_epoll.events_size);
+		if (!g_epoll.events)
+			return -ENOMEM;
+		g_epoll.epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (g_epoll.epfd < 0) {
+			rc = -errno;
+			TALLOC_FREE(g_epoll.events);
+			g_epoll.events_size = 0;
+			return rc;
+		}
+		llist_for_each_entry(ufd, &osmo_fds, list) {
+			ufd->when_kernel = 0;
+			rc = epoll_sync(ufd);
+			if (rc < 0) {
+				osmo_select_backend_set(OSMO_SELECT_BACKEND_POLL);
+				return rc;
+			}
+		}
+		return 0;
+	default:
+		return -EINVAL;
+	}
+#else
+	if (backend == OSMO_SELECT_BACKEND_POLL)
+		return 0;
+	return -ENOTSUP;
+#endif
+}
+
+/*! get the I/O multiplexing back-end used by osmo_select_main() on the current thread
+ *  \returns currently active back-end */
+enum osmo_select_backend osmo_select_backend_get(void)
+{
+#if !defined(FORCE_IO_SELECT) && defined(HAVE_SYS_EPOLL_H)
+	if (g_epoll.epfd >= 0)
+		return OSMO_SELECT_BACKEND_EPOLL;
+#endif
+	return OSMO_SELECT_BACKEND_POLL;
+}
+
 /* ensure main thread always has pre-initialized osmo_fds */
 static __attribute__((constructor)) void on_dso_load_select(void)
 {
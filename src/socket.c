@@ -28,6 +28,7 @@
 #ifdef HAVE_SYS_SOCKET_H
 
 #include <osmocom/core/logging.h>
+#include <osmocom/core/msgb_chain.h>
 #include <osmocom/core/select.h>
 #include <osmocom/core/socket.h>
 #include <osmocom/core/sockaddr_str.h>
@@ -37,6 +38,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <net/if.h>
 
@@ -1980,6 +1982,69 @@ int osmo_sock_set_priority(int fd, int prio)
 	return setsockopt(fd, SOL_SOCKET, SO_PRIORITY, &prio, sizeof(prio));
 }
 
+/*! Send an array of buffers on a socket with a single sendmsg() call.
+ *  \param[in] fd socket file descriptor
+ *  \param[in] iov buffers to send, in order
+ *  \param[in] iovcnt number of entries in \a iov
+ *  \param[in] dst destination address for unconnected sockets; NULL for connected sockets.
+ *		    AF_INET, AF_INET6, or AF_UNIX with a path name (not an abstract one).
+ *  \param[in] flags flags passed on to sendmsg(), e.g. MSG_DONTWAIT
+ *  \returns number of octets sent; negative errno on error */
+int osmo_sock_sendiov(int fd, const struct iovec *iov, unsigned int iovcnt,
+		      const struct osmo_sockaddr *dst, int flags)
+{
+	const struct sockaddr_un *sun;
+	struct msghdr mh = {
+		.msg_name = dst ? (void *)&dst->u.sa : NULL,
+		.msg_iov = (struct iovec *)iov,
+		.msg_iovlen = iovcnt,
+	};
+	int rc;
+
+	if (dst) {
+		switch (dst->u.sa.sa_family) {
+		case AF_INET:
+			mh.msg_namelen = sizeof(struct sockaddr_in);
+			break;
+		case AF_INET6:
+			mh.msg_namelen = sizeof(struct sockaddr_in6);
+			break;
+		case AF_UNIX:
+			sun = (const struct sockaddr_un *)&dst->u.sas;
+			mh.msg_namelen = offsetof(struct sockaddr_un, sun_path)
+					 + strnlen(sun->sun_path, sizeof(sun->sun_path));
+			break;
+		default:
+			return -EAFNOSUPPORT;
+		}
+	}
+
+	rc = sendmsg(fd, &mh, flags);
+	if (rc < 0)
+		return -errno;
+	return rc;
+}
+
+/*! Send a \ref msgb_chain on a socket with a single sendmsg() call, without copying its payload.
+ *  \param[in] fd socket file descriptor
+ *  \param[in] chain msgb chain to send; not freed by this function
+ *  \param[in] dst destination address for unconnected sockets; NULL for connected sockets
+ *  \param[in] flags flags passed on to sendmsg(), e.g. MSG_DONTWAIT
+ *  \returns number of octets sent; negative errno on error
+ *
+ * On stream sockets, fewer octets than msgb_chain_length() may be sent;
+ * msgb_chain_pull() the sent octets and send the remainder later. */
+int osmo_sock_send_chain(int fd, const struct msgb_chain *chain, const struct osmo_sockaddr *dst, int flags)
+{
+	struct iovec iov[OSMO_SOCK_CHAIN_MAX_SEGS];
+	int iovcnt;
+
+	iovcnt = msgb_chain_to_iovec(chain, iov, ARRAY_SIZE(iov));
+	if (iovcnt < 0)
+		return iovcnt;
+	return osmo_sock_sendiov(fd, iov, iovcnt, dst, flags);
+}
+
 #endif /* HAVE_SYS_SOCKET_H */
 
 /*! @} */
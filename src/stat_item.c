@@ -151,24 +151,72 @@
  *
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
 #include <osmocom/core/utils.h>
 #include <osmocom/core/linuxlist.h>
+#include <osmocom/core/hashtable.h>
 #include <osmocom/core/logging.h>
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/timer.h>
 #include <osmocom/core/stat_item.h>
 
 #include <stat_item_internal.h>
+#include "group_class_internal.h"
+#include "name_idx_internal.h"
 
 /*! global list of stat_item groups */
 static LLIST_HEAD(osmo_stat_item_groups);
+/*! stat_item groups hashed by group name and index */
+static DECLARE_HASHTABLE(osmo_stat_item_groups_by_name_idx, 12);
+/*! stat_item groups with a name, hashed by group name and name */
+static DECLARE_HASHTABLE(osmo_stat_item_groups_by_name_idxname, 10);
+/* groups by their group name prefix */
+static struct osmo_group_classes osmo_stat_item_classes = OSMO_GROUP_CLASSES_INIT(osmo_stat_item_classes);
+/*! groups with items changed since they were last visited by osmo_stat_item_for_each_dirty_group() */
+static LLIST_HEAD(osmo_stat_item_groups_dirty);
+/*! incremented whenever a group is removed from osmo_stat_item_groups */
+static unsigned int osmo_stat_item_groups_gen;
 
 /*! talloc context from which we allocate */
 static void *tall_stat_item_ctx;
 
+/* remember that items of the group changed, for osmo_stat_item_for_each_dirty_group() */
+static inline void group_mark_dirty(struct osmo_stat_item_group *statg)
+{
+	if (llist_empty(&statg->dirty_list))
+		llist_add_tail(&statg->dirty_list, &osmo_stat_item_groups_dirty);
+}
+
+static inline uint32_t group_key(const char *name, unsigned int idx)
+{
+	return osmo_name_idx_hash(name) + idx * 0x9e3779b1u;
+}
+
+static inline uint32_t group_key_idxname(const char *name, const char *idx_name)
+{
+	return osmo_name_idx_hash(name) ^ osmo_name_idx_hash(idx_name);
+}
+
+static void group_hash_add(struct osmo_stat_item_group *statg)
+{
+	if (!statg->desc)
+		return;
+	hash_add(osmo_stat_item_groups_by_name_idx, &statg->hnode,
+		 group_key(statg->desc->group_name_prefix, statg->idx));
+	if (statg->name)
+		hash_add(osmo_stat_item_groups_by_name_idxname, &statg->hnode_name,
+			 group_key_idxname(statg->desc->group_name_prefix, statg->name));
+}
+
+static void group_hash_del(struct osmo_stat_item_group *statg)
+{
+	hash_del(&statg->hnode);
+	hash_del(&statg->hnode_name);
+}
+
 /*! Allocate a new group of counters according to description.
  *  Allocate a group of stat items described in \a desc from talloc context \a ctx,
  *  giving the new group the index \a idx.
@@ -207,6 +255,7 @@ struct osmo_stat_item_group *osmo_stat_item_group_alloc(void *ctx,
 		group->items[item_idx] = item;
 		*item = (struct osmo_stat_item){
 			.desc = item_desc,
+			.group = group,
 			.value = {
 				.n = 0,
 				.last = item_desc->default_value,
@@ -217,7 +266,21 @@ struct osmo_stat_item_group *osmo_stat_item_group_alloc(void *ctx,
 		};
 	}
 
+	/* without the index, osmo_stat_item_get_by_name() searches linearly */
+	group->name_idx = osmo_name_idx_alloc(group, group_desc->item_desc, sizeof(group_desc->item_desc[0]),
+					      group_desc->num_items);
+
 	llist_add(&group->list, &osmo_stat_item_groups);
+	group_hash_add(group);
+	/* the default values haven't been reported yet */
+	INIT_LLIST_HEAD(&group->dirty_list);
+	group_mark_dirty(group);
+	INIT_LLIST_HEAD(&group->class_list);
+	if (osmo_group_class_add(&osmo_stat_item_classes, tall_stat_item_ctx, group_desc->group_name_prefix,
+				 &group->class_list) < 0) {
+		osmo_stat_item_group_free(group);
+		return NULL;
+	}
 	return group;
 }
 
@@ -228,9 +291,28 @@ void osmo_stat_item_group_free(struct osmo_stat_item_group *grp)
 		return;
 
 	llist_del(&grp->list);
+	llist_del(&grp->dirty_list);
+	group_hash_del(grp);
+	osmo_group_class_del(&osmo_stat_item_classes, grp->desc->group_name_prefix, &grp->class_list);
+	osmo_stat_item_groups_gen++;
 	talloc_free(grp);
 }
 
+/*! Return the classes of all stat item groups, to walk them across several
+ *  main loop iterations.  A position in their lists is only valid as long as
+ *  osmo_stat_item_group_list_gen() returns the same value. */
+struct osmo_group_classes *osmo_stat_item_group_classes(void)
+{
+	return &osmo_stat_item_classes;
+}
+
+/*! Return a number that changes whenever a group is removed from the lists
+ *  of osmo_stat_item_group_classes(). */
+unsigned int osmo_stat_item_group_list_gen(void)
+{
+	return osmo_stat_item_groups_gen;
+}
+
 /*! Get statistics item from group, identified by index idx
  *  \param[in] grp Rate counter group
  *  \param[in] idx Index of the counter to retrieve
@@ -248,7 +330,19 @@ struct osmo_stat_item *osmo_stat_item_group_get_item(struct osmo_stat_item_group
  */
 void osmo_stat_item_group_set_name(struct osmo_stat_item_group *statg, const char *name)
 {
+	group_hash_del(statg);
 	osmo_talloc_replace_string(statg, &statg->name, name);
+	group_hash_add(statg);
+}
+
+/*! Change the index of a statistics item group
+ *  \param[in] grp Statistics item group
+ *  \param[in] idx New index of the group */
+void osmo_stat_item_group_udp_idx(struct osmo_stat_item_group *grp, unsigned int idx)
+{
+	group_hash_del(grp);
+	grp->idx = idx;
+	group_hash_add(grp);
 }
 
 /*! Increase the stat_item to the given value.
@@ -281,6 +375,7 @@ void osmo_stat_item_dec(struct osmo_stat_item *item, int32_t value)
  */
 void osmo_stat_item_set(struct osmo_stat_item *item, int32_t value)
 {
+	group_mark_dirty(item->group);
 	item->value.last = value;
 	if (item->value.n == 0) {
 		/* No values recorded yet, clamp min and max to this first value. */
@@ -332,12 +427,8 @@ struct osmo_stat_item_group *osmo_stat_item_get_group_by_name_idx(
 {
 	struct osmo_stat_item_group *statg;
 
-	llist_for_each_entry(statg, &osmo_stat_item_groups, list) {
-		if (!statg->desc)
-			continue;
-
-		if (!strcmp(statg->desc->group_name_prefix, name) &&
-				statg->idx == idx)
+	hash_for_each_possible(osmo_stat_item_groups_by_name_idx, statg, hnode, group_key(name, idx)) {
+		if (statg->idx == idx && !strcmp(statg->desc->group_name_prefix, name))
 			return statg;
 	}
 	return NULL;
@@ -351,9 +442,8 @@ struct osmo_stat_item_group *osmo_stat_item_get_group_by_name_idxname(const char
 {
 	struct osmo_stat_item_group *statg;
 
-	llist_for_each_entry(statg, &osmo_stat_item_groups, list) {
-		if (!statg->desc || !statg->name)
-			continue;
+	hash_for_each_possible(osmo_stat_item_groups_by_name_idxname, statg, hnode_name,
+			       group_key_idxname(group_name, idx_name)) {
 		if (strcmp(statg->desc->group_name_prefix, group_name))
 			continue;
 		if (strcmp(statg->name, idx_name))
@@ -376,6 +466,12 @@ const struct osmo_stat_item *osmo_stat_item_get_by_name(
 	if (!statg->desc)
 		return NULL;
 
+	if (statg->name_idx) {
+		i = osmo_name_idx_find(statg->name_idx, statg->desc->item_desc, sizeof(statg->desc->item_desc[0]),
+				       name);
+		return i < 0 ? NULL : statg->items[i];
+	}
+
 	for (i = 0; i < statg->desc->num_items; i++) {
 		item_desc = &statg->desc->item_desc[i];
 
@@ -407,6 +503,47 @@ int osmo_stat_item_for_each_item(struct osmo_stat_item_group *statg,
 	return rc;
 }
 
+/*! Iterate over the stat_item groups changed since the last iteration
+ *  \param[in] handle_group Call-back function, aborts if rc < 0
+ *  \param[in] data Private data handed through to \a handle_group
+ *
+ *  A group stays in the iteration for one more time after the last change of
+ *  its items, as that ends the reporting period of the change, see
+ *  osmo_stat_item_flush(). */
+int osmo_stat_item_for_each_dirty_group(osmo_stat_item_group_handler_t handle_group, void *data)
+{
+	struct osmo_stat_item_group *statg;
+	LLIST_HEAD(visit);
+	int rc = 0;
+	int i;
+
+	llist_splice_init(&osmo_stat_item_groups_dirty, &visit);
+
+	while (!llist_empty(&visit)) {
+		bool changed = false;
+
+		statg = llist_first_entry(&visit, struct osmo_stat_item_group, dirty_list);
+		llist_del_init(&statg->dirty_list);
+
+		for (i = 0; i < statg->desc->num_items; i++) {
+			if (statg->items[i]->value.n) {
+				changed = true;
+				break;
+			}
+		}
+
+		rc = handle_group(statg, data);
+		if (changed)
+			group_mark_dirty(statg);
+		if (rc < 0)
+			break;
+	}
+
+	/* keep the groups not visited */
+	llist_splice(&visit, &osmo_stat_item_groups_dirty);
+	return rc;
+}
+
 /*! Iterate over all stat_item groups in system, call user-supplied function on each
  *  \param[in] handle_group Call-back function, aborts if rc < 0
  *  \param[in] data Private data handed through to \a handle_group
@@ -439,6 +576,7 @@ void osmo_stat_item_reset(struct osmo_stat_item *item)
 	item->value.sum = 0;
 	item->value.n = 0;
 	item->value.last = item->value.min = item->value.max = item->desc->default_value;
+	group_mark_dirty(item->group);
 }
 
 /*! Reset all osmo stat items in a group
@@ -23,6 +23,8 @@ struct osmo_stat_item_period {
 struct osmo_stat_item {
 	/*! back-reference to the item description */
 	const struct osmo_stat_item_desc *desc;
+	/*! back-reference to the group of the item */
+	struct osmo_stat_item_group *group;
 
 	/*! Current reporting period / current value. */
 	struct osmo_stat_item_period value;
@@ -32,4 +34,9 @@ struct osmo_stat_item {
 	struct osmo_stat_item_period reported;
 };
 
+int osmo_stat_item_for_each_dirty_group(osmo_stat_item_group_handler_t handle_group, void *data);
+struct osmo_group_classes;
+struct osmo_group_classes *osmo_stat_item_group_classes(void);
+unsigned int osmo_stat_item_group_list_gen(void);
+
 /*! @} */
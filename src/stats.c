@@ -61,6 +61,11 @@
 #include "config.h"
 #if !defined(EMBEDDED)
 
+/* sendmmsg() requires _GNU_SOURCE */
+#ifdef HAVE_SENDMMSG
+#define _GNU_SOURCE
+#endif
+
 #include <osmocom/core/byteswap.h>
 #include <osmocom/core/stats.h>
 
@@ -99,9 +104,12 @@
 #endif /* HAVE_SYSTEMTAP */
 
 #include <stat_item_internal.h>
+#include "rate_ctr_internal.h"
 
 #define STATS_DEFAULT_INTERVAL 5 /* secs */
 #define STATS_DEFAULT_BUFLEN 256
+/* maximum number of buffers queued for one sendmmsg() */
+#define STATS_TX_QUEUE_MAX 32
 
 LLIST_HEAD(osmo_stats_reporter_list);
 static void *osmo_stats_ctx = NULL;
@@ -221,6 +229,7 @@ struct osmo_stats_reporter *osmo_stats_reporter_alloc(enum osmo_stats_reporter_t
 	if (name)
 		srep->name = talloc_strdup(srep, name);
 	srep->fd = -1;
+	INIT_LLIST_HEAD(&srep->tx_queue);
 
 	llist_add_tail(&srep->list, &osmo_stats_reporter_list);
 
@@ -393,6 +402,19 @@ int osmo_stats_set_interval(int interval)
 	return 0;
 }
 
+/*! Enable or disable dirty tracking (common for all reporters)
+ *
+ * With dirty tracking, a report only visits the counter and stat item groups
+ * that changed since the previous report, instead of all of them; unless a
+ * reporter forces a flush of all values.  Changes of counters not done via
+ * rate_ctr_add2() or rate_ctr_inc2() are noticed with a delay of up to one
+ * second, so they may only be reported with the next report.
+ *  \param[in] enable true to enable dirty tracking */
+void osmo_stats_set_dirty_tracking(bool enable)
+{
+	osmo_stats_config->dirty_tracking = enable;
+}
+
 /*! Set the regular flush period for a given stats_reporter
  *
  * Send all stats even if they have not changed (i.e. force the flush)
@@ -490,6 +512,7 @@ int osmo_stats_reporter_udp_open(struct osmo_stats_reporter *srep)
 	srep->buffer = msgb_alloc(buffer_size, "stats buffer");
 	if (!srep->buffer)
 		goto failed;
+	srep->tx_queue_len = 0;
 
 	return 0;
 
@@ -541,22 +564,106 @@ int osmo_stats_reporter_send(struct osmo_stats_reporter *srep, const char *data,
 	return rc;
 }
 
-/*! Send current accumulated buffer to given stats_reporter.
- *  \param[in] srep stats_reporter whose UDP socket is to be opened
- *  \returns number of bytes on success; negative otherwise */
-int osmo_stats_reporter_send_buffer(struct osmo_stats_reporter *srep)
+/* Send all queued buffers, with as few sendmmsg() calls as possible */
+static int osmo_stats_reporter_send_queue(struct osmo_stats_reporter *srep)
+{
+	struct msgb *msg, *msg2;
+	int rc = 0, sent = 0;
+#ifdef HAVE_SENDMMSG
+	struct mmsghdr mmsg[STATS_TX_QUEUE_MAX];
+	struct iovec iov[STATS_TX_QUEUE_MAX];
+	unsigned int i = 0, done = 0, j;
+
+	llist_for_each_entry(msg, &srep->tx_queue, list) {
+		iov[i].iov_base = msgb_data(msg);
+		iov[i].iov_len = msgb_length(msg);
+		mmsg[i].msg_hdr = (struct msghdr) {
+			.msg_name = &srep->dest_addr,
+			.msg_namelen = srep->dest_addr_len,
+			.msg_iov = &iov[i],
+			.msg_iovlen = 1,
+		};
+		i++;
+	}
+
+	while (done < i) {
+		rc = sendmmsg(srep->fd, &mmsg[done], i - done,
+#ifdef MSG_NOSIGNAL
+			      MSG_NOSIGNAL |
+#endif
+			      MSG_DONTWAIT);
+		if (rc < 0 && errno == EINTR)
+			continue;
+		if (rc <= 0) {
+			/* like with sendto(), drop what can't be sent now */
+			rc = rc < 0 ? -errno : -EIO;
+			break;
+		}
+		/* only the first rc datagrams were sent */
+		for (j = done; j < done + rc; j++)
+			sent += mmsg[j].msg_len;
+		done += rc;
+	}
+#else
+	llist_for_each_entry(msg, &srep->tx_queue, list) {
+		rc = osmo_stats_reporter_send(srep, (const char *)msgb_data(msg), msgb_length(msg));
+		if (rc < 0)
+			break;
+		sent += rc;
+	}
+#endif
+
+	llist_for_each_entry_safe(msg, msg2, &srep->tx_queue, list) {
+		llist_del(&msg->list);
+		msgb_free(msg);
+	}
+	srep->tx_queue_len = 0;
+
+	return rc < 0 ? rc : sent;
+}
+
+/*! Queue the current accumulated buffer of a given stats_reporter for sending.
+ *  The queued buffers are sent together with one sendmmsg() once
+ *  STATS_TX_QUEUE_MAX are queued, or by osmo_stats_reporter_send_buffer(),
+ *  which is called after each report.
+ *  \param[in] srep stats_reporter whose buffer is to be queued
+ *  \returns 0 or number of bytes sent on success; negative otherwise */
+int osmo_stats_reporter_queue_buffer(struct osmo_stats_reporter *srep)
 {
-	int rc;
+	struct msgb *msg;
 
 	if (!srep->buffer || msgb_length(srep->buffer) == 0)
 		return 0;
 
-	rc = osmo_stats_reporter_send(srep,
-		(const char *)msgb_data(srep->buffer), msgb_length(srep->buffer));
+	msg = msgb_alloc(srep->buffer->data_len, "stats buffer");
+	if (!msg) {
+		/* send it right away */
+		int rc = osmo_stats_reporter_send(srep,
+			(const char *)msgb_data(srep->buffer), msgb_length(srep->buffer));
+		msgb_trim(srep->buffer, 0);
+		return rc;
+	}
 
-	msgb_trim(srep->buffer, 0);
+	llist_add_tail(&srep->buffer->list, &srep->tx_queue);
+	srep->buffer = msg;
 
-	return rc;
+	if (++srep->tx_queue_len >= STATS_TX_QUEUE_MAX)
+		return osmo_stats_reporter_send_queue(srep);
+	return 0;
+}
+
+/*! Send current accumulated buffer and all queued buffers to given stats_reporter.
+ *  \param[in] srep stats_reporter whose UDP socket is to be opened
+ *  \returns number of bytes on success; negative otherwise */
+int osmo_stats_reporter_send_buffer(struct osmo_stats_reporter *srep)
+{
+	int rc;
+
+	rc = osmo_stats_reporter_queue_buffer(srep);
+	if (rc < 0 || srep->tx_queue_len == 0)
+		return rc;
+
+	return osmo_stats_reporter_send_queue(srep);
 }
 #endif /* HAVE_SYS_SOCKET_H */
 
@@ -787,13 +894,30 @@ static void flush_all_reporters(void)
 	}
 }
 
+/* Does any reporter want to send all values, changed or not? */
+static bool flush_forced(void)
+{
+	struct osmo_stats_reporter *srep;
+
+	llist_for_each_entry(srep, &osmo_stats_reporter_list, list) {
+		if (srep->running && srep->force_single_flush)
+			return true;
+	}
+	return false;
+}
+
 int osmo_stats_report(void)
 {
 	/* per group actions */
 	TRACE(LIBOSMOCORE_STATS_START());
 	osmo_counters_for_each(handle_counter, NULL);
-	rate_ctr_for_each_group(rate_ctr_group_handler, NULL);
-	osmo_stat_item_for_each_group(osmo_stat_item_group_handler, NULL);
+	if (osmo_stats_config->dirty_tracking && !flush_forced()) {
+		rate_ctr_for_each_dirty_group(rate_ctr_group_handler, NULL);
+		osmo_stat_item_for_each_dirty_group(osmo_stat_item_group_handler, NULL);
+	} else {
+		rate_ctr_for_each_group(rate_ctr_group_handler, NULL);
+		osmo_stat_item_for_each_group(osmo_stat_item_group_handler, NULL);
+	}
 
 	/* global actions */
 	flush_all_reporters();
@@ -0,0 +1,751 @@
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*! \addtogroup stats
+ *  @{
+ *
+ * Prometheus / OpenMetrics exporter.
+ *
+ * Unlike the stats reporters, which push the values to a collector, the
+ * exporter is scraped: it listens on a TCP socket and answers HTTP GET
+ * requests for /metrics with the current values of all rate counter groups
+ * and stat item groups in the OpenMetrics text format, for example:
+ *
+ *   # TYPE bsc_chreq counter
+ *   # HELP bsc_chreq Received channel requests
+ *   bsc_chreq_total{idx="0"} 42
+ *   # TYPE bts_chanutil_gauge gauge
+ *   # HELP bts_chanutil_gauge Channel utilization [%]
+ *   bts_chanutil_gauge{idx="0",name="bts0"} 30
+ *   # EOF
+ *
+ * Each counter or item of a group description is a metric family, the group
+ * index and name become labels.  Families of stat items are suffixed with
+ * "_gauge", so they never clash with a counter of the same name.  The response is encoded while the socket
+ * is writable, a buffer at a time, so that even a scrape of many series only
+ * delays the main loop by the time it takes to encode PROM_TX_PER_EVENT
+ * bytes, and no memory is allocated per series.  When groups are freed
+ * during a scrape, samples of the family being encoded may be skipped or
+ * repeated.
+ *
+ * \file stats_prometheus.c */
+
+#include "config.h"
+#if !defined(EMBEDDED)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <osmocom/core/linuxlist.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/select.h>
+#include <osmocom/core/socket.h>
+#include <osmocom/core/stat_item.h>
+#include <osmocom/core/stats_prometheus.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/timer.h>
+#include <osmocom/core/utils.h>
+
+#include <stat_item_internal.h>
+#include "group_class_internal.h"
+#include "rate_ctr_internal.h"
+
+/* size of the buffer for the HTTP request header */
+#define PROM_RX_BUF_SIZE	2048
+/* size of the buffer the response is encoded into */
+#define PROM_TX_BUF_SIZE	16384
+/* bytes to send per write event at most, so that other file descriptors get their turn */
+#define PROM_TX_PER_EVENT	(128 * 1024)
+/* metric names and strings are clipped, so that a line always fits into the buffer */
+#define PROM_NAME_MAX		128
+#define PROM_STR_MAX		256
+/* maximum number of simultaneous connections */
+#define PROM_CONN_MAX		16
+/* seconds after which an idle connection is closed */
+#define PROM_IDLE_TIMEOUT	10
+
+#define PROM_CONTENT_TYPE	"application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+static struct osmo_stats_prometheus_config s_prom_config;
+struct osmo_stats_prometheus_config *osmo_stats_prometheus_config = &s_prom_config;
+
+static void *prom_ctx;
+static struct osmo_fd prom_listen_ofd = { .fd = -1 };
+static LLIST_HEAD(prom_conns);
+static unsigned int prom_num_conns;
+
+enum prom_kind {
+	PROM_K_CTR,
+	PROM_K_ITEM,
+	PROM_K_END,
+};
+
+enum prom_conn_state {
+	PROM_S_REQUEST,		/* receiving the request */
+	PROM_S_BODY,		/* encoding the metrics */
+	PROM_S_DONE,		/* sending the rest of tx[] */
+};
+
+/* Position of the encoder.  Families are encoded one after the other, each
+ * with a walk over the groups of the class (group name prefix) it belongs to,
+ * so that each step only visits groups that have a sample to encode.  (Groups
+ * of the same class may have different descriptions, when
+ * rate_ctr_group_alloc() had to make a copy with mangled names.) */
+struct prom_cursor {
+	enum prom_kind kind;
+	/* current class and its position in the list of classes; the list head when all are done */
+	struct llist_head *cls;
+	unsigned int cls_ord;
+	/* group name prefix of the current class, to find it again after groups were freed */
+	char prefix[PROM_NAME_MAX];
+	/* index of the current family (counter or item) */
+	unsigned int fam;
+	/* TYPE and HELP of the current family encoded? */
+	bool fam_started;
+	/* first group with the current family and its position in the class, NULL if unknown */
+	struct llist_head *first;
+	unsigned int first_ord;
+	/* next group to encode a sample of, and its position in the class */
+	struct llist_head *pos;
+	unsigned int ord;
+	/* group list generation the pointers above are valid for */
+	unsigned int gen;
+};
+
+struct prom_conn {
+	struct llist_head list;
+	struct osmo_fd ofd;
+	struct osmo_timer_list timer;
+	enum prom_conn_state state;
+
+	char rx[PROM_RX_BUF_SIZE];
+	size_t rx_len;
+
+	char tx[PROM_TX_BUF_SIZE];
+	size_t tx_len;
+	size_t tx_sent;
+
+	struct prom_cursor cur;
+};
+
+/* Encoder output, writes beyond the size are counted but not stored */
+struct prom_out {
+	char *buf;
+	size_t len;
+	size_t size;
+};
+
+static inline void out_char(struct prom_out *o, char c)
+{
+	if (o->len < o->size)
+		o->buf[o->len] = c;
+	o->len++;
+}
+
+static void out_str(struct prom_out *o, const char *str)
+{
+	while (*str)
+		out_char(o, *str++);
+}
+
+static void out_u64(struct prom_out *o, uint64_t val)
+{
+	char tmp[20];
+	unsigned int n = 0;
+
+	do {
+		tmp[n++] = '0' + val % 10;
+		val /= 10;
+	} while (val);
+	while (n)
+		out_char(o, tmp[--n]);
+}
+
+static void out_i64(struct prom_out *o, int64_t val)
+{
+	if (val < 0) {
+		out_char(o, '-');
+		out_u64(o, -(uint64_t)val);
+	} else
+		out_u64(o, val);
+}
+
+/* Append a name to a metric name, replacing characters not allowed in it */
+static void out_name(struct prom_out *o, const char *name, size_t *name_len)
+{
+	for (; *name && *name_len < PROM_NAME_MAX; name++, (*name_len)++) {
+		char c = *name;
+
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'
+		    || (c >= '0' && c <= '9' && *name_len > 0))
+			out_char(o, c);
+		else
+			out_char(o, '_');
+	}
+}
+
+/* Append the name of a metric family */
+static void out_metric(struct prom_out *o, enum prom_kind kind, const char *prefix, const char *name)
+{
+	size_t name_len = 0;
+
+	out_name(o, prefix, &name_len);
+	out_name(o, "_", &name_len);
+	out_name(o, name, &name_len);
+	if (kind == PROM_K_ITEM)
+		out_str(o, "_gauge");
+}
+
+/* Append an escaped HELP text or label value */
+static void out_escaped(struct prom_out *o, const char *str)
+{
+	unsigned int i;
+
+	for (i = 0; str[i] && i < PROM_STR_MAX; i++) {
+		switch (str[i]) {
+		case '\\':
+			out_str(o, "\\\\");
+			break;
+		case '\n':
+			out_str(o, "\\n");
+			break;
+		case '"':
+			out_str(o, "\\\"");
+			break;
+		default:
+			out_char(o, str[i]);
+		}
+	}
+}
+
+/* Accessors for the two kinds of groups */
+
+static struct osmo_group_classes *kind_classes(enum prom_kind kind)
+{
+	return kind == PROM_K_CTR ? rate_ctr_group_classes() : osmo_stat_item_group_classes();
+}
+
+static unsigned int kind_list_gen(enum prom_kind kind)
+{
+	return kind == PROM_K_CTR ? rate_ctr_group_list_gen() : osmo_stat_item_group_list_gen();
+}
+
+/* pos is the class_list member of a group */
+static const void *kind_desc(enum prom_kind kind, const struct llist_head *pos)
+{
+	if (kind == PROM_K_CTR)
+		return llist_entry(pos, struct rate_ctr_group, class_list)->desc;
+	return llist_entry(pos, struct osmo_stat_item_group, class_list)->desc;
+}
+
+static unsigned int kind_num_fam(enum prom_kind kind, const void *desc)
+{
+	if (kind == PROM_K_CTR)
+		return ((const struct rate_ctr_group_desc *)desc)->num_ctr;
+	return ((const struct osmo_stat_item_group_desc *)desc)->num_items;
+}
+
+static void out_fam_header(struct prom_out *o, enum prom_kind kind, const void *desc, unsigned int fam)
+{
+	const char *prefix, *name, *help, *unit = NULL;
+
+	if (kind == PROM_K_CTR) {
+		const struct rate_ctr_group_desc *gdesc = desc;
+		prefix = gdesc->group_name_prefix;
+		name = gdesc->ctr_desc[fam].name;
+		help = gdesc->ctr_desc[fam].description;
+	} else {
+		const struct osmo_stat_item_group_desc *gdesc = desc;
+		prefix = gdesc->group_name_prefix;
+		name = gdesc->item_desc[fam].name;
+		help = gdesc->item_desc[fam].description;
+		unit = gdesc->item_desc[fam].unit;
+	}
+
+	out_str(o, "# TYPE ");
+	out_metric(o, kind, prefix, name);
+	out_str(o, kind == PROM_K_CTR ? " counter\n" : " gauge\n");
+	if (help && *help) {
+		out_str(o, "# HELP ");
+		out_metric(o, kind, prefix, name);
+		out_char(o, ' ');
+		out_escaped(o, help);
+		if (unit && *unit) {
+			out_str(o, " [");
+			out_escaped(o, unit);
+			out_char(o, ']');
+		}
+		out_char(o, '\n');
+	}
+}
+
+static void out_sample(struct prom_out *o, enum prom_kind kind, struct llist_head *pos, unsigned int fam)
+{
+	const char *prefix, *name, *grp_name;
+	unsigned int idx;
+
+	if (kind == PROM_K_CTR) {
+		struct rate_ctr_group *ctrg = llist_entry(pos, struct rate_ctr_group, class_list);
+		/* fold the per-thread shards of the group in with its first family */
+		if (fam == 0)
+			rate_ctr_group_sync(ctrg);
+		prefix = ctrg->desc->group_name_prefix;
+		name = ctrg->desc->ctr_desc[fam].name;
+		idx = ctrg->idx;
+		grp_name = ctrg->name;
+	} else {
+		const struct osmo_stat_item_group *statg = llist_entry(pos, struct osmo_stat_item_group, class_list);
+		prefix = statg->desc->group_name_prefix;
+		name = statg->desc->item_desc[fam].name;
+		idx = statg->idx;
+		grp_name = statg->name;
+	}
+
+	out_metric(o, kind, prefix, name);
+	if (kind == PROM_K_CTR)
+		out_str(o, "_total");
+	out_str(o, "{idx=\"");
+	out_u64(o, idx);
+	if (grp_name) {
+		out_str(o, "\",name=\"");
+		out_escaped(o, grp_name);
+	}
+	out_str(o, "\"} ");
+	if (kind == PROM_K_CTR)
+		out_u64(o, llist_entry(pos, struct rate_ctr_group, class_list)->ctr[fam].current);
+	else
+		out_i64(o, osmo_stat_item_get_last(
+				llist_entry(pos, struct osmo_stat_item_group, class_list)->items[fam]));
+	out_char(o, '\n');
+}
+
+static struct llist_head *list_nth(struct llist_head *list, unsigned int n)
+{
+	struct llist_head *pos = list->next;
+
+	while (n-- && pos != list)
+		pos = pos->next;
+	return pos;
+}
+
+/* Start encoding the families of the class at cls */
+static void cursor_set_class(struct prom_cursor *c, struct llist_head *cls)
+{
+	c->cls = cls;
+	c->fam = 0;
+	c->fam_started = false;
+	c->first = NULL;
+	if (cls != &kind_classes(c->kind)->list)
+		osmo_strlcpy(c->prefix, llist_entry(cls, struct osmo_group_class, list)->prefix, sizeof(c->prefix));
+}
+
+/* Start encoding the families of the first class of a kind */
+static void cursor_start(struct prom_cursor *c, enum prom_kind kind)
+{
+	memset(c, 0, sizeof(*c));
+	c->kind = kind;
+	if (kind == PROM_K_END)
+		return;
+	c->gen = kind_list_gen(kind);
+	cursor_set_class(c, kind_classes(kind)->list.next);
+}
+
+/* Groups were freed since the cursor was last used: find its position again */
+static void cursor_restore(struct prom_cursor *c)
+{
+	struct osmo_group_classes *classes = kind_classes(c->kind);
+	struct osmo_group_class *cls = osmo_group_class_find(classes, c->prefix);
+
+	c->gen = kind_list_gen(c->kind);
+	c->first = NULL;
+	if (!cls) {
+		/* all groups of the class are gone, continue with the one that took its place */
+		cursor_set_class(c, list_nth(&classes->list, c->cls_ord));
+		return;
+	}
+	c->cls = &cls->list;
+	c->pos = list_nth(&cls->groups, c->ord);
+}
+
+/* Does the group at pos have the current family? */
+static bool cursor_match(const struct prom_cursor *c, const struct llist_head *pos)
+{
+	return c->fam < kind_num_fam(c->kind, kind_desc(c->kind, pos));
+}
+
+/* Find the first group of the class that has the current family */
+static bool cursor_find_first(struct prom_cursor *c)
+{
+	struct llist_head *groups = &llist_entry(c->cls, struct osmo_group_class, list)->groups;
+	struct llist_head *pos;
+	unsigned int ord = 0;
+
+	llist_for_each(pos, groups) {
+		if (cursor_match(c, pos)) {
+			c->first = pos;
+			c->first_ord = ord;
+			return true;
+		}
+		ord++;
+	}
+	return false;
+}
+
+/* Encode the next line of the response, or advance the cursor without
+ * output.  Returns false if the line didn't fit into the output. */
+static bool encode_step(struct prom_conn *conn, struct prom_out *o)
+{
+	struct prom_cursor *c = &conn->cur;
+	struct llist_head *groups;
+	size_t mark = o->len;
+
+	if (c->kind == PROM_K_END) {
+		out_str(o, "# EOF\n");
+		if (o->len > o->size) {
+			o->len = mark;
+			return false;
+		}
+		conn->state = PROM_S_DONE;
+		return true;
+	}
+
+	if (c->cls == &kind_classes(c->kind)->list) {
+		cursor_start(c, c->kind + 1);
+		return true;
+	}
+
+	if (kind_list_gen(c->kind) != c->gen) {
+		cursor_restore(c);
+		return true;
+	}
+	groups = &llist_entry(c->cls, struct osmo_group_class, list)->groups;
+
+	if (!c->fam_started) {
+		if ((!c->first || !cursor_match(c, c->first)) && !cursor_find_first(c)) {
+			/* no group has this family */
+			cursor_set_class(c, c->cls->next);
+			c->cls_ord++;
+			return true;
+		}
+		out_fam_header(o, c->kind, kind_desc(c->kind, c->first), c->fam);
+		if (o->len > o->size) {
+			o->len = mark;
+			return false;
+		}
+		c->fam_started = true;
+		c->pos = c->first;
+		c->ord = c->first_ord;
+		return true;
+	}
+
+	while (c->pos != groups && !cursor_match(c, c->pos)) {
+		c->pos = c->pos->next;
+		c->ord++;
+	}
+
+	if (c->pos == groups) {
+		/* end of the family, continue with the next one of the class */
+		c->fam_started = false;
+		c->fam++;
+		return true;
+	}
+
+	out_sample(o, c->kind, c->pos, c->fam);
+	if (o->len > o->size) {
+		o->len = mark;
+		return false;
+	}
+	c->pos = c->pos->next;
+	c->ord++;
+	return true;
+}
+
+/* Fill the (empty) tx buffer with the next part of the response */
+static void encode(struct prom_conn *conn)
+{
+	struct prom_out o = {
+		.buf = conn->tx,
+		.len = 0,
+		.size = sizeof(conn->tx),
+	};
+
+	while (conn->state == PROM_S_BODY && encode_step(conn, &o))
+		;
+
+	conn->tx_len = o.len;
+	conn->tx_sent = 0;
+}
+
+static void prom_conn_close(struct prom_conn *conn)
+{
+	osmo_timer_del(&conn->timer);
+	osmo_fd_close(&conn->ofd);
+	llist_del(&conn->list);
+	prom_num_conns--;
+	talloc_free(conn);
+}
+
+static void prom_conn_timeout_cb(void *data)
+{
+	struct prom_conn *conn = data;
+
+	LOGP(DLSTATS, LOGL_INFO, "Prometheus exporter: closing idle connection\n");
+	prom_conn_close(conn);
+}
+
+static void respond_error(struct prom_conn *conn, const char *status)
+{
+	struct prom_out o = {
+		.buf = conn->tx,
+		.len = 0,
+		.size = sizeof(conn->tx),
+	};
+
+	out_str(&o, "HTTP/1.1 ");
+	out_str(&o, status);
+	out_str(&o, "\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\n");
+	out_str(&o, status);
+	out_char(&o, '\n');
+
+	conn->tx_len = o.len;
+	conn->tx_sent = 0;
+	conn->state = PROM_S_DONE;
+}
+
+/* Handle a complete request header in rx[] */
+static void handle_request(struct prom_conn *conn)
+{
+	struct prom_out o = {
+		.buf = conn->tx,
+		.len = 0,
+		.size = sizeof(conn->tx),
+	};
+	const char *path;
+	size_t path_len;
+	bool head = false;
+
+	if (!strncmp(conn->rx, "GET ", 4))
+		path = conn->rx + 4;
+	else if (!strncmp(conn->rx, "HEAD ", 5)) {
+		path = conn->rx + 5;
+		head = true;
+	} else {
+		respond_error(conn, "405 Method Not Allowed");
+		return;
+	}
+
+	path_len = strcspn(path, " ?\r\n");
+	if (!(path_len == 1 && path[0] == '/') &&
+	    !(path_len == 8 && !strncmp(path, "/metrics", 8))) {
+		respond_error(conn, "404 Not Found");
+		return;
+	}
+
+	out_str(&o, "HTTP/1.1 200 OK\r\nContent-Type: " PROM_CONTENT_TYPE "\r\nConnection: close\r\n\r\n");
+	conn->tx_len = o.len;
+	conn->tx_sent = 0;
+
+	if (head) {
+		conn->state = PROM_S_DONE;
+		return;
+	}
+
+	cursor_start(&conn->cur, PROM_K_CTR);
+	conn->state = PROM_S_BODY;
+}
+
+static int prom_conn_read(struct prom_conn *conn)
+{
+	ssize_t rc;
+
+	rc = recv(conn->ofd.fd, conn->rx + conn->rx_len, sizeof(conn->rx) - 1 - conn->rx_len, 0);
+	if (rc < 0)
+		return (errno == EAGAIN || errno == EINTR) ? 0 : -errno;
+	if (rc == 0)
+		return -EPIPE;
+
+	conn->rx_len += rc;
+	conn->rx[conn->rx_len] = '\0';
+
+	if (strstr(conn->rx, "\r\n\r\n") || strstr(conn->rx, "\n\n"))
+		handle_request(conn);
+	else if (conn->rx_len == sizeof(conn->rx) - 1)
+		respond_error(conn, "431 Request Header Fields Too Large");
+	else
+		return 0;
+
+	osmo_fd_read_disable(&conn->ofd);
+	osmo_fd_write_enable(&conn->ofd);
+	return 0;
+}
+
+/* Returns 1 when the response is sent completely */
+static int prom_conn_write(struct prom_conn *conn)
+{
+	size_t sent = 0;
+	ssize_t rc;
+
+	while (sent < PROM_TX_PER_EVENT) {
+		if (conn->tx_sent == conn->tx_len) {
+			if (conn->state != PROM_S_BODY)
+				return 1;
+			encode(conn);
+			continue;
+		}
+
+		rc = send(conn->ofd.fd, conn->tx + conn->tx_sent, conn->tx_len - conn->tx_sent,
+#ifdef MSG_NOSIGNAL
+			  MSG_NOSIGNAL |
+#endif
+			  MSG_DONTWAIT);
+		if (rc < 0) {
+			if (errno == EAGAIN || errno == EINTR)
+				return 0;
+			return -errno;
+		}
+		conn->tx_sent += rc;
+		sent += rc;
+	}
+	return 0;
+}
+
+static int prom_conn_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	struct prom_conn *conn = ofd->data;
+	int rc = 0;
+
+	if (what & OSMO_FD_READ)
+		rc = prom_conn_read(conn);
+	if (rc == 0 && (what & OSMO_FD_WRITE))
+		rc = prom_conn_write(conn);
+
+	if (rc != 0) {
+		if (rc < 0)
+			LOGP(DLSTATS, LOGL_INFO, "Prometheus exporter: connection failed: %s\n", strerror(-rc));
+		prom_conn_close(conn);
+		return 0;
+	}
+
+	osmo_timer_schedule(&conn->timer, PROM_IDLE_TIMEOUT, 0);
+	return 0;
+}
+
+static int prom_accept_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	struct prom_conn *conn;
+	int fd;
+
+	fd = accept(ofd->fd, NULL, NULL);
+	if (fd < 0) {
+		LOGP(DLSTATS, LOGL_ERROR, "Prometheus exporter: accept() failed: %s\n", strerror(errno));
+		return 0;
+	}
+
+	if (prom_num_conns >= PROM_CONN_MAX) {
+		LOGP(DLSTATS, LOGL_NOTICE, "Prometheus exporter: too many connections\n");
+		close(fd);
+		return 0;
+	}
+
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0)
+		goto err_close;
+
+	conn = talloc_zero(prom_ctx, struct prom_conn);
+	if (!conn)
+		goto err_close;
+
+	osmo_fd_setup(&conn->ofd, fd, OSMO_FD_READ, prom_conn_cb, conn, 0);
+	if (osmo_fd_register(&conn->ofd) < 0) {
+		talloc_free(conn);
+		goto err_close;
+	}
+	osmo_timer_setup(&conn->timer, prom_conn_timeout_cb, conn);
+	osmo_timer_schedule(&conn->timer, PROM_IDLE_TIMEOUT, 0);
+
+	llist_add_tail(&conn->list, &prom_conns);
+	prom_num_conns++;
+	return 0;
+
+err_close:
+	close(fd);
+	return 0;
+}
+
+/*! Start the Prometheus / OpenMetrics exporter, or move it to another address.
+ *  \param[in] ctx talloc context to allocate connections from
+ *  \param[in] local_ip local IP address to listen on
+ *  \param[in] local_port local TCP port to listen on, 0 to pick a free port
+ *  \returns 0 on success; negative on error
+ *
+ *  On success, osmo_stats_prometheus_config holds the address and port the
+ *  exporter listens on. */
+int osmo_stats_prometheus_listen(void *ctx, const char *local_ip, uint16_t local_port)
+{
+	uint16_t port = local_port;
+	int rc;
+
+	if (prom_listen_ofd.fd >= 0)
+		osmo_fd_close(&prom_listen_ofd);
+
+	osmo_fd_setup(&prom_listen_ofd, -1, OSMO_FD_READ, prom_accept_cb, NULL, 0);
+	rc = osmo_sock_init2_ofd(&prom_listen_ofd, AF_UNSPEC, SOCK_STREAM, IPPROTO_TCP, local_ip, local_port,
+				 NULL, 0, OSMO_SOCK_F_BIND | OSMO_SOCK_F_NONBLOCK);
+	if (rc < 0) {
+		LOGP(DLSTATS, LOGL_ERROR, "Prometheus exporter: cannot listen on %s:%u\n", local_ip, local_port);
+		prom_listen_ofd.fd = -1;
+		TALLOC_FREE(s_prom_config.local_ip);
+		return rc;
+	}
+
+	if (local_port == 0) {
+		struct osmo_sockaddr osa;
+		socklen_t len = sizeof(osa.u.sas);
+
+		if (getsockname(prom_listen_ofd.fd, &osa.u.sa, &len) == 0)
+			port = osmo_sockaddr_port(&osa.u.sa);
+	}
+
+	prom_ctx = ctx;
+	osmo_talloc_replace_string(ctx, &s_prom_config.local_ip, local_ip);
+	s_prom_config.local_port = port;
+	return 0;
+}
+
+/*! Stop the Prometheus / OpenMetrics exporter, and close all its connections. */
+void osmo_stats_prometheus_close(void)
+{
+	struct prom_conn *conn, *conn2;
+
+	if (prom_listen_ofd.fd >= 0)
+		osmo_fd_close(&prom_listen_ofd);
+
+	llist_for_each_entry_safe(conn, conn2, &prom_conns, list)
+		prom_conn_close(conn);
+
+	TALLOC_FREE(s_prom_config.local_ip);
+	s_prom_config.local_port = 0;
+}
+
+#endif /* !EMBEDDED */
+
+/*! @} */
@@ -129,8 +129,8 @@ static int osmo_stats_reporter_statsd_send(struct osmo_stats_reporter *srep,
 		/* Truncated */
 		/* Restore original buffer (without trailing LF) */
 		msgb_trim(srep->buffer, old_len);
-		/* Send it */
-		rc = osmo_stats_reporter_send_buffer(srep);
+		/* Queue it, to be sent with the following packets */
+		rc = osmo_stats_reporter_queue_buffer(srep);
 
 		/* Try again */
 		buf = (char *)msgb_put(srep->buffer, 0);
@@ -150,7 +150,7 @@ static int osmo_stats_reporter_statsd_send(struct osmo_stats_reporter *srep,
 	}
 
 	if (!srep->agg_enabled)
-		rc = osmo_stats_reporter_send_buffer(srep);
+		rc = osmo_stats_reporter_queue_buffer(srep);
 
 	return rc;
 }
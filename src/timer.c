@@ -31,9 +31,13 @@
 #include <assert.h>
 #include <string.h>
 #include <limits.h>
+#include <errno.h>
+#include <stdint.h>
 #include <osmocom/core/timer.h>
 #include <osmocom/core/timer_compat.h>
 #include <osmocom/core/linuxlist.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
 
 /* These store the amount of time that we wait until next timer expires. */
 static __thread struct timeval nearest;
@@ -41,8 +45,249 @@ static __thread struct timeval *nearest_p;
 
 static __thread struct rb_root timer_root = RB_ROOT;
 
+/* Hierarchical timer wheel, in the style of the classic (pre-4.8) Linux kernel timer wheel.  One tick is one
+ * millisecond.  Level 0 has one slot per tick for the next 256 ticks, each of the higher levels has 64 slots
+ * covering 64 times the range of the level below.  Timers are cascaded down to the lower levels as time advances,
+ * so that add, delete and re-arm are all O(1). */
+#define WHEEL_L0_BITS		8
+#define WHEEL_LN_BITS		6
+#define WHEEL_L0_SIZE		(1 << WHEEL_L0_BITS)
+#define WHEEL_LN_SIZE		(1 << WHEEL_LN_BITS)
+#define WHEEL_LEVELS		5
+#define WHEEL_SHIFT(level)	(WHEEL_L0_BITS + ((level) - 1) * WHEEL_LN_BITS)
+#define WHEEL_MAX_DELTA		((1ULL << WHEEL_SHIFT(WHEEL_LEVELS)) - 1)
+/* the clock advancing by more than this is handled as a jump, see wheel_sync() */
+#define WHEEL_JUMP_MAX		(1ULL << WHEEL_SHIFT(2))
+
+struct timer_wheel {
+	/* all ticks before clk have been processed */
+	uint64_t clk;
+	/* number of pending timers */
+	unsigned int count;
+	/* level 0 slots, and a bitmap hinting at non-empty ones (bits are cleared lazily) */
+	struct llist_head l0[WHEEL_L0_SIZE];
+	uint64_t l0_map[WHEEL_L0_SIZE / 64];
+	/* levels 1..WHEEL_LEVELS-1 */
+	struct llist_head ln[WHEEL_LEVELS - 1][WHEEL_LN_SIZE];
+	uint64_t ln_map[WHEEL_LEVELS - 1];
+};
+
+/* NULL if the rbtree back-end is used */
+static __thread struct timer_wheel *wheel;
+/* set while timer call-backs are dispatched from osmo_timers_update() */
+static __thread bool in_update;
+
+/* round up, so that a timer never fires early */
+static inline uint64_t timeval_to_tick(const struct timeval *tv)
+{
+	return (uint64_t)tv->tv_sec * 1000 + (tv->tv_usec + 999) / 1000;
+}
+
+static void wheel_add(struct osmo_timer_list *timer)
+{
+	uint64_t expires = timeval_to_tick(&timer->timeout);
+	uint64_t delta;
+	unsigned int level, slot;
+
+	if (expires < wheel->clk)
+		expires = wheel->clk;
+	delta = expires - wheel->clk;
+
+	if (delta < WHEEL_L0_SIZE) {
+		slot = expires & (WHEEL_L0_SIZE - 1);
+		llist_add_tail(&timer->list, &wheel->l0[slot]);
+		wheel->l0_map[slot / 64] |= 1ULL << (slot % 64);
+		return;
+	}
+
+	/* timers beyond the range of the wheel are parked in the top level, and re-filed when cascaded */
+	if (delta > WHEEL_MAX_DELTA)
+		expires = wheel->clk + WHEEL_MAX_DELTA;
+
+	for (level = 1; level < WHEEL_LEVELS - 1; level++) {
+		if (delta < (1ULL << WHEEL_SHIFT(level + 1)))
+			break;
+	}
+	slot = (expires >> WHEEL_SHIFT(level)) & (WHEEL_LN_SIZE - 1);
+	llist_add_tail(&timer->list, &wheel->ln[level - 1][slot]);
+	wheel->ln_map[level - 1] |= 1ULL << slot;
+}
+
+/* re-file all timers of the current slot of the given level into the lower levels; returns the slot index */
+static unsigned int wheel_cascade(unsigned int level)
+{
+	unsigned int slot = (wheel->clk >> WHEEL_SHIFT(level)) & (WHEEL_LN_SIZE - 1);
+	struct osmo_timer_list *this, *tmp;
+	LLIST_HEAD(head);
+
+	llist_splice_init(&wheel->ln[level - 1][slot], &head);
+	wheel->ln_map[level - 1] &= ~(1ULL << slot);
+
+	llist_for_each_entry_safe(this, tmp, &head, list)
+		wheel_add(this);
+
+	return slot;
+}
+
+/* find the first bit set in a 64 bit map, starting at bit 'from' and wrapping around; returns the distance */
+static inline int map_next(uint64_t map, unsigned int from)
+{
+	uint64_t rot;
+
+	if (!map)
+		return -1;
+	rot = from ? ((map >> from) | (map << (64 - from))) : map;
+	return __builtin_ctzll(rot);
+}
+
+/* distance in ticks from clk to the next non-empty level 0 slot at or after clk, up to the end of the wheel
+ * revolution; -1 if there is none */
+static int wheel_l0_next(void)
+{
+	unsigned int idx = wheel->clk & (WHEEL_L0_SIZE - 1);
+	unsigned int i;
+
+	for (i = idx; i < WHEEL_L0_SIZE; ) {
+		uint64_t map = wheel->l0_map[i / 64] >> (i % 64);
+		int bit;
+
+		if (!map) {
+			i = (i / 64 + 1) * 64;
+			continue;
+		}
+		bit = __builtin_ctzll(map);
+		i += bit;
+		if (!llist_empty(&wheel->l0[i]))
+			return i - idx;
+		/* stale hint, clear it */
+		wheel->l0_map[i / 64] &= ~(1ULL << (i % 64));
+		i++;
+	}
+	return -1;
+}
+
+/* move all pending timers out of the wheel */
+static void wheel_take_all(struct llist_head *head)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < WHEEL_L0_SIZE; i++)
+		llist_splice_init(&wheel->l0[i], head);
+	for (i = 0; i < WHEEL_LEVELS - 1; i++) {
+		for (j = 0; j < WHEEL_LN_SIZE; j++)
+			llist_splice_init(&wheel->ln[i][j], head);
+	}
+	memset(wheel->l0_map, 0, sizeof(wheel->l0_map));
+	memset(wheel->ln_map, 0, sizeof(wheel->ln_map));
+}
+
+/* Timers are filed by their absolute expiration time, relative to the clock of the wheel.  Should the clock jump
+ * backwards, timers added afterwards would be held back until the wheel caught up; should it jump far forwards,
+ * the wheel would be walked slot by slot.  Instead, re-file all timers relative to tick 'now' in one pass, in
+ * which all timers that expired in the meantime end up in the current slot. */
+static void wheel_sync(uint64_t now)
+{
+	struct osmo_timer_list *this, *tmp;
+	LLIST_HEAD(pending);
+
+	if (now + 1 >= wheel->clk && now + 1 - wheel->clk <= WHEEL_JUMP_MAX)
+		return;
+
+	wheel_take_all(&pending);
+	wheel->clk = now;
+	llist_for_each_entry_safe(this, tmp, &pending, list)
+		wheel_add(this);
+}
+
+/* move all timers expiring up to (and including) tick 'now' to the eviction list */
+static void wheel_expire(uint64_t now, struct llist_head *eviction_list)
+{
+	while (wheel->clk <= now) {
+		unsigned int idx = wheel->clk & (WHEEL_L0_SIZE - 1);
+		unsigned int level;
+		uint64_t step;
+		int next;
+
+		if (!idx) {
+			for (level = 1; level < WHEEL_LEVELS; level++) {
+				if (wheel_cascade(level))
+					break;
+			}
+		}
+
+		next = wheel_l0_next();
+		if (next == 0) {
+			struct osmo_timer_list *this, *tmp;
+			/* same order as the rbtree back-end: last to expire first */
+			llist_for_each_entry_safe(this, tmp, &wheel->l0[idx], list) {
+				llist_del(&this->list);
+				llist_add(&this->list, eviction_list);
+			}
+			wheel->l0_map[idx / 64] &= ~(1ULL << (idx % 64));
+			next = 1;
+		} else if (next < 0) {
+			/* nothing in level 0 until the next cascade */
+			next = WHEEL_L0_SIZE - idx;
+		}
+
+		step = OSMO_MIN((uint64_t)next, now - wheel->clk + 1);
+		wheel->clk += step;
+	}
+}
+
+/* lower bound of the tick at which the next timer expires, in which case we need to wake up to either fire it or
+ * cascade it; returns false if no timers are pending */
+static bool wheel_next_tick(uint64_t *tick)
+{
+	uint64_t next_cascade = wheel->clk + WHEEL_L0_SIZE - (wheel->clk & (WHEEL_L0_SIZE - 1));
+	uint64_t earliest = UINT64_MAX;
+	unsigned int i, level;
+	int next;
+
+	if (!wheel->count)
+		return false;
+
+	next = wheel_l0_next();
+	if (next >= 0) {
+		*tick = wheel->clk + next;
+		return true;
+	}
+
+	/* level 0 slots before the current index belong to the next revolution, which starts with a cascade */
+	for (i = 0; i < ARRAY_SIZE(wheel->l0_map); i++) {
+		if (wheel->l0_map[i]) {
+			*tick = next_cascade;
+			return true;
+		}
+	}
+
+	/* the earliest cascade of any level: a higher level slot may be cascaded before the next non-empty slot
+	 * of a lower level */
+	for (level = 1; level < WHEEL_LEVELS; level++) {
+		unsigned int shift = WHEEL_SHIFT(level);
+		unsigned int cur = (wheel->clk >> shift) & (WHEEL_LN_SIZE - 1);
+		uint64_t t;
+		/* the current slot of a level was already cascaded, its timers are one revolution ahead */
+		next = map_next(wheel->ln_map[level - 1], (cur + 1) & (WHEEL_LN_SIZE - 1));
+		if (next < 0)
+			continue;
+		t = ((wheel->clk >> shift) + next + 1) << shift;
+		earliest = OSMO_MIN(earliest, t);
+	}
+
+	/* cannot happen, but waking up early is harmless */
+	*tick = earliest != UINT64_MAX ? earliest : next_cascade;
+	return true;
+}
+
 static void __add_timer(struct osmo_timer_list *timer)
 {
+	if (wheel) {
+		wheel_add(timer);
+		wheel->count++;
+		return;
+	}
+
 	struct rb_node **new = &(timer_root.rb_node);
 	struct rb_node *parent = NULL;
 
@@ -115,7 +360,12 @@ osmo_timer_schedule(struct osmo_timer_list *timer, int seconds, int microseconds
  */
 void osmo_timer_del(struct osmo_timer_list *timer)
 {
-	if (timer->active) {
+	if (timer->active && wheel) {
+		timer->active = 0;
+		/* either in a wheel slot or in the eviction list */
+		llist_del_init(&timer->list);
+		wheel->count--;
+	} else if (timer->active) {
 		timer->active = 0;
 		rb_erase(&timer->node, &timer_root);
 		/* make sure this is not already scheduled for removal. */
@@ -219,6 +469,21 @@ void osmo_timers_prepare(void)
 
 	osmo_gettimeofday(&current, NULL);
 
+	if (wheel) {
+		struct timeval cand;
+		uint64_t tick;
+
+		wheel_sync((uint64_t)current.tv_sec * 1000 + current.tv_usec / 1000);
+		if (!wheel_next_tick(&tick)) {
+			nearest_p = NULL;
+			return;
+		}
+		cand.tv_sec = tick / 1000;
+		cand.tv_usec = (tick % 1000) * 1000;
+		update_nearest(&cand, &current);
+		return;
+	}
+
 	node = rb_first(&timer_root);
 	if (node) {
 		struct osmo_timer_list *this;
@@ -241,13 +506,19 @@ int osmo_timers_update(void)
 	osmo_gettimeofday(&current_time, NULL);
 
 	INIT_LLIST_HEAD(&timer_eviction_list);
-	for (node = rb_first(&timer_root); node; node = rb_next(node)) {
-		this = container_of(node, struct osmo_timer_list, node);
+	if (wheel) {
+		uint64_t now = (uint64_t)current_time.tv_sec * 1000 + current_time.tv_usec / 1000;
+		wheel_sync(now);
+		wheel_expire(now, &timer_eviction_list);
+	} else {
+		for (node = rb_first(&timer_root); node; node = rb_next(node)) {
+			this = container_of(node, struct osmo_timer_list, node);
 
-		if (timercmp(&this->timeout, &current_time, >))
-			break;
+			if (timercmp(&this->timeout, &current_time, >))
+				break;
 
-		llist_add(&this->list, &timer_eviction_list);
+			llist_add(&this->list, &timer_eviction_list);
+		}
 	}
 
 	/*
@@ -262,6 +533,7 @@ int osmo_timers_update(void)
 	 * timer B from the A's callback, we continue with B in the next
 	 * iteration step, leading to an access-after-release.
 	 */
+	in_update = true;
 restart:
 	llist_for_each_entry(this, &timer_eviction_list, list) {
 		osmo_timer_del(this);
@@ -270,6 +542,7 @@ restart:
 		work = 1;
 		goto restart;
 	}
+	in_update = false;
 
 	return work;
 }
@@ -281,10 +554,82 @@ int osmo_timers_check(void)
 	struct rb_node *node;
 	int i = 0;
 
+	if (wheel)
+		return wheel->count;
+
 	for (node = rb_first(&timer_root); node; node = rb_next(node)) {
 		i++;
 	}
 	return i;
 }
 
+/*! Select the timer management back-end of the current thread
+ *  \param[in] backend back-end to switch to
+ *  \returns 0 on success; negative in case of error
+ *
+ * The rbtree back-end keeps timers sorted by their exact expiration time, at
+ * O(log n) cost for every add, delete and re-arm.  The timer wheel makes all
+ * of these O(1), at the expense of a granularity of one millisecond: timers
+ * never fire early, but up to one millisecond late.  It pays off with many
+ * thousands of timers which are constantly re-armed.
+ *
+ * Pending timers are transferred to the new back-end.  Must not be called
+ * from within a timer call-back.
+ */
+int osmo_timers_backend_set(enum osmo_timers_backend backend)
+{
+	struct osmo_timer_list *this, *tmp;
+	struct rb_node *node;
+	struct timeval now;
+	LLIST_HEAD(pending);
+	unsigned int i, j;
+
+	if (in_update)
+		return -EBUSY;
+
+	switch (backend) {
+	case OSMO_TIMERS_BACKEND_RBTREE:
+		if (!wheel)
+			return 0;
+		wheel_take_all(&pending);
+		talloc_free(wheel);
+		wheel = NULL;
+		llist_for_each_entry_safe(this, tmp, &pending, list) {
+			INIT_LLIST_HEAD(&this->list);
+			__add_timer(this);
+		}
+		return 0;
+	case OSMO_TIMERS_BACKEND_WHEEL:
+		if (wheel)
+			return 0;
+		wheel = talloc_zero(OTC_GLOBAL, struct timer_wheel);
+		if (!wheel)
+			return -ENOMEM;
+		for (i = 0; i < WHEEL_L0_SIZE; i++)
+			INIT_LLIST_HEAD(&wheel->l0[i]);
+		for (i = 0; i < WHEEL_LEVELS - 1; i++) {
+			for (j = 0; j < WHEEL_LN_SIZE; j++)
+				INIT_LLIST_HEAD(&wheel->ln[i][j]);
+		}
+		osmo_gettimeofday(&now, NULL);
+		wheel->clk = (uint64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+		while ((node = rb_first(&timer_root))) {
+			this = container_of(node, struct osmo_timer_list, node);
+			rb_erase(node, &timer_root);
+			INIT_LLIST_HEAD(&this->list);
+			__add_timer(this);
+		}
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/*! Get the timer management back-end of the current thread
+ *  \returns currently active back-end */
+enum osmo_timers_backend osmo_timers_backend_get(void)
+{
+	return wheel ? OSMO_TIMERS_BACKEND_WHEEL : OSMO_TIMERS_BACKEND_RBTREE;
+}
+
 /*! @} */
@@ -28,6 +28,7 @@
 #include <osmocom/core/utils.h>
 #include <osmocom/core/strrb.h>
 #include <osmocom/core/loggingrb.h>
+#include <osmocom/core/logging_bin.h>
 #include <osmocom/core/gsmtap.h>
 #include <osmocom/core/application.h>
 
@@ -381,6 +382,7 @@ DEFUN(logging_level,
 
 	tgt->categories[category].enabled = 1;
 	tgt->categories[category].loglevel = level;
+	log_level_cache_update();
 
 	RET_WITH_UNLOCK(CMD_SUCCESS);
 }
@@ -407,6 +409,7 @@ DEFUN(logging_level_set_all, logging_level_set_all_cmd,
 		cat->enabled = 1;
 		cat->loglevel = level;
 	}
+	log_level_cache_update();
 	RET_WITH_UNLOCK(CMD_SUCCESS);
 }
 
@@ -998,6 +1001,57 @@ DEFUN(cfg_no_log_alarms, cfg_no_log_alarms_cmd,
 	RET_WITH_UNLOCK(CMD_SUCCESS);
 }
 
+DEFUN(cfg_log_bin, cfg_log_bin_cmd,
+	"log binary-file FILENAME [<1-1024>]",
+	LOG_STR "Logging to a memory mapped binary file, see osmo-logbin-decode\n" "Filename\n"
+	"Size of the log record ring in MiB (default: 16)\n")
+{
+	const char *fname = argv[0];
+	size_t ring_size = argc > 1 ? (size_t)atoi(argv[1]) << 20 : LOG_BIN_RING_SIZE_DEFAULT;
+	struct log_target *tgt;
+
+	log_tgt_mutex_lock();
+	tgt = log_target_find(LOG_TGT_TYPE_BINARY, fname);
+	if (tgt && tgt->tgt_bin.ring_size != ring_size) {
+		log_target_destroy(tgt);
+		tgt = NULL;
+	}
+	if (!tgt) {
+		tgt = log_target_create_bin(fname, ring_size);
+		if (!tgt) {
+			vty_out(vty, "%% Unable to create binary file '%s'%s",
+				fname, VTY_NEWLINE);
+			RET_WITH_UNLOCK(CMD_WARNING);
+		}
+		log_add_target(tgt);
+	}
+
+	vty->index = tgt;
+	vty->node = CFG_LOG_NODE;
+
+	RET_WITH_UNLOCK(CMD_SUCCESS);
+}
+
+DEFUN(cfg_no_log_bin, cfg_no_log_bin_cmd,
+	"no log binary-file FILENAME",
+	NO_STR LOG_STR "Logging to a memory mapped binary file\n" "Filename\n")
+{
+	const char *fname = argv[0];
+	struct log_target *tgt;
+
+	log_tgt_mutex_lock();
+	tgt = log_target_find(LOG_TGT_TYPE_BINARY, fname);
+	if (!tgt) {
+		vty_out(vty, "%% No such binary log file '%s'%s",
+			fname, VTY_NEWLINE);
+		RET_WITH_UNLOCK(CMD_WARNING);
+	}
+
+	log_target_destroy(tgt);
+
+	RET_WITH_UNLOCK(CMD_SUCCESS);
+}
+
 static int config_write_log_single(struct vty *vty, struct log_target *tgt)
 {
 	char level_buf[128];
@@ -1040,6 +1094,13 @@ static int config_write_log_single(struct vty *vty, struct log_target *tgt)
 			tgt->sd_journal.raw ? " raw" : "",
 			VTY_NEWLINE);
 		break;
+	case LOG_TGT_TYPE_BINARY:
+		if (tgt->tgt_bin.ring_size == LOG_BIN_RING_SIZE_DEFAULT)
+			vty_out(vty, "log binary-file %s%s", tgt->tgt_bin.fname, VTY_NEWLINE);
+		else
+			vty_out(vty, "log binary-file %s %zu%s", tgt->tgt_bin.fname,
+				tgt->tgt_bin.ring_size >> 20, VTY_NEWLINE);
+		break;
 	}
 
 	vty_out(vty, " logging filter all %u%s",
@@ -1256,6 +1317,8 @@ void logging_vty_add_cmds()
 	install_lib_element(CONFIG_NODE, &cfg_no_log_stderr_cmd);
 	install_lib_element(CONFIG_NODE, &cfg_log_file_cmd);
 	install_lib_element(CONFIG_NODE, &cfg_no_log_file_cmd);
+	install_lib_element(CONFIG_NODE, &cfg_log_bin_cmd);
+	install_lib_element(CONFIG_NODE, &cfg_no_log_bin_cmd);
 	install_lib_element(CONFIG_NODE, &cfg_log_alarms_cmd);
 	install_lib_element(CONFIG_NODE, &cfg_no_log_alarms_cmd);
 #ifdef HAVE_SYSLOG_H
@@ -34,6 +34,7 @@
 #include <osmocom/core/counter.h>
 #include <osmocom/core/rate_ctr.h>
 #include <osmocom/core/stats_tcp.h>
+#include <osmocom/core/stats_prometheus.h>
 
 #define CFG_STATS_STR "Configure stats sub-system\n"
 #define CFG_REPORTER_STR "Configure a stats reporter\n"
@@ -391,6 +392,46 @@ DEFUN(cfg_stats_interval, cfg_stats_interval_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFUN(cfg_stats_dirty_tracking, cfg_stats_dirty_tracking_cmd,
+	"stats dirty-tracking",
+	CFG_STATS_STR "Only report the counters and stat items of groups that changed since the last report\n")
+{
+	osmo_stats_set_dirty_tracking(true);
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_no_stats_dirty_tracking, cfg_no_stats_dirty_tracking_cmd,
+	"no stats dirty-tracking",
+	NO_STR CFG_STATS_STR "Report the counters and stat items of all groups (default)\n")
+{
+	osmo_stats_set_dirty_tracking(false);
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_stats_prometheus_listen, cfg_stats_prometheus_listen_cmd,
+	"stats prometheus listen (A.B.C.D|X:X::X:X) <1-65535>",
+	CFG_STATS_STR "Configure the Prometheus / OpenMetrics exporter\n"
+	"Serve the metrics via HTTP on a TCP socket\n"
+	"Local IPv4 address\n" "Local IPv6 address\n" "Local TCP port\n")
+{
+	int rc = osmo_stats_prometheus_listen(tall_vty_ctx, argv[0], atoi(argv[1]));
+	if (rc < 0) {
+		vty_out(vty, "%% Unable to listen on %s:%s: %s%s",
+			argv[0], argv[1], strerror(-rc), VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_no_stats_prometheus, cfg_no_stats_prometheus_cmd,
+	"no stats prometheus",
+	NO_STR CFG_STATS_STR "Stop the Prometheus / OpenMetrics exporter\n")
+{
+	osmo_stats_prometheus_close();
+	return CMD_SUCCESS;
+}
+
 DEFUN(cfg_tcp_stats_interval, cfg_tcp_stats_interval_cmd,
 	"stats-tcp interval <0-65535>",
 	CFG_STATS_STR "Set the tcp socket stats polling interval\n"
@@ -726,6 +767,11 @@ static int config_write_stats(struct vty *vty)
 	struct osmo_stats_reporter *srep;
 
 	vty_out(vty, "stats interval %d%s", osmo_stats_config->interval, VTY_NEWLINE);
+	if (osmo_stats_config->dirty_tracking)
+		vty_out(vty, "stats dirty-tracking%s", VTY_NEWLINE);
+	if (osmo_stats_prometheus_config->local_ip)
+		vty_out(vty, "stats prometheus listen %s %u%s", osmo_stats_prometheus_config->local_ip,
+			osmo_stats_prometheus_config->local_port, VTY_NEWLINE);
 	if (osmo_tcp_stats_config->interval != TCP_STATS_DEFAULT_INTERVAL)
 		vty_out(vty, "stats-tcp interval %d%s", osmo_tcp_stats_config->interval, VTY_NEWLINE);
 	if (osmo_tcp_stats_config->batch_size != TCP_STATS_DEFAULT_BATCH_SIZE)
@@ -752,6 +798,10 @@ void osmo_stats_vty_add_cmds()
 	install_lib_element(CONFIG_NODE, &cfg_stats_reporter_log_cmd);
 	install_lib_element(CONFIG_NODE, &cfg_no_stats_reporter_log_cmd);
 	install_lib_element(CONFIG_NODE, &cfg_stats_interval_cmd);
+	install_lib_element(CONFIG_NODE, &cfg_stats_dirty_tracking_cmd);
+	install_lib_element(CONFIG_NODE, &cfg_no_stats_dirty_tracking_cmd);
+	install_lib_element(CONFIG_NODE, &cfg_stats_prometheus_listen_cmd);
+	install_lib_element(CONFIG_NODE, &cfg_no_stats_prometheus_cmd);
 	install_lib_element(CONFIG_NODE, &cfg_tcp_stats_interval_cmd);
 	install_lib_element(CONFIG_NODE, &cfg_tcp_stats_batch_size_cmd);
 
@@ -19,8 +19,14 @@
  */
 
 #include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/uio.h>
 #include <osmocom/core/write_queue.h>
+#include <osmocom/core/msgb_chain.h>
 #include <osmocom/core/logging.h>
+#include <osmocom/core/talloc.h>
 
 /*! \addtogroup write_queue
  *  @{
@@ -28,6 +34,129 @@
  *
  * \file write_queue.c */
 
+/* maximum number of segments of a msgb_chain written in one writev() call */
+#define WQUEUE_CHAIN_IOV_MAX 64
+
+/* maximum number of buffers gathered into one writev() in vectored mode */
+#if defined(IOV_MAX) && IOV_MAX < 1024
+#define WQUEUE_VEC_IOV_MAX IOV_MAX
+#else
+#define WQUEUE_VEC_IOV_MAX 1024
+#endif
+
+/* A msgb_chain in a write queue is carried by an empty msgb, which owns the chain.
+ * cb[0] marks the carrier, cb[1] refers to the chain. */
+static const char wqueue_chain_magic;
+
+static struct msgb_chain *wqueue_msgb_chain(const struct msgb *msg)
+{
+	if (msg->cb[0] != (unsigned long)&wqueue_chain_magic)
+		return NULL;
+	return (struct msgb_chain *)msg->cb[1];
+}
+
+/* write (the head of) a msgb_chain with a single writev(); returns -EAGAIN if anything is left to write */
+static int wqueue_write_chain(struct osmo_fd *fd, struct msgb_chain *chain)
+{
+	struct iovec iov[WQUEUE_CHAIN_IOV_MAX];
+	struct msgb_chain_seg *seg;
+	unsigned int iovcnt = 0;
+	ssize_t rc;
+
+	llist_for_each_entry(seg, &chain->segs, list) {
+		if (iovcnt == ARRAY_SIZE(iov))
+			break;
+		iov[iovcnt].iov_base = seg->data;
+		iov[iovcnt].iov_len = seg->len;
+		iovcnt++;
+	}
+
+	rc = writev(fd->fd, iov, iovcnt);
+	if (rc < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+			return -EAGAIN;
+		LOGP(DLGLOBAL, LOGL_ERROR, "wqueue(fd=%d): error writing msgb_chain: %s\n",
+		     fd->fd, strerror(errno));
+		return -errno;
+	}
+
+	msgb_chain_pull(chain, rc);
+	return msgb_chain_length(chain) ? -EAGAIN : 0;
+}
+
+/* write the head of the queue with a single writev(): free the msgbs written
+ * completely, and trim the one written partially.  Returns -ENODATA if writev()
+ * wrote nothing, so that write_cb can handle the head of the queue, 0 otherwise. */
+static int wqueue_write_vectored(struct osmo_wqueue *queue)
+{
+	struct iovec iov[WQUEUE_VEC_IOV_MAX];
+	struct msgb *msg, *msg2;
+	unsigned int iovcnt = 0;
+	size_t left;
+	ssize_t rc;
+
+	if (llist_empty(&queue->msg_queue))
+		return 0;
+
+	llist_for_each_entry(msg, &queue->msg_queue, list) {
+		struct msgb_chain *chain = wqueue_msgb_chain(msg);
+
+		if (iovcnt == ARRAY_SIZE(iov))
+			break;
+		if (chain) {
+			struct msgb_chain_seg *seg;
+
+			llist_for_each_entry(seg, &chain->segs, list) {
+				if (iovcnt == ARRAY_SIZE(iov))
+					break;
+				iov[iovcnt].iov_base = seg->data;
+				iov[iovcnt].iov_len = seg->len;
+				iovcnt++;
+			}
+		} else {
+			iov[iovcnt].iov_base = msgb_data(msg);
+			iov[iovcnt].iov_len = msgb_length(msg);
+			iovcnt++;
+		}
+	}
+
+	rc = writev(queue->bfd.fd, iov, iovcnt);
+	if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		return 0;
+	if (rc == 0 && queue->write_cb)
+		return -ENODATA;
+	if (rc <= 0) {
+		/* Not logged, as this may be the queue of a log target, and the error (e.g.
+		 * ENOSPC) persistent.  Drop all of the queue instead of one msgb per event. */
+		queue->tx_dropped += queue->current_length;
+		osmo_wqueue_clear(queue);
+		return 0;
+	}
+
+	queue->tx_bytes += rc;
+	queue->tx_batches++;
+
+	left = rc;
+	llist_for_each_entry_safe(msg, msg2, &queue->msg_queue, list) {
+		struct msgb_chain *chain = wqueue_msgb_chain(msg);
+		size_t len = chain ? msgb_chain_length(chain) : msgb_length(msg);
+
+		if (left < len) {
+			if (chain)
+				msgb_chain_pull(chain, left);
+			else
+				msgb_pull(msg, left);
+			break;
+		}
+		left -= len;
+		llist_del(&msg->list);
+		queue->current_length--;
+		queue->tx_msgs++;
+		msgb_free(msg);
+	}
+	return 0;
+}
+
 /*! Select loop function for write queue handling
  *  \param[in] fd osmocom file descriptor
  *  \param[in] what bit-mask of events that have happened
@@ -35,6 +164,14 @@
  *
  * This function is provided so that it can be registered with the
  * select loop abstraction code (\ref osmo_fd::cb).
+ *
+ * Each writable event dequeues one msgb and passes it to \ref
+ * osmo_wqueue::write_cb.  In vectored mode (\ref osmo_wqueue::vectored), it
+ * writes as many queued msgbs as possible with one writev() instead, up to
+ * 1024 of them, and keeps the rest of a partially written msgb at the head
+ * of the queue.  Should writev() fail, all queued msgbs are dropped; should
+ * it write nothing, the head of the queue is passed to write_cb, which may
+ * e.g. close the connection.
  */
 int osmo_wqueue_bfd_cb(struct osmo_fd *fd, unsigned int what)
 {
@@ -58,12 +195,22 @@ int osmo_wqueue_bfd_cb(struct osmo_fd *fd, unsigned int what)
 	if (what & OSMO_FD_WRITE) {
 		struct msgb *msg;
 
-		fd->when &= ~OSMO_FD_WRITE;
+		osmo_fd_write_disable(fd);
+
+		if (queue->vectored && wqueue_write_vectored(queue) != -ENODATA) {
+			if (!llist_empty(&queue->msg_queue))
+				osmo_fd_write_enable(fd);
+			return 0;
+		}
 
 		msg = msgb_dequeue_count(&queue->msg_queue, &queue->current_length);
 		/* the queue might have been emptied */
 		if (msg) {
-			rc = queue->write_cb(fd, msg);
+			struct msgb_chain *chain = wqueue_msgb_chain(msg);
+			if (chain)
+				rc = wqueue_write_chain(fd, chain);
+			else
+				rc = queue->write_cb(fd, msg);
 			if (rc == -EBADF) {
 				msgb_free(msg);
 				goto err_badfd;
@@ -75,7 +222,7 @@ int osmo_wqueue_bfd_cb(struct osmo_fd *fd, unsigned int what)
 				msgb_free(msg);
 
 			if (!llist_empty(&queue->msg_queue))
-				fd->when |= OSMO_FD_WRITE;
+				osmo_fd_write_enable(fd);
 		}
 	}
 
@@ -95,6 +242,11 @@ void osmo_wqueue_init(struct osmo_wqueue *queue, int max_length)
 	queue->read_cb = NULL;
 	queue->write_cb = NULL;
 	queue->except_cb = NULL;
+	queue->vectored = false;
+	queue->tx_bytes = 0;
+	queue->tx_batches = 0;
+	queue->tx_msgs = 0;
+	queue->tx_dropped = 0;
 	queue->bfd.cb = osmo_wqueue_bfd_cb;
 	INIT_LLIST_HEAD(&queue->msg_queue);
 }
@@ -110,7 +262,7 @@ int osmo_wqueue_enqueue_quiet(struct osmo_wqueue *queue, struct msgb *data)
 		return -ENOSPC;
 
 	msgb_enqueue_count(&queue->msg_queue, data, &queue->current_length);
-	queue->bfd.when |= OSMO_FD_WRITE;
+	osmo_fd_write_enable(&queue->bfd);
 
 	return 0;
 }
@@ -131,6 +283,38 @@ int osmo_wqueue_enqueue(struct osmo_wqueue *queue, struct msgb *data)
 	return osmo_wqueue_enqueue_quiet(queue, data);
 }
 
+/*! Enqueue a \ref msgb_chain into a write queue
+ *  \param[in] queue Write queue to be used
+ *  \param[in] chain to-be-enqueued msgb chain; ownership passes to the queue
+ *  \returns 0 on success; negative on error (CHAIN NOT FREED IN CASE OF ERROR).
+ *
+ * The chain is written with writev() directly from its segments, without
+ * calling \ref osmo_wqueue::write_cb and without copying the payload.  A
+ * partial write keeps the rest of the chain at the head of the queue.  It
+ * can be mixed with msgbs enqueued by osmo_wqueue_enqueue(), the queue
+ * order is retained.  Chains of more than 64 segments are written with
+ * several writev() calls, so they should only be used on stream fds.
+ */
+int osmo_wqueue_enqueue_chain(struct osmo_wqueue *queue, struct msgb_chain *chain)
+{
+	struct msgb *msg;
+
+	if (queue->current_length >= queue->max_length) {
+		LOGP(DLGLOBAL, LOGL_ERROR,
+			"wqueue(%p) is full. Rejecting msgb_chain\n", queue);
+		return -ENOSPC;
+	}
+
+	msg = msgb_alloc(0, "wqueue msgb_chain");
+	if (!msg)
+		return -ENOMEM;
+	talloc_steal(msg, chain);
+	msg->cb[0] = (unsigned long)&wqueue_chain_magic;
+	msg->cb[1] = (unsigned long)chain;
+
+	return osmo_wqueue_enqueue_quiet(queue, msg);
+}
+
 /*! Clear a \ref osmo_wqueue
  *  \param[in] queue Write queue to be cleared
  *
@@ -144,7 +328,7 @@ void osmo_wqueue_clear(struct osmo_wqueue *queue)
 	}
 
 	queue->current_length = 0;
-	queue->bfd.when &= ~OSMO_FD_WRITE;
+	osmo_fd_write_disable(&queue->bfd);
 }
 
 /*! @} */
@@ -0,0 +1,102 @@
+/* Benchmark of the batch generation of A5/x cipher streams */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Usage: a5_bench [num_pairs] [iterations]
+ *
+ * Generate the downlink and uplink cipher streams of num_pairs random
+ * (key, frame number) pairs with A5/1 to A5/4, once one by one with
+ * osmo_a5() and once with osmo_a5_batch() for each available kernel, and
+ * report the time per pair. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/gsm/a5.h>
+#include <osmocom/gsm/gsm0502.h>
+
+#define MAX_PAIRS 4096
+
+static uint8_t keys[MAX_PAIRS][16];
+static const uint8_t *keyp[MAX_PAIRS];
+static uint32_t fns[MAX_PAIRS];
+static ubit_t dl[MAX_PAIRS][114], ul[MAX_PAIRS][114];
+static ubit_t *dlp[MAX_PAIRS], *ulp[MAX_PAIRS];
+
+static double elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+int main(int argc, char **argv)
+{
+	static const enum osmo_a5_batch_kernel kernels[] = {
+		OSMO_A5_BATCH_KERNEL_GENERIC,
+		OSMO_A5_BATCH_KERNEL_VEC128,
+		OSMO_A5_BATCH_KERNEL_AVX2,
+	};
+	unsigned int num = argc > 1 ? atoi(argv[1]) : 256;
+	unsigned int iterations = argc > 2 ? atoi(argv[2]) : 100;
+	struct timespec start;
+	double t_single, t;
+	unsigned int i, j, k;
+	int n;
+
+	OSMO_ASSERT(num > 0 && num <= MAX_PAIRS);
+	for (i = 0; i < num; i++) {
+		for (j = 0; j < sizeof(keys[i]); j++)
+			keys[i][j] = rand();
+		keyp[i] = keys[i];
+		fns[i] = rand() % GSM_TDMA_HYPERFRAME;
+		dlp[i] = dl[i];
+		ulp[i] = ul[i];
+	}
+
+	for (n = 1; n <= 4; n++) {
+		printf("A5/%d, %u pairs:\n", n, num);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < iterations; i++) {
+			for (j = 0; j < num; j++)
+				osmo_a5(n, keys[j], fns[j], dl[j], ul[j]);
+		}
+		t_single = elapsed_ns(&start) / iterations / num;
+		printf("  %-10s %8.1f ns/pair\n", "osmo_a5", t_single);
+
+		for (k = 0; k < ARRAY_SIZE(kernels); k++) {
+			if (osmo_a5_batch_kernel_set(kernels[k]) < 0)
+				continue;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			for (i = 0; i < iterations; i++)
+				OSMO_ASSERT(osmo_a5_batch(n, keyp, fns, dlp, ulp, num) == 0);
+			t = elapsed_ns(&start) / iterations / num;
+			printf("  %-10s %8.1f ns/pair (%.2fx)\n",
+			       get_value_string(osmo_a5_batch_kernel_names, kernels[k]), t, t_single / t);
+			/* A5/3&4 don't depend on the kernel */
+			if (n > 2)
+				break;
+		}
+	}
+
+	return 0;
+}
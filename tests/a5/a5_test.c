@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -7,6 +8,7 @@
 #include <osmocom/core/bits.h>
 #include <osmocom/core/utils.h>
 #include <osmocom/gsm/a5.h>
+#include <osmocom/gsm/gsm0502.h>
 
 // make compiler happy
 void _a5_3(const uint8_t *key, uint32_t fn, ubit_t *dl, ubit_t *ul, bool fn_correct);
@@ -81,6 +83,174 @@ static inline bool test_a54(const char * kc, uint32_t count, const char * block1
 	return print_a5(4, 8, "DL", dlout, block1) & print_a5(4, 8, "UL", ulout, block2);
 }
 
+/* test vectors from 3GPP TS 55.217 and TS 55.218 */
+static const struct a5_34_vector {
+	int n;
+	const char *kc;
+	uint32_t count;
+	const char *dl;
+	const char *ul;
+} a5_34_vectors[] = {
+	{ 3, "2BD6459F82C5BC00", 0x24F20F, "889EEAAF9ED1BA1ABBD8436232E440", "5CA3406AA244CF69CF047AADA2DF40" },
+	{ 3, "952C49104881FF48", 0x061272, "FB4D5FBCEE13A33389285686E9A5C0", "25090378E0540457C57E367662E440" },
+	{ 3, "EFA8B2229E720C2A", 0x33FD3F, "0E4015755A336469C3DD8680E30340", "6F10669E2B4E18B042431A28E47F80" },
+	{ 3, "952C49104881FF48", 0x061527, "AB7DB38A573A325DAA76E4CB800A40", "4C4B594FEA9D00FE8978B7B7BC1080" },
+	{ 3, "3451F23A43BD2C87", 0x0E418C, "75F7C4C51560905DFBA05E46FB54C0", "192C95353CDF979E054186DF15BF00" },
+	{ 3, "CAA2639BE82435CF", 0x2FF229, "301437E4D4D6565D4904C631606EC0", "F0A3B8795E264D3E1A82F684353DC0" },
+	{ 3, "7AE67E87400B9FA6", 0x2F24E5, "F794290FEF643D2EA348A7796A2100", "CB6FA6C6B8A705AF9FEFE975818500" },
+	{ 3, "58AF69935540698B", 0x05446B, "749CA4E6B691E5A598C461D5FE4740", "31C9E444CD04677ADAA8A082ADBC40" },
+	{ 3, "017F81E5F236FE62", 0x156B26, "2A6976761E60CC4E8F9F52160276C0", "A544D8475F2C78C35614128F1179C0" },
+	{ 3, "1ACA8B448B767B39", 0x0BC3B5, "A4F70DC5A2C9707F5FA1C60EB10640", "7780B597B328C1400B5C74823E8500" },
+	{ 4, "3D43C388C9581E337FF1F97EB5C1F85E", 0x35D2CF, "A2FE3034B6B22CC4E33C7090BEC340", "170D7497432FF897B91BE8AECBA880" },
+	{ 4, "A4496A64DF4F399F3B4506814A3E07A1", 0x212777, "89CDEE360DF9110281BCF57755A040", "33822C0C779598C9CBFC49183AF7C0" },
+};
+
+static const enum osmo_a5_batch_kernel kernels[] = {
+	OSMO_A5_BATCH_KERNEL_GENERIC,
+	OSMO_A5_BATCH_KERNEL_VEC128,
+	OSMO_A5_BATCH_KERNEL_AVX2,
+};
+
+#define BATCH_MAX 600
+
+static uint8_t batch_keys[BATCH_MAX][16];
+static const uint8_t *batch_keyp[BATCH_MAX];
+static uint32_t batch_fns[BATCH_MAX];
+static ubit_t batch_dl[BATCH_MAX][114], batch_ul[BATCH_MAX][114];
+static ubit_t *batch_dlp[BATCH_MAX], *batch_ulp[BATCH_MAX];
+
+/* Frame number of which the 22 bit count is the given one, or -1 if there is none */
+static int64_t fn_of_count(uint32_t count)
+{
+	uint32_t fn;
+
+	for (fn = (count >> 11) * 26 * 51; fn < ((count >> 11) + 1) * 26 * 51; fn++) {
+		if (osmo_a5_fn_count(fn) == count)
+			return fn;
+	}
+	return -1;
+}
+
+static void batch_random_pairs(unsigned int num)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < num; i++) {
+		for (j = 0; j < 16; j++)
+			batch_keys[i][j] = rand();
+		batch_keyp[i] = batch_keys[i];
+		batch_fns[i] = rand() % GSM_TDMA_HYPERFRAME;
+		batch_dlp[i] = batch_dl[i];
+		batch_ulp[i] = batch_ul[i];
+	}
+}
+
+/* Known answers from a batch: the vectors above for A5/3&4, and those of main()
+ * for A5/1&2, as one pair among random ones */
+static void test_batch_kat(void)
+{
+	unsigned int i, k, num;
+	int n;
+
+	printf("%s\n", __func__);
+
+	for (n = 3; n <= 4; n++) {
+		num = 0;
+		for (i = 0; i < ARRAY_SIZE(a5_34_vectors); i++) {
+			const struct a5_34_vector *v = &a5_34_vectors[i];
+			int64_t f = fn_of_count(v->count);
+			if (v->n != n || f < 0)
+				continue;
+			osmo_hexparse(v->kc, batch_keys[num], n == 3 ? 8 : 16);
+			batch_keyp[num] = batch_keys[num];
+			batch_fns[num] = f;
+			batch_dlp[num] = batch_dl[num];
+			batch_ulp[num] = batch_ul[num];
+			num++;
+		}
+		OSMO_ASSERT(osmo_a5_batch(n, batch_keyp, batch_fns, batch_dlp, batch_ulp, num) == 0);
+
+		num = 0;
+		for (i = 0; i < ARRAY_SIZE(a5_34_vectors); i++) {
+			const struct a5_34_vector *v = &a5_34_vectors[i];
+			if (v->n != n || fn_of_count(v->count) < 0)
+				continue;
+			print_a5(n, 8, "DL", batch_dl[num], v->dl);
+			print_a5(n, 8, "UL", batch_ul[num], v->ul);
+			num++;
+		}
+	}
+
+	for (k = 0; k < ARRAY_SIZE(kernels); k++) {
+		if (osmo_a5_batch_kernel_set(kernels[k]) < 0)
+			continue;
+		for (n = 1; n <= 2; n++) {
+			ubit_t exp[114];
+
+			batch_random_pairs(100);
+			memcpy(batch_keys[77], key, sizeof(key));
+			batch_fns[77] = fn;
+			OSMO_ASSERT(osmo_a5_batch(n, batch_keyp, batch_fns, batch_dlp, batch_ulp, 100) == 0);
+
+			osmo_pbit2ubit(exp, &dl[15 * n], 114);
+			OSMO_ASSERT(memcmp(batch_dl[77], exp, 114) == 0);
+			osmo_pbit2ubit(exp, &ul[15 * n], 114);
+			OSMO_ASSERT(memcmp(batch_ul[77], exp, 114) == 0);
+		}
+	}
+	OSMO_ASSERT(osmo_a5_batch_kernel_set(OSMO_A5_BATCH_KERNEL_AUTO) == 0);
+	printf("A5/1 - A5/2 batch: OK\n");
+}
+
+/* Batches of random pairs must give the same cipher streams as osmo_a5(),
+ * with each kernel, for batch sizes around multiples of its lanes, and with
+ * streams not requested */
+static void test_batch_random(void)
+{
+	static const unsigned int nums[] = { 1, 63, 64, 65, 127, 128, 129, 255, 256, 257, 513 };
+	ubit_t exp_dl[114], exp_ul[114];
+	unsigned int i, j, k;
+	int n;
+
+	printf("%s\n", __func__);
+
+	for (k = 0; k < ARRAY_SIZE(kernels); k++) {
+		if (osmo_a5_batch_kernel_set(kernels[k]) < 0)
+			continue;
+		for (n = 0; n <= 4; n++) {
+			for (j = 0; j < ARRAY_SIZE(nums); j++) {
+				batch_random_pairs(nums[j]);
+				memset(batch_dl, 0xff, sizeof(batch_dl));
+				memset(batch_ul, 0xff, sizeof(batch_ul));
+				/* leave out some of the streams */
+				for (i = 0; i < nums[j]; i += 7)
+					batch_dlp[i] = NULL;
+				for (i = 3; i < nums[j]; i += 5)
+					batch_ulp[i] = NULL;
+
+				OSMO_ASSERT(osmo_a5_batch(n, batch_keyp, batch_fns, batch_dlp,
+							  j % 2 ? batch_ulp : NULL, nums[j]) == 0);
+
+				for (i = 0; i < nums[j]; i++) {
+					OSMO_ASSERT(osmo_a5(n, batch_keys[i], batch_fns[i], exp_dl, exp_ul) == 0);
+					if (batch_dlp[i]) {
+						OSMO_ASSERT(memcmp(batch_dl[i], exp_dl, 114) == 0);
+					} else {
+						OSMO_ASSERT(batch_dl[i][0] == 0xff);
+					}
+					if (j % 2 && batch_ulp[i]) {
+						OSMO_ASSERT(memcmp(batch_ul[i], exp_ul, 114) == 0);
+					} else {
+						OSMO_ASSERT(batch_ul[i][0] == 0xff);
+					}
+				}
+			}
+		}
+	}
+	OSMO_ASSERT(osmo_a5_batch_kernel_set(OSMO_A5_BATCH_KERNEL_AUTO) == 0);
+	OSMO_ASSERT(osmo_a5_batch(5, batch_keyp, batch_fns, batch_dlp, batch_ulp, 1) == -ENOTSUP);
+	printf("osmo_a5_batch() == osmo_a5(): OK\n");
+}
 
 int main(int argc, char **argv)
 {
@@ -125,19 +295,16 @@ int main(int argc, char **argv)
 		}
 	}
 
-// test vectors from 3GPP TS 55.217 and TS 55.218
-	test_a53("2BD6459F82C5BC00", 0x24F20F, "889EEAAF9ED1BA1ABBD8436232E440", "5CA3406AA244CF69CF047AADA2DF40");
-	test_a53("952C49104881FF48", 0x061272, "FB4D5FBCEE13A33389285686E9A5C0", "25090378E0540457C57E367662E440");
-	test_a53("EFA8B2229E720C2A", 0x33FD3F, "0E4015755A336469C3DD8680E30340", "6F10669E2B4E18B042431A28E47F80");
-	test_a53("952C49104881FF48", 0x061527, "AB7DB38A573A325DAA76E4CB800A40", "4C4B594FEA9D00FE8978B7B7BC1080");
-	test_a53("3451F23A43BD2C87", 0x0E418C, "75F7C4C51560905DFBA05E46FB54C0", "192C95353CDF979E054186DF15BF00");
-	test_a53("CAA2639BE82435CF", 0x2FF229, "301437E4D4D6565D4904C631606EC0", "F0A3B8795E264D3E1A82F684353DC0");
-	test_a53("7AE67E87400B9FA6", 0x2F24E5, "F794290FEF643D2EA348A7796A2100", "CB6FA6C6B8A705AF9FEFE975818500");
-	test_a53("58AF69935540698B", 0x05446B, "749CA4E6B691E5A598C461D5FE4740", "31C9E444CD04677ADAA8A082ADBC40");
-	test_a53("017F81E5F236FE62", 0x156B26, "2A6976761E60CC4E8F9F52160276C0", "A544D8475F2C78C35614128F1179C0");
-	test_a53("1ACA8B448B767B39", 0x0BC3B5, "A4F70DC5A2C9707F5FA1C60EB10640", "7780B597B328C1400B5C74823E8500");
-	test_a54("3D43C388C9581E337FF1F97EB5C1F85E", 0x35D2CF, "A2FE3034B6B22CC4E33C7090BEC340", "170D7497432FF897B91BE8AECBA880");
-	test_a54("A4496A64DF4F399F3B4506814A3E07A1", 0x212777, "89CDEE360DF9110281BCF57755A040", "33822C0C779598C9CBFC49183AF7C0");
+	for (i = 0; i < ARRAY_SIZE(a5_34_vectors); i++) {
+		const struct a5_34_vector *v = &a5_34_vectors[i];
+		if (v->n == 3)
+			test_a53(v->kc, v->count, v->dl, v->ul);
+		else
+			test_a54(v->kc, v->count, v->dl, v->ul);
+	}
+
+	test_batch_kat();
+	test_batch_random();
 
 	return 0;
 }
@@ -0,0 +1,201 @@
+/* Benchmark of reading and writing bit vector fields */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Usage: bitvec_bench [iterations]
+ *
+ * Read and write a sequence of fields of random sizes through a 23 byte
+ * MAC block, as CSN.1 and rest octets coding does, with
+ *  - copies of bitvec_read_field() / bitvec_write_field() as they used to
+ *    be implemented, bit by bit,
+ *  - bitvec_read_field() / bitvec_write_field(),
+ *  - bitvec_cursor_read() / bitvec_cursor_write(),
+ * once for fields of 1..8 bits and once for fields of 1..64 bits, and
+ * report the time per field. */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <osmocom/core/bitvec.h>
+#include <osmocom/core/utils.h>
+
+#define MAX_FIELDS 184
+
+static uint8_t data[23];
+static struct bitvec bv = { .data = data, .data_len = sizeof(data) };
+static unsigned int lens[MAX_FIELDS];
+static uint64_t vals[MAX_FIELDS];
+static unsigned int num_fields;
+
+/* keeps the compiler from optimizing the reads away */
+static volatile uint64_t sink;
+
+static double elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+/* fields of 1..max_len bits filling the block */
+static void gen_fields(unsigned int max_len)
+{
+	unsigned int bits = 0, len;
+
+	num_fields = 0;
+	while (bits < sizeof(data) * 8) {
+		len = 1 + rand() % max_len;
+		len = OSMO_MIN(len, sizeof(data) * 8 - bits);
+		lens[num_fields] = len;
+		vals[num_fields] = ((uint64_t)rand() << 32) ^ rand();
+		bits += len;
+		num_fields++;
+	}
+}
+
+/* bitvec_write_field() as it used to be implemented */
+static int serial_write_field(struct bitvec *bv, unsigned int *write_index, uint64_t val, unsigned int len)
+{
+	unsigned int i;
+	int rc;
+
+	bv->cur_bit = *write_index;
+	for (i = 0; i < len; i++) {
+		rc = bitvec_set_bit(bv, (val >> (len - i - 1)) & 1);
+		if (rc)
+			return rc;
+	}
+	*write_index += len;
+	return 0;
+}
+
+/* bitvec_read_field() as it used to be implemented */
+static uint64_t serial_read_field(struct bitvec *bv, unsigned int *read_index, unsigned int len)
+{
+	unsigned int i;
+	uint64_t ui = 0;
+
+	if (len && (*read_index + len - 1) / 8 >= bv->data_len) {
+		errno = EOVERFLOW;
+		return 0;
+	}
+
+	bv->cur_bit = *read_index;
+	errno = 0;
+
+	for (i = 0; i < len; i++) {
+		unsigned int bytenum = bv->cur_bit / 8;
+		unsigned int bitnum = 7 - (bv->cur_bit % 8);
+
+		if (bv->data[bytenum] & (1 << bitnum))
+			ui |= ((uint64_t)1 << (len - i - 1));
+		bv->cur_bit++;
+	}
+	*read_index += len;
+	return ui;
+}
+
+static void serial_write(void)
+{
+	unsigned int i, pos = 0;
+
+	for (i = 0; i < num_fields; i++)
+		serial_write_field(&bv, &pos, vals[i], lens[i]);
+}
+
+static void serial_read(void)
+{
+	unsigned int i, pos = 0;
+
+	for (i = 0; i < num_fields; i++)
+		sink = serial_read_field(&bv, &pos, lens[i]);
+}
+
+static void field_write(void)
+{
+	unsigned int i, pos = 0;
+
+	for (i = 0; i < num_fields; i++)
+		bitvec_write_field(&bv, &pos, vals[i], lens[i]);
+}
+
+static void field_read(void)
+{
+	unsigned int i, pos = 0;
+
+	for (i = 0; i < num_fields; i++)
+		sink = bitvec_read_field(&bv, &pos, lens[i]);
+}
+
+static void cursor_write(void)
+{
+	struct bitvec_cursor c;
+	unsigned int i;
+
+	bitvec_cursor_init(&c, &bv, 0);
+	for (i = 0; i < num_fields; i++)
+		bitvec_cursor_write(&c, vals[i], lens[i]);
+	OSMO_ASSERT(c.err == 0);
+}
+
+static void cursor_read(void)
+{
+	struct bitvec_cursor c;
+	unsigned int i;
+
+	bitvec_cursor_init(&c, &bv, 0);
+	for (i = 0; i < num_fields; i++)
+		sink = bitvec_cursor_read(&c, lens[i]);
+	OSMO_ASSERT(c.err == 0);
+}
+
+static void bench(const char *name, void (*fn)(void), unsigned int iterations)
+{
+	struct timespec start;
+	unsigned int i;
+	double t;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < iterations; i++)
+		fn();
+	t = elapsed_ns(&start) / iterations / num_fields;
+	printf("  %-14s %6.2f ns/field\n", name, t);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+	static const unsigned int max_lens[] = { 8, 64 };
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(max_lens); i++) {
+		gen_fields(max_lens[i]);
+		printf("%u fields of 1..%u bits:\n", num_fields, max_lens[i]);
+		bench("bit-serial wr", serial_write, iterations);
+		bench("write_field", field_write, iterations);
+		bench("cursor_write", cursor_write, iterations);
+		bench("bit-serial rd", serial_read, iterations);
+		bench("read_field", field_read, iterations);
+		bench("cursor_read", cursor_read, iterations);
+	}
+
+	return 0;
+}
@@ -262,6 +262,85 @@ static void test_bitvec_read_field(void)
 	_bitvec_read_field(8 * 8, 16); /* 16 bits past */
 }
 
+/* bit-serial reference of bitvec_cursor_read() */
+static uint64_t read_ref(const struct bitvec *bv, unsigned int bitnr, unsigned int len)
+{
+	uint64_t v = 0;
+	unsigned int i;
+
+	for (i = 0; i < len; i++)
+		v = (v << 1) | (bitvec_get_bit_pos(bv, bitnr + i) == ONE);
+	return v;
+}
+
+static void test_cursor(void)
+{
+	uint8_t data[23], ref[23];
+	struct bitvec bv = { .data_len = sizeof(data), .data = data };
+	struct bitvec bv_ref = { .data_len = sizeof(ref), .data = ref };
+	struct bitvec_cursor c;
+	unsigned int i, j;
+
+	printf("\n%s\n", __func__);
+
+	/* write fields of all sizes at all offsets, compare with bitvec_set_bit() */
+	srand(42);
+	for (i = 0; i < 2000; i++) {
+		unsigned int bitnr = rand() % (sizeof(data) * 8);
+		unsigned int len = rand() % 65;
+		uint64_t val = ((uint64_t)rand() << 33) ^ ((uint64_t)rand() << 11) ^ rand();
+		bool lh = rand() & 1;
+		int rc;
+
+		for (j = 0; j < sizeof(data); j++)
+			data[j] = ref[j] = rand();
+
+		bitvec_cursor_init(&c, &bv, bitnr);
+		rc = lh ? bitvec_cursor_write_lh(&c, val, len) : bitvec_cursor_write(&c, val, len);
+		if (bitnr + len > sizeof(data) * 8) {
+			OSMO_ASSERT(rc == -EOVERFLOW && c.err == -EOVERFLOW && c.pos == bitnr);
+			continue;
+		}
+		OSMO_ASSERT(rc == 0 && c.err == 0 && c.pos == bitnr + len);
+
+		for (j = 0; j < len; j++) {
+			bool b = (val >> (len - 1 - j)) & 1;
+			bitvec_set_bit_pos(&bv_ref, bitnr + j, lh ? (b ? H : L) : b);
+		}
+		OSMO_ASSERT(!memcmp(data, ref, sizeof(data)));
+
+		bitvec_cursor_init(&c, &bv, bitnr);
+		OSMO_ASSERT(bitvec_cursor_read(&c, len) == read_ref(&bv_ref, bitnr, len));
+		OSMO_ASSERT(c.err == 0 && c.pos == bitnr + len);
+	}
+
+	/* a sequence of fields, as when encoding rest octets */
+	memset(data, 0, sizeof(data));
+	bitvec_cursor_init(&c, &bv, 0);
+	bitvec_cursor_write(&c, 0x5, 3);
+	bitvec_cursor_write_lh(&c, 1, 1);
+	bitvec_cursor_write(&c, 0xdeadbeefcafe, 48);
+	bitvec_cursor_write(&c, 0x123456789abcdef0ULL, 64);
+	bitvec_cursor_fill(&c, 9, ONE);
+	bitvec_cursor_fill(&c, bitvec_cursor_tailroom(&c), L);
+	printf("written: %s, err=%d\n", osmo_hexdump_nospc(data, sizeof(data)), c.err);
+
+	bitvec_cursor_init(&c, &bv, 0);
+	printf("read: %" PRIx64, bitvec_cursor_read(&c, 3));
+	printf(" %" PRIx64, bitvec_cursor_read(&c, 1));
+	printf(" %" PRIx64, bitvec_cursor_read(&c, 48));
+	printf(" %" PRIx64, bitvec_cursor_read(&c, 64));
+	printf(" %" PRIx64 "\n", bitvec_cursor_read(&c, 9));
+	OSMO_ASSERT(c.err == 0);
+
+	/* reading past the end fails, the error sticks */
+	printf("past the end: %" PRIx64, bitvec_cursor_read(&c, bitvec_cursor_tailroom(&c) + 1));
+	printf(" err=%d", c.err);
+	printf(", then: %" PRIx64 " err=%d\n", bitvec_cursor_read(&c, 8), c.err);
+	OSMO_ASSERT(bitvec_cursor_write(&c, 0, 65) == -E2BIG);
+	OSMO_ASSERT(c.err == -EOVERFLOW);
+}
+
 int main(int argc, char **argv)
 {
 	struct bitvec bv;
@@ -374,6 +453,8 @@ int main(int argc, char **argv)
 	printf("\ntest bitvec_read_field():\n");
 	test_bitvec_read_field();
 
+	test_cursor();
+
 	printf("\nbitvec ok.\n");
 	return 0;
 }
@@ -0,0 +1,125 @@
+/* Benchmark of the batch decoding of GSM TS 05.03 blocks */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Usage: batch_bench [max_threads] [iterations]
+ *
+ * Decode the blocks of 64 timeslots (8 TRX x 8 TS), half of them xCCH and
+ * half of them TCH/FS, once one by one with gsm0503_xcch_decode() and
+ * gsm0503_tch_fr_decode(), and once with gsm0503_decode_batch() for each
+ * number of worker threads up to max_threads, and report the time per
+ * batch. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/coding/gsm0503_coding.h>
+#include <osmocom/coding/gsm0503_batch.h>
+
+#define NUM_JOBS 64
+
+static sbit_t bursts[NUM_JOBS][116 * 8];
+static uint8_t data[NUM_JOBS][33];
+static struct gsm0503_decode_job jobs[NUM_JOBS];
+
+static double elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+static void gen_jobs(void)
+{
+	ubit_t ubits[116 * 8];
+	uint8_t l2[33];
+	unsigned int i, j;
+
+	for (i = 0; i < NUM_JOBS; i++) {
+		for (j = 0; j < sizeof(l2); j++)
+			l2[j] = rand();
+		jobs[i].bursts = bursts[i];
+		jobs[i].data = data[i];
+		if (i % 2) {
+			jobs[i].chan = GSM0503_DECODE_XCCH;
+			OSMO_ASSERT(gsm0503_xcch_encode(ubits, l2) == 0);
+		} else {
+			jobs[i].chan = GSM0503_DECODE_TCH_FR;
+			jobs[i].u.tch_fr.net_order = 1;
+			l2[0] = 0xd0 | (l2[0] & 0x0f);
+			OSMO_ASSERT(gsm0503_tch_fr_encode(ubits, l2, 33, 1) == 0);
+		}
+		osmo_ubit2sbit(bursts[i], ubits, sizeof(ubits));
+		/* some bit errors */
+		for (j = 0; j < sizeof(ubits); j += 1 + rand() % 64)
+			bursts[i][j] = -bursts[i][j] / 2;
+	}
+}
+
+static void decode_single(void)
+{
+	struct gsm0503_decode_job *j;
+
+	for (j = jobs; j < jobs + NUM_JOBS; j++) {
+		if (j->chan == GSM0503_DECODE_XCCH)
+			j->rc = gsm0503_xcch_decode(j->data, j->bursts, &j->n_errors, &j->n_bits_total);
+		else
+			j->rc = gsm0503_tch_fr_decode(j->data, j->bursts, 1, 0, &j->n_errors, &j->n_bits_total);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int max_threads = argc > 1 ? atoi(argv[1]) : 4;
+	unsigned int iterations = argc > 2 ? atoi(argv[2]) : 1000;
+	struct timespec start;
+	double t_single, t;
+	unsigned int i, n;
+
+	gen_jobs();
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < iterations; i++)
+		decode_single();
+	t_single = elapsed_ns(&start) / iterations;
+	printf("%u blocks one by one:  %10.0f ns\n", NUM_JOBS, t_single);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < iterations; i++)
+		OSMO_ASSERT(gsm0503_decode_batch(NULL, jobs, NUM_JOBS) == 0);
+	t = elapsed_ns(&start) / iterations;
+	printf("batch, no pool:        %10.0f ns (%.2fx)\n", t, t_single / t);
+
+	for (n = 1; n <= max_threads; n++) {
+		struct gsm0503_decode_pool *pool = gsm0503_decode_pool_alloc(NULL, n);
+
+		OSMO_ASSERT(pool);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < iterations; i++)
+			OSMO_ASSERT(gsm0503_decode_batch(pool, jobs, NUM_JOBS) == 0);
+		t = elapsed_ns(&start) / iterations;
+		printf("batch, %2u worker(s):   %10.0f ns (%.2fx)\n", n, t, t_single / t);
+		gsm0503_decode_pool_free(pool);
+	}
+
+	return 0;
+}
@@ -0,0 +1,296 @@
+/* Test of the batch decoding of GSM TS 05.03 blocks */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/coding/gsm0503_coding.h>
+#include <osmocom/coding/gsm0503_batch.h>
+
+#define NUM_JOBS	300
+#define DATA_LEN	64
+
+static const char * const chan_names[] = {
+	[GSM0503_DECODE_XCCH]		= "XCCH",
+	[GSM0503_DECODE_PDTCH]		= "PDTCH",
+	[GSM0503_DECODE_PDTCH_EGPRS]	= "PDTCH_EGPRS",
+	[GSM0503_DECODE_TCH_FR]		= "TCH_FR",
+	[GSM0503_DECODE_TCH_HR]		= "TCH_HR",
+	[GSM0503_DECODE_TCH_AFS]	= "TCH_AFS",
+	[GSM0503_DECODE_TCH_AHS]	= "TCH_AHS",
+};
+
+static uint8_t amr_codec_afs[] = { 7 };	/* TCH/AFS12.2 */
+static uint8_t amr_codec_ahs[] = { 5 };	/* TCH/AHS7.95 */
+
+/* the input of a job, and the state its AMR arguments point to */
+struct block {
+	enum gsm0503_decode_chan chan;
+	sbit_t bursts[348 * 4];
+	uint8_t ft, cmr, dtx;
+};
+
+static struct block blocks[NUM_JOBS];
+static struct gsm0503_decode_job ref[NUM_JOBS];
+static uint8_t ref_data[NUM_JOBS][DATA_LEN];
+static struct gsm0503_decode_job jobs[NUM_JOBS];
+static uint8_t data[NUM_JOBS][DATA_LEN];
+
+/* Encode random data for the channel type and turn it into noisy soft bits */
+static void gen_block(struct block *b, enum gsm0503_decode_chan chan, unsigned int flip_permille)
+{
+	ubit_t ubits[348 * 4];
+	uint8_t l2[54];
+	unsigned int i, nbits = 116 * 8;
+	int rc = 0;
+
+	b->chan = chan;
+	for (i = 0; i < sizeof(l2); i++)
+		l2[i] = rand();
+	memset(ubits, 0, sizeof(ubits));
+
+	switch (chan) {
+	case GSM0503_DECODE_XCCH:
+		rc = gsm0503_xcch_encode(ubits, l2);
+		nbits = 116 * 4;
+		break;
+	case GSM0503_DECODE_PDTCH:
+		/* CS-1 .. CS-4 */
+		rc = gsm0503_pdtch_encode(ubits, l2, (const uint8_t []){ 23, 34, 40, 54 }[rand() % 4]);
+		OSMO_ASSERT(rc == GSM0503_GPRS_BURSTS_NBITS);
+		rc = 0;
+		nbits = 116 * 4;
+		break;
+	case GSM0503_DECODE_PDTCH_EGPRS:
+		/* random bits, EGPRS UL blocks can't be encoded */
+		for (i = 0; i < GSM0503_EGPRS_BURSTS_NBITS; i++)
+			ubits[i] = rand() & 1;
+		nbits = GSM0503_EGPRS_BURSTS_NBITS;
+		break;
+	case GSM0503_DECODE_TCH_FR:
+		l2[0] = 0xd0 | (l2[0] & 0x0f);
+		rc = gsm0503_tch_fr_encode(ubits, l2, 33, 1);
+		break;
+	case GSM0503_DECODE_TCH_HR:
+		l2[0] = 0x00;
+		rc = gsm0503_tch_hr_encode(ubits, l2, 15);
+		nbits = 116 * 6;
+		break;
+	case GSM0503_DECODE_TCH_AFS:
+		rc = gsm0503_tch_afs_encode(ubits, l2, 31, 0, amr_codec_afs, 1, 0, 0);
+		break;
+	case GSM0503_DECODE_TCH_AHS:
+		rc = gsm0503_tch_ahs_encode(ubits, l2, 20, 0, amr_codec_ahs, 1, 0, 0);
+		nbits = 116 * 6;
+		break;
+	}
+	OSMO_ASSERT(rc == 0);
+
+	osmo_ubit2sbit(b->bursts, ubits, nbits);
+	for (i = 0; i < nbits; i++) {
+		b->bursts[i] /= 1 + rand() % 4;
+		if ((unsigned int)rand() % 1000 < flip_permille)
+			b->bursts[i] = -b->bursts[i];
+	}
+}
+
+static void init_jobs(struct gsm0503_decode_job *j, uint8_t (*d)[DATA_LEN], unsigned int num)
+{
+	unsigned int i;
+
+	for (i = 0; i < num; i++) {
+		struct block *b = &blocks[i];
+
+		b->ft = b->cmr = b->dtx = 0;
+		memset(d[i], 0, DATA_LEN);
+		memset(&j[i], 0xff, sizeof(j[i]));
+		j[i].chan = b->chan;
+		j[i].bursts = b->bursts;
+		j[i].data = d[i];
+		switch (b->chan) {
+		case GSM0503_DECODE_PDTCH_EGPRS:
+			j[i].u.pdtch_egprs.nbits = GSM0503_EGPRS_BURSTS_NBITS;
+			break;
+		case GSM0503_DECODE_TCH_FR:
+			j[i].u.tch_fr.net_order = 1;
+			j[i].u.tch_fr.efr = 0;
+			break;
+		case GSM0503_DECODE_TCH_HR:
+			j[i].u.tch_hr.odd = i & 1;
+			break;
+		case GSM0503_DECODE_TCH_AFS:
+		case GSM0503_DECODE_TCH_AHS:
+			j[i].u.amr.odd = i & 1;
+			j[i].u.amr.codec_mode_req = 0;
+			j[i].u.amr.codec = b->chan == GSM0503_DECODE_TCH_AFS ? amr_codec_afs : amr_codec_ahs;
+			j[i].u.amr.codecs = 1;
+			j[i].u.amr.ft = &b->ft;
+			j[i].u.amr.cmr = &b->cmr;
+			j[i].u.amr.dtx = &b->dtx;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/* Decode each block with its single block function */
+static void decode_ref(unsigned int num)
+{
+	unsigned int i;
+
+	init_jobs(ref, ref_data, num);
+	for (i = 0; i < num; i++) {
+		struct gsm0503_decode_job *j = &ref[i];
+
+		j->usf = 0;
+		switch (j->chan) {
+		case GSM0503_DECODE_XCCH:
+			j->rc = gsm0503_xcch_decode(j->data, j->bursts, &j->n_errors, &j->n_bits_total);
+			break;
+		case GSM0503_DECODE_PDTCH:
+			j->rc = gsm0503_pdtch_decode(j->data, j->bursts, &j->usf, &j->n_errors, &j->n_bits_total);
+			break;
+		case GSM0503_DECODE_PDTCH_EGPRS:
+			j->rc = gsm0503_pdtch_egprs_decode(j->data, j->bursts, j->u.pdtch_egprs.nbits, &j->usf,
+							   &j->n_errors, &j->n_bits_total);
+			break;
+		case GSM0503_DECODE_TCH_FR:
+			j->rc = gsm0503_tch_fr_decode(j->data, j->bursts, 1, 0, &j->n_errors, &j->n_bits_total);
+			break;
+		case GSM0503_DECODE_TCH_HR:
+			j->rc = gsm0503_tch_hr_decode(j->data, j->bursts, j->u.tch_hr.odd,
+						      &j->n_errors, &j->n_bits_total);
+			break;
+		case GSM0503_DECODE_TCH_AFS:
+			j->rc = gsm0503_tch_afs_decode_dtx(j->data, j->bursts, 0, amr_codec_afs, 1,
+							   j->u.amr.ft, j->u.amr.cmr, &j->n_errors,
+							   &j->n_bits_total, j->u.amr.dtx);
+			break;
+		case GSM0503_DECODE_TCH_AHS:
+			j->rc = gsm0503_tch_ahs_decode_dtx(j->data, j->bursts, j->u.amr.odd, 0, amr_codec_ahs, 1,
+							   j->u.amr.ft, j->u.amr.cmr, &j->n_errors,
+							   &j->n_bits_total, j->u.amr.dtx);
+			break;
+		}
+	}
+}
+
+static void check_results(unsigned int num)
+{
+	unsigned int i;
+
+	for (i = 0; i < num; i++) {
+		if (jobs[i].rc != ref[i].rc || jobs[i].n_errors != ref[i].n_errors ||
+		    jobs[i].n_bits_total != ref[i].n_bits_total || jobs[i].usf != ref[i].usf ||
+		    memcmp(data[i], ref_data[i], DATA_LEN)) {
+			printf("job %u (%s): MISMATCH: rc=%d/%d n_errors=%d/%d n_bits_total=%d/%d usf=%u/%u\n",
+			       i, chan_names[jobs[i].chan], jobs[i].rc, ref[i].rc, jobs[i].n_errors,
+			       ref[i].n_errors, jobs[i].n_bits_total, ref[i].n_bits_total,
+			       jobs[i].usf, ref[i].usf);
+			OSMO_ASSERT(0);
+		}
+	}
+}
+
+static void test_batch(void *ctx)
+{
+	static const unsigned int threads[] = { 0, 1, 3, 8 };
+	unsigned int num_ok[ARRAY_SIZE(chan_names)] = { 0 }, num[ARRAY_SIZE(chan_names)] = { 0 };
+	unsigned int i;
+
+	printf("%s\n", __func__);
+
+	for (i = 0; i < NUM_JOBS; i++) {
+		/* mostly xCCH, as on a BTS; some blocks too noisy to decode */
+		enum gsm0503_decode_chan chan = rand() % 2 ? GSM0503_DECODE_XCCH : rand() % ARRAY_SIZE(chan_names);
+
+		gen_block(&blocks[i], chan, i % 5 == 0 ? 150 : 10);
+	}
+
+	decode_ref(NUM_JOBS);
+	for (i = 0; i < NUM_JOBS; i++) {
+		num[ref[i].chan]++;
+		num_ok[ref[i].chan] += ref[i].rc >= 0;
+	}
+	for (i = 0; i < ARRAY_SIZE(chan_names); i++)
+		printf("%s: %u blocks, %u decoded\n", chan_names[i], num[i], num_ok[i]);
+
+	/* without a pool */
+	init_jobs(jobs, data, NUM_JOBS);
+	OSMO_ASSERT(gsm0503_decode_batch(NULL, jobs, NUM_JOBS) == 0);
+	check_results(NUM_JOBS);
+
+	for (i = 0; i < ARRAY_SIZE(threads); i++) {
+		struct gsm0503_decode_pool *pool = gsm0503_decode_pool_alloc(ctx, threads[i]);
+		unsigned int n;
+
+		OSMO_ASSERT(pool);
+		printf("%u threads\n", threads[i]);
+
+		init_jobs(jobs, data, NUM_JOBS);
+		OSMO_ASSERT(gsm0503_decode_batch(pool, jobs, NUM_JOBS) == 0);
+		check_results(NUM_JOBS);
+
+		/* many batches of different sizes in a row */
+		for (n = 0; n < 40; n++) {
+			unsigned int len = n * n % 67;
+
+			decode_ref(len);
+			init_jobs(jobs, data, len);
+			OSMO_ASSERT(gsm0503_decode_batch(pool, jobs, len) == 0);
+			check_results(len);
+		}
+
+		gsm0503_decode_pool_free(pool);
+	}
+}
+
+static void test_invalid_chan(void)
+{
+	struct gsm0503_decode_job job = {
+		.chan = 42,
+		.bursts = blocks[0].bursts,
+		.data = data[0],
+	};
+
+	printf("%s\n", __func__);
+
+	OSMO_ASSERT(gsm0503_decode_batch(NULL, &job, 1) == 0);
+	printf("rc=%d\n", job.rc);
+	OSMO_ASSERT(job.rc == -EINVAL);
+}
+
+int main(int argc, char **argv)
+{
+	void *ctx = talloc_named_const(NULL, 0, "batch_test");
+
+	srand(1);
+
+	test_batch(ctx);
+	test_invalid_chan();
+
+	OSMO_ASSERT(talloc_total_blocks(ctx) == 1);
+	talloc_free(ctx);
+	return 0;
+}
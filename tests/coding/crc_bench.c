@@ -0,0 +1,100 @@
+/* Benchmark of the bit-serial and the table-driven CRC computation */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Usage: crc_bench [iterations]
+ *
+ * For each CRC code of gsm0503_parity.c, compute the CRC of a block of the
+ * size it is used with in gsm0503_coding.c, with osmo_crcXXgen_compute_bits()
+ * (bit-serial), osmo_crcXXgen_compute_bits_tbl() (table-driven, hard bits)
+ * and osmo_crcXXgen_compute_pbits() (table-driven, packed bits), and report
+ * the time per block. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/crcgen.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/coding/gsm0503_parity.h>
+
+#define MAX_LEN 600
+
+static ubit_t ubits[MAX_LEN];
+static pbit_t pbits[(MAX_LEN + 7) / 8];
+
+/* keeps the compiler from optimizing the computation away */
+static volatile uint64_t sink;
+
+static double elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+#define BENCH(XX, code, len, iterations) do { \
+		static struct osmo_crc##XX##gen_table tbl; \
+		struct timespec start; \
+		double t_bits, t_tbl, t_pbits; \
+		unsigned int i; \
+		osmo_crc##XX##gen_table_init(&tbl, &code); \
+		OSMO_ASSERT(osmo_crc##XX##gen_compute_bits_tbl(&tbl, ubits, len) == \
+			    osmo_crc##XX##gen_compute_bits(&code, ubits, len)); \
+		clock_gettime(CLOCK_MONOTONIC, &start); \
+		for (i = 0; i < iterations; i++) \
+			sink = osmo_crc##XX##gen_compute_bits(&code, ubits, len); \
+		t_bits = elapsed_ns(&start) / iterations; \
+		clock_gettime(CLOCK_MONOTONIC, &start); \
+		for (i = 0; i < iterations; i++) \
+			sink = osmo_crc##XX##gen_compute_bits_tbl(&tbl, ubits, len); \
+		t_tbl = elapsed_ns(&start) / iterations; \
+		clock_gettime(CLOCK_MONOTONIC, &start); \
+		for (i = 0; i < iterations; i++) \
+			sink = osmo_crc##XX##gen_compute_pbits(&tbl, pbits, len); \
+		t_pbits = elapsed_ns(&start) / iterations; \
+		printf("%-22s %4d bits: bit-serial %7.1f ns, table %6.1f ns, packed %6.1f ns\n", \
+		       #code, len, t_bits, t_tbl, t_pbits); \
+	} while (0)
+
+int main(int argc, char **argv)
+{
+	unsigned int iterations = 1000000;
+	int i;
+
+	if (argc > 1)
+		iterations = atoi(argv[1]);
+
+	for (i = 0; i < MAX_LEN; i++)
+		ubits[i] = rand() & 1;
+	osmo_ubit2pbit(pbits, ubits, MAX_LEN);
+
+	BENCH(64, gsm0503_fire_crc40, 184, iterations);
+	BENCH(16, gsm0503_cs234_crc16, 431, iterations);
+	BENCH(8, gsm0503_mcs_crc8_hdr, 46, iterations);
+	BENCH(16, gsm0503_mcs_crc12, 594, iterations);
+	BENCH(8, gsm0503_rach_crc6, 8, iterations);
+	BENCH(16, gsm0503_sch_crc10, 25, iterations);
+	BENCH(8, gsm0503_tch_fr_crc3, 50, iterations);
+	BENCH(8, gsm0503_tch_efr_crc8, 65, iterations);
+	BENCH(8, gsm0503_amr_crc6, 81, iterations);
+	BENCH(16, gsm0503_amr_crc14, 35, iterations);
+
+	return EXIT_SUCCESS;
+}
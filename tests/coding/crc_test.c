@@ -0,0 +1,134 @@
+/* Test of the table-driven CRC computation */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/crcgen.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/coding/gsm0503_parity.h>
+
+#define MAX_LEN 700
+
+static ubit_t ubits[MAX_LEN + 64];
+static sbit_t sbits[MAX_LEN + 64];
+static pbit_t pbits[(MAX_LEN + 7) / 8];
+
+static void random_bits(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(ubits); i++) {
+		ubits[i] = rand() & 1;
+		/* soft bits of any magnitude, 0 is a 0 as in osmo_sbit2ubit() */
+		sbits[i] = ubits[i] ? -(rand() % 128) - 1 : rand() % 128;
+	}
+}
+
+/* Compare the table-driven against the bit-serial computation of one code
+ * for all lengths up to MAX_LEN. */
+#define TEST_CODE(XX, code) do { \
+		static struct osmo_crc##XX##gen_table tbl; \
+		int len, i; \
+		osmo_crc##XX##gen_table_init(&tbl, &code); \
+		for (len = 0; len <= MAX_LEN; len++) { \
+			uint##XX##_t crc = osmo_crc##XX##gen_compute_bits(&code, ubits, len); \
+			osmo_ubit2pbit(pbits, ubits, len); \
+			OSMO_ASSERT(osmo_crc##XX##gen_compute_bits_tbl(&tbl, ubits, len) == crc); \
+			OSMO_ASSERT(osmo_crc##XX##gen_compute_pbits(&tbl, pbits, len) == crc); \
+			/* append the CRC, then check it */ \
+			osmo_crc##XX##gen_set_bits_tbl(&tbl, ubits, len, ubits + MAX_LEN); \
+			for (i = 0; i < code.bits; i++) { \
+				OSMO_ASSERT(ubits[MAX_LEN + i] == ((crc >> (code.bits - i - 1)) & 1)); \
+				sbits[MAX_LEN + i] = ubits[MAX_LEN + i] ? -127 : 127; \
+			} \
+			OSMO_ASSERT(osmo_crc##XX##gen_check_bits_tbl(&tbl, ubits, len, ubits + MAX_LEN) == 0); \
+			OSMO_ASSERT(osmo_crc##XX##gen_check_sbits_tbl(&tbl, sbits, len, sbits + MAX_LEN) == 0); \
+			/* flip one bit of the data */ \
+			if (len > 0) { \
+				i = rand() % len; \
+				ubits[i] ^= 1; \
+				sbits[i] = ubits[i] ? -1 : 0; \
+				OSMO_ASSERT(osmo_crc##XX##gen_check_bits_tbl(&tbl, ubits, len, ubits + MAX_LEN) == 1); \
+				OSMO_ASSERT(osmo_crc##XX##gen_check_sbits_tbl(&tbl, sbits, len, sbits + MAX_LEN) == 1); \
+				ubits[i] ^= 1; \
+				sbits[i] = ubits[i] ? -1 : 0; \
+			} \
+		} \
+		printf(#code " (%d bits): ok\n", code.bits); \
+	} while (0)
+
+static void test_gsm0503_codes(void)
+{
+	printf("%s\n", __func__);
+
+	random_bits();
+	TEST_CODE(64, gsm0503_fire_crc40);
+	TEST_CODE(16, gsm0503_cs234_crc16);
+	TEST_CODE(8, gsm0503_mcs_crc8_hdr);
+	TEST_CODE(16, gsm0503_mcs_crc12);
+	TEST_CODE(8, gsm0503_rach_crc6);
+	TEST_CODE(16, gsm0503_sch_crc10);
+	TEST_CODE(8, gsm0503_tch_fr_crc3);
+	TEST_CODE(8, gsm0503_tch_efr_crc8);
+	TEST_CODE(8, gsm0503_amr_crc6);
+	TEST_CODE(16, gsm0503_amr_crc14);
+}
+
+/* CRC-8/SMBUS, CRC-16/XMODEM, CRC-32/MPEG-2 and CRC-64/ECMA-182 */
+static const struct osmo_crc8gen_code crc8 = { 8, 0x07, 0x00, 0x00 };
+static const struct osmo_crc16gen_code crc16 = { 16, 0x1021, 0x0000, 0x0000 };
+static const struct osmo_crc32gen_code crc32 = { 32, 0x04c11db7, 0xffffffff, 0x00000000 };
+static const struct osmo_crc64gen_code crc64 = { 64, 0x42f0e1eba9ea3693ULL, 0, 0 };
+
+/* The well-known check values (CRC of "123456789") of codes as wide as the
+ * register */
+static void test_check_values(void)
+{
+	const pbit_t *in = (const pbit_t *)"123456789";
+	static struct osmo_crc8gen_table tbl8;
+	static struct osmo_crc16gen_table tbl16;
+	static struct osmo_crc32gen_table tbl32;
+	static struct osmo_crc64gen_table tbl64;
+
+	printf("%s\n", __func__);
+
+	osmo_crc8gen_table_init(&tbl8, &crc8);
+	osmo_crc16gen_table_init(&tbl16, &crc16);
+	osmo_crc32gen_table_init(&tbl32, &crc32);
+	osmo_crc64gen_table_init(&tbl64, &crc64);
+
+	printf("CRC-8:  0x%02x\n", osmo_crc8gen_compute_pbits(&tbl8, in, 72));
+	printf("CRC-16: 0x%04x\n", osmo_crc16gen_compute_pbits(&tbl16, in, 72));
+	printf("CRC-32: 0x%08x\n", osmo_crc32gen_compute_pbits(&tbl32, in, 72));
+	printf("CRC-64: 0x%016" PRIx64 "\n", osmo_crc64gen_compute_pbits(&tbl64, in, 72));
+}
+
+int main(int argc, char **argv)
+{
+	srand(0);
+
+	test_gsm0503_codes();
+	test_check_values();
+
+	printf("Done\n");
+	return 0;
+}
@@ -17,6 +17,63 @@ static void fill_random(ubit_t *b, int n)
 		b[i] = random() & 1;
 }
 
+#define BATCH_NUM	37
+
+/* Decode a batch of noisy codewords with each available kernel, and compare
+ * the result with the one of osmo_conv_decode() for each codeword */
+static int do_check_batch(const struct conv_test_vector *test)
+{
+	static const enum osmo_conv_batch_kernel kernels[] = {
+		OSMO_CONV_BATCH_KERNEL_AUTO,
+		OSMO_CONV_BATCH_KERNEL_GENERIC,
+		OSMO_CONV_BATCH_KERNEL_AVX2,
+		OSMO_CONV_BATCH_KERNEL_AVX512,
+	};
+	sbit_t *in[BATCH_NUM];
+	ubit_t *out[BATCH_NUM], *ref[BATCH_NUM];
+	ubit_t bu[MAX_LEN_BITS], be[MAX_LEN_BITS];
+	int i, j, k, rc = 0;
+
+	for (i = 0; i < BATCH_NUM; i++) {
+		in[i] = malloc(sizeof(sbit_t) * test->out_len);
+		out[i] = malloc(sizeof(ubit_t) * test->in_len);
+		ref[i] = malloc(sizeof(ubit_t) * test->in_len);
+
+		fill_random(bu, test->in_len);
+		osmo_conv_encode(test->code, bu, be);
+		for (j = 0; j < test->out_len; j++) {
+			/* soft bits of random confidence, some of them wrong */
+			in[i][j] = (be[j] ? -1 : 1) * (int)(random() % 128);
+			if (random() % 16 == 0)
+				in[i][j] = -in[i][j];
+		}
+		osmo_conv_decode(test->code, in[i], ref[i]);
+	}
+
+	for (k = 0; k < ARRAY_SIZE(kernels); k++) {
+		if (osmo_conv_batch_kernel_set(kernels[k]) < 0)
+			continue;
+
+		osmo_conv_decode_batch(test->code, (const sbit_t * const *) in, out, BATCH_NUM);
+		for (i = 0; i < BATCH_NUM; i++) {
+			if (memcmp(out[i], ref[i], test->in_len)) {
+				fprintf(stderr, "[!] Failed batch decoding (%s): codeword %d doesn't match\n",
+					get_value_string(osmo_conv_batch_kernel_names, kernels[k]), i);
+				rc = -1;
+			}
+		}
+	}
+	osmo_conv_batch_kernel_set(OSMO_CONV_BATCH_KERNEL_AUTO);
+
+	for (i = 0; i < BATCH_NUM; i++) {
+		free(in[i]);
+		free(out[i]);
+		free(ref[i]);
+	}
+
+	return rc;
+}
+
 int do_check(const struct conv_test_vector *test)
 {
 	ubit_t *bu0, *bu1;
@@ -132,6 +189,13 @@ int do_check(const struct conv_test_vector *test)
 		printf("OK\n");
 	}
 
+	printf("[..] Batch decoding : ");
+	if (do_check_batch(test)) {
+		printf("ERROR !\n");
+		return -1;
+	}
+	printf("OK\n");
+
 	/* Spacing */
 	printf("\n");
 
@@ -0,0 +1,137 @@
+/* Benchmark of the single codeword and batch Viterbi decoders */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Usage: conv_bench [batch_size]
+ *
+ * For a selection of GSM 05.03 codes, decode the same noisy codewords with
+ * osmo_conv_decode() one by one, and with osmo_conv_decode_batch() in
+ * batches of batch_size (default: 32) codewords using each kernel supported
+ * by the CPU, and report the decoded codewords per second. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/conv.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/gsm/gsm0503.h>
+
+#define NUM_CODEWORDS	4096
+
+static const struct {
+	const char *name;
+	const struct osmo_conv_code *code;
+} codes[] = {
+	{ "xcch", &gsm0503_xcch },
+	{ "rach", &gsm0503_rach },
+	{ "tch_fr", &gsm0503_tch_fr },
+	{ "tch_afs_12_2", &gsm0503_tch_afs_12_2 },
+	{ "mcs1_dl_hdr", &gsm0503_mcs1_dl_hdr },
+};
+
+static double elapsed_s(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void bench(const char *name, const struct osmo_conv_code *code, unsigned int batch)
+{
+	static const enum osmo_conv_batch_kernel kernels[] = {
+		OSMO_CONV_BATCH_KERNEL_GENERIC,
+		OSMO_CONV_BATCH_KERNEL_AVX2,
+		OSMO_CONV_BATCH_KERNEL_AVX512,
+	};
+	int in_len = osmo_conv_get_input_length(code, 0);
+	int out_len = osmo_conv_get_output_length(code, 0);
+	sbit_t **in = malloc(sizeof(*in) * NUM_CODEWORDS);
+	ubit_t **out = malloc(sizeof(*out) * NUM_CODEWORDS);
+	ubit_t *bu = malloc(in_len), *be = malloc(out_len);
+	struct timespec start;
+	double t;
+	int i, j, k;
+
+	OSMO_ASSERT(in && out && bu && be);
+
+	for (i = 0; i < NUM_CODEWORDS; i++) {
+		in[i] = malloc(out_len);
+		out[i] = malloc(in_len);
+		OSMO_ASSERT(in[i] && out[i]);
+
+		for (j = 0; j < in_len; j++)
+			bu[j] = random() & 1;
+		osmo_conv_encode(code, bu, be);
+		for (j = 0; j < out_len; j++)
+			in[i][j] = (be[j] ? -1 : 1) * (int)(random() % 128);
+	}
+
+	printf("%-13s K=%d N=%d len=%3d:", name, code->K, code->N, code->len);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < NUM_CODEWORDS; i++)
+		osmo_conv_decode(code, in[i], out[i]);
+	t = elapsed_s(&start);
+	printf("  single %8.0f/s", NUM_CODEWORDS / t);
+
+	for (k = 0; k < ARRAY_SIZE(kernels); k++) {
+		if (osmo_conv_batch_kernel_set(kernels[k]) < 0)
+			continue;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < NUM_CODEWORDS; i += batch)
+			osmo_conv_decode_batch(code, (const sbit_t * const *) &in[i], &out[i],
+					       OSMO_MIN(batch, NUM_CODEWORDS - i));
+		t = elapsed_s(&start);
+		printf("  %s %8.0f/s", get_value_string(osmo_conv_batch_kernel_names, kernels[k]),
+		       NUM_CODEWORDS / t);
+	}
+	osmo_conv_batch_kernel_set(OSMO_CONV_BATCH_KERNEL_AUTO);
+	printf("\n");
+
+	for (i = 0; i < NUM_CODEWORDS; i++) {
+		free(in[i]);
+		free(out[i]);
+	}
+	free(in);
+	free(out);
+	free(bu);
+	free(be);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int batch = 32;
+	int i;
+
+	if (argc > 1)
+		batch = atoi(argv[1]);
+	if (batch < 1) {
+		fprintf(stderr, "batch size must be at least 1\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("codewords per second, batches of %u:\n", batch);
+	for (i = 0; i < ARRAY_SIZE(codes); i++)
+		bench(codes[i].name, codes[i].code, batch);
+
+	return EXIT_SUCCESS;
+}
@@ -158,6 +158,30 @@ static const struct one_test test_messages_list[] = {
 		"ERROR 1 Command not found",
 
 	},
+	{ "GET 1 variable,other.variable",
+		{
+			.type = CTRL_TYPE_GET,
+			.id = "1",
+			.variable = "variable,other.variable",
+		},
+		"ERROR 1 variable: Command not found",
+	},
+	{ "GET 1 variable,,other",
+		{
+			.type = CTRL_TYPE_ERROR,
+			.id = "1",
+			.reply = "GET variable contains invalid characters",
+		},
+		"ERROR 1 GET variable contains invalid characters",
+	},
+	{ "GET 1 variable,",
+		{
+			.type = CTRL_TYPE_ERROR,
+			.id = "1",
+			.reply = "GET variable contains invalid characters",
+		},
+		"ERROR 1 GET variable contains invalid characters",
+	},
 	{ "GET 1 var\ni\nable",
 		{
 			.type = CTRL_TYPE_ERROR,
@@ -452,6 +476,149 @@ static void test_deferred_cmd()
 	printf("success\n");
 }
 
+/* commands with overlapping names and wildcards, in the order of installation */
+#define LOOKUP_CMD(nr, cmdstr) \
+	static int get_lookup_##nr(struct ctrl_cmd *cmd, void *data) \
+	{ \
+		cmd->reply = "'" cmdstr "'"; \
+		return CTRL_CMD_REPLY; \
+	} \
+	static struct ctrl_cmd_element cmd_lookup_##nr = { \
+		.name = cmdstr, \
+		.get = get_lookup_##nr, \
+	}
+
+LOOKUP_CMD(0, "lk a b");
+LOOKUP_CMD(1, "lk a * z");
+LOOKUP_CMD(2, "lk a *");
+LOOKUP_CMD(3, "lk c");
+LOOKUP_CMD(4, "lk c d");
+LOOKUP_CMD(5, "lk * e");
+LOOKUP_CMD(6, "lk f");
+
+/* fails without setting a reply */
+static int get_lookup_err(struct ctrl_cmd *cmd, void *data)
+{
+	return CTRL_CMD_ERROR;
+}
+static struct ctrl_cmd_element cmd_lookup_err = {
+	.name = "lk err",
+	.get = get_lookup_err,
+};
+
+static void test_lookup()
+{
+	static const char *cmds[] = {
+		"GET 1 lk.a.b",
+		"GET 1 lk.a.b.z",
+		"GET 1 lk.a.q",
+		"GET 1 lk.a.q.z",
+		"GET 1 lk.a",
+		"GET 1 lk.c.d",
+		"GET 1 lk.c",
+		"GET 1 lk.f",
+		"GET 1 lk.f.g",
+		"GET 1 lk.z.e",
+		"GET 1 lk.b",
+		"GET 1 lk",
+		"GET 1 lk.a.b,lk.c,lk.f.g",
+		"GET 1 lk.a.b,lk.b,lk.c",
+		"GET 1 lk.a.b,test-defer",
+		"GET 1 lk.a.b,lk.err",
+	};
+	struct ctrl_handle *ctrl;
+	int i;
+
+	printf("\n%s\n", __func__);
+
+	ctrl = ctrl_handle_alloc2(ctx, NULL, NULL, 0);
+
+	ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_lookup_0);
+	ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_lookup_1);
+	ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_lookup_2);
+	ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_lookup_3);
+	ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_lookup_4);
+	ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_lookup_5);
+	ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_lookup_6);
+	ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_lookup_err);
+
+	for (i = 0; i < ARRAY_SIZE(cmds); i++) {
+		struct ctrl_cmd *cmd = ctrl_cmd_exec_from_string(ctrl, cmds[i]);
+
+		OSMO_ASSERT(cmd);
+		printf("%s -> %s %s\n", cmds[i], get_value_string(ctrl_type_vals, cmd->type),
+		       osmo_escape_str(cmd->reply, -1));
+		talloc_free(cmd);
+	}
+
+	talloc_free(ctrl);
+}
+
+static char long_reply[100];
+
+static int get_lookup_long(struct ctrl_cmd *cmd, void *data)
+{
+	cmd->reply = long_reply;
+	return CTRL_CMD_REPLY;
+}
+static struct ctrl_cmd_element cmd_lookup_long = {
+	.name = "long *",
+	.get = get_lookup_long,
+};
+
+/* a bulk GET whose reply doesn't fit into a message must fail, not overflow the msgb */
+static void test_bulk_too_long()
+{
+	char name[193];
+	struct ctrl_handle *ctrl;
+	struct ctrl_cmd *cmd;
+	struct msgb *msg;
+	char *huge;
+	int i, n;
+
+	printf("\n%s\n", __func__);
+
+	memset(long_reply, 'x', sizeof(long_reply) - 1);
+	memset(name, 'v', sizeof(name) - 1);
+	name[sizeof(name) - 1] = '\0';
+	ctrl = ctrl_handle_alloc2(ctx, NULL, NULL, 0);
+	ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_lookup_long);
+
+	/* many long variable names, the reply repeats them */
+	for (n = 120; n <= 140; n += 20) {
+		msg = msgb_alloc(UINT16_MAX, "bulk");
+		OSMO_ASSERT(msg);
+		msg->l2h = msg->tail;
+		msgb_printf(msg, "GET 1 ");
+		for (i = 0; i < n; i++)
+			msgb_printf(msg, "%slong.%s", i ? "," : "", name);
+
+		cmd = ctrl_cmd_parse2(ctx, msg);
+		msgb_free(msg);
+		OSMO_ASSERT(cmd && cmd->type == CTRL_TYPE_GET);
+		ctrl_cmd_handle(ctrl, cmd, NULL);
+		msg = ctrl_cmd_make(cmd);
+		OSMO_ASSERT(msg);
+		printf("%d variables -> %s, %u bytes encoded\n", n, get_value_string(ctrl_type_vals, cmd->type),
+		       msgb_l2len(msg));
+		msgb_free(msg);
+		talloc_free(cmd);
+	}
+
+	/* ctrl_cmd_make() refuses what doesn't fit into a msgb */
+	cmd = ctrl_cmd_create(ctx, CTRL_TYPE_GET_REPLY);
+	OSMO_ASSERT(cmd);
+	huge = talloc_zero_size(cmd, 70000);
+	memset(huge, 'x', 70000 - 1);
+	cmd->id = "1";
+	cmd->variable = "var";
+	cmd->reply = huge;
+	printf("70000 bytes reply -> %s\n", ctrl_cmd_make(cmd) ? "encoded" : "refused");
+	talloc_free(cmd);
+
+	talloc_free(ctrl);
+}
+
 static struct log_info_cat test_categories[] = {
 };
 
@@ -481,8 +648,12 @@ int main(int argc, char **argv)
 
 	test_deferred_cmd();
 
-	/* Expecting root ctx + msgb root ctx + 5 logging elements */
-	if (talloc_total_blocks(ctx) != 7) {
+	test_lookup();
+
+	test_bulk_too_long();
+
+	/* Expecting root ctx + msgb root ctx + 6 logging elements */
+	if (talloc_total_blocks(ctx) != 8) {
 		talloc_report_full(ctx, stdout);
 		OSMO_ASSERT(false);
 	}
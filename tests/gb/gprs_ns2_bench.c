@@ -0,0 +1,191 @@
+/* Benchmark of the NSE/NS-VC lookup functions of gprs_ns2 */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Usage: gprs_ns2_bench [num_nse ...]
+ *
+ * For each number of NSEs (default: 100 1000 10000), create one IP bind and
+ * as many NSEs with one (inactive) NS-VC each, and measure the cost of looking
+ * up random NSEs by NSEI, NS-VCs by NSVCI, and NS-VCs by remote address, as
+ * done for every received PDU. A walk over all NSEs, as done by the lookup
+ * functions before they were hash indexed, is given for comparison. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include <osmocom/core/application.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/core/socket.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/gprs/gprs_ns2.h>
+
+#define NUM_LOOKUPS 1000000
+
+int bssgp_prim_cb(struct osmo_prim_hdr *oph, void *ctx)
+{
+	return -1;
+}
+
+static int ns_prim_cb(struct osmo_prim_hdr *oph, void *ctx)
+{
+	return 0;
+}
+
+static const struct log_info_cat bench_cat[] = {};
+
+static const struct log_info bench_log_info = {
+	.cat = bench_cat,
+	.num_cat = ARRAY_SIZE(bench_cat),
+};
+
+static uint32_t prng_state = 1;
+
+static uint32_t prng(void)
+{
+	/* xorshift32 */
+	prng_state ^= prng_state << 13;
+	prng_state ^= prng_state >> 17;
+	prng_state ^= prng_state << 5;
+	return prng_state;
+}
+
+static void remote_addr(struct osmo_sockaddr *saddr, unsigned int i)
+{
+	memset(saddr, 0, sizeof(*saddr));
+	saddr->u.sin.sin_family = AF_INET;
+	saddr->u.sin.sin_addr.s_addr = htonl(0x0a000000 + i);
+	saddr->u.sin.sin_port = htons(23000);
+}
+
+static double elapsed_ns(const struct timespec *start, unsigned int num)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec)) / num;
+}
+
+static void bench(void *ctx, unsigned int num)
+{
+	struct gprs_ns2_inst *nsi = gprs_ns2_instantiate(ctx, ns_prim_cb, NULL);
+	struct gprs_ns2_vc_bind *bind;
+	struct gprs_ns2_nse **nses;
+	struct osmo_sockaddr local, *remotes;
+	struct timespec start;
+	unsigned long found = 0;
+	double t_nsei, t_nsvci, t_bind, t_nse, t_walk;
+	unsigned int i, walks;
+
+	OSMO_ASSERT(nsi);
+	nses = talloc_zero_array(ctx, struct gprs_ns2_nse *, num);
+	remotes = talloc_zero_array(ctx, struct osmo_sockaddr, num);
+	OSMO_ASSERT(nses && remotes);
+
+	memset(&local, 0, sizeof(local));
+	local.u.sin.sin_family = AF_INET;
+	local.u.sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	OSMO_ASSERT(gprs_ns2_ip_bind(nsi, "bench", &local, 0, &bind) == 0);
+
+	for (i = 0; i < num; i++) {
+		nses[i] = gprs_ns2_create_nse(nsi, i, GPRS_NS2_LL_UDP, GPRS_NS2_DIALECT_STATIC_RESETBLOCK);
+		OSMO_ASSERT(nses[i]);
+		remote_addr(&remotes[i], i);
+		OSMO_ASSERT(gprs_ns2_ip_connect_inactive(bind, &remotes[i], nses[i], i));
+	}
+
+	prng_state = 1;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < NUM_LOOKUPS; i++)
+		found += !!gprs_ns2_nse_by_nsei(nsi, prng() % num);
+	t_nsei = elapsed_ns(&start, NUM_LOOKUPS);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < NUM_LOOKUPS; i++)
+		found += !!gprs_ns2_nsvc_by_nsvci(nsi, prng() % num);
+	t_nsvci = elapsed_ns(&start, NUM_LOOKUPS);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < NUM_LOOKUPS; i++)
+		found += !!gprs_ns2_nsvc_by_sockaddr_bind(bind, &remotes[prng() % num]);
+	t_bind = elapsed_ns(&start, NUM_LOOKUPS);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < NUM_LOOKUPS; i++) {
+		unsigned int n = prng() % num;
+		found += !!gprs_ns2_nsvc_by_sockaddr_nse(nses[n], &remotes[n]);
+	}
+	t_nse = elapsed_ns(&start, NUM_LOOKUPS);
+
+	/* linear search over all NSEs, for comparison; fewer iterations as it is O(num) */
+	walks = NUM_LOOKUPS / num;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < walks; i++) {
+		uint16_t nsei = prng() % num;
+		struct gprs_ns2_nse *nse = NULL;
+		unsigned int j;
+
+		for (j = 0; j < num; j++) {
+			if (gprs_ns2_nse_nsei(nses[j]) == nsei) {
+				nse = nses[j];
+				break;
+			}
+		}
+		found += !!nse;
+	}
+	t_walk = elapsed_ns(&start, walks);
+
+	printf("%6u NSEs: nse_by_nsei %6.1f ns, nsvc_by_nsvci %6.1f ns, nsvc_by_sockaddr_bind %6.1f ns, "
+	       "nsvc_by_sockaddr_nse %6.1f ns, linear walk %9.1f ns%s\n",
+	       num, t_nsei, t_nsvci, t_bind, t_nse, t_walk,
+	       found != 4 * NUM_LOOKUPS + walks ? " ERROR" : "");
+
+	gprs_ns2_free(nsi);
+	talloc_free(remotes);
+	talloc_free(nses);
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int default_nums[] = { 100, 1000, 10000 };
+	void *ctx = talloc_named_const(NULL, 0, "gprs_ns2_bench");
+	int i;
+
+	osmo_init_logging2(ctx, &bench_log_info);
+	log_set_log_level(osmo_stderr_target, LOGL_ERROR);
+
+	if (argc < 2) {
+		for (i = 0; i < ARRAY_SIZE(default_nums); i++)
+			bench(ctx, default_nums[i]);
+	}
+
+	for (i = 1; i < argc; i++) {
+		unsigned int num = atoi(argv[i]);
+		if (num < 1 || num > 65535) {
+			fprintf(stderr, "number of NSEs must be within 1..65535\n");
+			return EXIT_FAILURE;
+		}
+		bench(ctx, num);
+	}
+
+	talloc_free(ctx);
+	return EXIT_SUCCESS;
+}
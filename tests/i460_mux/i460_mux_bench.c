@@ -0,0 +1,158 @@
+/* Benchmark of the I.460 sub-channel demultiplexer and multiplexer */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Usage: i460_mux_bench [seconds_of_e1]
+ *
+ * Simulates an E1 line with 31 timeslots, each split into sub-channels of
+ * one rate (4x16k as used for TRAU frames, 8x8k and 2x32k), and
+ * passes the given amount of E1 data (default: 60s) through the
+ * demultiplexer and the multiplexer in blocks of 160 octets (20ms).  The
+ * demultiplexer is measured both with unpacked-bit and with octet
+ * call-backs. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/msgb.h>
+#include <osmocom/gsm/i460_mux.h>
+
+#define NUM_TS		31
+#define BLOCK_LEN	160
+
+static struct osmo_i460_timeslot e1_ts[NUM_TS];
+static unsigned long demux_bits;
+static void *ctx;
+
+static void bits_cb(struct osmo_i460_subchan *schan, void *user_data,
+		    const ubit_t *bits, unsigned int num_bits)
+{
+	demux_bits += num_bits;
+}
+
+static void bytes_cb(struct osmo_i460_subchan *schan, void *user_data,
+		     const uint8_t *bytes, unsigned int num_bytes)
+{
+	demux_bits += num_bytes * 8;
+}
+
+static void queue_empty_cb(struct osmo_i460_subchan *schan, void *user_data)
+{
+	/* one TRAU frame worth of (idle) bits */
+	struct msgb *msg = msgb_alloc_c(ctx, 320, "i460_bench");
+	memset(msgb_put(msg, 320), 1, 320);
+	osmo_i460_mux_enqueue(schan, msg);
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static void bench(enum osmo_i460_rate rate, unsigned int num_schan, bool packed, unsigned int seconds)
+{
+	static const char *rate_names[] = {
+		[OSMO_I460_RATE_64k] = "64k",
+		[OSMO_I460_RATE_32k] = "32k",
+		[OSMO_I460_RATE_16k] = "16k",
+		[OSMO_I460_RATE_8k] = "8k",
+	};
+	unsigned int num_blocks = seconds * 8000 / BLOCK_LEN;
+	uint8_t block[BLOCK_LEN];
+	double t_demux, t_mux;
+	struct timespec start;
+	unsigned int i, j, ts;
+
+	for (i = 0; i < sizeof(block); i++)
+		block[i] = i * 37;
+
+	for (ts = 0; ts < NUM_TS; ts++) {
+		osmo_i460_ts_init(&e1_ts[ts]);
+		for (j = 0; j < num_schan; j++) {
+			struct osmo_i460_schan_desc scd = {
+				.rate = rate,
+				.bit_offset = j * (8 / num_schan),
+				.demux = {
+					.num_bits = 320,
+					.out_cb_bits = packed ? NULL : bits_cb,
+					.out_cb_bytes = packed ? bytes_cb : NULL,
+				},
+				.mux = {
+					.in_cb_queue_empty = queue_empty_cb,
+				},
+			};
+			OSMO_ASSERT(osmo_i460_subchan_add(ctx, &e1_ts[ts], &scd));
+		}
+	}
+
+	demux_bits = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < num_blocks; i++) {
+		for (ts = 0; ts < NUM_TS; ts++)
+			osmo_i460_demux_in(&e1_ts[ts], block, sizeof(block));
+	}
+	t_demux = elapsed_ms(&start);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < num_blocks; i++) {
+		for (ts = 0; ts < NUM_TS; ts++)
+			osmo_i460_mux_out(&e1_ts[ts], block, sizeof(block));
+	}
+	t_mux = elapsed_ms(&start);
+
+	printf("%ux%-3s %-6s: demux %8.1f ms (%6.1fx real-time), mux %8.1f ms (%6.1fx real-time)\n",
+	       num_schan, rate_names[rate], packed ? "bytes" : "bits",
+	       t_demux, seconds * 1e3 / t_demux, t_mux, seconds * 1e3 / t_mux);
+	OSMO_ASSERT(demux_bits >= (unsigned long)num_blocks * NUM_TS * BLOCK_LEN * 8 - NUM_TS * num_schan * 320);
+
+	for (ts = 0; ts < NUM_TS; ts++) {
+		for (j = 0; j < num_schan; j++)
+			osmo_i460_subchan_del(&e1_ts[ts].schan[j]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int seconds = 60;
+
+	if (argc > 1)
+		seconds = atoi(argv[1]);
+
+	ctx = talloc_named_const(NULL, 0, "i460_mux_bench");
+	msgb_talloc_ctx_init(ctx, 0);
+
+	printf("%u timeslots, %us of E1 data in blocks of %u octets:\n", NUM_TS, seconds, BLOCK_LEN);
+	bench(OSMO_I460_RATE_16k, 4, false, seconds);
+	bench(OSMO_I460_RATE_16k, 4, true, seconds);
+	bench(OSMO_I460_RATE_8k, 8, false, seconds);
+	bench(OSMO_I460_RATE_8k, 8, true, seconds);
+	bench(OSMO_I460_RATE_32k, 2, false, seconds);
+	bench(OSMO_I460_RATE_32k, 2, true, seconds);
+
+	talloc_free(ctx);
+	return EXIT_SUCCESS;
+}
@@ -387,6 +387,55 @@ static void test_unused_subchan(void)
 	osmo_i460_subchan_del(&ts->schan[0]);
 }
 
+static void bytes_cb(struct osmo_i460_subchan *schan, void *user_data,
+		     const uint8_t *bytes, unsigned int num_bytes)
+{
+	char *str = user_data;
+	printf("demux_bytes_cb '%s': %s\n", str, osmo_hexdump(bytes, num_bytes));
+}
+
+static void test_demux_bytes(void)
+{
+	struct osmo_i460_timeslot _ts, *ts = &_ts;
+	const struct osmo_i460_schan_desc scd16_2_bytes = {
+		.rate = OSMO_I460_RATE_16k,
+		.bit_offset = 2,
+		.demux = {
+			.num_bits = 16,
+			.out_cb_bytes = bytes_cb,
+			.user_data = "16k_2",
+		},
+	};
+	/* buffer size not a multiple of the sub-channel bits per octet */
+	const struct osmo_i460_schan_desc scd32_4_odd = {
+		.rate = OSMO_I460_RATE_32k,
+		.bit_offset = 4,
+		.demux = {
+			.num_bits = 13,
+			.out_cb_bits = bits_cb,
+			.user_data = "32k_4",
+		},
+	};
+	uint8_t data[11];
+	int i;
+
+	/* Initialization */
+	printf("\n==> %s\n", __func__);
+	osmo_i460_ts_init(ts);
+	osmo_i460_subchan_add(NULL, ts, &scd16_2_bytes);
+	osmo_i460_subchan_add(NULL, ts, &scd32_4_odd);
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = 0x10 + i * 0x11;
+
+	/* feed in a block not completing an output octet of 16k_2, then the rest */
+	osmo_i460_demux_in(ts, data, 3);
+	osmo_i460_demux_in(ts, data + 3, sizeof(data) - 3);
+
+	osmo_i460_subchan_del(&ts->schan[0]);
+	osmo_i460_subchan_del(&ts->schan[1]);
+}
+
 int main(int argc, char **argv)
 {
 	test_no_subchan();
@@ -395,5 +444,6 @@ int main(int argc, char **argv)
 	test_16k_subchan();
 	test_8k_subchan();
 	test_unused_subchan();
+	test_demux_bytes();
 	return 0;
 }
@@ -1,5 +1,8 @@
 #include <stdio.h>
 #include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <inttypes.h>
 
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/utils.h>
@@ -64,6 +67,8 @@ static void tc_queue_length(void)
 	item = talloc_zero(OTC_GLOBAL, struct it_q_test1);
 	rc = osmo_it_q_enqueue(q1, item, list);
 	OSMO_ASSERT(rc == -ENOSPC);
+	talloc_free(item);
+	printf("depth %u, dropped %" PRIu64 "\n", osmo_it_q_depth(q1), osmo_it_q_dropped(q1));
 
 	osmo_it_q_destroy(q1);
 }
@@ -111,10 +116,155 @@ static void tc_eventfd(void)
 	osmo_it_q_destroy(q1);
 }
 
+static void tc_ring_queue_length(void)
+{
+	struct osmo_it_q *q1;
+	unsigned int qlen = 3;
+	struct it_q_test1 *item;
+	int i, rc;
+
+	ENTER_TC;
+
+	printf("allocating q1\n");
+	q1 = osmo_it_q_alloc_ring(OTC_GLOBAL, "q1", qlen, NULL, NULL);
+	OSMO_ASSERT(q1);
+
+	/* fill and drain twice, to wrap around the ring */
+	for (i = 0; i < 2 * qlen; i++) {
+		item = talloc_zero(OTC_GLOBAL, struct it_q_test1);
+		rc = osmo_it_q_enqueue(q1, item, list);
+		OSMO_ASSERT(rc == 0);
+		if (i % qlen == qlen - 1) {
+			printf("depth %u\n", osmo_it_q_depth(q1));
+			osmo_it_q_flush(q1);
+		}
+	}
+
+	printf("adding queue entries up to the limit\n");
+	for (i = 0; i < qlen; i++) {
+		item = talloc_zero(OTC_GLOBAL, struct it_q_test1);
+		rc = osmo_it_q_enqueue(q1, item, list);
+		OSMO_ASSERT(rc == 0);
+	}
+	printf("attempting to add more than the limit\n");
+	item = talloc_zero(OTC_GLOBAL, struct it_q_test1);
+	rc = osmo_it_q_enqueue(q1, item, list);
+	OSMO_ASSERT(rc == -ENOSPC);
+	printf("depth %u, dropped %" PRIu64 "\n", osmo_it_q_depth(q1), osmo_it_q_dropped(q1));
+
+	/* dequeue in order */
+	osmo_it_q_dequeue(q1, &item, list);
+	OSMO_ASSERT(item);
+	talloc_free(item);
+	rc = osmo_it_q_enqueue(q1, item = talloc_zero(OTC_GLOBAL, struct it_q_test1), list);
+	OSMO_ASSERT(rc == 0);
+	printf("depth %u\n", osmo_it_q_depth(q1));
+
+	osmo_it_q_destroy(q1);
+}
+
+static void tc_ring_eventfd(void)
+{
+	struct osmo_it_q *q1;
+	unsigned int qlen = 30;
+	struct it_q_test1 *item;
+	uint64_t val;
+	int i, rc;
+
+	ENTER_TC;
+
+	g_read_cb_count = 0;
+	printf("allocating q1\n");
+	q1 = osmo_it_q_alloc_ring(OTC_GLOBAL, "q1", qlen, q_read_cb, NULL);
+	OSMO_ASSERT(q1);
+
+	printf("adding %u queue entries up to the limit\n", qlen);
+	for (i = 0; i < qlen; i++) {
+		item = talloc_zero(OTC_GLOBAL, struct it_q_test1);
+		item->foo = &g_read_cb_count;
+		rc = osmo_it_q_enqueue(q1, item, list);
+		OSMO_ASSERT(rc == 0);
+	}
+
+	/* only the first item has signalled the eventfd */
+	rc = read(q1->event_ofd.fd, &val, sizeof(val));
+	OSMO_ASSERT(rc == sizeof(val));
+	printf("eventfd was signalled %" PRIu64 " times\n", val);
+	OSMO_ASSERT(write(q1->event_ofd.fd, &val, sizeof(val)) == sizeof(val));
+
+	osmo_fd_register(&q1->event_ofd);
+	osmo_select_main(1);
+	printf("%u entries were dequeued\n", g_read_cb_count);
+	OSMO_ASSERT(g_read_cb_count == qlen);
+	OSMO_ASSERT(osmo_it_q_depth(q1) == 0);
+
+	/* no wake-up without anything queued */
+	OSMO_ASSERT(osmo_select_main(1) == 0);
+
+	osmo_it_q_destroy(q1);
+}
+
+#define RING_THREADS	4
+#define RING_ITEMS	100000
+
+static void *ring_producer(void *data)
+{
+	struct osmo_it_q *q = data;
+	struct it_q_test2 *item;
+	int i;
+
+	for (i = 0; i < RING_ITEMS; i++) {
+		item = talloc_zero(NULL, struct it_q_test2);
+		item->foo = i;
+		while (osmo_it_q_enqueue(q, item, list) < 0)
+			usleep(100);
+	}
+	return NULL;
+}
+
+static int g_ring_count;
+
+static void ring_read_cb(struct osmo_it_q *q, struct llist_head *item)
+{
+	struct it_q_test2 *it = container_of(item, struct it_q_test2, list);
+	g_ring_count++;
+	talloc_free(it);
+}
+
+static void tc_ring_threads(void)
+{
+	struct osmo_it_q *q1;
+	pthread_t threads[RING_THREADS];
+	int i;
+
+	ENTER_TC;
+
+	q1 = osmo_it_q_alloc_ring(OTC_GLOBAL, "q1", 64, ring_read_cb, NULL);
+	OSMO_ASSERT(q1);
+	osmo_fd_register(&q1->event_ofd);
+
+	printf("enqueueing %u items from each of %u threads\n", RING_ITEMS, RING_THREADS);
+	for (i = 0; i < RING_THREADS; i++)
+		OSMO_ASSERT(pthread_create(&threads[i], NULL, ring_producer, q1) == 0);
+
+	while (g_ring_count < RING_THREADS * RING_ITEMS)
+		osmo_select_main(0);
+
+	for (i = 0; i < RING_THREADS; i++)
+		OSMO_ASSERT(pthread_join(threads[i], NULL) == 0);
+	printf("%d entries were dequeued\n", g_ring_count);
+	OSMO_ASSERT(osmo_it_q_depth(q1) == 0);
+
+	osmo_it_q_destroy(q1);
+}
+
 int main(int argc, char **argv)
 {
 	tc_alloc();
 	tc_queue_length();
 	tc_eventfd();
+	tc_ring_queue_length();
+	tc_ring_eventfd();
+	tc_ring_threads();
 	return 0;
 }
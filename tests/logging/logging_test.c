@@ -17,8 +17,13 @@
 
 #include <osmocom/core/logging.h>
 #include <osmocom/core/utils.h>
+#include <osmocom/core/rate_ctr.h>
 
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 enum {
 	DRLL,
@@ -65,6 +70,108 @@ const struct log_info log_info = {
 
 extern struct log_info *osmo_log_info;
 
+static bool async;
+
+/* In async mode, output the queued messages before changing the format */
+static void flush_async(void)
+{
+	if (async)
+		log_async_flush();
+}
+
+#define ASYNC_THREADS		4
+#define ASYNC_MSGS_PER_THREAD	5000
+
+static void *async_thread(void *arg)
+{
+	int i;
+
+	for (i = 0; i < ASYNC_MSGS_PER_THREAD; i++)
+		LOGP(DMM, LOGL_ERROR, "thread %ld message %d\n", (long)arg, i);
+	return NULL;
+}
+
+/* log from several threads at once to a file target; each message must be
+ * either queued or counted as dropped */
+static void test_async_threads(struct log_target *stderr_target)
+{
+	struct log_target *null_target = log_target_create_file("/dev/null");
+	struct rate_ctr_group *ctrg;
+	pthread_t threads[ASYNC_THREADS];
+	uint64_t queued, dropped;
+	long i;
+
+	OSMO_ASSERT(null_target);
+	log_set_all_filter(null_target, 1);
+	log_set_category_filter(null_target, DMM, 1, LOGL_ERROR);
+	log_set_category_filter(stderr_target, DMM, 0, LOGL_ERROR);
+	log_tgt_mutex_lock();
+	log_add_target(null_target);
+	log_tgt_mutex_unlock();
+
+	for (i = 0; i < ASYNC_THREADS; i++)
+		OSMO_ASSERT(pthread_create(&threads[i], NULL, async_thread, (void *)i) == 0);
+	for (i = 0; i < ASYNC_THREADS; i++)
+		pthread_join(threads[i], NULL);
+	log_async_flush();
+
+	ctrg = rate_ctr_get_group_by_name_idx("log:async", 0);
+	OSMO_ASSERT(ctrg);
+	rate_ctr_group_sync(ctrg);
+	queued = rate_ctr_group_get_ctr(ctrg, LOG_ASYNC_CTR_QUEUED)->current;
+	dropped = rate_ctr_group_get_ctr(ctrg, LOG_ASYNC_CTR_DROP_FULL)->current;
+	OSMO_ASSERT(queued + dropped >= ASYNC_THREADS * ASYNC_MSGS_PER_THREAD);
+	OSMO_ASSERT(rate_ctr_group_get_ctr(ctrg, LOG_ASYNC_CTR_DROP_WRITE)->current == 0);
+
+	log_tgt_mutex_lock();
+	log_target_destroy(null_target);
+	log_tgt_mutex_unlock();
+}
+
+/* a message queued for a deleted target must not be output to a target added
+ * afterwards, which got the bit of the deleted one */
+static void test_async_bit_reuse(void)
+{
+	char fname[] = "/tmp/logging_test_XXXXXX";
+	struct log_target *old_target, *new_target;
+	struct stat st;
+	int fd, bit;
+
+	fd = mkstemp(fname);
+	OSMO_ASSERT(fd >= 0);
+	close(fd);
+
+	old_target = log_target_create_file("/dev/null");
+	OSMO_ASSERT(old_target);
+	log_set_all_filter(old_target, 1);
+	log_set_category_filter(old_target, DMM, 1, LOGL_ERROR);
+	log_tgt_mutex_lock();
+	log_add_target(old_target);
+	log_tgt_mutex_unlock();
+
+	LOGP(DMM, LOGL_ERROR, "queued for the deleted target\n");
+
+	log_tgt_mutex_lock();
+	bit = old_target->async_bit;
+	log_target_destroy(old_target);
+	new_target = log_target_create_file(fname);
+	OSMO_ASSERT(new_target);
+	log_set_all_filter(new_target, 1);
+	log_set_category_filter(new_target, DMM, 1, LOGL_ERROR);
+	log_add_target(new_target);
+	log_tgt_mutex_unlock();
+	OSMO_ASSERT(new_target->async_bit == bit);
+
+	log_async_flush();
+	OSMO_ASSERT(stat(fname, &st) == 0);
+	OSMO_ASSERT(st.st_size == 0);
+
+	log_tgt_mutex_lock();
+	log_target_destroy(new_target);
+	log_tgt_mutex_unlock();
+	unlink(fname);
+}
+
 int main(int argc, char **argv)
 {
 	struct log_target *stderr_target;
@@ -83,6 +190,12 @@ int main(int argc, char **argv)
 	else
 		log_target_file_switch_to_stream(stderr_target);
 
+	if (argc > 1 && !strcmp(argv[1], "async")) {
+		/* smallest ring, to also exercise dropping in test_async_threads() */
+		OSMO_ASSERT(log_async_enable(16384) == 0);
+		async = true;
+	}
+
 	log_parse_category_mask(stderr_target, "DRLL:DCC");
 	log_parse_category_mask(stderr_target, "DRLL");
 
@@ -130,13 +243,34 @@ int main(int argc, char **argv)
 	log_set_category_filter(stderr_target, DLGLOBAL, 1, LOGL_DEBUG);
 	DEBUGP(DLGLOBAL, "You should see this (DLGLOBAL on DEBUG)\n");
 
+	/* Check the cached minimum level of a subsystem */
+	log_set_category_filter(stderr_target, DMM, 1, LOGL_NOTICE);
+	OSMO_ASSERT(log_check_level(DMM, LOGL_INFO) == 0);
+	OSMO_ASSERT(log_check_level(DMM, LOGL_NOTICE) != 0);
+	log_set_log_level(stderr_target, LOGL_ERROR);
+	OSMO_ASSERT(log_check_level(DMM, LOGL_NOTICE) == 0);
+	log_set_log_level(stderr_target, 0);
+	stderr_target->categories[DMM].loglevel = LOGL_DEBUG;
+	log_level_cache_update();
+	OSMO_ASSERT(log_check_level(DMM, LOGL_DEBUG) != 0);
+	log_set_category_filter(stderr_target, DMM, 0, LOGL_DEBUG);
+	OSMO_ASSERT(log_check_level(DMM, LOGL_FATAL) == 0);
+
 	/* Test printing of the filename */
+	flush_async();
 	log_set_print_filename2(stderr_target, LOG_FILENAME_BASENAME);
 
 	log_set_print_filename_pos(stderr_target, LOG_FILENAME_POS_HEADER_END);
 	DEBUGP(DLGLOBAL, "A message with source info printed first\n");
+	flush_async();
 	log_set_print_filename_pos(stderr_target, LOG_FILENAME_POS_LINE_END);
 	DEBUGP(DLGLOBAL, "A message with source info printed last\n");
 
+	if (async) {
+		test_async_threads(stderr_target);
+		test_async_bit_reuse();
+		log_async_disable();
+	}
+
 	return 0;
 }
@@ -0,0 +1,268 @@
+/* Test of the binary log target and reader */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <osmocom/core/logging.h>
+#include <osmocom/core/logging_bin.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+
+#define TMP_FNAME	"logging_bin_test.tmp"
+#define TMP_FNAME_OLD	TMP_FNAME ".1"
+
+enum {
+	DRLL,
+	DCC,
+};
+
+static const struct log_info_cat default_categories[] = {
+	[DRLL] = {
+		  .name = "DRLL",
+		  .description = "A-bis Radio Link Layer (RLL)",
+		  .enabled = 1, .loglevel = LOGL_NOTICE,
+		  },
+	[DCC] = {
+		 .name = "DCC",
+		 .description = "Layer3 Call Control (CC)",
+		 .enabled = 1, .loglevel = LOGL_NOTICE,
+		 },
+};
+
+const struct log_info log_info = {
+	.cat = default_categories,
+	.num_cat = ARRAY_SIZE(default_categories),
+};
+
+static char expected[64][256];
+static unsigned int num_expected;
+
+/* log a message, and remember how vsnprintf() formats it */
+#define LOG_CHECK(ss, fmt, args...) do { \
+		OSMO_ASSERT(num_expected < ARRAY_SIZE(expected)); \
+		snprintf(expected[num_expected++], sizeof(expected[0]), fmt, ##args); \
+		LOGP(ss, LOGL_NOTICE, fmt, ##args); \
+	} while (0)
+
+static struct log_target *create_target(size_t ring_size)
+{
+	struct log_target *tgt = log_target_create_bin(TMP_FNAME, ring_size);
+
+	OSMO_ASSERT(tgt);
+	log_add_target(tgt);
+	log_set_all_filter(tgt, 1);
+	return tgt;
+}
+
+static void test_formats(void)
+{
+	struct log_target *tgt;
+	struct log_bin_reader *rd;
+	static struct log_bin_msg msg;
+	char buf[4] = { 'a', 'b', 'c', 'd' };
+	static char fmt[32];
+	unsigned int i;
+
+	printf("%s\n", __func__);
+
+	tgt = create_target(0);
+
+	LOG_CHECK(DRLL, "plain message\n");
+	LOG_CHECK(DRLL, "int %d uint %u hex %x %08X char %c\n", -42, 42u, 0xdead, 0xbeef, 'x');
+	LOG_CHECK(DRLL, "short %hd %hhu\n", (short)-3, (unsigned char)200);
+	LOG_CHECK(DCC, "long %ld %lu %lx\n", -1234567890L, 4000000000UL, 0xcafeUL);
+	LOG_CHECK(DCC, "long long %lld %llu %#llx\n", -1234567890123LL, 18446744073709551615ULL, 0x123456789aULL);
+	LOG_CHECK(DCC, "size %zu ssize %zd ptrdiff %td intmax %jd\n", (size_t)4096, (ssize_t)-1,
+		  (ptrdiff_t)-7, (intmax_t)-8);
+	LOG_CHECK(DCC, "double %f %.3e %g |%10.2f|%-8.1f|\n", 3.14159, 12345.678, 0.0001, -2.5, 7.25);
+	LOG_CHECK(DCC, "long double %Lf\n", (long double)1.5);
+	LOG_CHECK(DRLL, "string '%s' '%10s' '%-6s' '%.3s' '%.*s' '%*d'\n", "abc", "right", "left", "truncate",
+		  2, "xyz", 5, 42);
+	LOG_CHECK(DRLL, "unterminated '%.4s'\n", buf);
+	LOG_CHECK(DRLL, "pointer %p %p\n", (void *)0x1234, NULL);
+	LOG_CHECK(DRLL, "percent 100%% done, %s\n", "50% %d literal");
+	errno = ENOENT;
+	LOG_CHECK(DRLL, "formatted when logged: %m\n");
+	LOG_CHECK(DRLL, "formatted when logged: %2$s %1$s\n", "world", "hello");
+	LOG_CHECK(DLGLOBAL, "library category %u", 1);
+	/* continuation */
+	snprintf(expected[num_expected++], sizeof(expected[0]), " continued %d\n", 2);
+	LOGPC(DLGLOBAL, LOGL_NOTICE, " continued %d\n", 2);
+	/* the same format string again */
+	for (i = 0; i < 3; i++)
+		LOG_CHECK(DCC, "loop %u\n", i);
+	/* a format string which is not a literal, replaced by another one at the same address */
+	strcpy(fmt, "changing %d\n");
+	LOG_CHECK(DCC, fmt, 1);
+	strcpy(fmt, "changed to %s\n");
+	LOG_CHECK(DCC, fmt, "a string");
+	/* not logged, below the level of the category */
+	LOGP(DRLL, LOGL_DEBUG, "You should not see this\n");
+
+	rd = log_bin_reader_open(NULL, TMP_FNAME);
+	OSMO_ASSERT(rd);
+	for (i = 0; i < num_expected; i++) {
+		OSMO_ASSERT(log_bin_reader_next(rd, &msg) == 1);
+		if (strcmp(msg.text, expected[i])) {
+			printf("MISMATCH: expected '%s', got '%s'\n", expected[i], msg.text);
+			OSMO_ASSERT(0);
+		}
+		OSMO_ASSERT(msg.file && strstr(msg.file, "logging_bin_test.c"));
+		OSMO_ASSERT(msg.line > 0);
+		printf("%s level %u%s: %s\n", msg.category, msg.level, msg.cont ? " (cont)" : "",
+		       osmo_escape_str(msg.text, -1));
+	}
+	OSMO_ASSERT(log_bin_reader_next(rd, &msg) == 0);
+	log_bin_reader_close(rd);
+
+	log_target_destroy(tgt);
+}
+
+static void test_long_message(void)
+{
+	struct log_target *tgt;
+	struct log_bin_reader *rd;
+	static struct log_bin_msg msg;
+	static char str[LOG_BIN_REC_MAX * 2];
+
+	printf("%s\n", __func__);
+
+	memset(str, 'x', sizeof(str) - 1);
+	tgt = create_target(0);
+	LOGP(DRLL, LOGL_NOTICE, "long %s %d\n", str, 1);
+	LOGP(DRLL, LOGL_NOTICE, "after %s\n", "long");
+
+	rd = log_bin_reader_open(NULL, TMP_FNAME);
+	OSMO_ASSERT(rd);
+	/* the string is truncated to fit into the record, the following
+	 * integer doesn't fit anymore: formatted when logged, truncated */
+	OSMO_ASSERT(log_bin_reader_next(rd, &msg) == 1);
+	printf("truncated to %zu characters\n", strlen(msg.text));
+	OSMO_ASSERT(!strncmp(msg.text, "long xxx", 8));
+	OSMO_ASSERT(log_bin_reader_next(rd, &msg) == 1);
+	printf("%s", msg.text);
+	OSMO_ASSERT(log_bin_reader_next(rd, &msg) == 0);
+	log_bin_reader_close(rd);
+
+	log_target_destroy(tgt);
+}
+
+static void test_wrap(void)
+{
+	const unsigned int num_msgs = 10000;
+	struct log_target *tgt;
+	struct log_bin_reader *rd;
+	static struct log_bin_msg msg;
+	unsigned int i, first = 0, num = 0;
+	int rc;
+
+	printf("%s\n", __func__);
+
+	/* the minimum ring size */
+	tgt = create_target(1);
+	for (i = 0; i < num_msgs; i++)
+		LOGP(DCC, LOGL_NOTICE, "message %u with %s\n", i, "some text to fill the ring");
+
+	rd = log_bin_reader_open(NULL, TMP_FNAME);
+	OSMO_ASSERT(rd);
+	while ((rc = log_bin_reader_next(rd, &msg)) > 0) {
+		unsigned int n;
+
+		OSMO_ASSERT(sscanf(msg.text, "message %u", &n) == 1);
+		if (num == 0)
+			first = n;
+		/* the newest messages, without gaps */
+		OSMO_ASSERT(n == first + num);
+		num++;
+	}
+	OSMO_ASSERT(rc == 0);
+	OSMO_ASSERT(num > 0 && num < num_msgs);
+	OSMO_ASSERT(first + num == num_msgs);
+	printf("oldest messages overwritten: %s\n", first > 0 ? "yes" : "no");
+	log_bin_reader_close(rd);
+
+	log_target_destroy(tgt);
+}
+
+static void test_previous_file(void)
+{
+	struct log_target *tgt;
+	struct log_bin_reader *rd;
+	static struct log_bin_msg msg;
+
+	printf("%s\n", __func__);
+
+	tgt = create_target(0);
+	LOGP(DRLL, LOGL_NOTICE, "first run\n");
+	log_target_destroy(tgt);
+
+	tgt = create_target(0);
+	LOGP(DRLL, LOGL_NOTICE, "second run\n");
+	log_target_destroy(tgt);
+
+	rd = log_bin_reader_open(NULL, TMP_FNAME_OLD);
+	OSMO_ASSERT(rd);
+	OSMO_ASSERT(log_bin_reader_next(rd, &msg) == 1);
+	printf(TMP_FNAME_OLD ": %s", msg.text);
+	OSMO_ASSERT(log_bin_reader_next(rd, &msg) == 0);
+	log_bin_reader_close(rd);
+
+	rd = log_bin_reader_open(NULL, TMP_FNAME);
+	OSMO_ASSERT(rd);
+	OSMO_ASSERT(log_bin_reader_next(rd, &msg) == 1);
+	printf(TMP_FNAME ": %s", msg.text);
+	OSMO_ASSERT(log_bin_reader_next(rd, &msg) == 0);
+	log_bin_reader_close(rd);
+}
+
+static void test_invalid_file(void)
+{
+	FILE *f;
+
+	printf("%s\n", __func__);
+
+	f = fopen(TMP_FNAME, "w");
+	OSMO_ASSERT(f);
+	fprintf(f, "not a binary log file\n");
+	fclose(f);
+
+	OSMO_ASSERT(!log_bin_reader_open(NULL, TMP_FNAME));
+	printf("errno: %s\n", strerror(errno));
+}
+
+int main(int argc, char **argv)
+{
+	void *ctx = talloc_named_const(NULL, 0, "logging_bin_test");
+
+	log_init(&log_info, ctx);
+
+	test_formats();
+	test_long_message();
+	test_wrap();
+	test_previous_file();
+	test_invalid_file();
+
+	unlink(TMP_FNAME);
+	unlink(TMP_FNAME_OLD);
+	return 0;
+}
@@ -15,11 +15,16 @@
  */
 
 #include <stdlib.h>
+#include <inttypes.h>
 #include <osmocom/core/application.h>
 #include <osmocom/core/logging.h>
 #include <osmocom/core/utils.h>
 #include <osmocom/core/msgb.h>
+#include <osmocom/core/msgb_chain.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/stat_item.h>
 #include <setjmp.h>
+#include <pthread.h>
 
 #include <errno.h>
 
@@ -377,19 +382,199 @@ static void test_msgb_printf()
 	msgb_free(msg_ref);
 }
 
+static void *msgb_ctx;
+
+static void print_chain(const char *label, const struct msgb_chain *chain)
+{
+	struct iovec iov[8];
+	int i, n;
+
+	n = msgb_chain_to_iovec(chain, iov, ARRAY_SIZE(iov));
+	OSMO_ASSERT(n == chain->num_segs);
+	printf("%s: len=%u segs=%d:", label, msgb_chain_length(chain), n);
+	for (i = 0; i < n; i++)
+		printf(" [%s]", osmo_hexdump_nospc(iov[i].iov_base, iov[i].iov_len));
+	printf("\n");
+}
+
+static struct msgb *chain_test_msgb(uint8_t first, unsigned int len)
+{
+	struct msgb *msg = msgb_alloc_headroom(64, 8, "chain payload");
+	unsigned int i;
+
+	for (i = 0; i < len; i++)
+		msgb_put_u8(msg, first + i);
+	return msg;
+}
+
+static void test_msgb_chain(void *ctx)
+{
+	size_t msgb_blocks = talloc_total_blocks(msgb_ctx);
+	struct msgb_chain *chain, *frag;
+	struct msgb *msg;
+	struct iovec iov[1];
+	uint8_t *hdr;
+
+	printf("Testing msgb chains\n");
+
+	chain = msgb_chain_alloc(ctx, "chain");
+	OSMO_ASSERT(msgb_chain_append_msgb(chain, chain_test_msgb(0x10, 4)) == 0);
+	OSMO_ASSERT(msgb_chain_append_msgb(chain, chain_test_msgb(0x20, 6)) == 0);
+	OSMO_ASSERT(msgb_chain_append_msgb(chain, msgb_alloc(16, "empty")) == 0);
+	print_chain("append", chain);
+	OSMO_ASSERT(msgb_chain_to_iovec(chain, iov, ARRAY_SIZE(iov)) == -ENOSPC);
+
+	/* fits into the headroom of the first msgb */
+	hdr = msgb_chain_push(chain, 2);
+	hdr[0] = 0xa0;
+	hdr[1] = 0xa1;
+	print_chain("push 2", chain);
+	/* exceeds the headroom, a header segment is prepended */
+	hdr = msgb_chain_push(chain, 7);
+	memset(hdr, 0xb0, 7);
+	print_chain("push 7", chain);
+
+	/* split within the third segment: it is shared by both chains */
+	frag = msgb_chain_split(chain, 11, "fragment");
+	OSMO_ASSERT(frag);
+	print_chain("split 11, head", frag);
+	print_chain("split 11, tail", chain);
+	OSMO_ASSERT(msgb_chain_split(chain, 9, "too long") == NULL);
+
+	/* a shared segment must not be pushed into in-place */
+	hdr = msgb_chain_push(chain, 1);
+	*hdr = 0xc0;
+	print_chain("push 1 on tail", chain);
+
+	OSMO_ASSERT(msgb_chain_pull(chain, 10) == -EINVAL);
+	OSMO_ASSERT(msgb_chain_pull(chain, 3) == 0);
+	print_chain("pull 3", chain);
+
+	msg = msgb_chain_linearize(frag, ctx, 4, "linear");
+	OSMO_ASSERT(msgb_headroom(msg) == 4);
+	printf("linearize: %s\n", msgb_hexdump(msg));
+	msgb_free(msg);
+
+	/* the shared msgb is released with the last chain referring to it */
+	msgb_chain_free(frag);
+	msgb_chain_free(chain);
+	OSMO_ASSERT(talloc_total_blocks(msgb_ctx) == msgb_blocks);
+}
+
+/* msgb_set_talloc_ctx() is how existing msgb_alloc() users opt in to a msgb pool */
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+static void print_pool_stats(struct msgb_pool *pool)
+{
+	struct rate_ctr_group *ctrg = msgb_pool_get_ctrg(pool);
+	struct osmo_stat_item_group *statg = msgb_pool_get_statg(pool);
+
+	printf("  in_use=%u hit=%"PRIu64" miss=%"PRIu64" oversize=%"PRIu64" in_use_max=%d\n",
+	       msgb_pool_in_use(pool),
+	       rate_ctr_group_get_ctr(ctrg, 0)->current,
+	       rate_ctr_group_get_ctr(ctrg, 1)->current,
+	       rate_ctr_group_get_ctr(ctrg, 2)->current,
+	       osmo_stat_item_get_last(osmo_stat_item_group_get_item(statg, 1)));
+}
+
+/* a pool must not be used from another thread */
+static void *msgb_pool_other_thread(void *data)
+{
+	struct msgb_pool *pool = data;
+	volatile int e = 0;
+
+	if (OSMO_PANIC_TRY(&e))
+		msgb_alloc_pool(pool, 100, "other thread");
+	OSMO_ASSERT(e != 0);
+	return NULL;
+}
+
+static void test_msgb_pool(void *ctx)
+{
+	static const uint16_t sizes[] = { 128, 1024 };
+	void *other_ctx = talloc_named_const(ctx, 0, "other");
+	struct msgb_pool *pool;
+	struct msgb *msg, *msg2, *msg3;
+	pthread_t thread;
+
+	printf("Testing msgb pool\n");
+
+	OSMO_ASSERT(msgb_pool_create(ctx, 0, sizes, 0, 1, 0) == NULL);
+	pool = msgb_pool_create(ctx, 0, sizes, ARRAY_SIZE(sizes), 1, 0);
+	OSMO_ASSERT(pool);
+
+	printf("allocate from the pre-allocated free lists:\n");
+	msg = msgb_alloc_pool(pool, 100, "small");
+	OSMO_ASSERT(msg);
+	OSMO_ASSERT(msg->data_len == 100);
+	OSMO_ASSERT(msgb_tailroom(msg) == 100);
+	OSMO_ASSERT(msgb_length(msg) == 0);
+	msg2 = msgb_alloc_pool(pool, 1000, "large");
+	OSMO_ASSERT(msg2);
+	print_pool_stats(pool);
+
+	printf("free and allocate again, the msgb is recycled:\n");
+	msgb_put_u32(msg, 0xdeadbeef);
+	msgb_free(msg);
+	msg3 = msgb_alloc_pool(pool, 128, "recycled");
+	OSMO_ASSERT(msg3 == msg);
+	OSMO_ASSERT(msgb_length(msg3) == 0 && msgb_tailroom(msg3) == 128);
+	OSMO_ASSERT(msg3->l1h == NULL && msg3->l2h == NULL && msg3->l3h == NULL);
+	print_pool_stats(pool);
+
+	printf("empty free list, the pool grows:\n");
+	msg = msgb_alloc_pool(pool, 50, "grown");
+	OSMO_ASSERT(msg && msg != msg3);
+	print_pool_stats(pool);
+
+	printf("oversize allocation is not pooled:\n");
+	msgb_free(msgb_alloc_pool(pool, 2000, "oversize"));
+	print_pool_stats(pool);
+
+	printf("msgb stolen to another ctx still returns to the pool:\n");
+	talloc_steal(other_ctx, msg);
+	talloc_free(other_ctx);
+	msgb_free(msg2);
+	msgb_free(msg3);
+	print_pool_stats(pool);
+
+	printf("msgb_alloc() with the pool as msgb talloc ctx:\n");
+	msgb_set_talloc_ctx(pool);
+	msg = msgb_alloc(200, "via msgb_alloc");
+	OSMO_ASSERT(msg);
+	OSMO_ASSERT(talloc_parent(msg) == pool);
+	msgb_free(msg);
+	msg = msgb_alloc_headroom(120, 20, "via msgb_alloc_headroom");
+	OSMO_ASSERT(msgb_headroom(msg) == 20 && msgb_tailroom(msg) == 100);
+	msgb_free(msg);
+	print_pool_stats(pool);
+	msgb_set_talloc_ctx(msgb_ctx);
+
+	printf("allocation from another thread:\n");
+	osmo_set_panic_handler(osmo_panic_raise);
+	OSMO_ASSERT(pthread_create(&thread, NULL, msgb_pool_other_thread, pool) == 0);
+	OSMO_ASSERT(pthread_join(thread, NULL) == 0);
+	osmo_set_panic_handler(NULL);
+	print_pool_stats(pool);
+
+	msgb_pool_destroy(pool);
+}
+
 static struct log_info info = {};
 
 int main(int argc, char **argv)
 {
 	void *ctx = talloc_named_const(NULL, 0, "msgb_test");
 	osmo_init_logging2(ctx, &info);
-	msgb_talloc_ctx_init(ctx, 0);
+	msgb_ctx = msgb_talloc_ctx_init(ctx, 0);
 
 	test_msgb_api();
 	test_msgb_api_errors();
 	test_msgb_copy();
 	test_msgb_resize_area();
 	test_msgb_printf();
+	test_msgb_pool(ctx);
+	test_msgb_chain(ctx);
 
 	printf("Success.\n");
 
@@ -23,6 +23,8 @@
 #include <errno.h>
 
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 
@@ -388,6 +390,50 @@ static void test_osa_str(void)
 const struct log_info_cat default_categories[] = {
 };
 
+static void test_sock_sendiov(void)
+{
+	struct iovec iov[2] = {
+		{ .iov_base = "hello ", .iov_len = 6 },
+		{ .iov_base = "world", .iov_len = 5 },
+	};
+	struct osmo_sockaddr dst = {};
+	socklen_t len = sizeof(dst.u.sas);
+	struct sockaddr_un *sun = (struct sockaddr_un *)&dst.u.sas;
+	char buf[64];
+	int rx, tx, rc;
+
+	printf("Checking osmo_sock_sendiov() to an AF_INET address\n");
+	rx = osmo_sock_init2(AF_INET, SOCK_DGRAM, IPPROTO_UDP, "127.0.0.1", 0, NULL, 0, OSMO_SOCK_F_BIND);
+	OSMO_ASSERT(rx >= 0);
+	OSMO_ASSERT(getsockname(rx, &dst.u.sa, &len) == 0);
+	tx = socket(AF_INET, SOCK_DGRAM, 0);
+	OSMO_ASSERT(tx >= 0);
+	rc = osmo_sock_sendiov(tx, iov, ARRAY_SIZE(iov), &dst, 0);
+	OSMO_ASSERT(rc == 11);
+	rc = recv(rx, buf, sizeof(buf), 0);
+	printf("received '%.*s'\n", rc, buf);
+	close(tx);
+	close(rx);
+
+	printf("Checking osmo_sock_sendiov() to an AF_UNIX address\n");
+	memset(&dst, 0, sizeof(dst));
+	sun->sun_family = AF_UNIX;
+	snprintf(sun->sun_path, sizeof(sun->sun_path), "/tmp/socket_test.%d", (int)getpid());
+	unlink(sun->sun_path);
+	rx = socket(AF_UNIX, SOCK_DGRAM, 0);
+	OSMO_ASSERT(rx >= 0);
+	OSMO_ASSERT(bind(rx, (struct sockaddr *)sun, sizeof(*sun)) == 0);
+	tx = socket(AF_UNIX, SOCK_DGRAM, 0);
+	OSMO_ASSERT(tx >= 0);
+	rc = osmo_sock_sendiov(tx, iov, ARRAY_SIZE(iov), &dst, 0);
+	OSMO_ASSERT(rc == 11);
+	rc = recv(rx, buf, sizeof(buf), 0);
+	printf("received '%.*s'\n", rc, buf);
+	close(tx);
+	close(rx);
+	unlink(sun->sun_path);
+}
+
 static struct log_info info = {
 	.cat = default_categories,
 	.num_cat = ARRAY_SIZE(default_categories),
@@ -407,6 +453,7 @@ int main(int argc, char *argv[])
 	test_get_ip_and_port();
 	test_sockinit_osa();
 	test_osa_str();
+	test_sock_sendiov();
 
 	return EXIT_SUCCESS;
 }
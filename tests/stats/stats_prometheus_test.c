@@ -0,0 +1,310 @@
+/* Test of the Prometheus / OpenMetrics exporter */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <osmocom/core/application.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/select.h>
+#include <osmocom/core/stat_item.h>
+#include <osmocom/core/stats.h>
+#include <osmocom/core/stats_prometheus.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+
+enum test_ctr {
+	TEST_A_CTR,
+	TEST_B_CTR,
+};
+
+static const struct rate_ctr_desc ctr_description[] = {
+	[TEST_A_CTR] = { "ctr:a", "The A counter value" },
+	[TEST_B_CTR] = { "ctr:b", "The B counter value\nwith a \\ newline and \"quotes\"" },
+};
+
+static const struct rate_ctr_group_desc ctrg_desc = {
+	.group_name_prefix = "ctr-test",
+	.group_description = "Counter test",
+	.num_ctr = ARRAY_SIZE(ctr_description),
+	.ctr_desc = ctr_description,
+	.class_id = OSMO_STATS_CLASS_SUBSCRIBER,
+};
+
+enum test_items {
+	TEST_A_ITEM,
+	TEST_B_ITEM,
+};
+
+static const struct osmo_stat_item_desc item_description[] = {
+	[TEST_A_ITEM] = { "item.a", "The A value", "ms", 4, -1 },
+	[TEST_B_ITEM] = { "item.b", "The B value", OSMO_STAT_ITEM_NO_UNIT, 7, -1 },
+};
+
+static const struct osmo_stat_item_group_desc statg_desc = {
+	.group_name_prefix = "test.one",
+	.group_description = "Test number 1",
+	.num_items = ARRAY_SIZE(item_description),
+	.item_desc = item_description,
+	.class_id = OSMO_STATS_CLASS_PEER,
+};
+
+/* an item with the same group name prefix and name as a counter */
+static const struct osmo_stat_item_desc item_description2[] = {
+	{ "ctr:a", "An A item", OSMO_STAT_ITEM_NO_UNIT, 4, -1 },
+};
+
+static const struct osmo_stat_item_group_desc statg_desc2 = {
+	.group_name_prefix = "ctr-test",
+	.group_description = "Test clashing with the counters",
+	.num_items = ARRAY_SIZE(item_description2),
+	.item_desc = item_description2,
+	.class_id = OSMO_STATS_CLASS_PEER,
+};
+
+static void *ctx;
+
+/* Send a request to the exporter and return the complete response */
+static char *http_request(const char *req, void (*between)(void))
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(osmo_stats_prometheus_config->local_port),
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+	};
+	size_t len = 0, size = 4096;
+	char *resp = talloc_size(ctx, size);
+	int rcvbuf = 4096;
+	int fd, rc;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	OSMO_ASSERT(fd >= 0);
+	/* make the exporter wait for the socket to become writable */
+	OSMO_ASSERT(setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) == 0);
+	OSMO_ASSERT(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+	OSMO_ASSERT(send(fd, req, strlen(req), 0) == strlen(req));
+
+	while (1) {
+		osmo_select_main(1);
+		if (len + 1 == size) {
+			size *= 2;
+			resp = talloc_realloc_size(ctx, resp, size);
+		}
+		rc = recv(fd, resp + len, size - 1 - len, MSG_DONTWAIT);
+		if (rc < 0 && errno == EAGAIN)
+			continue;
+		OSMO_ASSERT(rc >= 0);
+		if (rc == 0)
+			break;
+		if (len == 0 && between)
+			between();
+		len += rc;
+	}
+	resp[len] = '\0';
+	close(fd);
+	return resp;
+}
+
+static void test_scrape(void)
+{
+	struct rate_ctr_group *ctrg1, *ctrg2;
+	struct osmo_stat_item_group *statg, *statg2;
+	char *resp;
+
+	printf("%s\n", __func__);
+
+	ctrg1 = rate_ctr_group_alloc(ctx, &ctrg_desc, 0);
+	ctrg2 = rate_ctr_group_alloc_mt(ctx, &ctrg_desc, 1);
+	rate_ctr_group_set_name(ctrg2, "peer \"two\"");
+	statg = osmo_stat_item_group_alloc(ctx, &statg_desc, 3);
+	statg2 = osmo_stat_item_group_alloc(ctx, &statg_desc2, 0);
+	OSMO_ASSERT(ctrg1 && ctrg2 && statg && statg2);
+
+	rate_ctr_add(rate_ctr_group_get_ctr(ctrg1, TEST_A_CTR), 5);
+	/* still in the per-thread shards */
+	rate_ctr_add2(ctrg2, TEST_B_CTR, 1234567890);
+	osmo_stat_item_set(osmo_stat_item_group_get_item(statg, TEST_A_ITEM), -42);
+	osmo_stat_item_set(osmo_stat_item_group_get_item(statg2, 0), 7);
+
+	resp = http_request("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n", NULL);
+	printf("%s", resp);
+	talloc_free(resp);
+
+	rate_ctr_group_free(ctrg1);
+	rate_ctr_group_free(ctrg2);
+	osmo_stat_item_group_free(statg);
+	osmo_stat_item_group_free(statg2);
+}
+
+static void test_requests(void)
+{
+	const char *reqs[] = {
+		"HEAD /metrics HTTP/1.0\r\n\r\n",
+		"GET /foo HTTP/1.1\r\n\r\n",
+		"POST /metrics HTTP/1.1\r\n\r\n",
+		"GET /?foo=bar HTTP/1.0\n\n",
+	};
+	unsigned int i;
+
+	printf("%s\n", __func__);
+
+	for (i = 0; i < ARRAY_SIZE(reqs); i++) {
+		char *resp = http_request(reqs[i], NULL);
+		printf("%s-> %s", osmo_escape_str(reqs[i], -1), resp);
+		talloc_free(resp);
+	}
+}
+
+#define NUM_GROUPS 20000
+static struct rate_ctr_group *groups[NUM_GROUPS];
+
+static void free_some_groups(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < NUM_GROUPS; i += 3) {
+		rate_ctr_group_free(groups[i]);
+		groups[i] = NULL;
+	}
+}
+
+/* Check that each family is in one piece, return the number of samples */
+static unsigned int check_families(char *resp, unsigned int *num_fam)
+{
+	char *line, *saveptr = NULL;
+	char fam[64] = "";
+	unsigned int num_samples = 0;
+
+	*num_fam = 0;
+	for (line = strtok_r(resp, "\n", &saveptr); line; line = strtok_r(NULL, "\n", &saveptr)) {
+		if (!strncmp(line, "# TYPE ", 7)) {
+			OSMO_ASSERT(sscanf(line, "# TYPE %63s", fam) == 1);
+			(*num_fam)++;
+		} else if (line[0] != '#' && !strncmp(line, "ctr_test_", 9)) {
+			OSMO_ASSERT(!strncmp(line, fam, strlen(fam)));
+			/* the sample belongs to the family, and not to one with a longer name */
+			OSMO_ASSERT(!strncmp(line + strlen(fam), "_total{", 7));
+			num_samples++;
+		}
+	}
+	return num_samples;
+}
+
+static void test_large(void)
+{
+	unsigned int i, num_fam;
+	char *resp;
+
+	printf("%s\n", __func__);
+
+	for (i = 0; i < NUM_GROUPS; i++)
+		groups[i] = rate_ctr_group_alloc(ctx, &ctrg_desc, i);
+
+	resp = http_request("GET /metrics HTTP/1.1\r\n\r\n", NULL);
+	OSMO_ASSERT(strstr(resp, "\n# EOF\n"));
+	OSMO_ASSERT(check_families(resp, &num_fam) == NUM_GROUPS * ctrg_desc.num_ctr);
+	printf("%u families\n", num_fam);
+	talloc_free(resp);
+
+	/* free groups while the response is being sent */
+	resp = http_request("GET /metrics HTTP/1.1\r\n\r\n", free_some_groups);
+	OSMO_ASSERT(strstr(resp, "\n# EOF\n"));
+	OSMO_ASSERT(check_families(resp, &num_fam) < NUM_GROUPS * ctrg_desc.num_ctr);
+	printf("%u families\n", num_fam);
+	talloc_free(resp);
+
+	for (i = 0; i < NUM_GROUPS; i++)
+		rate_ctr_group_free(groups[i]);
+}
+
+#define NUM_CLASSES 2000
+static struct rate_ctr_group_desc class_desc[NUM_CLASSES];
+static char class_prefix[NUM_CLASSES][32];
+static struct rate_ctr_group *class_groups[NUM_CLASSES][2];
+
+static void free_some_classes(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < NUM_CLASSES; i += 3) {
+		rate_ctr_group_free(class_groups[i][0]);
+		rate_ctr_group_free(class_groups[i][1]);
+		class_groups[i][0] = class_groups[i][1] = NULL;
+	}
+}
+
+/* Many groups with different group name prefixes */
+static void test_many_classes(void)
+{
+	unsigned int i, num_fam;
+	char *resp;
+
+	printf("%s\n", __func__);
+
+	for (i = 0; i < NUM_CLASSES; i++) {
+		snprintf(class_prefix[i], sizeof(class_prefix[i]), "ctr-test-%u", i);
+		class_desc[i] = ctrg_desc;
+		class_desc[i].group_name_prefix = class_prefix[i];
+		class_groups[i][0] = rate_ctr_group_alloc(ctx, &class_desc[i], 0);
+		class_groups[i][1] = rate_ctr_group_alloc(ctx, &class_desc[i], 1);
+		OSMO_ASSERT(class_groups[i][0] && class_groups[i][1]);
+	}
+
+	resp = http_request("GET /metrics HTTP/1.1\r\n\r\n", NULL);
+	OSMO_ASSERT(strstr(resp, "\n# EOF\n"));
+	OSMO_ASSERT(check_families(resp, &num_fam) == NUM_CLASSES * 2 * ctrg_desc.num_ctr);
+	printf("%u families\n", num_fam);
+	talloc_free(resp);
+
+	/* free all groups of some classes while the response is being sent */
+	resp = http_request("GET /metrics HTTP/1.1\r\n\r\n", free_some_classes);
+	OSMO_ASSERT(strstr(resp, "\n# EOF\n"));
+	OSMO_ASSERT(check_families(resp, &num_fam) < NUM_CLASSES * 2 * ctrg_desc.num_ctr);
+	talloc_free(resp);
+
+	for (i = 0; i < NUM_CLASSES; i++) {
+		rate_ctr_group_free(class_groups[i][0]);
+		rate_ctr_group_free(class_groups[i][1]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	ctx = talloc_named_const(NULL, 0, "stats_prometheus_test");
+	osmo_init_logging2(ctx, NULL);
+	osmo_stat_item_init(ctx);
+
+	OSMO_ASSERT(osmo_stats_prometheus_listen(ctx, "127.0.0.1", 0) == 0);
+	OSMO_ASSERT(osmo_stats_prometheus_config->local_port != 0);
+
+	test_scrape();
+	test_requests();
+	test_large();
+	test_many_classes();
+
+	osmo_stats_prometheus_close();
+	OSMO_ASSERT(osmo_stats_prometheus_config->local_ip == NULL);
+	talloc_free(ctx);
+	return 0;
+}
@@ -29,6 +29,7 @@
 
 #include <stdio.h>
 #include <inttypes.h>
+#include <pthread.h>
 
 enum test_ctr {
 	TEST_A_CTR,
@@ -495,6 +496,228 @@ static void test_reporting()
 	fprintf(stderr, "End test: %s\n", __func__);
 }
 
+static void test_reporting_dirty(void)
+{
+	struct osmo_stats_reporter *srep;
+	struct osmo_stat_item_group *statg1, *statg2;
+	struct rate_ctr_group *ctrg1, *ctrg2;
+	void *stats_ctx = talloc_named_const(NULL, 1, "stats test context");
+	int rc;
+
+	fprintf(stderr, "Start test: %s\n", __func__);
+
+	statg1 = osmo_stat_item_group_alloc(stats_ctx, &statg_desc, 1);
+	OSMO_ASSERT(statg1 != NULL);
+	statg2 = osmo_stat_item_group_alloc(stats_ctx, &statg_desc, 2);
+	OSMO_ASSERT(statg2 != NULL);
+	ctrg1 = rate_ctr_group_alloc(stats_ctx, &ctrg_desc, 1);
+	OSMO_ASSERT(ctrg1 != NULL);
+	ctrg2 = rate_ctr_group_alloc(stats_ctx, &ctrg_desc, 2);
+	OSMO_ASSERT(ctrg2 != NULL);
+
+	srep = stats_reporter_create_test("test");
+	OSMO_ASSERT(srep != NULL);
+	rc = osmo_stats_reporter_enable(srep);
+	OSMO_ASSERT(rc >= 0);
+	rc = osmo_stats_reporter_set_max_class(srep, OSMO_STATS_CLASS_SUBSCRIBER);
+	OSMO_ASSERT(rc >= 0);
+
+	osmo_stats_set_dirty_tracking(true);
+
+	fprintf(stderr, "report (initial, flush forced):\n");
+	do_report(4, 4);
+
+	fprintf(stderr, "report (should be empty):\n");
+	do_report(0, 0);
+
+	fprintf(stderr, "report (group 1, counter 1 update):\n");
+	rate_ctr_inc2(ctrg1, TEST_A_CTR);
+	do_report(1, 0);
+
+	fprintf(stderr, "report (group 2, item 2 update, group 1 counter 2 update):\n");
+	osmo_stat_item_set(osmo_stat_item_group_get_item(statg2, TEST_B_ITEM), 7);
+	rate_ctr_add2(ctrg1, TEST_B_CTR, 3);
+	do_report(1, 1);
+
+	fprintf(stderr, "report (should be empty):\n");
+	do_report(0, 0);
+
+	fprintf(stderr, "report (group 1, item 1 update twice, check max):\n");
+	osmo_stat_item_set(osmo_stat_item_group_get_item(statg1, TEST_A_ITEM), 20);
+	osmo_stat_item_set(osmo_stat_item_group_get_item(statg1, TEST_A_ITEM), 10);
+	do_report(0, 1);
+
+	fprintf(stderr, "report (group 1, item 1 no update, send last item (!= last max)):\n");
+	do_report(0, 1);
+
+	fprintf(stderr, "report (should be empty):\n");
+	do_report(0, 0);
+
+	fprintf(stderr, "report (remove changed groups):\n");
+	rate_ctr_inc2(ctrg2, TEST_A_CTR);
+	osmo_stat_item_set(osmo_stat_item_group_get_item(statg1, TEST_A_ITEM), 5);
+	rate_ctr_group_free(ctrg2);
+	osmo_stat_item_group_free(statg1);
+	do_report(0, 0);
+
+	fprintf(stderr, "report (flush forced):\n");
+	srep->force_single_flush = 1;
+	do_report(2, 2);
+
+	osmo_stats_set_dirty_tracking(false);
+	osmo_stats_reporter_free(srep);
+	rate_ctr_group_free(ctrg1);
+	osmo_stat_item_group_free(statg2);
+
+	/* Leak check */
+	OSMO_ASSERT(talloc_total_blocks(stats_ctx) == 1);
+	talloc_free(stats_ctx);
+
+	fprintf(stderr, "End test: %s\n", __func__);
+}
+
+#define MT_THREADS	4
+#define MT_INCS		100000
+
+static void *rate_ctr_mt_thread(void *data)
+{
+	struct rate_ctr_group *ctrg = data;
+	int i;
+
+	for (i = 0; i < MT_INCS; i++) {
+		rate_ctr_inc2(ctrg, TEST_A_CTR);
+		rate_ctr_add2(ctrg, TEST_B_CTR, 2);
+		/* without the group, this is looked up */
+		rate_ctr_inc(rate_ctr_group_get_ctr(ctrg, TEST_B_CTR));
+	}
+	return NULL;
+}
+
+static int rate_ctr_mt_handler(struct rate_ctr_group *ctrg, struct rate_ctr *ctr,
+			       const struct rate_ctr_desc *desc, void *data)
+{
+	fprintf(stderr, "  %s = %" PRIu64 "\n", desc->name, ctr->current);
+	return 0;
+}
+
+static void test_rate_ctr_mt(void)
+{
+	struct rate_ctr_group *ctrg;
+	pthread_t threads[MT_THREADS];
+	int i;
+
+	fprintf(stderr, "Start test: %s\n", __func__);
+
+	ctrg = rate_ctr_group_alloc_mt(NULL, &ctrg_desc, 10);
+	OSMO_ASSERT(ctrg);
+
+	/* increments from the main thread */
+	rate_ctr_inc2(ctrg, TEST_A_CTR);
+	rate_ctr_add(rate_ctr_group_get_ctr(ctrg, TEST_B_CTR), 5);
+
+	for (i = 0; i < MT_THREADS; i++)
+		OSMO_ASSERT(pthread_create(&threads[i], NULL, rate_ctr_mt_thread, ctrg) == 0);
+	for (i = 0; i < MT_THREADS; i++)
+		OSMO_ASSERT(pthread_join(threads[i], NULL) == 0);
+
+	/* not folded into the counters before reading */
+	OSMO_ASSERT(rate_ctr_group_get_ctr(ctrg, TEST_A_CTR)->current == 0);
+	OSMO_ASSERT(rate_ctr_group_get_ctr(ctrg, TEST_B_CTR)->current == 0);
+
+	fprintf(stderr, "counters after %d threads:\n", MT_THREADS);
+	rate_ctr_for_each_counter(ctrg, rate_ctr_mt_handler, NULL);
+	OSMO_ASSERT(rate_ctr_group_get_ctr(ctrg, TEST_A_CTR)->current == MT_THREADS * MT_INCS + 1);
+	OSMO_ASSERT(rate_ctr_group_get_ctr(ctrg, TEST_B_CTR)->current == MT_THREADS * MT_INCS * 3 + 5);
+
+	/* pending increments are dropped on reset */
+	rate_ctr_inc2(ctrg, TEST_A_CTR);
+	rate_ctr_group_reset(ctrg);
+	fprintf(stderr, "counters after reset:\n");
+	rate_ctr_for_each_counter(ctrg, rate_ctr_mt_handler, NULL);
+
+	rate_ctr_group_free(ctrg);
+
+	fprintf(stderr, "End test: %s\n", __func__);
+}
+
+#define LOOKUP_GROUPS	1000
+
+static void test_group_lookup(void)
+{
+	static struct rate_ctr_group *ctrg[LOOKUP_GROUPS];
+	static struct osmo_stat_item_group *statg[LOOKUP_GROUPS];
+	struct rate_ctr_group *ctrg_dot;
+	char name[32];
+	int i;
+
+	fprintf(stderr, "Start test: %s\n", __func__);
+
+	for (i = 0; i < LOOKUP_GROUPS; i++) {
+		ctrg[i] = rate_ctr_group_alloc(NULL, &ctrg_desc, i);
+		OSMO_ASSERT(ctrg[i]);
+		statg[i] = osmo_stat_item_group_alloc(NULL, &statg_desc, i);
+		OSMO_ASSERT(statg[i]);
+	}
+
+	for (i = 0; i < LOOKUP_GROUPS; i++) {
+		OSMO_ASSERT(rate_ctr_get_group_by_name_idx("ctr-test:one", i) == ctrg[i]);
+		OSMO_ASSERT(osmo_stat_item_get_group_by_name_idx("test.one", i) == statg[i]);
+		OSMO_ASSERT(rate_ctr_get_by_name(ctrg[i], "ctr:b") == rate_ctr_group_get_ctr(ctrg[i], TEST_B_CTR));
+		OSMO_ASSERT(osmo_stat_item_get_by_name(statg[i], "item.b")
+			    == osmo_stat_item_group_get_item(statg[i], TEST_B_ITEM));
+	}
+	OSMO_ASSERT(!rate_ctr_get_group_by_name_idx("ctr-test:one", LOOKUP_GROUPS));
+	OSMO_ASSERT(!rate_ctr_get_group_by_name_idx("ctr-test:two", 0));
+	OSMO_ASSERT(!rate_ctr_get_by_name(ctrg[0], "ctr:c"));
+	OSMO_ASSERT(!osmo_stat_item_get_by_name(statg[0], "item"));
+
+	/* counter names mangled from '.' to ':' */
+	ctrg_dot = rate_ctr_group_alloc(NULL, &ctrg_desc_dot, 0);
+	OSMO_ASSERT(ctrg_dot);
+	OSMO_ASSERT(rate_ctr_get_group_by_name_idx("ctr-test:one_dot", 0) == ctrg_dot);
+	OSMO_ASSERT(rate_ctr_get_by_name(ctrg_dot, "ctr:a") == rate_ctr_group_get_ctr(ctrg_dot, TEST_A_CTR));
+	OSMO_ASSERT(!rate_ctr_get_by_name(ctrg_dot, "ctr.a"));
+	rate_ctr_group_free(ctrg_dot);
+
+	/* changing the index */
+	rate_ctr_group_upd_idx(ctrg[3], LOOKUP_GROUPS + 3);
+	OSMO_ASSERT(!rate_ctr_get_group_by_name_idx("ctr-test:one", 3));
+	OSMO_ASSERT(rate_ctr_get_group_by_name_idx("ctr-test:one", LOOKUP_GROUPS + 3) == ctrg[3]);
+	osmo_stat_item_group_udp_idx(statg[3], LOOKUP_GROUPS + 3);
+	OSMO_ASSERT(!osmo_stat_item_get_group_by_name_idx("test.one", 3));
+	OSMO_ASSERT(osmo_stat_item_get_group_by_name_idx("test.one", LOOKUP_GROUPS + 3) == statg[3]);
+
+	/* looking up stat item groups by name */
+	for (i = 0; i < LOOKUP_GROUPS; i += 10) {
+		snprintf(name, sizeof(name), "name-%d", i);
+		osmo_stat_item_group_set_name(statg[i], name);
+	}
+	for (i = 0; i < LOOKUP_GROUPS; i += 10) {
+		snprintf(name, sizeof(name), "name-%d", i);
+		OSMO_ASSERT(osmo_stat_item_get_group_by_name_idxname("test.one", name) == statg[i]);
+	}
+	OSMO_ASSERT(!osmo_stat_item_get_group_by_name_idxname("test.one", "name-1"));
+	OSMO_ASSERT(!osmo_stat_item_get_group_by_name_idxname("test.two", "name-0"));
+	osmo_stat_item_group_set_name(statg[10], "renamed");
+	OSMO_ASSERT(!osmo_stat_item_get_group_by_name_idxname("test.one", "name-10"));
+	OSMO_ASSERT(osmo_stat_item_get_group_by_name_idxname("test.one", "renamed") == statg[10]);
+	osmo_stat_item_group_set_name(statg[10], NULL);
+	OSMO_ASSERT(!osmo_stat_item_get_group_by_name_idxname("test.one", "renamed"));
+	/* changing the index keeps the name */
+	osmo_stat_item_group_udp_idx(statg[20], LOOKUP_GROUPS + 20);
+	OSMO_ASSERT(osmo_stat_item_get_group_by_name_idxname("test.one", "name-20") == statg[20]);
+
+	for (i = 0; i < LOOKUP_GROUPS; i++) {
+		rate_ctr_group_free(ctrg[i]);
+		osmo_stat_item_group_free(statg[i]);
+	}
+	OSMO_ASSERT(!rate_ctr_get_group_by_name_idx("ctr-test:one", 0));
+	OSMO_ASSERT(!osmo_stat_item_get_group_by_name_idx("test.one", 0));
+	OSMO_ASSERT(!osmo_stat_item_get_group_by_name_idxname("test.one", "name-0"));
+
+	fprintf(stderr, "End test: %s\n", __func__);
+}
+
 int main(int argc, char **argv)
 {
 	void *ctx = talloc_named_const(NULL, 0, "main");
@@ -510,6 +733,9 @@ int main(int argc, char **argv)
 
 	stat_test();
 	test_reporting();
+	test_reporting_dirty();
+	test_rate_ctr_mt();
+	test_group_lookup();
 	talloc_free(ctx);
 	return 0;
 }
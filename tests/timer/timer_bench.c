@@ -0,0 +1,145 @@
+/* Benchmark comparing the rbtree and timer wheel back-ends of osmo_timer_* */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Usage: timer_bench [num_timers ...]
+ *
+ * For each number of timers (default: 10000 100000 1000000), and each back-end:
+ *  - schedule all timers at pseudo-random timeouts between 1ms and 30s,
+ *  - re-arm random timers 4 * num_timers times, like LAPD/NS/FSM timers do,
+ *  - advance the (overridden) clock in steps of 20ms for 60s, firing all timers.
+ * Timers firing early or not at all are reported as errors. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/timer.h>
+#include <osmocom/core/utils.h>
+
+struct bench_timer {
+	struct osmo_timer_list timer;
+	struct timeval expected;
+};
+
+static unsigned long fired, fired_early;
+
+static uint32_t prng_state = 1;
+
+static uint32_t prng(void)
+{
+	/* xorshift32, to get the same sequence for all back-ends */
+	prng_state ^= prng_state << 13;
+	prng_state ^= prng_state >> 17;
+	prng_state ^= prng_state << 5;
+	return prng_state;
+}
+
+static void bench_timer_cb(void *data)
+{
+	struct bench_timer *bt = data;
+	struct timeval now;
+
+	osmo_gettimeofday(&now, NULL);
+	if (timercmp(&now, &bt->expected, <))
+		fired_early++;
+	fired++;
+}
+
+static void bench_schedule(struct bench_timer *bt)
+{
+	unsigned int ms = 1 + prng() % 30000;
+
+	osmo_timer_schedule(&bt->timer, ms / 1000, (ms % 1000) * 1000);
+	bt->expected = bt->timer.timeout;
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static void bench(enum osmo_timers_backend backend, const char *name, unsigned int num)
+{
+	struct bench_timer *timers = talloc_zero_array(NULL, struct bench_timer, num);
+	double t_add, t_rearm, t_fire;
+	struct timespec start;
+	unsigned int i;
+
+	OSMO_ASSERT(timers);
+	OSMO_ASSERT(osmo_timers_backend_set(backend) == 0);
+	osmo_gettimeofday_override_time = (struct timeval){ 1000, 0 };
+	prng_state = 1;
+	fired = fired_early = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < num; i++) {
+		osmo_timer_setup(&timers[i].timer, bench_timer_cb, &timers[i]);
+		bench_schedule(&timers[i]);
+	}
+	t_add = elapsed_ms(&start);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < 4 * num; i++)
+		bench_schedule(&timers[prng() % num]);
+	t_rearm = elapsed_ms(&start);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < 60000 / 20; i++) {
+		osmo_gettimeofday_override_add(0, 20000);
+		osmo_timers_prepare();
+		osmo_timers_update();
+	}
+	t_fire = elapsed_ms(&start);
+
+	printf("%-7s %8u timers: add %8.1f ns/op, re-arm %8.1f ns/op, expire %8.1f ns/timer%s\n",
+	       name, num, t_add * 1e6 / num, t_rearm * 1e6 / (4 * num), t_fire * 1e6 / num,
+	       (fired != num || fired_early) ? " ERROR" : "");
+	if (fired != num || fired_early)
+		printf("  fired %lu of %u timers, %lu too early\n", fired, num, fired_early);
+
+	OSMO_ASSERT(osmo_timers_check() == 0);
+	talloc_free(timers);
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int default_nums[] = { 10000, 100000, 1000000 };
+	int i;
+
+	osmo_gettimeofday_override = true;
+
+	if (argc < 2) {
+		for (i = 0; i < ARRAY_SIZE(default_nums); i++) {
+			bench(OSMO_TIMERS_BACKEND_RBTREE, "rbtree", default_nums[i]);
+			bench(OSMO_TIMERS_BACKEND_WHEEL, "wheel", default_nums[i]);
+		}
+		return EXIT_SUCCESS;
+	}
+
+	for (i = 1; i < argc; i++) {
+		unsigned int num = atoi(argv[i]);
+		bench(OSMO_TIMERS_BACKEND_RBTREE, "rbtree", num);
+		bench(OSMO_TIMERS_BACKEND_WHEEL, "wheel", num);
+	}
+	return EXIT_SUCCESS;
+}
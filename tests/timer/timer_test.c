@@ -18,6 +18,7 @@
  *
  */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
@@ -28,6 +29,7 @@
 #include <osmocom/core/timer.h>
 #include <osmocom/core/select.h>
 #include <osmocom/core/linuxlist.h>
+#include <osmocom/core/utils.h>
 
 #include "../config.h"
 
@@ -56,6 +58,7 @@ struct test_timer {
 #define TIME_BETWEEN_TIMER_CHECKS 423210
 
 static int timer_nsteps = MAIN_TIMER_NSTEPS;
+static bool test_over;
 static unsigned int expired_timers = 0;
 static unsigned int total_timers = 0;
 static unsigned int too_late = 0;
@@ -138,7 +141,8 @@ static void secondary_timer_fired(void *data)
 	if (expired_timers == total_timers) {
 		printf("test over: added=%u expired=%u too_soon=%u too_late=%u\n",
 		       total_timers, expired_timers, too_soon, too_late);
-		exit(EXIT_SUCCESS);
+		test_over = true;
+		return;
 	}
 
 	/* "random" deletion of timers. */
@@ -158,6 +162,85 @@ static void secondary_timer_fired(void *data)
 	       total_timers - expired_timers);
 }
 
+static void dummy_timer_fired(void *data)
+{
+}
+
+/* A timer on a higher level of the timer wheel, which is cascaded before the next non-empty slot of a lower
+ * level, must not be missed when computing the time to sleep */
+static void test_nearest_cascade(void)
+{
+	struct osmo_timer_list a, b;
+	struct timeval *tv = &osmo_gettimeofday_override_time;
+	unsigned int ms = tv->tv_sec * 1000 + tv->tv_usec / 1000;
+	int nearest;
+
+	printf("%s\n", __func__);
+
+	/* start right after a boundary of the 16384 ms slots of level 2 */
+	osmo_gettimeofday_override_add(0, ((16384 + 5 - ms % 16384) % 16384) * 1000 - tv->tv_usec % 1000);
+	osmo_timers_prepare();
+	osmo_timers_update();
+
+	osmo_timer_setup(&a, dummy_timer_fired, NULL);
+	/* the wheel has processed the current tick already, so this is 16384 ms ahead of its clock: level 2 */
+	osmo_timer_schedule(&a, 16, 385000);
+	osmo_gettimeofday_override_add(16, 78000);
+	osmo_timers_prepare();
+	osmo_timers_update();
+
+	osmo_timer_setup(&b, dummy_timer_fired, NULL);
+	osmo_timer_schedule(&b, 10, 0);
+	osmo_timers_prepare();
+	nearest = osmo_timers_nearest_ms();
+	if (nearest >= 0 && nearest <= 307)
+		printf("nearest timer: OK\n");
+	else
+		printf("nearest timer: %d ms, expected at most 307 ms\n", nearest);
+
+	osmo_timer_del(&a);
+	osmo_timer_del(&b);
+}
+
+static void flag_timer_fired(void *data)
+{
+	*(bool *)data = true;
+}
+
+/* Timers must neither be delayed by the clock jumping backwards, nor take long to process when it jumps far
+ * forwards */
+static void test_clock_jump(void)
+{
+	struct osmo_timer_list a, b;
+	bool a_fired = false, b_fired = false;
+	int nearest;
+
+	printf("%s\n", __func__);
+
+	osmo_timer_setup(&a, flag_timer_fired, &a_fired);
+	osmo_timer_schedule(&a, 5, 0);
+
+	/* backwards: a timer scheduled afterwards fires on time, the earlier one stays pending */
+	osmo_gettimeofday_override_time.tv_sec -= 10;
+	osmo_timers_prepare();
+	osmo_timers_update();
+	osmo_timer_setup(&b, flag_timer_fired, &b_fired);
+	osmo_timer_schedule(&b, 0, 100000);
+	osmo_timers_prepare();
+	nearest = osmo_timers_nearest_ms();
+	printf("after jumping backwards: nearest timer %s\n", nearest >= 0 && nearest <= 100 ? "OK" : "too late");
+	osmo_gettimeofday_override_add(0, 100000);
+	osmo_timers_prepare();
+	osmo_timers_update();
+	printf("a fired: %d, b fired: %d\n", a_fired, b_fired);
+
+	/* one year forwards */
+	osmo_gettimeofday_override_time.tv_sec += 365 * 86400;
+	osmo_timers_prepare();
+	osmo_timers_update();
+	printf("after jumping forwards: a fired: %d, %d timers pending\n", a_fired, osmo_timers_check());
+}
+
 int main(int argc, char *argv[])
 {
 	int c;
@@ -165,7 +248,7 @@ int main(int argc, char *argv[])
 
 	osmo_gettimeofday_override = true;
 
-	while ((c = getopt_long(argc, argv, "s:", NULL, NULL)) != -1) {
+	while ((c = getopt_long(argc, argv, "s:w", NULL, NULL)) != -1) {
 	switch(c) {
 		case 's':
 			timer_nsteps = atoi(optarg);
@@ -175,6 +258,9 @@ int main(int argc, char *argv[])
 				exit(EXIT_FAILURE);
 			}
 			break;
+		case 'w':
+			OSMO_ASSERT(osmo_timers_backend_set(OSMO_TIMERS_BACKEND_WHEEL) == 0);
+			break;
 		default:
 			exit(EXIT_FAILURE);
 		}
@@ -191,13 +277,16 @@ int main(int argc, char *argv[])
 	osmo_timer_schedule(&main_timer, 1, 0);
 
 #ifdef HAVE_SYS_SELECT_H
-	while (steps--) {
+	while (steps-- && !test_over) {
 		printf("%d.%06d\n", (int)osmo_gettimeofday_override_time.tv_sec,
 		       (int)osmo_gettimeofday_override_time.tv_usec);
 		osmo_timers_prepare();
 		osmo_timers_update();
 		osmo_gettimeofday_override_add(0, TIME_BETWEEN_TIMER_CHECKS);
 	}
+
+	test_nearest_cascade();
+	test_clock_jump();
 #else
 	printf("Select not supported on this platform!\n");
 #endif
@@ -0,0 +1,120 @@
+/* Benchmark of the generic and the generated TLV parsers */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Usage: tlv_bench [iterations]
+ *
+ * Parses typical BSSMAP, RSL and BSSGP messages with tlv_parse() and
+ * tlv_parse_compact(), both with the generated parser for the protocol and
+ * with the generic parser, which is used for a copy of the tlv_definition. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <osmocom/core/utils.h>
+#include <osmocom/gsm/tlv.h>
+#include <osmocom/gsm/gsm0808.h>
+#include <osmocom/gsm/rsl.h>
+#include <osmocom/gsm/protocol/gsm_08_08.h>
+#include <osmocom/gsm/protocol/gsm_08_58.h>
+#include <osmocom/gprs/protocol/gsm_08_18.h>
+
+/* IEs of a BSSMAP ASSIGNMENT REQUEST for AoIP */
+static const uint8_t bssmap_ies[] = {
+	GSM0808_IE_CHANNEL_TYPE, 0x04, 0x01, 0x08, 0x81, 0x05,
+	GSM0808_IE_AOIP_TRASP_ADDR, 0x06, 0xc0, 0xa8, 0x64, 0x11, 0x04, 0xd2,
+	GSM0808_IE_SPEECH_CODEC_LIST, 0x05, 0x54, 0x0f, 0xff, 0x52, 0x81,
+	GSM0808_IE_CALL_ID, 0xde, 0xad, 0xbe, 0xef,
+};
+
+/* IEs of an RSL DATA INDICATION */
+static const uint8_t rsl_ies[] = {
+	RSL_IE_CHAN_NR, 0x0a,
+	RSL_IE_LINK_IDENT, 0x00,
+	RSL_IE_L3_INFO, 0x00, 0x05, 0x05, 0x24, 0x11, 0x03, 0x33,
+	RSL_IE_MS_POWER, 0x05,
+	RSL_IE_TIMING_ADVANCE, 0x01,
+};
+
+/* IEs of a BSSGP UL-UNITDATA, after TLLI and QoS profile */
+static const uint8_t bssgp_ies[] = {
+	BSSGP_IE_CELL_ID, 0x88, 0x62, 0xf2, 0x20, 0x00, 0x01, 0x02, 0x00, 0x03,
+	BSSGP_IE_PDU_LIFETIME, 0x82, 0x03, 0xe8,
+	BSSGP_IE_LLC_PDU, 0x90, 0x01, 0x40, 0x0c, 0xd2, 0x2a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00,
+};
+
+static double elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+static void bench(const char *name, const struct tlv_definition *def, const uint8_t *buf, int buf_len,
+		  unsigned int iterations)
+{
+	struct tlv_definition *def_generic = malloc(sizeof(*def_generic));
+	const struct tlv_definition *defs[] = { def_generic, def };
+	struct tlv_parsed_compact tpc;
+	struct tlv_parsed tp;
+	struct timespec start;
+	double t_parse[2], t_compact[2];
+	unsigned int i, d;
+	int rc;
+
+	OSMO_ASSERT(def_generic);
+	memcpy(def_generic, def, sizeof(*def));
+
+	for (d = 0; d < ARRAY_SIZE(defs); d++) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < iterations; i++) {
+			rc = tlv_parse(&tp, defs[d], buf, buf_len, 0, 0);
+			OSMO_ASSERT(rc > 0);
+		}
+		t_parse[d] = elapsed_ns(&start) / iterations;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < iterations; i++) {
+			rc = tlv_parse_compact(&tpc, defs[d], buf, buf_len, 0, 0);
+			OSMO_ASSERT(rc > 0);
+		}
+		t_compact[d] = elapsed_ns(&start) / iterations;
+	}
+
+	printf("%-7s %d IEs: tlv_parse() generic %6.1f ns, generated %6.1f ns; "
+	       "tlv_parse_compact() generic %6.1f ns, generated %6.1f ns\n",
+	       name, rc, t_parse[0], t_parse[1], t_compact[0], t_compact[1]);
+	free(def_generic);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int iterations = 1000000;
+
+	if (argc > 1)
+		iterations = atoi(argv[1]);
+
+	bench("BSSMAP", gsm0808_att_tlvdef(), bssmap_ies, sizeof(bssmap_ies), iterations);
+	bench("RSL", &rsl_att_tlvdef, rsl_ies, sizeof(rsl_ies), iterations);
+	bench("BSSGP", &tvlv_att_def, bssgp_ies, sizeof(bssgp_ies), iterations);
+
+	return EXIT_SUCCESS;
+}
@@ -1,6 +1,7 @@
 #include <osmocom/core/msgb.h>
 #include <osmocom/gsm/tlv.h>
 #include <osmocom/gsm/gsm0808.h>
+#include <osmocom/gsm/rsl.h>
 
 static void check_tlv_parse(uint8_t **data, size_t *data_len,
 			    uint8_t exp_tag, size_t exp_len, const uint8_t *exp_val)
@@ -454,6 +455,239 @@ static void test_tlv_lens()
 	}
 }
 
+static void check_tlvpc_equals_tlvp(const struct tlv_parsed_compact *tpc, const struct tlv_parsed *tp)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tp->lv); i++) {
+		OSMO_ASSERT(TLVPC_PRESENT(tpc, i) == TLVP_PRESENT(tp, i));
+		OSMO_ASSERT(TLVPC_VAL(tpc, i) == TLVP_VAL(tp, i));
+		if (TLVP_PRESENT(tp, i))
+			OSMO_ASSERT(TLVPC_LEN(tpc, i) == TLVP_LEN(tp, i));
+	}
+}
+
+static void test_tlv_parse_compact()
+{
+	const uint8_t enc_ies[] = {
+		0x17, 0x14,	0x06, 0x2b, 0x12, 0x2b, 0x0b, 0x40, 0x2b, 0xb7, 0x05, 0xd0, 0x63, 0x82, 0x95, 0x03, 0x05, 0x40,
+				0x07, 0x08, 0x43, 0x90,
+		0x2c,		0x04,
+		0x40,		0x42,
+	};
+	static const uint8_t mand_ies[] = { 0x2c, 0x40 };
+	static struct osmo_tlv_prot_def pdef = {
+		.name = "test",
+		.msg_def = {
+			[0x01] = MSG_DEF("msg", mand_ies, 0),
+		},
+		.ie_def = {
+			[0x17] = { 20, "ie_17" },
+		},
+	};
+	struct tlv_parsed_compact tpc;
+	struct tlv_parsed tp, tp3[3], tp3_conv[3];
+	struct tlv_definition def;
+	uint8_t test_data[3 * 10];
+	const uint8_t tag = 0x1a;
+	int i, rc;
+
+	printf("Testing compact TLV parser\n");
+
+	/* same result as tlv_parse() */
+	memset(&tpc, 0xaa, sizeof(tpc));
+	rc = tlv_parse_compact(&tpc, gsm0808_att_tlvdef(), enc_ies, ARRAY_SIZE(enc_ies), 0, 0);
+	OSMO_ASSERT(rc == 3);
+	OSMO_ASSERT(tlv_parse(&tp, gsm0808_att_tlvdef(), enc_ies, ARRAY_SIZE(enc_ies), 0, 0) == 3);
+	check_tlvpc_equals_tlvp(&tpc, &tp);
+	OSMO_ASSERT(tlvpc_val8(&tpc, 0x40, 0) == 0x42);
+	OSMO_ASSERT(tlvpc_val8(&tpc, 0x41, 0x23) == 0x23);
+	OSMO_ASSERT(TLVPC_GET(&tpc, 0x41) == NULL);
+	OSMO_ASSERT(TLVPC_GET_MINLEN(&tpc, 0x17, 20) == &tpc.ie[0]);
+	OSMO_ASSERT(TLVPC_GET_MINLEN(&tpc, 0x17, 21) == NULL);
+	OSMO_ASSERT(tlvpc_val16be(&tpc, 0x17) == 0x062b);
+
+	/* osmo_tlv_prot_parse() integration */
+	pdef.tlv_def = gsm0808_att_tlvdef();
+	rc = osmo_tlv_prot_parse_compact(&pdef, &tpc, 0x01, enc_ies, ARRAY_SIZE(enc_ies), 0, 0, 0, "test");
+	OSMO_ASSERT(rc == 0);
+
+	/* repeated IEs; the initial LV is one of them */
+	memset(&def, 0, sizeof(def));
+	def.def[tag].type = TLV_TYPE_TLV;
+	for (i = 0; i < ARRAY_SIZE(test_data); i += 3) {
+		test_data[i] = tag;
+		test_data[i + 1] = 1;
+		test_data[i + 2] = i / 3;
+	}
+	rc = tlv_parse_compact(&tpc, &def, &test_data[1], sizeof(test_data) - 1, tag, 0);
+	OSMO_ASSERT(rc == 10);
+	OSMO_ASSERT(TLVPC_VAL(&tpc, tag) == &test_data[2]);
+	OSMO_ASSERT(tlvpc_get_nth(&tpc, tag, 0) == TLVPC_GET(&tpc, tag));
+	OSMO_ASSERT(tlvpc_get_nth(&tpc, tag, 9)->val == &test_data[3 * 9 + 2]);
+	OSMO_ASSERT(tlvpc_get_nth(&tpc, tag, 10) == NULL);
+	OSMO_ASSERT(tlvpc_get_nth(&tpc, tag + 1, 0) == NULL);
+
+	/* conversion for code still using struct tlv_parsed */
+	rc = tlv_parse2(tp3, 3, &def, test_data, sizeof(test_data), 0, 0);
+	OSMO_ASSERT(rc == 10);
+	rc = tlv_parse_compact(&tpc, &def, test_data, sizeof(test_data), 0, 0);
+	OSMO_ASSERT(rc == 10);
+	osmo_tlvpc_to_tlvp(tp3_conv, 3, &tpc);
+	check_tlvpc_equals_tlvp(&tpc, &tp3_conv[0]);
+	OSMO_ASSERT(memcmp(tp3, tp3_conv, sizeof(tp3)) == 0);
+
+	/* errors */
+	rc = tlv_parse_compact(&tpc, &def, test_data, sizeof(test_data) - 1, 0, 0);
+	OSMO_ASSERT(rc == OSMO_TLVP_ERR_OFS_LEN_BEYOND_BUFFER);
+	OSMO_ASSERT(tlvpc_get_nth(&tpc, tag, 8) != NULL);
+	OSMO_ASSERT(tlvpc_get_nth(&tpc, tag, 9) == NULL);
+	rc = tlv_parse_compact(&tpc, &def, test_data, 0, tag, 0);
+	OSMO_ASSERT(rc == OSMO_TLVP_ERR_OFS_BEYOND_BUFFER);
+	OSMO_ASSERT(!TLVPC_PRESENT(&tpc, tag));
+	{
+		uint8_t many[2 * (TLV_PARSED_COMPACT_MAX_IES + 1)] = { 0 };
+		def.def[0].type = TLV_TYPE_TV;
+		rc = tlv_parse_compact(&tpc, &def, many, sizeof(many) - 2, 0, 0);
+		OSMO_ASSERT(rc == TLV_PARSED_COMPACT_MAX_IES);
+		rc = tlv_parse_compact(&tpc, &def, many, sizeof(many), 0, 0);
+		OSMO_ASSERT(rc == OSMO_TLVP_ERR_TOO_MANY_IES);
+	}
+}
+
+static uint32_t prng_state = 1;
+
+static uint32_t prng(void)
+{
+	/* xorshift32, for a reproducible sequence */
+	prng_state ^= prng_state << 13;
+	prng_state ^= prng_state >> 17;
+	prng_state ^= prng_state << 5;
+	return prng_state;
+}
+
+/* fill buf with a random sequence of IEs, mostly well-formed according to def
+ * \returns number of octets to parse, possibly truncating the last IE */
+static int gen_random_ies(uint8_t *buf, int buf_size, const struct tlv_definition *def)
+{
+	uint8_t known[256];
+	int num_known = 0;
+	int i, ofs = 0;
+
+	for (i = 0; i < ARRAY_SIZE(def->def); i++) {
+		if (def->def[i].type != TLV_TYPE_NONE)
+			known[num_known++] = i;
+	}
+
+	while (ofs < buf_size - 8) {
+		uint32_t r = prng();
+		uint8_t tag = (num_known && (r & 15)) ? known[(r >> 8) % num_known] : r >> 8;
+		int len = prng() % 5;
+
+		buf[ofs++] = tag;
+		switch (def->def[tag].type) {
+		case TLV_TYPE_T:
+		case TLV_TYPE_SINGLE_TV:
+			len = 0;
+			break;
+		case TLV_TYPE_TV:
+			len = 1;
+			break;
+		case TLV_TYPE_FIXED:
+			len = def->def[tag].fixed_len;
+			break;
+		case TLV_TYPE_TLV:
+			buf[ofs++] = len;
+			break;
+		case TLV_TYPE_TvLV:
+		case TLV_TYPE_vTvLV_GAN:
+			if (r & 0x10) {
+				buf[ofs++] = 0x80 | len;
+				break;
+			}
+			/* fall-through */
+		case TLV_TYPE_TL16V:
+			buf[ofs++] = 0;
+			buf[ofs++] = len;
+			break;
+		default:
+			break;
+		}
+		for (i = 0; i < len && ofs < buf_size; i++)
+			buf[ofs++] = prng();
+		if (prng() % 4 == 0)
+			break;
+	}
+
+	/* truncate some messages */
+	if (ofs && prng() % 4 == 0)
+		ofs = prng() % ofs;
+	return ofs;
+}
+
+static void check_tlv_parse_gen(const char *name, const struct tlv_definition *def, unsigned int iterations)
+{
+	/* a copy of the definition is not recognized, and parsed by the generic parser */
+	struct tlv_definition *def_copy = malloc(sizeof(*def_copy));
+	struct tlv_parsed tp[3], tp_ref[3];
+	struct tlv_parsed_compact tpc, tpc_ref;
+	unsigned int i, num_ok = 0;
+	uint8_t buf[64];
+
+	OSMO_ASSERT(def_copy);
+	memcpy(def_copy, def, sizeof(*def));
+
+	for (i = 0; i < iterations; i++) {
+		uint8_t lv_tag = (prng() % 4 == 0) ? 0xfe : 0;
+		int buf_len, rc, rc_ref, j;
+
+		buf_len = gen_random_ies(buf, sizeof(buf), def);
+
+		rc = tlv_parse2(tp, ARRAY_SIZE(tp), def, buf, buf_len, lv_tag, 0);
+		rc_ref = tlv_parse2(tp_ref, ARRAY_SIZE(tp_ref), def_copy, buf, buf_len, lv_tag, 0);
+		OSMO_ASSERT(rc == rc_ref);
+		OSMO_ASSERT(memcmp(tp, tp_ref, sizeof(tp)) == 0);
+		if (rc >= 0)
+			num_ok++;
+
+		rc = tlv_parse_compact(&tpc, def, buf, buf_len, lv_tag, 0);
+		rc_ref = tlv_parse_compact(&tpc_ref, def_copy, buf, buf_len, lv_tag, 0);
+		OSMO_ASSERT(rc == rc_ref);
+		OSMO_ASSERT(tpc.num_ies == tpc_ref.num_ies);
+		OSMO_ASSERT(memcmp(tpc.present, tpc_ref.present, sizeof(tpc.present)) == 0);
+		for (j = 0; j < tpc.num_ies; j++) {
+			OSMO_ASSERT(tpc.tag[j] == tpc_ref.tag[j]);
+			OSMO_ASSERT(tpc.ie[j].val == tpc_ref.ie[j].val);
+			OSMO_ASSERT(tpc.ie[j].len == tpc_ref.ie[j].len);
+		}
+	}
+
+	printf("%s: %u random messages, %u parsed successfully, generated parser matches\n",
+	       name, iterations, num_ok);
+	free(def_copy);
+}
+
+static void test_tlv_parse_gen()
+{
+	printf("Testing generated TLV parsers against the generic one\n");
+
+	check_tlv_parse_gen("tvlv", &tvlv_att_def, 20000);
+	check_tlv_parse_gen("bssmap", gsm0808_att_tlvdef(), 20000);
+	check_tlv_parse_gen("rsl", &rsl_att_tlvdef, 20000);
+
+	/* tvlv_att_def is not const, and may be changed by applications */
+	tvlv_att_def.def[0x01].type = TLV_TYPE_TV;
+	tvlv_att_def.def[0x02] = (struct tlv_def) { TLV_TYPE_FIXED, 3 };
+	tvlv_att_def.def[0x03].type = TLV_TYPE_NONE;
+	/* also changes the meaning of the TvLV tags 0x51..0x5f */
+	tvlv_att_def.def[0x50].type = TLV_TYPE_SINGLE_TV;
+	check_tlv_parse_gen("tvlv (changed)", &tvlv_att_def, 20000);
+	tvlv_att_def.def[0x01].type = TLV_TYPE_TvLV;
+	tvlv_att_def.def[0x02] = (struct tlv_def) { TLV_TYPE_TvLV, 0 };
+	tvlv_att_def.def[0x03].type = TLV_TYPE_TvLV;
+	tvlv_att_def.def[0x50].type = TLV_TYPE_TvLV;
+}
+
 int main(int argc, char **argv)
 {
 	//osmo_init_logging2(ctx, &info);
@@ -463,6 +697,8 @@ int main(int argc, char **argv)
 	test_tlv_encoder();
 	test_tlv_parser_bounds();
 	test_tlv_lens();
+	test_tlv_parse_compact();
+	test_tlv_parse_gen();
 
 	printf("Done.\n");
 	return EXIT_SUCCESS;
@@ -1,6 +1,18 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/socket.h>
+
 #include <osmocom/core/logging.h>
 #include <osmocom/core/utils.h>
 #include <osmocom/core/write_queue.h>
+#include <osmocom/core/msgb_chain.h>
+#include <osmocom/core/socket.h>
 
 static const struct log_info_cat default_categories[] = {
 };
@@ -65,6 +77,143 @@ static void test_wqueue_limit(void)
 	osmo_wqueue_clear(&wqueue);
 }
 
+static int chain_test_write_cb(struct osmo_fd *fd, struct msgb *msg)
+{
+	return write(fd->fd, msgb_data(msg), msgb_length(msg)) < 0 ? -errno : 0;
+}
+
+static struct msgb_chain *chain_test_alloc(const char *a, const char *b)
+{
+	struct msgb_chain *chain = msgb_chain_alloc(NULL, "chain");
+	struct msgb *msg;
+
+	msg = msgb_alloc(64, "a");
+	memcpy(msgb_put(msg, strlen(a)), a, strlen(a));
+	OSMO_ASSERT(msgb_chain_append_msgb(chain, msg) == 0);
+	msg = msgb_alloc(64, "b");
+	memcpy(msgb_put(msg, strlen(b)), b, strlen(b));
+	OSMO_ASSERT(msgb_chain_append_msgb(chain, msg) == 0);
+	return chain;
+}
+
+static void test_wqueue_chain(void)
+{
+	struct osmo_wqueue wqueue;
+	struct msgb_chain *chain;
+	struct msgb *msg;
+	char buf[64];
+	int sv[2];
+	int rc;
+
+	printf("Testing msgb_chain in write queue\n");
+
+	OSMO_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+	/* sent directly on the socket */
+	chain = chain_test_alloc("hello ", "world");
+	rc = osmo_sock_send_chain(sv[0], chain, NULL, 0);
+	OSMO_ASSERT(rc == 11);
+	msgb_chain_free(chain);
+	rc = read(sv[1], buf, sizeof(buf));
+	printf("osmo_sock_send_chain: '%.*s'\n", rc, buf);
+
+	/* chains and msgbs in the same write queue keep their order */
+	osmo_wqueue_init(&wqueue, 3);
+	wqueue.write_cb = chain_test_write_cb;
+	osmo_fd_setup(&wqueue.bfd, sv[0], 0, osmo_wqueue_bfd_cb, NULL, 0);
+	OSMO_ASSERT(osmo_fd_register(&wqueue.bfd) == 0);
+
+	msg = msgb_alloc(64, "msg");
+	memcpy(msgb_put(msg, 4), "one ", 4);
+	OSMO_ASSERT(osmo_wqueue_enqueue(&wqueue, msg) == 0);
+	OSMO_ASSERT(osmo_wqueue_enqueue_chain(&wqueue, chain_test_alloc("two ", "three ")) == 0);
+	msg = msgb_alloc(64, "msg");
+	memcpy(msgb_put(msg, 4), "four", 4);
+	OSMO_ASSERT(osmo_wqueue_enqueue(&wqueue, msg) == 0);
+	chain = chain_test_alloc("five", "");
+	OSMO_ASSERT(osmo_wqueue_enqueue_chain(&wqueue, chain) == -ENOSPC);
+	msgb_chain_free(chain);
+
+	while (wqueue.current_length)
+		osmo_select_main(1);
+	rc = read(sv[1], buf, sizeof(buf));
+	printf("osmo_wqueue_enqueue_chain: '%.*s'\n", rc, buf);
+
+	osmo_fd_unregister(&wqueue.bfd);
+	osmo_wqueue_clear(&wqueue);
+	close(sv[0]);
+	close(sv[1]);
+}
+
+static void test_wqueue_vectored(void)
+{
+	struct osmo_wqueue wqueue;
+	struct msgb *msg;
+	static char expect[10 * 1000 + 16], buf[sizeof(expect)];
+	size_t expect_len = 0, len = 0;
+	int fds[2];
+	unsigned int i;
+	int rc;
+
+	printf("Testing vectored write queue\n");
+
+	OSMO_ASSERT(pipe(fds) == 0);
+	/* a small pipe, to get partial writes */
+	OSMO_ASSERT(fcntl(fds[1], F_SETPIPE_SZ, 4096) == 4096);
+	OSMO_ASSERT(fcntl(fds[1], F_SETFL, O_NONBLOCK) == 0);
+
+	osmo_wqueue_init(&wqueue, 16);
+	wqueue.vectored = true;
+	osmo_fd_setup(&wqueue.bfd, fds[1], 0, osmo_wqueue_bfd_cb, NULL, 0);
+	OSMO_ASSERT(osmo_fd_register(&wqueue.bfd) == 0);
+
+	for (i = 0; i < 10; i++) {
+		msg = msgb_alloc(1000, "msg");
+		memset(msgb_put(msg, 1000), 'a' + i, 1000);
+		memcpy(expect + expect_len, msgb_data(msg), 1000);
+		expect_len += 1000;
+		OSMO_ASSERT(osmo_wqueue_enqueue(&wqueue, msg) == 0);
+		if (i == 4) {
+			OSMO_ASSERT(osmo_wqueue_enqueue_chain(&wqueue, chain_test_alloc("<chain ", "segments>")) == 0);
+			memcpy(expect + expect_len, "<chain segments>", 16);
+			expect_len += 16;
+		}
+	}
+	printf("queued %u msgbs, %zu bytes\n", wqueue.current_length, expect_len);
+
+	while (wqueue.current_length) {
+		osmo_select_main(1);
+		printf("batch %" PRIu64 ": %" PRIu64 " bytes, %" PRIu64 " msgbs written, %u queued\n",
+		       wqueue.tx_batches, wqueue.tx_bytes, wqueue.tx_msgs, wqueue.current_length);
+		rc = read(fds[0], buf + len, sizeof(buf) - len);
+		OSMO_ASSERT(rc > 0);
+		len += rc;
+	}
+	OSMO_ASSERT(len == expect_len);
+	OSMO_ASSERT(!memcmp(buf, expect, len));
+	printf("data complete and in order\n");
+
+	/* a writable event with nothing queued does not call writev() */
+	osmo_wqueue_bfd_cb(&wqueue.bfd, OSMO_FD_WRITE);
+	printf("empty queue: %" PRIu64 " batches\n", wqueue.tx_batches);
+
+	/* a persistent error drops all of the queue at once */
+	signal(SIGPIPE, SIG_IGN);
+	close(fds[0]);
+	for (i = 0; i < 3; i++) {
+		msg = msgb_alloc(1000, "msg");
+		memset(msgb_put(msg, 1000), 'x', 1000);
+		OSMO_ASSERT(osmo_wqueue_enqueue(&wqueue, msg) == 0);
+	}
+	osmo_select_main(1);
+	printf("write error: %" PRIu64 " batches, %" PRIu64 " msgbs dropped, %u queued\n",
+	       wqueue.tx_batches, wqueue.tx_dropped, wqueue.current_length);
+
+	osmo_fd_unregister(&wqueue.bfd);
+	osmo_wqueue_clear(&wqueue);
+	close(fds[1]);
+}
+
 int main(int argc, char **argv)
 {
 	struct log_target *stderr_target;
@@ -77,6 +226,8 @@ int main(int argc, char **argv)
 	log_set_print_category(stderr_target, 0);
 
 	test_wqueue_limit();
+	test_wqueue_chain();
+	test_wqueue_vectored();
 
 	printf("Done\n");
 	return 0;
@@ -0,0 +1,141 @@
+/*! \file osmo-logbin-decode.c
+ * Utility program rendering binary log files as text. */
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+
+#include <osmocom/core/utils.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/core/logging_bin.h>
+
+static const struct value_string level_names[] = {
+	{ LOGL_DEBUG,	"DEBUG" },
+	{ LOGL_INFO,	"INFO" },
+	{ LOGL_NOTICE,	"NOTICE" },
+	{ LOGL_ERROR,	"ERROR" },
+	{ LOGL_FATAL,	"FATAL" },
+	{ 0, NULL }
+};
+
+static struct {
+	bool utc;
+	bool print_timestamp;
+	bool print_tid;
+	bool print_file;
+} opts = {
+	.print_timestamp = true,
+	.print_tid = true,
+	.print_file = true,
+};
+
+static void print_msg(const struct log_bin_msg *msg)
+{
+	if (!msg->cont) {
+		if (opts.print_timestamp) {
+			struct tm tm;
+			char buf[32];
+
+			if (opts.utc)
+				gmtime_r(&msg->ts.tv_sec, &tm);
+			else
+				localtime_r(&msg->ts.tv_sec, &tm);
+			strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+			printf("%s.%06ld ", buf, msg->ts.tv_nsec / 1000);
+		}
+		if (opts.print_tid)
+			printf("[%u] ", msg->tid);
+		if (msg->category)
+			printf("%s ", msg->category);
+		else
+			printf("<%04x> ", msg->subsys);
+		printf("%s ", get_value_string(level_names, msg->level));
+		if (opts.print_file)
+			printf("%s:%u ", msg->file ? : "?", msg->line);
+	}
+	fputs(msg->text, stdout);
+}
+
+static void help(const char *progname)
+{
+	printf("Usage: %s [-h] [-u] [-T] [-t] [-f] FILE\n"
+	       "Print the messages of a binary log file (see 'log binary-file') as text.\n"
+	       "  -u	print time stamps in UTC instead of local time\n"
+	       "  -T	don't print time stamps\n"
+	       "  -t	don't print thread ids\n"
+	       "  -f	don't print source file names and lines\n",
+	       progname);
+}
+
+int main(int argc, char **argv)
+{
+	static struct log_bin_msg msg;
+	struct log_bin_reader *rd;
+	int opt, rc;
+
+	while ((opt = getopt(argc, argv, "huTtf")) != -1) {
+		switch (opt) {
+		case 'u':
+			opts.utc = true;
+			break;
+		case 'T':
+			opts.print_timestamp = false;
+			break;
+		case 't':
+			opts.print_tid = false;
+			break;
+		case 'f':
+			opts.print_file = false;
+			break;
+		case 'h':
+			help(argv[0]);
+			exit(0);
+			break;
+		default:
+			help(argv[0]);
+			exit(2);
+			break;
+		}
+	}
+
+	if (argc != optind + 1) {
+		help(argv[0]);
+		exit(2);
+	}
+
+	rd = log_bin_reader_open(NULL, argv[optind]);
+	if (!rd) {
+		fprintf(stderr, "Cannot read binary log file %s: %s\n", argv[optind], strerror(errno));
+		exit(1);
+	}
+
+	while ((rc = log_bin_reader_next(rd, &msg)) > 0)
+		print_msg(&msg);
+
+	log_bin_reader_close(rd);
+
+	if (rc < 0) {
+		fprintf(stderr, "Corrupt binary log file %s: %s\n", argv[optind], strerror(-rc));
+		exit(1);
+	}
+	return 0;
+}
@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+
+mod_license = """
+/*
+ * (C) 2026 by sysmocom - s.f.m.c. GmbH <info@sysmocom.de>
+ * All Rights Reserved
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+"""
+
+# Generate TLV parsers specialised for particular struct tlv_definition.
+#
+# Instead of looking up the type of each IE in the tlv_definition and
+# switching over the type at runtime, like tlv_parse_one() does, the
+# generated parse_one functions switch over the tag itself, with all tags of
+# the same type (and fixed length) sharing one case.  The tlv_definition
+# tables are read from their C source files; tags are emitted as the
+# symbols used there, so no header needs to be parsed.
+
+import sys, os, re, argparse
+
+# name: name of the generated parser
+# def_expr: C expression evaluating to the tlv_definition pointer
+# source: (C file below src/, name of the tlv_definition) to read the table from
+# uniform: type of all 256 tags, for tlv_definitions filled at runtime.  Such
+#          a table is not const, so the generated parser checks the type of
+#          each tag in it, and of the single octet TV IE its upper nibble
+#          would select, and leaves tags changed by an application to
+#          tlv_parse_one().
+# includes: headers required for the tag symbols and def_expr
+protocols = [
+	{
+		"name": "tvlv",
+		"def_expr": "&tvlv_att_def",
+		"uniform": "TLV_TYPE_TvLV",
+		"includes": [],
+	},
+	{
+		"name": "bssmap",
+		"def_expr": "gsm0808_att_tlvdef()",
+		"source": ("gsm/gsm0808.c", "bss_att_tlvdef"),
+		"includes": ["osmocom/gsm/gsm0808.h", "osmocom/gsm/protocol/gsm_08_08.h"],
+	},
+	{
+		"name": "rsl",
+		"def_expr": "&rsl_att_tlvdef",
+		"source": ("gsm/rsl.c", "rsl_att_tlvdef"),
+		"includes": ["osmocom/gsm/rsl.h", "osmocom/gsm/protocol/gsm_08_58.h"],
+	},
+]
+
+# C code parsing an IE of each type; tag is at buf[0], buf_len >= 1
+type_code = {
+	"TLV_TYPE_T": [
+		"/* GSM TS 04.07 11.2.4: Type 1 TV or Type 2 T */",
+		"*o_val = buf;",
+		"*o_len = 0;",
+		"len = 1;",
+	],
+	"TLV_TYPE_TV": [
+		"*o_val = buf+1;",
+		"*o_len = 1;",
+		"len = 2;",
+	],
+	"TLV_TYPE_FIXED": [
+		"*o_val = buf+1;",
+		"*o_len = %(fixed_len)s;",
+		"len = %(fixed_len)s + 1;",
+	],
+	"TLV_TYPE_TLV": [
+		"/* GSM TS 04.07 11.2.4: Type 4 TLV */",
+		"if (buf_len < 2)",
+		"\treturn OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;",
+		"*o_val = buf+2;",
+		"*o_len = buf[1];",
+		"len = *o_len + 2;",
+	],
+	"TLV_TYPE_TL16V": [
+		"if (buf_len < 3)",
+		"\treturn OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;",
+		"*o_val = buf+3;",
+		"*o_len = buf[1] << 8 | buf[2];",
+		"len = *o_len + 3;",
+	],
+	"TLV_TYPE_TvLV": [
+		"if (buf_len < 2)",
+		"\treturn OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;",
+		"if (buf[1] & 0x80) {",
+		"\t/* like TLV, but without highest bit of len */",
+		"\t*o_val = buf+2;",
+		"\t*o_len = buf[1] & 0x7f;",
+		"\tlen = *o_len + 2;",
+		"} else {",
+		"\t/* like TL16V */",
+		"\tif (buf_len < 3)",
+		"\t\treturn OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;",
+		"\t*o_val = buf+3;",
+		"\t*o_len = buf[1] << 8 | buf[2];",
+		"\tlen = *o_len + 3;",
+		"}",
+	],
+	"TLV_TYPE_vTvLV_GAN": [
+		"/* 44.318 / 11.1.4 */",
+		"if (buf_len < 2)",
+		"\treturn OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;",
+		"if (buf[1] & 0x80) {",
+		"\tif (buf_len < 3)",
+		"\t\treturn OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;",
+		"\t/* like TL16V but without highest bit of len */",
+		"\t*o_val = buf+3;",
+		"\t*o_len = (buf[1] & 0x7F) << 8 | buf[2];",
+		"\tlen = *o_len + 3;",
+		"} else {",
+		"\t/* like TLV */",
+		"\t*o_val = buf+2;",
+		"\t*o_len = buf[1];",
+		"\tlen = *o_len + 2;",
+		"}",
+	],
+}
+
+def read_tlv_definition(path, var):
+	src = open(path).read()
+	# strip comments
+	src = re.sub(r"/\*.*?\*/", "", src, flags = re.S)
+	src = re.sub(r"//[^\n]*", "", src)
+
+	m = re.search(r"struct\s+tlv_definition\s+" + var + r"\s*=\s*\{(.*?)\n\};", src, re.S)
+	if not m:
+		raise ValueError("tlv_definition '%s' not found in %s" % (var, path))
+
+	entries = []
+	for e in re.finditer(r"\[\s*(\w+)\s*\]\s*=\s*\{\s*(TLV_TYPE_\w+)\s*(?:,\s*([^}]+?))?\s*\}", m.group(1)):
+		(tag, tlv_type, fixed_len) = e.groups()
+		if tlv_type not in type_code and tlv_type not in ("TLV_TYPE_NONE", "TLV_TYPE_SINGLE_TV"):
+			raise ValueError("%s: unknown type %s of %s" % (var, tlv_type, tag))
+		if tlv_type == "TLV_TYPE_FIXED" and not fixed_len:
+			fixed_len = "0"
+		entries.append((tag, tlv_type, fixed_len))
+
+	# like a designated initializer, a later entry for the same tag wins
+	tags = {}
+	for (tag, tlv_type, fixed_len) in entries:
+		tags[tag] = (tlv_type, fixed_len)
+	return [(tag, t, l) for (tag, (t, l)) in tags.items() if t != "TLV_TYPE_NONE"]
+
+def write_code(f, lines, indent):
+	for line in lines:
+		f.write("\t" * indent + line + "\n")
+
+def gen_parse_one(f, proto, entries):
+	name = proto["name"]
+
+	f.write("static inline __attribute__((always_inline))\n")
+	f.write("int tlv_parse_one_%s(uint8_t *o_tag, uint16_t *o_len, const uint8_t **o_val,\n" % name)
+	f.write("\t\tconst struct tlv_definition *def, const uint8_t *buf, int buf_len)\n")
+	f.write("{\n")
+	f.write("\tuint8_t tag;\n")
+	f.write("\tint len; /* number of bytes consumed by TLV entry */\n\n")
+	f.write("\tif (buf_len < 1)\n")
+	f.write("\t\treturn OSMO_TLVP_ERR_OFS_BEYOND_BUFFER;\n\n")
+	f.write("\ttag = *buf;\n")
+	f.write("\t*o_tag = tag;\n\n")
+
+	if "uniform" in proto:
+		f.write("\t/* the table may have been changed since it was filled, also to\n")
+		f.write("\t * make the tag a single octet TV IE via its upper nibble */\n")
+		f.write("\tif (OSMO_UNLIKELY(def->def[tag].type != %s ||\n" % proto["uniform"])
+		f.write("\t\t\t def->def[tag & 0xf0].type == TLV_TYPE_SINGLE_TV))\n")
+		f.write("\t\treturn tlv_parse_one(o_tag, o_len, o_val, def, buf, buf_len);\n\n")
+		write_code(f, type_code[proto["uniform"]], 1)
+	else:
+		single_tv = [tag for (tag, t, l) in entries if t == "TLV_TYPE_SINGLE_TV"]
+		if single_tv:
+			f.write("\t/* single octet TV IE */\n")
+			f.write("\tswitch (tag & 0xf0) {\n")
+			for tag in single_tv:
+				f.write("\tcase %s:\n" % tag)
+			f.write("\t\t*o_tag = tag & 0xf0;\n")
+			f.write("\t\t*o_val = buf;\n")
+			f.write("\t\t*o_len = 1;\n")
+			f.write("\t\treturn 1;\n")
+			f.write("\t}\n\n")
+
+		# group the tags by type and fixed length, in order of first appearance
+		groups = {}
+		for (tag, t, l) in entries:
+			if t == "TLV_TYPE_SINGLE_TV":
+				continue
+			key = (t, l if t == "TLV_TYPE_FIXED" else None)
+			groups.setdefault(key, []).append(tag)
+
+		f.write("\tswitch (tag) {\n")
+		for ((t, l), tags) in groups.items():
+			for tag in tags:
+				f.write("\tcase %s:\n" % tag)
+			write_code(f, [x % { "fixed_len": l } for x in type_code[t]], 2)
+			f.write("\t\tbreak;\n")
+		f.write("\tdefault:\n")
+		f.write("\t\treturn OSMO_TLVP_ERR_UNKNOWN_TLV_TYPE;\n")
+		f.write("\t}\n")
+
+	f.write("\n\tif (buf_len < len) {\n")
+	f.write("\t\t*o_val = NULL;\n")
+	f.write("\t\treturn OSMO_TLVP_ERR_OFS_LEN_BEYOND_BUFFER;\n")
+	f.write("\t}\n")
+	f.write("\treturn len;\n")
+	f.write("}\n\n")
+
+	f.write("static int tlv_parse2_%s(struct tlv_parsed *dec, int dec_multiples, const struct tlv_definition *def,\n" % name)
+	f.write("\t\tconst uint8_t *buf, int buf_len, uint8_t lv_tag, uint8_t lv_tag2)\n")
+	f.write("{\n")
+	f.write("\treturn tlv_parse2_with(tlv_parse_one_%s, dec, dec_multiples, def, buf, buf_len, lv_tag, lv_tag2);\n" % name)
+	f.write("}\n\n")
+
+	f.write("static int tlv_parse_compact_%s(struct tlv_parsed_compact *dec, const struct tlv_definition *def,\n" % name)
+	f.write("\t\tconst uint8_t *buf, int buf_len, uint8_t lv_tag, uint8_t lv_tag2)\n")
+	f.write("{\n")
+	f.write("\treturn tlv_parse_compact_with(tlv_parse_one_%s, dec, def, buf, buf_len, lv_tag, lv_tag2);\n" % name)
+	f.write("}\n\n")
+
+def gen_parsers(srcdir, out):
+	f = open(out, "w")
+	f.write("/* Generated by utils/tlv_gen.py, do not edit */\n")
+	f.write(mod_license + "\n")
+	f.write("#include <stdint.h>\n")
+	f.write("#include <osmocom/gsm/tlv.h>\n")
+	includes = []
+	for proto in protocols:
+		includes += [i for i in proto["includes"] if i not in includes]
+	for i in includes:
+		f.write("#include <%s>\n" % i)
+	f.write("\n#include \"tlv_parser_internal.h\"\n\n")
+
+	for proto in protocols:
+		entries = None
+		if "source" in proto:
+			(path, var) = proto["source"]
+			entries = read_tlv_definition(os.path.join(srcdir, path), var)
+			sys.stderr.write("Generate '%s' TLV parser (%d IEs)\n" % (proto["name"], len(entries)))
+		else:
+			sys.stderr.write("Generate '%s' TLV parser\n" % proto["name"])
+		gen_parse_one(f, proto, entries)
+
+	f.write("static const struct tlv_parser_gen parsers[] = {\n")
+	for proto in protocols:
+		f.write("\t{ \"%s\", tlv_parse2_%s, tlv_parse_compact_%s },\n" % ((proto["name"],) * 3))
+	f.write("};\n\n")
+
+	f.write("const struct tlv_parser_gen *tlv_parser_gen_find(const struct tlv_definition *def)\n")
+	f.write("{\n")
+	for (i, proto) in enumerate(protocols):
+		f.write("\tif (def == %s)\n" % proto["def_expr"])
+		f.write("\t\treturn &parsers[%d];\n" % i)
+	f.write("\treturn NULL;\n")
+	f.write("}\n")
+	f.close()
+
+def parse_argv():
+	parser = argparse.ArgumentParser()
+
+	parser.add_argument("-s", "--srcdir", required = True,
+		help = "path of the src/ directory containing the tlv_definitions")
+	parser.add_argument("-o", "--output", required = True,
+		help = "file to generate")
+
+	return parser.parse_args()
+
+if __name__ == '__main__':
+	argv = parse_argv()
+	gen_parsers(argv.srcdir, argv.output)